@@ -0,0 +1,150 @@
+#pragma once
+#ifndef FrameRing_H
+#define FrameRing_H
+
+// Typed single-reader/single-writer ring buffer for passing audio frames to
+// the graphics thread.
+//
+// Unlike SingleRWRingBuffer, which moves raw bytes and always copies out
+// into a buffer of the caller's, the reader here gets a Span: at most two
+// contiguous runs of T pointing straight into the ring. They can be appended
+// to a Mesh (or handed to glBufferSubData) in one go:
+//
+//   FrameRing<Vec3f> ring{8192};                      // app member
+//
+//   ring.write(frames, n);                            // audio thread
+//
+//   auto span = ring.latest(4096);                    // graphics thread
+//   span.appendTo(mesh.vertices());
+//   if (!ring.intact(span)) mesh.reset();             // lapped while reading
+//   ring.consume(span);
+//
+// With Overwrite the writer never waits for the reader: it keeps writing
+// over the oldest frames, and the reader skips ahead to whatever is newest.
+// intact() tells the reader whether the writer got around the ring and
+// into the span while it was being read, which can only happen if reading
+// takes longer than the writer needs for capacity() - span.size() frames.
+// With DropNewest the writer instead stops when the ring is full, like
+// SingleRWRingBuffer.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+template <class T>
+class FrameRing
+{
+public:
+	enum Policy
+	{
+		Overwrite,  // a full ring loses its oldest frames
+		DropNewest  // a full ring loses the frames being written
+	};
+
+	struct Span
+	{
+		const T *first = nullptr;
+		size_t firstSize = 0;
+		const T *second = nullptr;
+		size_t secondSize = 0;
+		uint64_t begin = 0;  // position of first[0] in the stream
+
+		size_t size() const { return firstSize + secondSize; }
+		uint64_t end() const { return begin + size(); }
+
+		template <class Container>
+		void appendTo(Container &c) const
+		{
+			c.insert(c.end(), first, first + firstSize);
+			c.insert(c.end(), second, second + secondSize);
+		}
+	};
+
+	// Capacity is rounded up to a power of two
+	FrameRing(size_t capacity, Policy policy = Overwrite) : mPolicy(policy)
+	{
+		size_t size = 1;
+		while (size < capacity) size <<= 1;
+		mFrames.resize(size);
+		mMask = size - 1;
+	}
+
+	size_t capacity() const { return mFrames.size(); }
+	Policy policy() const { return mPolicy; }
+
+	// Writer: append n frames in at most two copies. Returns how many were
+	// written, which is less than n only with DropNewest.
+	size_t write(const T *frames, size_t n)
+	{
+		uint64_t w = mWritten.load(std::memory_order_relaxed);
+		if (mPolicy == DropNewest)
+		{
+			uint64_t r = mRead.load(std::memory_order_acquire);
+			n = std::min<size_t>(n, capacity() - (w - r));
+		}
+		else if (n > capacity())
+		{
+			// Only the newest capacity() frames would survive anyway
+			frames += n - capacity();
+			w += n - capacity();
+			n = capacity();
+		}
+		if (n == 0) return 0;
+
+		// Announce the frames about to be overwritten before touching them
+		mClaimed.store(w + n, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		size_t start = w & mMask;
+		size_t firstSize = std::min(n, capacity() - start);
+		std::copy_n(frames, firstSize, &mFrames[start]);
+		std::copy_n(frames + firstSize, n - firstSize, &mFrames[0]);
+
+		mWritten.store(w + n, std::memory_order_release);
+		return n;
+	}
+
+	// Reader: the frames written since the last consume(), at most the
+	// newest maxFrames of them (and never more than half the ring, to leave
+	// the writer room before it laps the span)
+	Span latest(size_t maxFrames)
+	{
+		maxFrames = std::min(maxFrames, capacity() / 2);
+		uint64_t w = mWritten.load(std::memory_order_acquire);
+		uint64_t r = mRead.load(std::memory_order_relaxed);
+		if (w - r > maxFrames) r = w - maxFrames;
+
+		Span span;
+		span.begin = r;
+		size_t n = w - r;
+		size_t start = r & mMask;
+		span.first = &mFrames[start];
+		span.firstSize = std::min(n, capacity() - start);
+		span.second = &mFrames[0];
+		span.secondSize = n - span.firstSize;
+		return span;
+	}
+
+	// Reader: false if the writer may have overwritten part of `span` since
+	// latest() returned it. Call after reading.
+	bool intact(const Span &span) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return mClaimed.load(std::memory_order_relaxed) <= span.begin + capacity();
+	}
+
+	// Reader: done with everything up to the end of `span`
+	void consume(const Span &span) { mRead.store(span.end(), std::memory_order_release); }
+
+private:
+	std::vector<T> mFrames;
+	size_t mMask;
+	Policy mPolicy;
+
+	std::atomic<uint64_t> mWritten{0};  // writer position
+	std::atomic<uint64_t> mClaimed{0};  // writer position once the current write is done
+	std::atomic<uint64_t> mRead{0};     // reader position
+};
+
+#endif
@@ -11,8 +11,11 @@ Author:
 Lance Putnam, 10/2012, putnam.lance@gmail.com
 */
 
+#include <vector>
+
 #include "al/app/al_App.hpp"
-#include "al/types/al_SingleRWRingBuffer.hpp"
+
+#include "FrameRing.h"
 
 using namespace al;
 
@@ -22,21 +25,32 @@ using namespace al;
 class MyApp : public App {
  public:
   const size_t bufferSize = 8192;
+  // Frames are handed to the ring this many at a time
+  static const size_t blockSize = 256;
 
-  float bufferData[8192];
   double phase = 0;
-  // Create ring buffer with size 2048, we will use this buffer to inter
-  // leave the stereo samples from the audio callback
-  SingleRWRingBuffer ringBuffer{bufferSize * sizeof(float)};
+  // Ring buffer of 8192 stereo frames, stored as the curve's vertices so the
+  // mesh can be filled straight from it. With Overwrite the audio thread
+  // never has to drop samples because the graphics thread fell behind.
+  FrameRing<Vec3f> ringBuffer{bufferSize, FrameRing<Vec3f>::Overwrite};
+  // Vertex colors depend only on the index, so they are computed once
+  std::vector<Color> colors;
   Mesh curve;
 
-  void onCreate() { nav().pos(0, 0, 4); }
+  void onCreate() {
+    nav().pos(0, 0, 4);
+    // The redder the lines, the closer we are to a full ring buffer
+    for (size_t i = 0; i < bufferSize / 2; ++i)
+      colors.push_back(HSV(0.5 * float(bufferSize) / (bufferSize - 2 * i)));
+  }
 
   // Audio callback
   void onSound(AudioIOData& io) {
     // Set the base frequency to 55 Hz
     double freq = 55 / io.framesPerSecond();
     float out[2];
+    Vec3f frames[blockSize];
+    size_t numFrames = 0;
 
     while (io()) {
       // Update the oscillators' phase
@@ -47,28 +61,35 @@ class MyApp : public App {
       out[0] = cos(5 * phase * 2 * M_PI);
       out[1] = sin(4 * phase * 2 * M_PI);
 
-      // Write the waveforms to the ring buffer.
-      ringBuffer.write((const char*)out, 2 * sizeof(float));
+      // Collect the waveforms, and write them to the ring buffer a block
+      // at a time.
+      frames[numFrames++] = Vec3f(out[0], out[1], 0);
+      if (numFrames == blockSize) {
+        ringBuffer.write(frames, numFrames);
+        numFrames = 0;
+      }
 
       // Send scaled waveforms to output...
       io.out(0) = out[0] * 0.2f;
       io.out(1) = out[1] * 0.2f;
     }
+    ringBuffer.write(frames, numFrames);
   }
 
   void onAnimate(double dt) {
     curve.primitive(Mesh::LINE_STRIP);
     curve.reset();
 
-    size_t samplesRead =
-        ringBuffer.read((char*)bufferData, bufferSize * sizeof(float));
+    // Now we copy the newest frames from the ring buffer straight into the
+    // mesh to be displayed
+    auto frames = ringBuffer.latest(bufferSize / 2);
+    frames.appendTo(curve.vertices());
+    curve.colors().insert(curve.colors().end(), colors.begin(),
+                          colors.begin() + frames.size());
 
-    // Now we read samples from the buffer into the meash to be displayed
-    for (size_t i = 0; i < samplesRead / sizeof(float); i = i + 2) {
-      curve.vertex(bufferData[i], bufferData[i + 1]);
-      // The redder the lines, the closer we are to a full ring buffer
-      curve.color(HSV(0.5 * float(bufferSize) / (bufferSize - i)));
-    }
+    // The audio thread got all the way around the ring while we were copying
+    if (!ringBuffer.intact(frames)) curve.reset();
+    ringBuffer.consume(frames);
   }
 
   void onDraw(Graphics& g) {
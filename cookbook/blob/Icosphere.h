@@ -0,0 +1,75 @@
+#pragma once
+#ifndef Icosphere_H
+#define Icosphere_H
+
+// Icospheres like the .ico files main.cpp loads (which aren't in the
+// repository), for the benchmarks: an icosahedron subdivided `levels`
+// times, 10 * 4^levels + 2 vertices on the unit sphere, and each vertex's
+// neighbors.
+//
+//   vector<Vec3> vertices;
+//   vector<vector<int>> nn;
+//   icosphere(6, vertices, nn);   // 40962 vertices
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+struct Vec3
+{
+	float x, y, z;
+};
+
+inline void icosphere(int levels, std::vector<Vec3> &vertices, std::vector<std::vector<int>> &nn)
+{
+	const float t = (1 + std::sqrt(5.f)) / 2;
+	vertices = {{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+	            {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+	std::vector<std::array<int, 3>> faces = {{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+	                                         {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+	                                         {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+	                                         {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}};
+	for (int level = 0; level < levels; ++level)
+	{
+		std::map<std::pair<int, int>, int> midpoints;
+		auto midpoint = [&](int a, int b)
+		{
+			auto key = std::make_pair(std::min(a, b), std::max(a, b));
+			auto found = midpoints.find(key);
+			if (found != midpoints.end()) return found->second;
+			Vec3 p = vertices[a], q = vertices[b];
+			vertices.push_back({(p.x + q.x) / 2, (p.y + q.y) / 2, (p.z + q.z) / 2});
+			return midpoints[key] = (int)vertices.size() - 1;
+		};
+		std::vector<std::array<int, 3>> finer;
+		for (auto &f : faces)
+		{
+			int a = midpoint(f[0], f[1]), b = midpoint(f[1], f[2]), c = midpoint(f[2], f[0]);
+			finer.push_back({{f[0], a, c}});
+			finer.push_back({{f[1], b, a}});
+			finer.push_back({{f[2], c, b}});
+			finer.push_back({{a, b, c}});
+		}
+		faces.swap(finer);
+	}
+	for (auto &v : vertices)
+	{
+		float r = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+		v = {v.x / r, v.y / r, v.z / r};
+	}
+	nn.assign(vertices.size(), {});
+	for (auto &f : faces)
+	{
+		for (int e = 0; e < 3; ++e)
+		{
+			int a = f[e], b = f[(e + 1) % 3];
+			if (std::find(nn[a].begin(), nn[a].end(), b) == nn[a].end()) nn[a].push_back(b);
+			if (std::find(nn[b].begin(), nn[b].end(), a) == nn[b].end()) nn[b].push_back(a);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,249 @@
+#pragma once
+#ifndef SpringMesh_H
+#define SpringMesh_H
+
+// The blob's spring solver (main.cpp) for meshes of up to several hundred
+// thousand vertices: every vertex is pulled back to its rest position and
+// toward each of its neighbors, with damping.
+//
+// The neighbor lists are packed into one array, CSR style: vertex i's
+// neighbors are neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1].
+// Positions and velocities are separate x, y, z arrays, double-buffered:
+// the next state of every vertex is computed from the previous state of
+// all of them, 8 (AVX2, with gathers) or 4 (SSE2) vertices at a time, so
+// vertices can be updated in any order. Given a StealingPool, runs of
+// vertices are spread over its threads; the result is the same for any
+// number of threads.
+//
+//   SpringMesh springs;
+//   springs.setNeighbors(nn);                  // vector<vector<int>>
+//   springs.reset(&mesh.vertices()[0].x, n);   // rest positions, x y z each
+//
+//   springs.poke(i, dx, dy, dz);
+//   springs.step(&state().p[0].x, &pool);      // every frame; writes x y z
+//
+// Each vertex's force is summed in the same order as main.cpp's loop did.
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "../simulation/StealingPool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPRINGMESH_SSE2 1
+#endif
+
+class SpringMesh
+{
+public:
+	float anchorK = 0.06f;   // spring constant for anchor points
+	float neighborK = 0.1f;  // spring constant between neighbors
+	float damping = 0.08f;
+
+	// Neighbor graph, CSR packed
+	std::vector<uint32_t> offsets, neighbors;
+
+	// Current positions and velocities
+	std::vector<float> x, y, z, vx, vy, vz;
+
+	unsigned size() const { return mSize; }
+
+	template <class Lists>
+	void setNeighbors(const Lists &lists)
+	{
+		offsets.assign(1, 0);
+		neighbors.clear();
+		for (const auto &list : lists)
+		{
+			for (auto j : list) neighbors.push_back((uint32_t)j);
+			offsets.push_back((uint32_t)neighbors.size());
+		}
+	}
+
+	// n rest positions, x y z each; starts there, at rest
+	void reset(const float *xyz, unsigned n)
+	{
+		mSize = n;
+		for (auto *a : {&x, &y, &z, &mRestX, &mRestY, &mRestZ}) a->resize(n);
+		for (unsigned i = 0; i < n; ++i)
+		{
+			x[i] = mRestX[i] = xyz[3 * i];
+			y[i] = mRestY[i] = xyz[3 * i + 1];
+			z[i] = mRestZ[i] = xyz[3 * i + 2];
+		}
+		for (auto *a : {&vx, &vy, &vz, &mX, &mY, &mZ, &mVx, &mVy, &mVz}) a->assign(n, 0.f);
+	}
+
+	// Moves vertex i by d and its neighbors by half of it
+	void poke(unsigned i, float dx, float dy, float dz)
+	{
+		for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k)
+		{
+			uint32_t j = neighbors[k];
+			x[j] += dx * 0.5f;
+			y[j] += dy * 0.5f;
+			z[j] += dz * 0.5f;
+		}
+		x[i] += dx;
+		y[i] += dy;
+		z[i] += dz;
+	}
+
+	// One step; also writes the new positions to xyz (x y z each) if given
+	void step(float *xyz = nullptr, StealingPool *pool = nullptr)
+	{
+		unsigned runs = (mSize + kRun - 1) / kRun;
+		auto run = [&](unsigned r, unsigned)
+		{
+			unsigned end = std::min(mSize, (r + 1) * kRun);
+			update(r * kRun, end);
+			if (xyz)
+			{
+				for (unsigned i = r * kRun; i < end; ++i)
+				{
+					xyz[3 * i] = mX[i];
+					xyz[3 * i + 1] = mY[i];
+					xyz[3 * i + 2] = mZ[i];
+				}
+			}
+		};
+		if (pool)
+			pool->forEach(runs, run);
+		else
+			for (unsigned r = 0; r < runs; ++r) run(r, 0);
+		x.swap(mX);
+		y.swap(mY);
+		z.swap(mZ);
+		vx.swap(mVx);
+		vy.swap(mVy);
+		vz.swap(mVz);
+	}
+
+private:
+	static const unsigned kRun = 1024;
+
+	// Next state of vertices [begin, end), into mX ... mVz
+	void update(unsigned begin, unsigned end)
+	{
+		const float sk = -anchorK, nk = -neighborK, d = damping;
+		unsigned i = begin;
+#if defined(__AVX2__)
+		const __m256 vsk = _mm256_set1_ps(sk), vnk = _mm256_set1_ps(nk), vd = _mm256_set1_ps(d);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 px = _mm256_loadu_ps(&x[i]), py = _mm256_loadu_ps(&y[i]), pz = _mm256_loadu_ps(&z[i]);
+			__m256 fx = _mm256_mul_ps(_mm256_sub_ps(px, _mm256_loadu_ps(&mRestX[i])), vsk);
+			__m256 fy = _mm256_mul_ps(_mm256_sub_ps(py, _mm256_loadu_ps(&mRestY[i])), vsk);
+			__m256 fz = _mm256_mul_ps(_mm256_sub_ps(pz, _mm256_loadu_ps(&mRestZ[i])), vsk);
+
+			__m256i first = _mm256_loadu_si256((const __m256i *)&offsets[i]);
+			__m256i degree = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)&offsets[i + 1]), first);
+			uint32_t most = 0;
+			for (unsigned lane = 0; lane < 8; ++lane) most = std::max(most, offsets[i + lane + 1] - offsets[i + lane]);
+			for (uint32_t k = 0; k < most; ++k)
+			{
+				// Lanes past their last neighbor "gather" their own position,
+				// which adds nothing
+				__m256i in = _mm256_cmpgt_epi32(degree, _mm256_set1_epi32((int)k));
+				__m256i j = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)neighbors.data(),
+				                                        _mm256_add_epi32(first, _mm256_set1_epi32((int)k)), in, 4);
+				__m256 inf = _mm256_castsi256_ps(in);
+				__m256 nx = _mm256_mask_i32gather_ps(px, x.data(), j, inf, 4);
+				__m256 ny = _mm256_mask_i32gather_ps(py, y.data(), j, inf, 4);
+				__m256 nz = _mm256_mask_i32gather_ps(pz, z.data(), j, inf, 4);
+				fx = _mm256_add_ps(fx, _mm256_mul_ps(_mm256_sub_ps(px, nx), vnk));
+				fy = _mm256_add_ps(fy, _mm256_mul_ps(_mm256_sub_ps(py, ny), vnk));
+				fz = _mm256_add_ps(fz, _mm256_mul_ps(_mm256_sub_ps(pz, nz), vnk));
+			}
+
+			__m256 nvx = _mm256_loadu_ps(&vx[i]), nvy = _mm256_loadu_ps(&vy[i]), nvz = _mm256_loadu_ps(&vz[i]);
+			fx = _mm256_sub_ps(fx, _mm256_mul_ps(nvx, vd));
+			fy = _mm256_sub_ps(fy, _mm256_mul_ps(nvy, vd));
+			fz = _mm256_sub_ps(fz, _mm256_mul_ps(nvz, vd));
+			nvx = _mm256_add_ps(nvx, fx);
+			nvy = _mm256_add_ps(nvy, fy);
+			nvz = _mm256_add_ps(nvz, fz);
+			_mm256_storeu_ps(&mVx[i], nvx);
+			_mm256_storeu_ps(&mVy[i], nvy);
+			_mm256_storeu_ps(&mVz[i], nvz);
+			_mm256_storeu_ps(&mX[i], _mm256_add_ps(px, nvx));
+			_mm256_storeu_ps(&mY[i], _mm256_add_ps(py, nvy));
+			_mm256_storeu_ps(&mZ[i], _mm256_add_ps(pz, nvz));
+		}
+#elif defined(SPRINGMESH_SSE2)
+		// No gathers: each lane's neighbor is loaded on its own
+		const __m128 vsk = _mm_set1_ps(sk), vnk = _mm_set1_ps(nk), vd = _mm_set1_ps(d);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 px = _mm_loadu_ps(&x[i]), py = _mm_loadu_ps(&y[i]), pz = _mm_loadu_ps(&z[i]);
+			__m128 fx = _mm_mul_ps(_mm_sub_ps(px, _mm_loadu_ps(&mRestX[i])), vsk);
+			__m128 fy = _mm_mul_ps(_mm_sub_ps(py, _mm_loadu_ps(&mRestY[i])), vsk);
+			__m128 fz = _mm_mul_ps(_mm_sub_ps(pz, _mm_loadu_ps(&mRestZ[i])), vsk);
+
+			uint32_t most = 0;
+			for (unsigned lane = 0; lane < 4; ++lane) most = std::max(most, offsets[i + lane + 1] - offsets[i + lane]);
+			for (uint32_t k = 0; k < most; ++k)
+			{
+				// Lanes past their last neighbor take their own position
+				uint32_t j[4];
+				for (unsigned lane = 0; lane < 4; ++lane)
+				{
+					uint32_t at = offsets[i + lane] + k;
+					j[lane] = at < offsets[i + lane + 1] ? neighbors[at] : i + lane;
+				}
+				__m128 nx = _mm_setr_ps(x[j[0]], x[j[1]], x[j[2]], x[j[3]]);
+				__m128 ny = _mm_setr_ps(y[j[0]], y[j[1]], y[j[2]], y[j[3]]);
+				__m128 nz = _mm_setr_ps(z[j[0]], z[j[1]], z[j[2]], z[j[3]]);
+				fx = _mm_add_ps(fx, _mm_mul_ps(_mm_sub_ps(px, nx), vnk));
+				fy = _mm_add_ps(fy, _mm_mul_ps(_mm_sub_ps(py, ny), vnk));
+				fz = _mm_add_ps(fz, _mm_mul_ps(_mm_sub_ps(pz, nz), vnk));
+			}
+
+			__m128 nvx = _mm_loadu_ps(&vx[i]), nvy = _mm_loadu_ps(&vy[i]), nvz = _mm_loadu_ps(&vz[i]);
+			fx = _mm_sub_ps(fx, _mm_mul_ps(nvx, vd));
+			fy = _mm_sub_ps(fy, _mm_mul_ps(nvy, vd));
+			fz = _mm_sub_ps(fz, _mm_mul_ps(nvz, vd));
+			nvx = _mm_add_ps(nvx, fx);
+			nvy = _mm_add_ps(nvy, fy);
+			nvz = _mm_add_ps(nvz, fz);
+			_mm_storeu_ps(&mVx[i], nvx);
+			_mm_storeu_ps(&mVy[i], nvy);
+			_mm_storeu_ps(&mVz[i], nvz);
+			_mm_storeu_ps(&mX[i], _mm_add_ps(px, nvx));
+			_mm_storeu_ps(&mY[i], _mm_add_ps(py, nvy));
+			_mm_storeu_ps(&mZ[i], _mm_add_ps(pz, nvz));
+		}
+#endif
+		for (; i < end; ++i)
+		{
+			float px = x[i], py = y[i], pz = z[i];
+			float fx = (px - mRestX[i]) * sk, fy = (py - mRestY[i]) * sk, fz = (pz - mRestZ[i]) * sk;
+			for (uint32_t k = offsets[i]; k < offsets[i + 1]; ++k)
+			{
+				uint32_t j = neighbors[k];
+				fx += (px - x[j]) * nk;
+				fy += (py - y[j]) * nk;
+				fz += (pz - z[j]) * nk;
+			}
+			fx -= vx[i] * d;
+			fy -= vy[i] * d;
+			fz -= vz[i] * d;
+			mVx[i] = vx[i] + fx;
+			mVy[i] = vy[i] + fy;
+			mVz[i] = vz[i] + fz;
+			mX[i] = px + mVx[i];
+			mY[i] = py + mVy[i];
+			mZ[i] = pz + mVz[i];
+		}
+	}
+
+	unsigned mSize = 0;
+	std::vector<float> mRestX, mRestY, mRestZ;
+	std::vector<float> mX, mY, mZ, mVx, mVy, mVz;  // next state
+};
+
+#endif
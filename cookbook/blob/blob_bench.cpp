@@ -0,0 +1,141 @@
+// Checks SpringMesh.h against the loop main.cpp used to run and times a
+// step for icospheres of 2562 to 655362 vertices.
+//
+//   ./run.sh cookbook/blob/blob_bench.cpp
+//
+// The icospheres come from Icosphere.h, like the .ico files main.cpp loads
+// (which aren't in the repository).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Icosphere.h"
+#include "SpringMesh.h"
+
+using namespace std;
+
+// The loop main.cpp used to run
+struct Before
+{
+  vector<vector<int>> nn;
+  vector<Vec3> p, velocity, original;
+  float SK = 0.06f, NK = 0.1f, D = 0.08f;
+
+  void poke(int n, Vec3 v)
+  {
+    for (int j : nn[n]) p[j] = {p[j].x + v.x * 0.5f, p[j].y + v.y * 0.5f, p[j].z + v.z * 0.5f};
+    p[n] = {p[n].x + v.x, p[n].y + v.y, p[n].z + v.z};
+  }
+
+  void step()
+  {
+    for (size_t i = 0; i < p.size(); i++)
+    {
+      Vec3 &v = p[i];
+      Vec3 force = {(v.x - original[i].x) * -SK, (v.y - original[i].y) * -SK, (v.z - original[i].z) * -SK};
+      for (size_t k = 0; k < nn[i].size(); k++)
+      {
+        Vec3 &n = p[nn[i][k]];
+        force = {force.x + (v.x - n.x) * -NK, force.y + (v.y - n.y) * -NK, force.z + (v.z - n.z) * -NK};
+      }
+      force = {force.x - velocity[i].x * D, force.y - velocity[i].y * D, force.z - velocity[i].z * D};
+      velocity[i] = {velocity[i].x + force.x, velocity[i].y + force.y, velocity[i].z + force.z};
+    }
+    for (size_t i = 0; i < p.size(); i++)
+      p[i] = {p[i].x + velocity[i].x, p[i].y + velocity[i].y, p[i].z + velocity[i].z};
+  }
+};
+
+// 300 steps on 2562 vertices with a poke every 50
+bool same()
+{
+  Before before;
+  icosphere(4, before.original, before.nn);
+  before.p = before.original;
+  before.velocity.assign(before.p.size(), {0, 0, 0});
+
+  SpringMesh after;
+  StealingPool pool(3);
+  after.setNeighbors(before.nn);
+  after.reset(&before.original[0].x, (unsigned)before.original.size());
+  vector<Vec3> out(before.p.size());
+  for (int s = 0; s < 300; ++s)
+  {
+    if (s % 50 == 0)
+    {
+      int n = (s * 7919) % (int)before.p.size();
+      Vec3 v = {0.3f, -0.2f, 0.1f};
+      before.poke(n, v);
+      after.poke(n, v.x, v.y, v.z);
+    }
+    before.step();
+    after.step(&out[0].x, &pool);
+  }
+  float maxDiff = 0, peak = 0;
+  for (size_t i = 0; i < out.size(); ++i)
+  {
+    maxDiff = max({maxDiff, fabs(out[i].x - before.p[i].x), fabs(out[i].y - before.p[i].y),
+                   fabs(out[i].z - before.p[i].z)});
+    float dx = before.p[i].x - before.original[i].x, dy = before.p[i].y - before.original[i].y,
+          dz = before.p[i].z - before.original[i].z;
+    peak = max(peak, sqrt(dx * dx + dy * dy + dz * dz));
+  }
+  bool ok = maxDiff <= 1e-5f;
+  printf("300 steps of %zu vertices, 3 threads: max difference %g (largest displacement %g): %s\n",
+         out.size(), maxDiff, peak, ok ? "same within tolerance" : "POSITIONS DIFFER");
+  return ok;
+}
+
+// Milliseconds per call, over at least half a second
+template <typename F>
+double msPerCall(F f)
+{
+  int calls = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    f();
+    ++calls;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1000 / calls;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+  const char *path = "AVX2";
+#elif defined(SPRINGMESH_SSE2)
+  const char *path = "SSE2";
+#else
+  const char *path = "scalar";
+#endif
+  bool ok = same();
+
+  StealingPool pool;
+  printf("%9s %11s %11s %11s\n", "vertices", "before ms", "1 thread ms", "threads ms");
+  for (int levels : {4, 6, 7, 8})
+  {
+    Before before;
+    icosphere(levels, before.original, before.nn);
+    before.p = before.original;
+    before.velocity.assign(before.p.size(), {0, 0, 0});
+    before.poke(0, {0.3f, 0.3f, 0.3f});
+    double old = msPerCall([&]() { before.step(); });
+
+    SpringMesh after;
+    after.setNeighbors(before.nn);
+    after.reset(&before.original[0].x, (unsigned)before.original.size());
+    after.poke(0, 0.3f, 0.3f, 0.3f);
+    vector<Vec3> out(before.p.size());
+    double serial = msPerCall([&]() { after.step(&out[0].x); });
+    double threaded = msPerCall([&]() { after.step(&out[0].x, &pool); });
+    printf("%9zu %11.2f %11.2f %11.2f\n", out.size(), old, serial, threaded);
+  }
+  printf("path: %s, %u threads\n", path, pool.size());
+  return ok ? 0 : 1;
+}
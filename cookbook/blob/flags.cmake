@@ -0,0 +1,6 @@
+# With CODED_VERTICES defined, main.cpp shares the vertices through
+# shm_open(), which is in librt on Linux with glibc before 2.34
+file(STRINGS ${file_full_path} coded_vertices REGEX "^#define CODED_VERTICES")
+if(${CMAKE_SYSTEM_NAME} MATCHES "Linux" AND coded_vertices)
+  set(app_link_libs rt)
+endif()
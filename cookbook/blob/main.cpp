@@ -9,6 +9,9 @@
 
 #include <Gamma/Noise.h>
 
+#include "SpringMesh.h"
+#include "../distributed/StateHistory.h"
+
 using namespace al;
 
 #include <iostream> // cout
@@ -27,8 +30,26 @@ using namespace al;
 //#define N 163842
 //#define N 655362
 
+// Uncomment to send the vertices on their own, as StateCodec packets through
+// a StateSender, instead of in State: cuttlebone then only carries the
+// settings, and the vertices take a fraction of the bandwidth (15 times less
+// at 40962 vertices, see cookbook/distributed/state_codec_bench.cpp). Renderers
+// on the primary's machine read the packets from shared memory (kVertexRing),
+// the others have to be reachable at kVertexAddress.
+//#define CODED_VERTICES
+#ifdef CODED_VERTICES
+// POSIX sockets and shared memory: only built when the vertices are coded
+#include "../distributed/StateCodec.h"
+#include "../distributed/StateTransport.h"
+
+const char *kVertexAddress = "127.255.255.255"; // renderers' broadcast address
+const uint16_t kVertexPort = 63060;
+const char *kVertexRing = "/blob_vertices";
+#endif
+
 struct State {
-  Pose pose; // for navigation
+  double time = 0; // primary's clock when sent, for renderers' StateHistory
+  Pose pose;   // for navigation
 
   // this is how you might control renderering settings.
   double eyeSeparation;
@@ -48,7 +69,9 @@ struct State {
   // renderer, only interpreted.
   //
 
+#ifndef CODED_VERTICES
   Vec3f p[N];
+#endif
 };
 
 // Load file into mesh
@@ -135,8 +158,9 @@ struct Blob : DistributedAppWithState<State> {
   // This data will not be shared to remote nodes, so you should only use it on
   // the simulator machine
   vector<vector<int>> nn;
-  vector<Vec3f> velocity;
   vector<Vec3f> original;
+  SpringMesh springs; // neighbor graph, positions and velocities
+  StealingPool pool;
 
   // a boolean value that is read and reset (false) by the simulation step and
   // written (true) by audio, keyboard and mouse callbacks.
@@ -147,6 +171,24 @@ struct Blob : DistributedAppWithState<State> {
   // a mesh we use to do graphics rendering in this app
   Mesh mesh;
 
+#ifdef CODED_VERTICES
+  // The vertices, sent and received apart from State
+  std::vector<Vec3f> p = std::vector<Vec3f>(N);
+  StateEncoder encoder;
+  StateDecoder decoder;
+  StateSender sender;
+  StateReceiver receiver;
+  std::vector<uint8_t> packet;
+  Vec3f *vertices() { return p.data(); }
+#else
+  Vec3f *vertices() { return state().p; }
+#endif
+
+  // Renderers keep the last few poses and vertex positions and draw in
+  // between them, instead of jumping to each state as it arrives
+  StateHistory poses, shapes;
+  float shownPose[7]; // position, quaternion w x y z
+
   gam::NoisePink<> pinkNoise;
 
   void onInit() override {
@@ -168,18 +210,33 @@ struct Blob : DistributedAppWithState<State> {
       shouldPoke = true; // start with a poke
 
       // Initialize simulation data
-      velocity.resize(mesh.vertices().size(), Vec3f(0, 0, 0));
       original.resize(mesh.vertices().size());
       for (int i = 0; i < mesh.vertices().size(); i++)
         original[i] = mesh.vertices()[i];
+      springs.setNeighbors(nn);
+      springs.reset(&original[0].x, N);
 
       for (int i = 0; i < N; i++)
-        state().p[i] = original[i];
+        vertices()[i] = original[i];
       state().eyeSeparation = 0.03;
       state().backgroundColor = Color(0.1f, 0.1f);
       state().wireFrame = true;
     }
 
+#ifdef CODED_VERTICES
+    if (isPrimary()) {
+      sender.open(kVertexRing, StateEncoder::maxPacket(sizeof(double), N),
+                  kVertexAddress, kVertexPort);
+    } else {
+      receiver.open(kVertexRing, kVertexPort);
+    }
+#endif
+    if (!isPrimary()) {
+      poses.resize(7);
+      poses.quaternion(3);
+      shapes.resize(3 * N);
+    }
+
     // Enable cuttlebone for state distribution
     auto cuttleboneDomain =
         CuttleboneStateSimulationDomain<State>::enableCuttlebone(this);
@@ -207,42 +264,66 @@ struct Blob : DistributedAppWithState<State> {
         pokedVertex = n;
         pokedVertexRest = original[n];
         Vec3f v = Vec3f(rnd::uniformS(), rnd::uniformS(), rnd::uniformS());
-        for (unsigned k = 0; k < nn[n].size(); k++)
-          state().p[nn[n][k]] += v * 0.5;
-        state().p[n] += v;
+        springs.poke(n, v.x, v.y, v.z);
       }
 
-      // Compute new postions
-      for (int i = 0; i < N; i++) {
-        Vec3f &v = state().p[i];
-        Vec3f force = (v - original[i]) * -SK;
-
-        for (int k = 0; k < nn[i].size(); k++) {
-          Vec3f &n = state().p[nn[i][k]];
-          force += (v - n) * -NK;
-        }
-
-        force -= velocity[i] * D;
-        velocity[i] += force;
-      }
-
-      for (int i = 0; i < N; i++) {
-        state().p[i] += velocity[i];
-      }
+      // Compute new postions, from the previous ones of all vertices, and
+      // copy them to the state
+      springs.anchorK = SK;
+      springs.neighborK = NK;
+      springs.damping = D;
+      springs.step(&vertices()[0].x, &pool);
+      state().time = StateHistory::now();
+#ifdef CODED_VERTICES
+      auto &coded = encoder.encode(&state().time, sizeof(double), &p[0].x, N);
+      sender.send(coded.data(), coded.size());
+#endif
 
       // Update variables in state to send to nodes
       state().pose = nav();
       state().backgroundColor = bgColor;
       state().wireFrame = wireFrame;
 
+      // Copy vertex positions from state to mesh
+      memcpy(&mesh.vertices()[0], vertices(), sizeof(Vec3f) * N);
+
     } else {
-      // For remote nodes, update pose and color from state
-      pose() = state().pose;
+      // For remote nodes, add new states to the histories, and show pose and
+      // vertices from in between the last two. (state().time stays 0 until
+      // the first state arrives.)
+      bool received = state().time > 0;
+      if (float *v = received ? poses.push(state().time) : nullptr) {
+        Vec3d pos = state().pose.pos();
+        Quatd quat = state().pose.quat();
+        float values[7] = {float(pos.x),  float(pos.y),  float(pos.z), float(quat.w),
+                           float(quat.x), float(quat.y), float(quat.z)};
+        std::copy(values, values + 7, v);
+      }
+      if (poses.sample(shownPose)) {
+        const float *v = shownPose;
+        pose().pos(v[0], v[1], v[2]);
+        pose().quat().set(v[3], v[4], v[5], v[6]);
+      }
+#ifdef CODED_VERTICES
+      // Copied out before decoding: the decoder keeps keyframes, and one
+      // overwritten in shared memory while read must not become one
+      double sent;
+      bool intact = receiver.newest([&](const uint8_t *data, size_t size) {
+        packet.assign(data, data + size);
+      });
+      if (intact &&
+          decoder.decode(packet.data(), packet.size(), &sent, sizeof(double), &p[0].x, N)) {
+        if (float *v = shapes.push(sent))
+          memcpy(v, p.data(), sizeof(Vec3f) * N);
+      }
+#else
+      if (float *v = received ? shapes.push(state().time) : nullptr)
+        memcpy(v, state().p, sizeof(Vec3f) * N);
+#endif
+      shapes.sample(&mesh.vertices()[0].x);
       bgColor = state().backgroundColor;
       wireFrame = state().wireFrame;
     }
-    // Copy vertex positions from state to mesh
-    memcpy(&mesh.vertices()[0], &state().p[0], sizeof(Vec3f) * N);
   }
 
   void onDraw(Graphics &g) override {
@@ -275,7 +356,7 @@ struct Blob : DistributedAppWithState<State> {
           }
         }
 
-        float f = (state().p[pokedVertex] - pokedVertexRest).mag() - 0.45;
+        float f = (vertices()[pokedVertex] - pokedVertexRest).mag() - 0.45;
 
         if (f > 0.99) {
           f = 0.99;
@@ -0,0 +1,304 @@
+#pragma once
+#ifndef ChunkedState_H
+#define ChunkedState_H
+
+// State of any size over UDP: the primary's ChunkSender splits each frame
+// into datagrams that fit an Ethernet MTU, and every renderer's
+// ChunkReceiver puts them back together and hands over only whole frames.
+// A frame missing a datagram is dropped when a newer one completes, so a
+// renderer sees some frames late or not at all but never a torn one.
+//
+// Each datagram is a small header (frame number, frame size, where the
+// chunk goes) and its chunk. The receiver reads the header first and then
+// the chunk straight into its place in the frame; a finished frame is
+// handed to the app by swapping buffers. Frames are sent to a broadcast
+// address so any number of renderers get them: the cluster's, or
+// 127.255.255.255 for renderers on this machine (Linux; macOS has no
+// broadcast on loopback).
+//
+//   ChunkSender sender;                                      // primary
+//   sender.open("127.255.255.255", 63059);
+//   sender.send(&state, sizeof(state));                      // every frame
+//
+//   ChunkReceiver receiver;                                  // renderers
+//   receiver.open(63059);
+//   std::vector<uint8_t> frame;
+//   if (receiver.newest(frame))
+//     ...  // frame holds the newest whole frame received
+//
+// The receiver runs its own thread so datagrams are read as they come
+// rather than once per app frame. POSIX sockets only, like cuttlebone.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chunkedstate
+{
+const uint32_t kMagic = 0x31435342;  // "BSC1"
+
+struct Header
+{
+	uint32_t magic;
+	uint32_t session;  // changes when the primary restarts
+	uint32_t frame;
+	uint32_t size;     // of the whole frame
+	uint32_t index;    // the chunk at index * chunk
+	uint32_t chunk;    // bytes per chunk (the last may be shorter)
+};
+
+// Bytes per chunk: 1500 byte MTU, less IP, UDP and our headers
+const uint32_t kChunk = 1500 - 20 - 8 - sizeof(Header);
+
+inline uint32_t chunks(uint32_t size, uint32_t chunk) { return size ? (size + chunk - 1) / chunk : 1; }
+}  // namespace chunkedstate
+
+class ChunkSender
+{
+public:
+	ChunkSender() = default;
+	ChunkSender(const ChunkSender &) = delete;
+	ChunkSender &operator=(const ChunkSender &) = delete;
+	~ChunkSender() { close(); }
+
+	bool open(const char *address, uint16_t port)
+	{
+		close();
+		std::memset(&mTo, 0, sizeof mTo);
+		mTo.sin_family = AF_INET;
+		mTo.sin_port = htons(port);
+		if (inet_pton(AF_INET, address, &mTo.sin_addr) != 1) return false;
+		mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+		if (mSocket < 0) return false;
+		int yes = 1, buffer = 4 << 20;
+		setsockopt(mSocket, SOL_SOCKET, SO_BROADCAST, &yes, sizeof yes);
+		setsockopt(mSocket, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof buffer);
+		mSession = uint32_t(std::chrono::steady_clock::now().time_since_epoch().count()) ^ uint32_t(getpid());
+		return true;
+	}
+
+	void close()
+	{
+		if (mSocket >= 0) ::close(mSocket);
+		mSocket = -1;
+	}
+
+	// Sends one frame; false if a datagram couldn't be sent
+	bool send(const void *data, size_t size)
+	{
+		using namespace chunkedstate;
+		if (mSocket < 0) return false;
+		Header header = {kMagic, mSession, ++mFrame, uint32_t(size), 0, kChunk};
+		bool sent = true;
+		for (uint32_t i = 0, n = chunks(header.size, kChunk); i < n; ++i)
+		{
+			header.index = i;
+			size_t offset = size_t(i) * kChunk;
+			iovec parts[2] = {{&header, sizeof header},
+			                  {(uint8_t *)data + offset, std::min<size_t>(kChunk, size - offset)}};
+			msghdr message = {};
+			message.msg_name = &mTo;
+			message.msg_namelen = sizeof mTo;
+			message.msg_iov = parts;
+			message.msg_iovlen = 2;
+			sent = sendmsg(mSocket, &message, 0) >= 0 && sent;
+		}
+		return sent;
+	}
+
+	uint32_t frame() const { return mFrame; }
+
+private:
+	int mSocket = -1;
+	sockaddr_in mTo;
+	uint32_t mSession = 0, mFrame = 0;
+};
+
+class ChunkReceiver
+{
+public:
+	ChunkReceiver() = default;
+	ChunkReceiver(const ChunkReceiver &) = delete;
+	ChunkReceiver &operator=(const ChunkReceiver &) = delete;
+	~ChunkReceiver() { close(); }
+
+	// Starts receiving frames sent to port, along with any other receivers on
+	// this machine
+	bool open(uint16_t port)
+	{
+		close();
+		mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+		if (mSocket < 0) return false;
+		int yes = 1, buffer = 8 << 20;
+		setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+#ifdef SO_REUSEPORT
+#ifdef __APPLE__
+		setsockopt(mSocket, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof yes);
+#endif
+#endif
+		setsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof buffer);
+		timeval timeout = {0, 100000};
+		setsockopt(mSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+		sockaddr_in at = {};
+		at.sin_family = AF_INET;
+		at.sin_port = htons(port);
+		at.sin_addr.s_addr = htonl(INADDR_ANY);
+		if (bind(mSocket, (sockaddr *)&at, sizeof at) < 0)
+		{
+			close();
+			return false;
+		}
+		mRunning = true;
+		mThread = std::thread([this]() { receive(); });
+		return true;
+	}
+
+	void close()
+	{
+		mRunning = false;
+		if (mThread.joinable()) mThread.join();
+		if (mSocket >= 0) ::close(mSocket);
+		mSocket = -1;
+	}
+
+	// Swaps the newest whole frame into frame, if there is one since the last
+	// call; frame's old buffer is reused for a later frame
+	bool newest(std::vector<uint8_t> &frame)
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		if (!mFresh) return false;
+		frame.swap(mReady);
+		mFresh = false;
+		return true;
+	}
+
+	// Frame number of the last whole frame, and counts of whole frames and of
+	// frames dropped unfinished
+	uint32_t frame() const { return mLastFrame; }
+	uint32_t completed() const { return mCompleted; }
+	uint32_t dropped() const { return mDropped; }
+
+private:
+	// A frame being put together
+	struct Assembly
+	{
+		uint32_t frame = 0;  // 0: free
+		uint32_t size = 0, chunk = 0, missing = 0;
+		std::vector<uint8_t> have;  // per chunk
+		std::vector<uint8_t> data;
+	};
+
+	void receive()
+	{
+		using namespace chunkedstate;
+		uint8_t discard[16];
+		while (mRunning)
+		{
+			Header header;
+			ssize_t peeked = recv(mSocket, &header, sizeof header, MSG_PEEK);
+			if (peeked < 0) continue;  // timed out; check mRunning
+			Assembly *into = peeked == sizeof header ? place(header) : nullptr;
+			if (!into)
+			{
+				recv(mSocket, discard, sizeof discard, 0);
+				continue;
+			}
+
+			size_t offset = size_t(header.index) * header.chunk;
+			size_t length = std::min<size_t>(header.chunk, header.size - offset);
+			iovec parts[2] = {{&header, sizeof header}, {into->data.data() + offset, length}};
+			msghdr message = {};
+			message.msg_iov = parts;
+			message.msg_iovlen = 2;
+			ssize_t got = recvmsg(mSocket, &message, 0);
+			if (got != ssize_t(sizeof header + length) || (message.msg_flags & MSG_TRUNC)) continue;
+			into->have[header.index] = 1;
+			if (--into->missing == 0) finish(*into);
+		}
+	}
+
+	// The assembly a chunk goes to, or null to drop it
+	Assembly *place(const chunkedstate::Header &header)
+	{
+		using namespace chunkedstate;
+		if (header.magic != kMagic || !header.chunk || header.index >= chunks(header.size, header.chunk))
+			return nullptr;
+		if (header.session != mSession)
+		{
+			mSession = header.session;
+			mLastFrame = 0;
+			for (auto &a : mAssemblies) a.frame = 0;
+		}
+		if (header.frame <= mLastFrame) return nullptr;
+
+		Assembly *into = nullptr;
+		for (auto &a : mAssemblies)
+			if (a.frame == header.frame) into = &a;
+		if (into)
+		{
+			if (into->size != header.size || into->chunk != header.chunk || into->have[header.index]) return nullptr;
+			return into;
+		}
+
+		// A new frame takes a free assembly or the oldest one
+		into = &mAssemblies[0];
+		for (auto &a : mAssemblies)
+			if (a.frame < into->frame) into = &a;
+		if (into->frame > header.frame) return nullptr;
+		if (into->frame) ++mDropped;
+		uint32_t n = chunks(header.size, header.chunk);
+		into->frame = header.frame;
+		into->size = header.size;
+		into->chunk = header.chunk;
+		into->missing = n;
+		into->have.assign(n, 0);
+		into->data.resize(header.size);
+		return into;
+	}
+
+	void finish(Assembly &done)
+	{
+		for (auto &a : mAssemblies)
+		{
+			if (a.frame && a.frame < done.frame)
+			{
+				a.frame = 0;
+				++mDropped;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			done.data.swap(mReady);
+			mFresh = true;
+		}
+		mLastFrame = done.frame;
+		done.frame = 0;
+		++mCompleted;
+	}
+
+	int mSocket = -1;
+	std::thread mThread;
+	std::atomic<bool> mRunning{false};
+
+	// Receiving thread's
+	uint32_t mSession = 0;
+	Assembly mAssemblies[2];
+	std::atomic<uint32_t> mLastFrame{0}, mCompleted{0}, mDropped{0};
+
+	std::mutex mLock;
+	std::vector<uint8_t> mReady;
+	bool mFresh = false;
+};
+
+#endif
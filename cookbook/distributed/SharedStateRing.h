@@ -0,0 +1,261 @@
+#pragma once
+#ifndef SharedStateRing_H
+#define SharedStateRing_H
+
+// Frames of state in POSIX shared memory, for renderers on the primary's
+// own machine: the primary writes each frame once, into the next of a ring
+// of slots, and every local renderer maps the ring read-only and reads the
+// newest slot in place. No sockets, and nothing copied per renderer.
+//
+// Each slot has a version that is odd while the primary writes it and
+// 2 * (frame number) + 2 after. A renderer checks it before and after using
+// a frame; the primary only comes back to a slot after writing all the
+// others, so with 8 slots a renderer has 7 frames' time to use one.
+//
+//   SharedStateWriter writer;                                // primary
+//   writer.open("/blob", sizeof(State));
+//   writer.write(&state, sizeof(state));                     // every frame
+//
+//   SharedStateReader reader;                                // renderers
+//   reader.open("/blob");                                    // false: none here
+//   SharedStateReader::Frame frame;
+//   if (reader.newest(frame))
+//   {
+//     ...  // use frame.data, frame.size
+//     if (!reader.intact(frame)) ...  // overwritten meanwhile: discard
+//   }
+//
+// Ring names are shm_open() names: a slash and up to 30 characters.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace sharedstate
+{
+const uint32_t kMagic = 0x31435343;  // "CSC1"
+
+struct Header
+{
+	uint32_t magic;
+	uint32_t slots;
+	uint64_t capacity;               // bytes per slot
+	std::atomic<uint64_t> newest;    // frame number of the newest frame; 0: none
+	std::atomic<int64_t> heartbeat;  // steady clock (ns) at the last write
+};
+
+struct Slot
+{
+	std::atomic<uint64_t> version;
+	uint64_t size;
+};
+
+inline size_t align(size_t bytes) { return (bytes + 63) & ~size_t(63); }
+
+inline size_t bytes(uint32_t slots, uint64_t capacity)
+{
+	return align(sizeof(Header) + slots * sizeof(Slot)) + slots * align(capacity);
+}
+
+inline int64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+}  // namespace sharedstate
+
+class SharedStateWriter
+{
+public:
+	SharedStateWriter() = default;
+	SharedStateWriter(const SharedStateWriter &) = delete;
+	SharedStateWriter &operator=(const SharedStateWriter &) = delete;
+	~SharedStateWriter() { close(); }
+
+	// Creates the ring, replacing one left by a primary that didn't exit
+	bool open(const char *name, size_t capacity, uint32_t slots = 8)
+	{
+		using namespace sharedstate;
+		close();
+		shm_unlink(name);
+		int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd < 0) return false;
+		mBytes = bytes(slots, capacity);
+		void *map = ftruncate(fd, off_t(mBytes)) == 0
+		                ? mmap(nullptr, mBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+		                : MAP_FAILED;
+		::close(fd);
+		if (map == MAP_FAILED)
+		{
+			shm_unlink(name);
+			return false;
+		}
+		mName = name;
+		mHeader = new (map) Header;
+		mHeader->slots = slots;
+		mHeader->capacity = capacity;
+		mHeader->newest = 0;
+		mHeader->heartbeat = now();
+		for (uint32_t s = 0; s < slots; ++s) new (slot(s)) Slot{{0}, 0};
+		mHeader->magic = kMagic;
+		return true;
+	}
+
+	void close()
+	{
+		if (!mHeader) return;
+		munmap(mHeader, mBytes);
+		shm_unlink(mName.c_str());
+		mHeader = nullptr;
+	}
+
+	// The next slot, to write a frame of size bytes straight into, then
+	// commit(); null if the frame doesn't fit
+	void *begin(size_t size)
+	{
+		if (!mHeader || size > mHeader->capacity) return nullptr;
+		uint64_t frame = mHeader->newest.load(std::memory_order_relaxed) + 1;
+		sharedstate::Slot *s = slot(frame % mHeader->slots);
+		s->version.store(2 * frame + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		s->size = size;
+		return data(frame % mHeader->slots);
+	}
+
+	void commit()
+	{
+		uint64_t frame = mHeader->newest.load(std::memory_order_relaxed) + 1;
+		slot(frame % mHeader->slots)->version.store(2 * frame + 2, std::memory_order_release);
+		mHeader->newest.store(frame, std::memory_order_release);
+		mHeader->heartbeat.store(sharedstate::now(), std::memory_order_relaxed);
+	}
+
+	bool write(const void *bytes, size_t size)
+	{
+		void *into = begin(size);
+		if (!into) return false;
+		std::memcpy(into, bytes, size);
+		commit();
+		return true;
+	}
+
+	// Marks the primary alive without a new frame
+	void beat()
+	{
+		if (mHeader) mHeader->heartbeat.store(sharedstate::now(), std::memory_order_relaxed);
+	}
+
+private:
+	sharedstate::Slot *slot(uint64_t s) { return (sharedstate::Slot *)(mHeader + 1) + s; }
+	uint8_t *data(uint64_t s)
+	{
+		using namespace sharedstate;
+		return (uint8_t *)mHeader + align(sizeof(Header) + mHeader->slots * sizeof(Slot)) + s * align(mHeader->capacity);
+	}
+
+	std::string mName;
+	sharedstate::Header *mHeader = nullptr;
+	size_t mBytes = 0;
+};
+
+class SharedStateReader
+{
+public:
+	struct Frame
+	{
+		const void *data = nullptr;
+		size_t size = 0;
+		uint64_t number = 0;
+	};
+
+	SharedStateReader() = default;
+	SharedStateReader(const SharedStateReader &) = delete;
+	SharedStateReader &operator=(const SharedStateReader &) = delete;
+	~SharedStateReader() { close(); }
+
+	// Maps the ring read-only; false if no primary on this machine made one
+	bool open(const char *name)
+	{
+		using namespace sharedstate;
+		close();
+		int fd = shm_open(name, O_RDONLY, 0);
+		if (fd < 0) return false;
+		struct stat info;
+		void *map = MAP_FAILED;
+		if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(Header))
+		{
+			mBytes = size_t(info.st_size);
+			map = mmap(nullptr, mBytes, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		::close(fd);
+		if (map == MAP_FAILED) return false;
+		mHeader = (const Header *)map;
+		if (mHeader->magic != kMagic || bytes(mHeader->slots, mHeader->capacity) > mBytes)
+		{
+			close();
+			return false;
+		}
+		mLast = 0;
+		return true;
+	}
+
+	void close()
+	{
+		if (mHeader) munmap((void *)mHeader, mBytes);
+		mHeader = nullptr;
+	}
+
+	bool isOpen() const { return mHeader != nullptr; }
+
+	// The primary wrote (or beat()) in the last `seconds`
+	bool alive(double seconds = 1) const
+	{
+		return mHeader && sharedstate::now() - mHeader->heartbeat.load(std::memory_order_relaxed) < seconds * 1e9;
+	}
+
+	// The newest frame, if it is newer than the last one returned
+	bool newest(Frame &frame)
+	{
+		if (!mHeader) return false;
+		uint64_t number = mHeader->newest.load(std::memory_order_acquire);
+		if (number <= mLast) return false;
+		const sharedstate::Slot *s = slot(number % mHeader->slots);
+		if (s->version.load(std::memory_order_acquire) != 2 * number + 2) return false;
+		frame.data = data(number % mHeader->slots);
+		frame.size = size_t(s->size);
+		frame.number = number;
+		if (frame.size > mHeader->capacity || !intact(frame)) return false;
+		mLast = number;
+		return true;
+	}
+
+	// The frame wasn't overwritten while it was used
+	bool intact(const Frame &frame) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot(frame.number % mHeader->slots)->version.load(std::memory_order_relaxed) == 2 * frame.number + 2;
+	}
+
+private:
+	const sharedstate::Slot *slot(uint64_t s) const { return (const sharedstate::Slot *)(mHeader + 1) + s; }
+	const uint8_t *data(uint64_t s) const
+	{
+		using namespace sharedstate;
+		return (const uint8_t *)mHeader + align(sizeof(Header) + mHeader->slots * sizeof(Slot)) +
+		       s * align(mHeader->capacity);
+	}
+
+	const sharedstate::Header *mHeader = nullptr;
+	size_t mBytes = 0;
+	uint64_t mLast = 0;
+};
+
+#endif
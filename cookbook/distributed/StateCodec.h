@@ -0,0 +1,354 @@
+#pragma once
+#ifndef StateCodec_H
+#define StateCodec_H
+
+// Packets, much smaller than the state itself, for a distributed state that
+// is mostly positions, like the blob's vertices (cookbook/blob/main.cpp).
+//
+// Positions are quantized to 16 bits per coordinate inside a box around
+// them. Every keyframeInterval frames, and whenever a position leaves the
+// box, a keyframe is sent whole; the frames in between are sent as their
+// difference from a keyframe, which is zero wherever nothing moved. The
+// differences are split into a plane of low bytes and a plane of high bytes
+// and runs of zero bytes are sent as a count, so a vertex that moved a
+// little costs about a byte per coordinate and one that didn't costs almost
+// nothing. The rest of the state (pose, settings) is sent exactly, XORed
+// with the keyframe's.
+//
+// Every frame refers to a keyframe, not to the frame before it: a lost
+// packet costs one frame, and a renderer that joins late shows the state
+// from the next keyframe on. With waitForAcks, frames only refer to
+// keyframes all renderers have acknowledged (each reports its
+// decoder.keyframe(), and the primary passes the oldest of those to
+// encoder.acknowledge()); until then every frame is a keyframe.
+//
+//   StateEncoder encoder;                                    // primary
+//   auto &packet = encoder.encode(&settings, sizeof(settings), &p[0].x, n);
+//   ...  // send packet.data(), packet.size()
+//
+//   StateDecoder decoder;                                    // renderers
+//   if (decoder.decode(data, size, &settings, sizeof(settings), &p[0].x, n))
+//     ...  // settings and p are the primary's, positions to within a step
+//
+// Packets are in the host's byte order, as cuttlebone's are.
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace statecodec
+{
+const uint32_t kMagic = 0x31435341;  // "ASC1"
+
+struct Header
+{
+	uint32_t magic;
+	uint32_t frame;
+	uint32_t keyframe;  // frame number of the keyframe this is relative to
+	uint32_t rawSize;
+	uint32_t points;
+	float box[6];       // the keyframe's: min x y z, max x y z
+};
+
+// A keyframe, as both ends keep it
+struct Keyframe
+{
+	uint32_t frame = 0;  // 0: none
+	float box[6];
+	std::vector<uint8_t> raw;
+	std::vector<uint16_t> q;  // x y z each
+};
+
+inline void putCount(std::vector<uint8_t> &out, size_t v)
+{
+	while (v >= 0x80)
+	{
+		out.push_back(uint8_t(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(uint8_t(v));
+}
+
+inline bool getCount(const uint8_t *&p, const uint8_t *end, size_t &v)
+{
+	v = 0;
+	for (int shift = 0; p < end && shift < 35; shift += 7)
+	{
+		uint8_t b = *p++;
+		v |= size_t(b & 0x7f) << shift;
+		if (!(b & 0x80)) return true;
+	}
+	return false;
+}
+
+// Appends n bytes as (zero run, literal count, literals) triples; zeros
+// shorter than a triple's overhead stay in the literals
+inline void packRuns(const uint8_t *bytes, size_t n, std::vector<uint8_t> &out)
+{
+	size_t i = 0;
+	while (i < n)
+	{
+		size_t start = i;
+		while (i + 8 <= n)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + i, 8);
+			if (word) break;
+			i += 8;
+		}
+		while (i < n && !bytes[i]) ++i;
+		size_t zeros = i - start, literal = i;
+		while (literal < n)
+		{
+			if (bytes[literal])
+				++literal;
+			else if (literal + 3 <= n && !bytes[literal + 1] && !bytes[literal + 2])
+				break;
+			else
+				literal += 1 + (literal + 1 < n && !bytes[literal + 1]);
+		}
+		literal = std::min(literal, n);
+		putCount(out, zeros);
+		putCount(out, literal - i);
+		out.insert(out.end(), bytes + i, bytes + literal);
+		i = literal;
+	}
+}
+
+// Undoes packRuns() into exactly n bytes
+inline bool unpackRuns(const uint8_t *&p, const uint8_t *end, uint8_t *bytes, size_t n)
+{
+	size_t i = 0;
+	while (i < n)
+	{
+		size_t zeros, literal;
+		if (!getCount(p, end, zeros) || !getCount(p, end, literal)) return false;
+		if (zeros > n - i || literal > n - i - zeros || literal > size_t(end - p)) return false;
+		std::memset(bytes + i, 0, zeros);
+		i += zeros;
+		std::memcpy(bytes + i, p, literal);
+		i += literal;
+		p += literal;
+	}
+	return true;
+}
+
+inline uint16_t zigzag(uint16_t d) { return uint16_t((d << 1) ^ -(d >> 15)); }
+inline uint16_t unzigzag(uint16_t z) { return uint16_t((z >> 1) ^ -(z & 1)); }
+
+// Low bytes of the differences q - ref, zigzagged, then the high bytes.
+// Without ref (a keyframe) the differences are from the point before, which
+// is near on a mesh.
+inline void toPlanes(const uint16_t *q, const uint16_t *ref, size_t n, uint8_t *planes)
+{
+	for (size_t k = 0; k < n; ++k)
+	{
+		uint16_t d = zigzag(uint16_t(q[k] - (ref ? ref[k] : k >= 3 ? q[k - 3] : 0)));
+		planes[k] = uint8_t(d);
+		planes[n + k] = uint8_t(d >> 8);
+	}
+}
+
+inline void fromPlanes(const uint8_t *planes, const uint16_t *ref, size_t n, uint16_t *q)
+{
+	for (size_t k = 0; k < n; ++k)
+	{
+		uint16_t d = unzigzag(uint16_t(planes[k] | planes[n + k] << 8));
+		q[k] = uint16_t(d + (ref ? ref[k] : k >= 3 ? q[k - 3] : 0));
+	}
+}
+
+// Quantizes into box; false if a position is outside it
+inline bool quantize(const float *xyz, size_t n, const float *box, uint16_t *q)
+{
+	float scale[3];
+	for (int a = 0; a < 3; ++a) scale[a] = 65535 / (box[3 + a] - box[a]);
+	bool inside = true;
+	for (size_t k = 0; k < n; ++k)
+	{
+		float t = (xyz[k] - box[k % 3]) * scale[k % 3];
+		inside = inside && t >= 0 && t <= 65535;
+		q[k] = uint16_t(std::min(std::max(t, 0.f), 65535.f) + 0.5f);
+	}
+	return inside;
+}
+
+inline void dequantize(const uint16_t *q, size_t n, const float *box, float *xyz)
+{
+	float step[3];
+	for (int a = 0; a < 3; ++a) step[a] = (box[3 + a] - box[a]) / 65535;
+	for (size_t k = 0; k < n; ++k) xyz[k] = box[k % 3] + q[k] * step[k % 3];
+}
+}  // namespace statecodec
+
+class StateEncoder
+{
+public:
+	unsigned keyframeInterval = 60;  // frames
+	bool waitForAcks = false;
+
+	// This frame's packet: raw sent as is, points positions (x y z each)
+	// quantized. Valid until the next call.
+	const std::vector<uint8_t> &encode(const void *raw, size_t rawSize, const float *xyz, unsigned points)
+	{
+		using namespace statecodec;
+		const size_t n = size_t(points) * 3;
+		++mFrame;
+		mQ.resize(n);
+		mRaw.resize(rawSize);
+
+		const Keyframe *ref = waitForAcks ? &mAcked : (mSent.empty() ? nullptr : &mSent.back());
+		bool key = !ref || !ref->frame || ref->raw.size() != rawSize || ref->q.size() != n ||
+		           mFrame - mSent.back().frame >= keyframeInterval;
+		if (!key) key = !quantize(xyz, n, ref->box, mQ.data());
+		if (key)
+		{
+			Keyframe next;
+			next.frame = mFrame;
+			box(xyz, n, next.box);
+			quantize(xyz, n, next.box, mQ.data());
+			next.raw.assign((const uint8_t *)raw, (const uint8_t *)raw + rawSize);
+			next.q = mQ;
+			mSent.push_back(std::move(next));
+			if (mSent.size() > kKept) mSent.erase(mSent.begin());
+			ref = &mSent.back();
+		}
+
+		Header header = {kMagic, mFrame, ref->frame, uint32_t(rawSize), points,
+		                 {ref->box[0], ref->box[1], ref->box[2], ref->box[3], ref->box[4], ref->box[5]}};
+		mPacket.resize(sizeof header);
+		std::memcpy(mPacket.data(), &header, sizeof header);
+		for (size_t b = 0; b < rawSize; ++b)
+			mRaw[b] = ((const uint8_t *)raw)[b] ^ (key ? 0 : ref->raw[b]);
+		packRuns(mRaw.data(), rawSize, mPacket);
+		mPlanes.resize(2 * n);
+		toPlanes(mQ.data(), key ? nullptr : ref->q.data(), n, mPlanes.data());
+		packRuns(mPlanes.data(), 2 * n, mPacket);
+		mKey = key;
+		return mPacket;
+	}
+
+	// A renderer has keyframe (StateDecoder::keyframe()); with waitForAcks,
+	// later frames refer to it
+	void acknowledge(uint32_t keyframe)
+	{
+		if (keyframe <= mAcked.frame) return;
+		for (auto &sent : mSent)
+			if (sent.frame == keyframe) mAcked = sent;
+	}
+
+	uint32_t frame() const { return mFrame; }
+	bool wasKeyframe() const { return mKey; }
+
+	// Largest packet encode() can make: runs of zeros cost at most half again
+	// the bytes they cover
+	static size_t maxPacket(size_t rawSize, unsigned points)
+	{
+		return sizeof(statecodec::Header) + (rawSize + 6 * size_t(points)) * 3 / 2 + 32;
+	}
+
+private:
+	static const size_t kKept = 4;  // keyframes that can still be acknowledged
+
+	// Box around the positions, with room to move half its size each way
+	static void box(const float *xyz, size_t n, float *box)
+	{
+		float lo[3] = {0, 0, 0}, hi[3] = {0, 0, 0};
+		for (size_t k = 0; k < n; ++k)
+		{
+			int a = int(k % 3);
+			lo[a] = k < 3 ? xyz[k] : std::min(lo[a], xyz[k]);
+			hi[a] = k < 3 ? xyz[k] : std::max(hi[a], xyz[k]);
+		}
+		float margin = std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]}) / 2;
+		if (!(margin > 0)) margin = 1;
+		for (int a = 0; a < 3; ++a)
+		{
+			box[a] = lo[a] - margin;
+			box[3 + a] = hi[a] + margin;
+		}
+	}
+
+	uint32_t mFrame = 0;
+	bool mKey = false;
+	std::vector<statecodec::Keyframe> mSent;  // newest last
+	statecodec::Keyframe mAcked;
+	std::vector<uint16_t> mQ;
+	std::vector<uint8_t> mRaw, mPlanes, mPacket;
+};
+
+class StateDecoder
+{
+public:
+	// Writes the frame in packet to raw and xyz. False, leaving them alone,
+	// if the packet is malformed, for a different layout, older than the last
+	// frame decoded, or relative to a keyframe this decoder hasn't seen. If
+	// the packet is an older keyframe, the primary was restarted and decoding
+	// starts over from it.
+	bool decode(const void *packet, size_t size, void *raw, size_t rawSize, float *xyz, unsigned points)
+	{
+		using namespace statecodec;
+		const size_t n = size_t(points) * 3;
+		Header header;
+		if (size < sizeof header) return false;
+		std::memcpy(&header, packet, sizeof header);
+		if (header.magic != kMagic || header.rawSize != rawSize || header.points != points) return false;
+		bool key = header.keyframe == header.frame;
+		if (header.frame <= mFrame)
+		{
+			// An older keyframe means the primary started over
+			if (!key) return false;
+			mKept.clear();
+		}
+		const uint8_t *p = (const uint8_t *)packet + sizeof header, *end = (const uint8_t *)packet + size;
+
+		const Keyframe *ref = nullptr;
+		if (!key)
+		{
+			for (auto &kept : mKept)
+				if (kept.frame == header.keyframe) ref = &kept;
+			if (!ref) return false;
+		}
+
+		mRaw.resize(rawSize);
+		mPlanes.resize(2 * n);
+		mQ.resize(n);
+		if (!unpackRuns(p, end, mRaw.data(), rawSize) || !unpackRuns(p, end, mPlanes.data(), 2 * n)) return false;
+		for (size_t b = 0; b < rawSize && ref; ++b) mRaw[b] ^= ref->raw[b];
+		fromPlanes(mPlanes.data(), ref ? ref->q.data() : nullptr, n, mQ.data());
+
+		if (key)
+		{
+			Keyframe next;
+			next.frame = header.frame;
+			std::copy(header.box, header.box + 6, next.box);
+			next.raw = mRaw;
+			next.q = mQ;
+			mKept.push_back(std::move(next));
+			if (mKept.size() > kKept) mKept.erase(mKept.begin());
+		}
+		if (rawSize) std::memcpy(raw, mRaw.data(), rawSize);
+		dequantize(mQ.data(), n, header.box, xyz);
+		mFrame = header.frame;
+		return true;
+	}
+
+	// Frame number of the newest keyframe received (0: none yet), for
+	// StateEncoder::acknowledge()
+	uint32_t keyframe() const { return mKept.empty() ? 0 : mKept.back().frame; }
+
+	// Frame number of the last frame decoded
+	uint32_t frame() const { return mFrame; }
+
+private:
+	static const size_t kKept = 4;
+
+	uint32_t mFrame = 0;
+	std::vector<statecodec::Keyframe> mKept;  // newest last
+	std::vector<uint16_t> mQ;
+	std::vector<uint8_t> mRaw, mPlanes;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#pragma once
+#ifndef StateHistory_H
+#define StateHistory_H
+
+// The last few states a renderer received, stamped with the primary's time,
+// so it can draw the state in between them at its own frame rate instead
+// of whatever arrived last.
+//
+// Each state is an array of floats: a pose, vertex positions, anything that
+// moves smoothly. sample() shows the states as they were at a fixed delay
+// behind the newest one (by default one interval between states), blending
+// the two on either side; 30 states a second then look like 60, and a late
+// packet is absorbed by the delay instead of showing as a stutter. If
+// packets stop, the last two are extrapolated for up to maxExtrapolation
+// seconds and then held. Quaternions, marked with quaternion(), are blended
+// along the shorter way and normalized.
+//
+// The primary's clock is matched to the renderer's from the arrival times,
+// taking the quickest recent arrival as the one with no network delay, so
+// the primary only has to send its time with the state.
+//
+//   StateHistory history;                                    // renderers
+//   history.resize(7 + 3 * N);                               // pose, vertices
+//   history.quaternion(3);
+//
+//   if (float *values = history.push(state().time))          // new state
+//     ...  // write its pose and vertices into values
+//   if (history.sample(values.data()))                       // every frame
+//     ...  // read the pose and vertices to draw back from values
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+class StateHistory
+{
+public:
+	double delay = -1;               // seconds behind the newest state; < 0: one interval
+	double maxExtrapolation = 0.05;  // seconds past the newest state
+
+	// Floats per state; clears the history and the quaternions
+	void resize(size_t values)
+	{
+		mValues = values;
+		mQuaternions.clear();
+		for (auto &entry : mEntries) entry.values.assign(values, 0.f);
+		clear();
+	}
+
+	// Floats at..at + 3 are a quaternion (w x y z or x y z w)
+	void quaternion(size_t at) { mQuaternions.push_back(at); }
+
+	void clear()
+	{
+		mCount = 0;
+		mOffsetCount = 0;
+		mInterval = 0;
+	}
+
+	// Room for the state the primary sent at `sent` (its clock), arrived at
+	// `arrived` (now()); null if it's not newer than the newest. A state much
+	// older than the newest means the primary started over: the history is
+	// cleared.
+	float *push(double sent, double arrived = now())
+	{
+		if (mCount)
+		{
+			double newest = at(0).sent;
+			if (sent <= newest)
+			{
+				if (newest - sent < 1) return nullptr;
+				clear();
+			}
+			else
+			{
+				double interval = sent - newest;
+				mInterval = mInterval > 0 ? mInterval * 0.9 + interval * 0.1 : interval;
+			}
+		}
+		mNewest = (mNewest + 1) % kKept;
+		mCount = std::min(mCount + 1, kKept);
+		mEntries[mNewest].sent = sent;
+
+		mOffsets[mOffsetCount++ % kOffsets] = arrived - sent;
+		size_t offsets = std::min(mOffsetCount, kOffsets);
+		mOffset = *std::min_element(mOffsets, mOffsets + offsets);
+		return mEntries[mNewest].values.data();
+	}
+
+	// The state to show at local time `at`; false if there is none yet
+	bool sample(float *out, double at = now()) const
+	{
+		if (!mCount) return false;
+		double target = at - mOffset - (delay >= 0 ? delay : mInterval);
+
+		// Between two states, or past the newest (extrapolated), or before the
+		// oldest (held)
+		size_t newer = 0;
+		while (newer + 1 < mCount && this->at(newer + 1).sent > target) ++newer;
+		if (mCount == 1 || (newer + 1 == mCount && this->at(newer).sent > target))
+		{
+			std::copy(this->at(newer).values.begin(), this->at(newer).values.end(), out);
+			return true;
+		}
+		if (newer == 0 && target > this->at(0).sent) target = std::min(target, this->at(0).sent + maxExtrapolation);
+		const Entry &a = this->at(newer + 1), &b = this->at(newer);
+		float t = float((target - a.sent) / (b.sent - a.sent));
+		blend(a.values.data(), b.values.data(), t, out);
+		return true;
+	}
+
+	// Seconds on a steady clock
+	static double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	size_t size() const { return mCount; }
+	double interval() const { return mInterval; }
+
+private:
+	static const size_t kKept = 8, kOffsets = 32;
+
+	struct Entry
+	{
+		double sent = 0;
+		std::vector<float> values;
+	};
+
+	// i-th newest
+	const Entry &at(size_t i) const { return mEntries[(mNewest + kKept - i) % kKept]; }
+
+	void blend(const float *a, const float *b, float t, float *out) const
+	{
+		for (size_t k = 0; k < mValues; ++k) out[k] = a[k] + (b[k] - a[k]) * t;
+		for (size_t q : mQuaternions)
+		{
+			float dot = 0, length = 0;
+			for (int c = 0; c < 4; ++c) dot += a[q + c] * b[q + c];
+			float sign = dot < 0 ? -1.f : 1.f;
+			for (int c = 0; c < 4; ++c)
+			{
+				out[q + c] = a[q + c] + (sign * b[q + c] - a[q + c]) * t;
+				length += out[q + c] * out[q + c];
+			}
+			float scale = length > 0 ? 1 / std::sqrt(length) : 1.f;
+			for (int c = 0; c < 4; ++c) out[q + c] *= scale;
+		}
+	}
+
+	size_t mValues = 0;
+	std::vector<size_t> mQuaternions;
+	Entry mEntries[kKept];
+	size_t mNewest = 0, mCount = 0;
+	double mInterval = 0;  // between states, averaged
+	double mOffsets[kOffsets], mOffset = 0;
+	size_t mOffsetCount = 0;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef StateTransport_H
+#define StateTransport_H
+
+// Frames of state from the primary to every renderer, through shared memory
+// (SharedStateRing.h) to the renderers on the primary's machine and as
+// datagrams (ChunkedState.h) to the others. Each renderer picks for itself:
+// the ring if a primary on its machine is writing one, datagrams otherwise,
+// checking again every second, so the same app works on one machine with
+// several renderer processes and across a cluster.
+//
+//   StateSender sender;                                      // primary
+//   sender.open("/blob", sizeof(State), "127.255.255.255", 63059);
+//   sender.send(&state, sizeof(state));                      // every frame
+//
+//   StateReceiver receiver;                                  // renderers
+//   receiver.open("/blob", 63059);
+//   receiver.newest([&](const uint8_t *data, size_t size) {
+//     ...  // use the newest frame; data is only valid in here
+//   });
+//
+// A local renderer uses the frame in place in the ring. In the unlikely
+// case the primary overwrote it meanwhile (a renderer 7 frames behind),
+// newest() returns false after use() and whatever use() did should be
+// discarded.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ChunkedState.h"
+#include "SharedStateRing.h"
+
+class StateSender
+{
+public:
+	// A ring called name for renderers here, and datagrams to address and
+	// port for the others (none if address is null)
+	bool open(const char *name, size_t capacity, const char *address, uint16_t port)
+	{
+		bool local = mRing.open(name, capacity);
+		mRemote = address && mChunks.open(address, port);
+		return local || mRemote;
+	}
+
+	void send(const void *data, size_t size)
+	{
+		mRing.write(data, size);
+		if (mRemote) mChunks.send(data, size);
+	}
+
+private:
+	SharedStateWriter mRing;
+	ChunkSender mChunks;
+	bool mRemote = false;
+};
+
+class StateReceiver
+{
+public:
+	void open(const char *name, uint16_t port)
+	{
+		mName = name;
+		mPort = port;
+		mChecked = {};
+		choose();
+	}
+
+	// Calls use(data, size) with the newest frame, if there is one since the
+	// last call; false if there wasn't or it was overwritten during use()
+	template <class F>
+	bool newest(F use)
+	{
+		choose();
+		if (mRing.isOpen())
+		{
+			SharedStateReader::Frame frame;
+			if (!mRing.newest(frame)) return false;
+			use((const uint8_t *)frame.data, frame.size);
+			return mRing.intact(frame);
+		}
+		if (!mChunks.newest(mFrame)) return false;
+		use((const uint8_t *)mFrame.data(), mFrame.size());
+		return true;
+	}
+
+	// Reading the ring of a primary on this machine
+	bool local() const { return mRing.isOpen(); }
+
+private:
+	// Once a second: the ring if there is a live one, datagrams otherwise
+	void choose()
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (now - mChecked < std::chrono::seconds(1)) return;
+		mChecked = now;
+		if (mRing.isOpen() && mRing.alive()) return;
+		if (mRing.open(mName.c_str()) && mRing.alive())
+		{
+			if (mListening) mChunks.close();
+			mListening = false;
+			return;
+		}
+		mRing.close();
+		if (!mListening) mListening = mChunks.open(mPort);
+	}
+
+	std::string mName;
+	uint16_t mPort = 0;
+	std::chrono::steady_clock::time_point mChecked;
+	SharedStateReader mRing;
+	ChunkReceiver mChunks;
+	bool mListening = false;
+	std::vector<uint8_t> mFrame;
+};
+
+#endif
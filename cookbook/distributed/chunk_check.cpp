@@ -0,0 +1,168 @@
+// Sends frames through ChunkedState.h to three renderer processes over
+// loopback and checks that every frame they get is whole.
+//
+//   ./run.sh cookbook/distributed/chunk_check.cpp
+//
+// Frames are 1 MB (724 datagrams). The primary sends them at 60 frames per
+// second, then as fast as it can, then through a link that loses one
+// datagram in a thousand (about half the frames miss one), then restarts and
+// sends at 60 again. Every word of a frame depends on the frame, so a
+// renderer that showed a frame put together from two frames, or one missing
+// a datagram, would notice. Linux only: it sends to 127.255.255.255.
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ChunkedState.h"
+
+using namespace std;
+
+const uint16_t kPort = 63061;
+const size_t kWords = (1 << 20) / 4 + 7;
+const uint32_t kEnd = 0xffffffff;
+
+uint32_t word(uint32_t phase, uint32_t k, size_t i)
+{
+  uint32_t h = uint32_t(i) * 2654435761u ^ (phase << 24 | k);
+  return h ^ (h >> 15);
+}
+
+void fill(vector<uint32_t> &frame, uint32_t phase, uint32_t k)
+{
+  for (size_t i = 0; i < frame.size(); ++i) frame[i] = word(phase, k, i);
+  frame[0] = phase;
+  frame[1] = k;
+}
+
+// ChunkSender's datagrams, losing one in `rate` on the way
+struct LossyLink
+{
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in to = {};
+  uint32_t frame = 0;
+  mt19937 rng{1};
+
+  LossyLink()
+  {
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_BROADCAST, &yes, sizeof yes);
+    to.sin_family = AF_INET;
+    to.sin_port = htons(kPort);
+    inet_pton(AF_INET, "127.255.255.255", &to.sin_addr);
+  }
+  ~LossyLink() { close(s); }
+
+  void send(const void *data, size_t size, unsigned rate)
+  {
+    using namespace chunkedstate;
+    Header header = {kMagic, 12345, ++frame, uint32_t(size), 0, kChunk};
+    vector<uint8_t> datagram;
+    for (uint32_t i = 0; i < chunks(header.size, kChunk); ++i)
+    {
+      header.index = i;
+      size_t offset = size_t(i) * kChunk, length = min<size_t>(kChunk, size - offset);
+      datagram.assign((uint8_t *)&header, (uint8_t *)&header + sizeof header);
+      datagram.insert(datagram.end(), (uint8_t *)data + offset, (uint8_t *)data + offset + length);
+      if (rng() % rate) sendto(s, datagram.data(), datagram.size(), 0, (sockaddr *)&to, sizeof to);
+    }
+  }
+};
+
+// Counts whole frames per phase until the end frame; returns 0 if none
+// was torn
+int renderer(int id)
+{
+  ChunkReceiver receiver;
+  if (!receiver.open(kPort)) return 2;
+  vector<uint8_t> frame;
+  unsigned got[4] = {0, 0, 0, 0}, torn = 0;
+  auto last = chrono::steady_clock::now();
+  while (chrono::steady_clock::now() - last < chrono::seconds(5))
+  {
+    if (!receiver.newest(frame))
+    {
+      this_thread::sleep_for(chrono::milliseconds(2));
+      continue;
+    }
+    last = chrono::steady_clock::now();
+    const uint32_t *w = (const uint32_t *)frame.data();
+    if (frame.size() == 4 && w[0] == kEnd) break;
+    bool whole = frame.size() == kWords * 4 && w[0] < 4;
+    for (size_t i = 2; whole && i < kWords; ++i) whole = w[i] == word(w[0], w[1], i);
+    if (whole)
+      ++got[w[0]];
+    else
+      ++torn;
+  }
+  printf("renderer %d: whole frames %u paced, %u flooded, %u lossy, %u after restart; %u dropped unfinished, "
+         "%u torn\n",
+         id, got[0], got[1], got[2], got[3], receiver.dropped(), torn);
+  return torn || !got[0] || !got[2] || !got[3] || !receiver.dropped() ? 1 : 0;
+}
+
+int main()
+{
+  vector<pid_t> renderers;
+  for (int id = 0; id < 3; ++id)
+  {
+    pid_t pid = fork();
+    if (pid == 0) return renderer(id);
+    renderers.push_back(pid);
+  }
+  this_thread::sleep_for(chrono::milliseconds(500));
+
+  vector<uint32_t> frame(kWords);
+  auto paced = [&](ChunkSender &sender, uint32_t phase, uint32_t count)
+  {
+    for (uint32_t k = 0; k < count; ++k)
+    {
+      fill(frame, phase, k);
+      sender.send(frame.data(), frame.size() * 4);
+      this_thread::sleep_for(chrono::microseconds(16667));
+    }
+  };
+  {
+    ChunkSender sender;
+    if (!sender.open("127.255.255.255", kPort)) return 2;
+    paced(sender, 0, 120);
+    auto start = chrono::steady_clock::now();
+    for (uint32_t k = 0; k < 120; ++k)
+    {
+      fill(frame, 1, k);
+      sender.send(frame.data(), frame.size() * 4);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("primary: flooded 120 frames at %.0f MB/s\n", 120 * frame.size() * 4 / seconds / 1e6);
+  }
+  LossyLink lossy;
+  for (uint32_t k = 0; k < 60; ++k)
+  {
+    fill(frame, 2, k);
+    lossy.send(frame.data(), frame.size() * 4, 1000);
+    this_thread::sleep_for(chrono::microseconds(16667));
+  }
+  ChunkSender restarted;
+  if (!restarted.open("127.255.255.255", kPort)) return 2;
+  paced(restarted, 3, 60);
+  for (int k = 0; k < 5; ++k)
+  {
+    restarted.send(&kEnd, 4);
+    this_thread::sleep_for(chrono::milliseconds(20));
+  }
+
+  bool ok = true;
+  for (pid_t pid : renderers)
+  {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  printf("%s\n", ok ? "ok: no renderer saw a torn frame" : "FAILED");
+  return ok ? 0 : 1;
+}
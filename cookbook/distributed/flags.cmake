@@ -0,0 +1,4 @@
+# shm_open() is in librt before glibc 2.34 (SharedStateRing.h)
+if(${CMAKE_SYSTEM_NAME} MATCHES "Linux")
+  set(app_link_libs rt)
+endif()
@@ -0,0 +1,148 @@
+// Shows a primary's 30 states a second on a 60 Hz renderer, with network
+// jitter, by copying the newest state (as 04_state.cpp and the blob did) and
+// through StateHistory.h, and times sample() for the blob's vertices.
+//
+//   ./run.sh cookbook/distributed/history_bench.cpp
+//
+// The state is a point going around a circle at a constant speed and a
+// rotation about y at a constant rate. Packets take 1 to 6 ms, and one in
+// twenty takes 30 ms more. Smooth display moves the point the same distance
+// every frame: "stutter" is the standard deviation of the distance per
+// frame over its mean, and "error" is how far the point drawn is from the
+// circle at the time the renderer shows (less the delay).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "StateHistory.h"
+
+using namespace std;
+
+const double kPi = 3.14159265358979;
+
+// Position x y z and quaternion w x y z of the state at primary time t
+void truth(double t, float *v)
+{
+  v[0] = float(cos(t)), v[1] = 0, v[2] = float(sin(t));
+  v[3] = float(cos(t / 2)), v[4] = 0, v[5] = float(sin(t / 2)), v[6] = 0;
+}
+
+struct Arrival
+{
+  double sent, arrived;
+};
+
+struct Shown
+{
+  double stutter = 0, error = 0;
+  bool unit = true;
+};
+
+// Shows 20 s of states; history null copies the newest
+Shown show(const vector<Arrival> &arrivals, StateHistory *history, double clockOffset)
+{
+  vector<float> newest(7), v(7), ideal(7);
+  bool any = false;
+  size_t next = 0;
+  vector<double> steps;
+  double error = 0, px = 0, pz = 0;
+  Shown shown;
+  for (int frame = 0; frame < 1200; ++frame)
+  {
+    double now = 2 + frame / 60.0 + clockOffset;  // renderer's clock
+    for (; next < arrivals.size() && arrivals[next].arrived <= now; ++next)
+    {
+      truth(arrivals[next].sent, newest.data());
+      any = true;
+      if (history)
+      {
+        float *values = history->push(arrivals[next].sent, arrivals[next].arrived);
+        if (values) copy(newest.begin(), newest.end(), values);
+      }
+    }
+    if (!any) continue;
+    if (history)
+      history->sample(v.data(), now);
+    else
+      v = newest;
+
+    // Compared with where the state was when the one shown was sent, at the
+    // same delay behind
+    if (frame > 60)
+    {
+      double shownAt = atan2(v[2], v[0]);
+      double step = remainder(shownAt - atan2(pz, px), 2 * kPi);
+      steps.push_back(step);
+      truth(now - clockOffset - (history ? history->interval() : 0) - 0.0035, ideal.data());
+      error += fabs(remainder(shownAt - atan2(ideal[2], ideal[0]), 2 * kPi));
+    }
+    px = v[0], pz = v[2];
+    float length = v[3] * v[3] + v[4] * v[4] + v[5] * v[5] + v[6] * v[6];
+    shown.unit = shown.unit && fabs(length - 1) < 1e-4f;
+  }
+  double mean = 0, variance = 0;
+  for (double s : steps) mean += s / steps.size();
+  for (double s : steps) variance += (s - mean) * (s - mean) / steps.size();
+  shown.stutter = sqrt(variance) / mean;
+  shown.error = error / steps.size();
+  return shown;
+}
+
+// Milliseconds per call, over at least half a second
+template <typename F>
+double msPerCall(F f)
+{
+  int calls = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    f();
+    ++calls;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1000 / calls;
+}
+
+int main()
+{
+  // The primary's clock starts 1000 s behind the renderer's
+  const double offset = 1000;
+  mt19937 rng(3);
+  uniform_real_distribution<double> latency(0.001, 0.006);
+  vector<Arrival> arrivals;
+  for (int k = 0; k < 30 * 24; ++k)
+  {
+    double sent = k / 30.0;
+    arrivals.push_back({sent, sent + offset + latency(rng) + (rng() % 20 == 0 ? 0.03 : 0)});
+  }
+  sort(arrivals.begin(), arrivals.end(), [](const Arrival &a, const Arrival &b) { return a.arrived < b.arrived; });
+
+  StateHistory history;
+  history.resize(7);
+  history.quaternion(3);
+  Shown copied = show(arrivals, nullptr, offset), blended = show(arrivals, &history, offset);
+  printf("30 states/s shown at 60 Hz   stutter   mean error (rad)\n");
+  printf("  newest state copied       %7.3f   %7.4f\n", copied.stutter, copied.error);
+  printf("  StateHistory              %7.3f   %7.4f\n", blended.stutter, blended.error);
+  bool ok = blended.stutter < copied.stutter / 5 && blended.error < 0.01 && blended.unit;
+
+  StateHistory vertices;
+  printf("%9s %12s\n", "vertices", "sample() ms");
+  for (size_t n : {2562u, 40962u, 163842u, 655362u})
+  {
+    vertices.resize(7 + 3 * n);
+    vertices.quaternion(3);
+    for (int k = 0; k < 3; ++k) fill_n(vertices.push(k / 30.0, 1 + k / 30.0), 7 + 3 * n, float(k));
+    vector<float> out(7 + 3 * n);
+    double t = 1.05;
+    double ms = msPerCall([&]() { vertices.sample(out.data(), t += 1e-9); });
+    printf("%9zu %12.3f\n", n, ms);
+  }
+  printf("%s\n", ok ? "ok" : "STATEHISTORY NOT SMOOTHER");
+  return ok ? 0 : 1;
+}
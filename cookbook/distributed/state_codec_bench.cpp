@@ -0,0 +1,127 @@
+// Sends the blob's state (cookbook/blob/main.cpp) through StateCodec.h and
+// back, and reports bytes per frame against the whole State struct that
+// cuttlebone sends now.
+//
+//   ./run.sh cookbook/distributed/state_codec_bench.cpp
+//
+// Each run is 20 seconds at 60 frames per second of the blob's springs on an
+// icosphere, poked every 2 seconds as a key press would, with the navigation
+// pose drifting. Every packet is decoded by a renderer that gets all of
+// them, one that loses one in ten and one that joins after a second; all
+// three have to show the same positions, to within the quantization step of
+// the primary's.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../blob/Icosphere.h"
+#include "../blob/SpringMesh.h"
+#include "StateCodec.h"
+
+using namespace std;
+
+// State's members other than the positions
+struct Settings
+{
+  double pose[7];  // al::Pose: position, quaternion
+  double eyeSeparation;
+  float backgroundColor[4];
+  bool wireFrame;
+};
+
+struct Result
+{
+  double raw = 0, coded = 0, keyframes = 0;
+  unsigned frames = 0, keys = 0;
+  double encodeMs = 0, decodeMs = 0;
+  bool ok = true;
+};
+
+Result run(int levels, bool print)
+{
+  vector<Vec3> rest;
+  vector<vector<int>> nn;
+  icosphere(levels, rest, nn);
+  const unsigned n = (unsigned)rest.size();
+  SpringMesh springs;
+  springs.setNeighbors(nn);
+  springs.reset(&rest[0].x, n);
+  StealingPool pool;
+
+  Settings settings = {{0, 0, 8, 1, 0, 0, 0}, 0.03, {0.1f, 0.1f, 0.1f, 0.1f}, true};
+  vector<Vec3> p(rest), all(n), lossy(n), late(n);
+  Settings allSettings, lossySettings, lateSettings;
+  StateEncoder encoder;
+  StateDecoder allDecoder, lossyDecoder, lateDecoder;
+  mt19937 rng(levels);
+  uniform_real_distribution<float> uniformS(-1, 1);
+
+  Result result;
+  const unsigned frames = 1200;
+  for (unsigned f = 0; f < frames; ++f)
+  {
+    if (f % 120 == 0) springs.poke(rng() % n, uniformS(rng), uniformS(rng), uniformS(rng));
+    springs.step(&p[0].x, &pool);
+    settings.pose[0] += 0.001;
+    settings.pose[2] -= 0.002;
+
+    auto start = chrono::steady_clock::now();
+    auto &packet = encoder.encode(&settings, sizeof settings, &p[0].x, n);
+    auto encoded = chrono::steady_clock::now();
+    bool decoded = allDecoder.decode(packet.data(), packet.size(), &allSettings, sizeof allSettings, &all[0].x, n);
+    result.decodeMs += chrono::duration<double, milli>(chrono::steady_clock::now() - encoded).count();
+    result.encodeMs += chrono::duration<double, milli>(encoded - start).count();
+
+    result.raw += sizeof settings + sizeof(Vec3) * n;
+    result.coded += packet.size();
+    if (encoder.wasKeyframe())
+    {
+      result.keyframes += packet.size();
+      ++result.keys;
+    }
+
+    // Within half a step of the primary's positions
+    float error = 0, bound = 0;
+    const auto *header = (const statecodec::Header *)packet.data();
+    for (int a = 0; a < 3; ++a) bound = max(bound, (header->box[3 + a] - header->box[a]) / 65535);
+    for (unsigned i = 0; i < n; ++i)
+      error = max({error, fabs(all[i].x - p[i].x), fabs(all[i].y - p[i].y), fabs(all[i].z - p[i].z)});
+    bool exact = decoded && !memcmp(&allSettings, &settings, sizeof settings) && error <= bound * 0.51f;
+
+    // The others show what they decode, and nothing when they can't
+    bool lost = rng() % 10 == 0;
+    if (!lost && lossyDecoder.decode(packet.data(), packet.size(), &lossySettings, sizeof lossySettings,
+                                     &lossy[0].x, n))
+      exact = exact && !memcmp(&lossy[0], &all[0], sizeof(Vec3) * n);
+    if (f >= 60 && lateDecoder.decode(packet.data(), packet.size(), &lateSettings, sizeof lateSettings,
+                                      &late[0].x, n))
+      exact = exact && !memcmp(&late[0], &all[0], sizeof(Vec3) * n);
+    if (!exact && result.ok && print) printf("frame %u differs (error %g, step %g)\n", f, error, bound);
+    result.ok = result.ok && exact;
+  }
+  result.ok = result.ok && lateDecoder.frame() == frames;
+  result.frames = frames;
+  return result;
+}
+
+int main()
+{
+  bool ok = true;
+  printf("%9s %11s %11s %9s %11s %6s %10s %10s\n", "vertices", "raw B/frame", "coded B/frm", "ratio",
+         "keyframe B", "keys", "encode ms", "decode ms");
+  for (int levels : {4, 6, 7, 8})
+  {
+    Result r = run(levels, true);
+    unsigned n = 10 * (1u << (2 * levels)) + 2;
+    printf("%9u %11.0f %11.0f %8.1fx %11.0f %6u %10.3f %10.3f  %s\n", n, r.raw / r.frames, r.coded / r.frames,
+           r.raw / r.coded, r.keys ? r.keyframes / r.keys : 0, r.keys, r.encodeMs / r.frames,
+           r.decodeMs / r.frames, r.ok ? "ok" : "RENDERERS DIFFER");
+    ok = ok && r.ok;
+  }
+  return ok ? 0 : 1;
+}
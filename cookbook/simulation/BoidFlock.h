@@ -0,0 +1,459 @@
+#pragma once
+#ifndef BoidFlock_H
+#define BoidFlock_H
+
+// Flocking engine for large flocks: the same collision avoidance, velocity
+// matching and random hunting as flocking.cpp, but with each boid visiting
+// only the flockmates close enough to matter instead of all of them.
+//
+// Boids are stored as separate x, y, vx, vy arrays (plus an id that stays
+// with each boid, e.g. for coloring). Every step counting-sorts them into a
+// uniform grid of cutoff() sized cells, so each cell's boids are contiguous
+// and a row of three neighboring cells is one contiguous run. Each boid then
+// gathers from the runs around it: the distances and both Gaussian falloffs
+// for a whole run are evaluated 8 (AVX2) or 4 (SSE2) lanes at a time.
+//
+// The step is double-buffered: every boid's next state is computed from
+// the previous state of all of them, so boids can be updated in any order.
+// Given a StealingPool the cells are spread over its threads; each boid's
+// sums still run in the same order, so for a given seed the flock moves
+// exactly the same whatever the number of threads.
+//
+//   BoidFlock flock;
+//   StealingPool pool;
+//   flock.params = BoidFlock::scaledFor(10000);
+//   flock.resize(10000);
+//   flock.reset(seed);
+//   flock.step(dt, &pool);   // every frame, then read x, y, vx, vy
+//
+// Beyond cutoff() (three of the larger radius) the falloffs are below 1e-4
+// and are dropped. Where flocking.cpp blended velocities pair by pair, here
+// each boid moves its velocity toward the falloff-weighted average of its
+// flockmates', by at most all the way; for a lone pair it is the same blend.
+
+#include <stdint.h>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <vector>
+
+#include "StealingPool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BOIDFLOCK_SSE2 1
+#endif
+
+namespace boidflock
+{
+
+// e^x for x <= 0 as 2^k * 2^f, |f| <= 1/2, with a degree 6 polynomial for
+// 2^f (relative error about 1e-7). Inputs are clamped to -80 so the result
+// never goes denormal, which is slow. The vector versions do the same.
+inline float expNeg(float x)
+{
+	float t = std::max(x, -80.f) * 1.44269504f;
+	float k = std::nearbyint(t);
+	float f = t - k;
+	float p = 1.5403530e-4f;
+	p = p * f + 1.3333558e-3f;
+	p = p * f + 9.6181291e-3f;
+	p = p * f + 5.5504109e-2f;
+	p = p * f + 2.4022651e-1f;
+	p = p * f + 6.9314718e-1f;
+	p = p * f + 1.f;
+	return std::ldexp(p, (int)k);
+}
+
+#if defined(__AVX2__)
+inline __m256 expNeg(__m256 x)
+{
+	__m256 t = _mm256_mul_ps(_mm256_max_ps(x, _mm256_set1_ps(-80.f)), _mm256_set1_ps(1.44269504f));
+	__m256i k = _mm256_cvtps_epi32(t);
+	__m256 f = _mm256_sub_ps(t, _mm256_cvtepi32_ps(k));
+	__m256 p = _mm256_set1_ps(1.5403530e-4f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.3333558e-3f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(9.6181291e-3f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(5.5504109e-2f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(2.4022651e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(6.9314718e-1f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.f));
+	return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(p), _mm256_slli_epi32(k, 23)));
+}
+#elif defined(BOIDFLOCK_SSE2)
+inline __m128 expNeg(__m128 x)
+{
+	__m128 t = _mm_mul_ps(_mm_max_ps(x, _mm_set1_ps(-80.f)), _mm_set1_ps(1.44269504f));
+	__m128i k = _mm_cvtps_epi32(t);
+	__m128 f = _mm_sub_ps(t, _mm_cvtepi32_ps(k));
+	__m128 p = _mm_set1_ps(1.5403530e-4f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.3333558e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504109e-2f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.4022651e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.9314718e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.f));
+	return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(k, 23)));
+}
+#endif
+
+#if defined(__AVX2__)
+const unsigned kLanes = 8;
+#elif defined(BOIDFLOCK_SSE2)
+const unsigned kLanes = 4;
+#else
+const unsigned kLanes = 1;
+#endif
+
+// Counter-based random numbers, so a boid's hunting motion depends only on
+// the seed, its id and the step, not on the order boids are visited in
+inline uint64_t mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// Uniform point in the unit disc
+inline void ball(uint64_t key, float &x, float &y)
+{
+	for (uint64_t draw = 0;; ++draw)
+	{
+		uint64_t r = mix(key + draw * 0x9E3779B97F4A7C15ull);
+		x = (float)(r >> 40) * (2.f / 16777216.f) - 1.f;
+		y = (float)((r >> 16) & 0xFFFFFF) * (2.f / 16777216.f) - 1.f;
+		if (x * x + y * y <= 1.f) return;
+	}
+}
+
+} // boidflock::
+
+class BoidFlock
+{
+public:
+	struct Params
+	{
+		float pushRadius = 0.05f;    // collision avoidance
+		float pushStrength = 1.f;
+		float matchRadius = 0.125f;  // velocity matching
+		float huntUrge = 0.2f;       // random motion
+	};
+
+	// Radii scaled so that n boids in the box have as many flockmates in
+	// reach as the 32 of flocking.cpp do with the default ones
+	static Params scaledFor(unsigned n)
+	{
+		Params p;
+		float s = n > 32 ? std::sqrt(32.f / n) : 1.f;
+		p.pushRadius *= s;
+		p.matchRadius *= s;
+		return p;
+	}
+
+	Params params;
+
+	// Per-boid state, reordered by grid cell on every step
+	std::vector<float> x, y, vx, vy;
+	std::vector<uint32_t> id;
+
+	unsigned size() const { return mSize; }
+
+	// New boids start at the origin; call reset() to scatter them
+	void resize(unsigned n)
+	{
+		mSize = n;
+		// Padding so the vector loops can read whole lanes past the last boid
+		for (auto *a : {&x, &y, &vx, &vy}) a->assign(n + boidflock::kLanes, 0.f);
+		for (auto *a : {&mX, &mY, &mVx, &mVy}) a->assign(n + boidflock::kLanes, 0.f);
+		id.resize(n);
+		mId.resize(n);
+		for (unsigned i = 0; i < n; ++i) id[i] = i;
+		mCell.resize(n);
+	}
+
+	// Positions and velocities uniformly inside the unit disc
+	void reset(uint64_t seed)
+	{
+		mSeed = seed;
+		mStep = 0;
+		for (unsigned i = 0; i < mSize; ++i)
+		{
+			id[i] = i;
+			boidflock::ball(key(i, 0), x[i], y[i]);
+			boidflock::ball(key(i, 1), vx[i], vy[i]);
+		}
+	}
+
+	// Pairs are dropped beyond this distance
+	float cutoff() const { return 3.f * std::max(params.pushRadius, params.matchRadius); }
+
+	// Spread over pool's threads if given one
+	void step(float dt, StealingPool *pool = nullptr)
+	{
+		sortIntoCells();
+		prepareScratch(pool ? pool->size() : 1);
+		++mStep;
+		auto updateCell = [&](unsigned cell, unsigned thread)
+		{
+			for (unsigned i = mCellStart[cell]; i < mCellStart[cell + 1]; ++i) update(i, dt, mScratch[thread]);
+		};
+		if (pool)
+			pool->forEach(mCols * mCols, updateCell);
+		else
+			for (int cell = 0; cell < mCols * mCols; ++cell) updateCell(cell, 0);
+		x.swap(mX);
+		y.swap(mY);
+		vx.swap(mVx);
+		vy.swap(mVy);
+	}
+
+	// Pairs currently within cutoff(), found through the grid. Reorders the
+	// boids like step() does but doesn't move them.
+	uint64_t countPairs()
+	{
+		sortIntoCells();
+		prepareScratch(1);
+		uint64_t pairs = 0;
+		for (unsigned i = 0; i < mSize; ++i)
+			forEachRun(i, [&](unsigned j0, unsigned n) { pairs += falloffs(x[i], y[i], j0, n, mScratch[0]); });
+		return pairs / 2;
+	}
+
+private:
+	uint64_t key(uint32_t boid, uint64_t step) const
+	{
+		return boidflock::mix(mSeed ^ boidflock::mix(step * 0x100000001B3ull + boid));
+	}
+
+	static void bounce(float &p, float &v)
+	{
+		if (p > 1 || p < -1)
+		{
+			p = p > 0 ? 1 : -1;
+			v = -v;
+		}
+	}
+
+	// Counting sort of the boids by cell, row by row over the box [-1, 1]^2.
+	// Boids pushed outside it go into the nearest edge cell. Leaves mCell[i]
+	// the cell of (sorted) boid i.
+	void sortIntoCells()
+	{
+		// Cells at least cutoff() wide (a hair more, against rounding), so
+		// every pair within it is in neighboring cells
+		float cell = cutoff() * 1.0001f;
+		mCols = std::max(1, std::min(4096, (int)std::floor(2.f / cell)));
+		mCellScale = mCols / 2.f;
+		mCellStart.assign(mCols * mCols + 1, 0);
+		for (unsigned i = 0; i < mSize; ++i)
+		{
+			mCell[i] = cellOf(x[i], y[i]);
+			++mCellStart[mCell[i] + 1];
+		}
+		for (size_t c = 1; c < mCellStart.size(); ++c) mCellStart[c] += mCellStart[c - 1];
+		mCellFill.assign(mCellStart.begin(), mCellStart.end() - 1);
+		for (unsigned i = 0; i < mSize; ++i)
+		{
+			unsigned to = mCellFill[mCell[i]]++;
+			mX[to] = x[i];
+			mY[to] = y[i];
+			mVx[to] = vx[i];
+			mVy[to] = vy[i];
+			mId[to] = id[i];
+		}
+		x.swap(mX);
+		y.swap(mY);
+		vx.swap(mVx);
+		vy.swap(mVy);
+		id.swap(mId);
+		for (int c = 0; c < mCols * mCols; ++c)
+			for (unsigned i = mCellStart[c]; i < mCellStart[c + 1]; ++i) mCell[i] = c;
+	}
+
+	unsigned cellOf(float px, float py) const
+	{
+		int cx = std::min(mCols - 1, std::max(0, (int)((px + 1.f) * mCellScale)));
+		int cy = std::min(mCols - 1, std::max(0, (int)((py + 1.f) * mCellScale)));
+		return cy * mCols + cx;
+	}
+
+	// Per-thread falloffs of one run
+	struct Scratch
+	{
+		std::vector<float> pushX, pushY, match;
+	};
+
+	void prepareScratch(unsigned numThreads)
+	{
+		size_t longest = 0;
+		for (int c = 0; c < mCols * mCols; ++c)
+			longest = std::max(longest, (size_t)(mCellStart[c + 1] - mCellStart[c]));
+		size_t bufferSize = 3 * longest + boidflock::kLanes;
+		if (mScratch.size() < numThreads) mScratch.resize(numThreads);
+		for (auto &scratch : mScratch)
+		{
+			if (scratch.pushX.size() >= bufferSize) continue;
+			scratch.pushX.resize(bufferSize);
+			scratch.pushY.resize(bufferSize);
+			scratch.match.resize(bufferSize);
+		}
+	}
+
+	// Calls visit(j0, n) for the runs [j0, j0 + n) of boids that may be
+	// within cutoff() of boid i, leaving out i itself: the rows of three
+	// cells below, around and above its cell, in that order.
+	template <class Visit>
+	void forEachRun(unsigned i, Visit visit)
+	{
+		int c = (int)mCell[i];
+		int cx = c % mCols, cy = c / mCols;
+		for (int row = std::max(0, cy - 1); row <= std::min(mCols - 1, cy + 1); ++row)
+		{
+			int first = row * mCols + std::max(0, cx - 1);
+			int last = row * mCols + std::min(mCols - 1, cx + 1);
+			unsigned begin = mCellStart[first], end = mCellStart[last + 1];
+			if (row == cy)
+			{
+				if (begin < i) visit(begin, i - begin);
+				if (i + 1 < end) visit(i + 1, end - i - 1);
+			}
+			else if (begin < end)
+			{
+				visit(begin, end - begin);
+			}
+		}
+	}
+
+	// Next state of boid i from the previous state of all of them, into
+	// mX, mY, mVx, mVy
+	void update(unsigned i, float dt, Scratch &scratch)
+	{
+		const float xi = x[i], yi = y[i];
+		float pushX = 0, pushY = 0;
+		float weight = 0, matchVx = 0, matchVy = 0;
+		forEachRun(i, [&](unsigned j0, unsigned n)
+		{
+			falloffs(xi, yi, j0, n, scratch);
+			for (unsigned k = 0; k < n; ++k)
+			{
+				// Collision avoidance
+				pushX += scratch.pushX[k];
+				pushY += scratch.pushY[k];
+				// Velocity matching
+				float w = scratch.match[k];
+				weight += w;
+				matchVx += vx[j0 + k] * w;
+				matchVy += vy[j0 + k] * w;
+			}
+		});
+
+		float px = xi + pushX * params.pushStrength;
+		float py = yi + pushY * params.pushStrength;
+		// Toward the weighted average of the flockmates' velocities
+		float blend = 1.f / std::max(1.f, weight);
+		float nvx = vx[i] + (matchVx - weight * vx[i]) * blend;
+		float nvy = vy[i] + (matchVy - weight * vy[i]) * blend;
+
+		// Random "hunting" motion, cubed to make small jumps more frequent
+		float hx, hy;
+		boidflock::ball(key(id[i], mStep + 1), hx, hy);
+		float h = (hx * hx + hy * hy) * params.huntUrge;
+		nvx += hx * h;
+		nvy += hy * h;
+
+		// Bound boid into a box
+		bounce(px, nvx);
+		bounce(py, nvy);
+
+		mX[i] = px + nvx * dt;
+		mY[i] = py + nvy * dt;
+		mVx[i] = nvx;
+		mVy[i] = nvy;
+	}
+
+	// Push direction (unit vector times the avoidance falloff) and velocity
+	// matching weight from each of boids [j0, j0 + n) to boid (xi, yi), into
+	// scratch. Both are zero beyond cutoff(). Returns how many of the n are
+	// within it.
+	unsigned falloffs(float xi, float yi, unsigned j0, unsigned n, Scratch &scratch)
+	{
+		float *outX = scratch.pushX.data();
+		float *outY = scratch.pushY.data();
+		float *outMatch = scratch.match.data();
+		const float pushScale = -1.f / (params.pushRadius * params.pushRadius);
+		const float matchScale = -1.f / (params.matchRadius * params.matchRadius);
+		const float cutoff2 = cutoff() * cutoff();
+		const float *xs = x.data() + j0;
+		const float *ys = y.data() + j0;
+		unsigned inRange = 0;
+		unsigned k = 0;
+#if defined(__AVX2__)
+		__m256 vxi = _mm256_set1_ps(xi), vyi = _mm256_set1_ps(yi);
+		for (; k < n; k += 8)
+		{
+			__m256 dx = _mm256_sub_ps(vxi, _mm256_loadu_ps(xs + k));
+			__m256 dy = _mm256_sub_ps(vyi, _mm256_loadu_ps(ys + k));
+			__m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			__m256 in = _mm256_cmp_ps(d2, _mm256_set1_ps(cutoff2), _CMP_LT_OQ);
+			__m256 invDist = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(_mm256_max_ps(d2, _mm256_set1_ps(1e-30f))));
+			__m256 push = _mm256_mul_ps(boidflock::expNeg(_mm256_mul_ps(d2, _mm256_set1_ps(pushScale))), invDist);
+			__m256 match = _mm256_mul_ps(boidflock::expNeg(_mm256_mul_ps(d2, _mm256_set1_ps(matchScale))), _mm256_set1_ps(0.5f));
+			_mm256_storeu_ps(outX + k, _mm256_and_ps(in, _mm256_mul_ps(dx, push)));
+			_mm256_storeu_ps(outY + k, _mm256_and_ps(in, _mm256_mul_ps(dy, push)));
+			_mm256_storeu_ps(outMatch + k, _mm256_and_ps(in, match));
+			unsigned mask = (unsigned)_mm256_movemask_ps(in);
+			if (k + 8 > n) mask &= (1u << (n - k)) - 1;
+			inRange += (unsigned)std::bitset<8>(mask).count();
+		}
+#elif defined(BOIDFLOCK_SSE2)
+		__m128 vxi = _mm_set1_ps(xi), vyi = _mm_set1_ps(yi);
+		for (; k < n; k += 4)
+		{
+			__m128 dx = _mm_sub_ps(vxi, _mm_loadu_ps(xs + k));
+			__m128 dy = _mm_sub_ps(vyi, _mm_loadu_ps(ys + k));
+			__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			__m128 in = _mm_cmplt_ps(d2, _mm_set1_ps(cutoff2));
+			__m128 invDist = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(_mm_max_ps(d2, _mm_set1_ps(1e-30f))));
+			__m128 push = _mm_mul_ps(boidflock::expNeg(_mm_mul_ps(d2, _mm_set1_ps(pushScale))), invDist);
+			__m128 match = _mm_mul_ps(boidflock::expNeg(_mm_mul_ps(d2, _mm_set1_ps(matchScale))), _mm_set1_ps(0.5f));
+			_mm_storeu_ps(outX + k, _mm_and_ps(in, _mm_mul_ps(dx, push)));
+			_mm_storeu_ps(outY + k, _mm_and_ps(in, _mm_mul_ps(dy, push)));
+			_mm_storeu_ps(outMatch + k, _mm_and_ps(in, match));
+			unsigned mask = (unsigned)_mm_movemask_ps(in);
+			if (k + 4 > n) mask &= (1u << (n - k)) - 1;
+			inRange += (unsigned)std::bitset<4>(mask).count();
+		}
+#else
+		for (; k < n; ++k)
+		{
+			float dx = xi - xs[k], dy = yi - ys[k];
+			float d2 = dx * dx + dy * dy;
+			bool in = d2 < cutoff2;
+			float push = boidflock::expNeg(d2 * pushScale) / std::sqrt(std::max(d2, 1e-30f));
+			outX[k] = in ? dx * push : 0.f;
+			outY[k] = in ? dy * push : 0.f;
+			outMatch[k] = in ? boidflock::expNeg(d2 * matchScale) * 0.5f : 0.f;
+			inRange += in;
+		}
+#endif
+		return inRange;
+	}
+
+	unsigned mSize = 0;
+	uint64_t mSeed = 0;
+	uint64_t mStep = 0;
+
+	int mCols = 1;
+	float mCellScale = 0.5f;
+	std::vector<unsigned> mCell, mCellStart, mCellFill;
+
+	// Sorting targets and next state, swapped with the public arrays
+	std::vector<float> mX, mY, mVx, mVy;
+	std::vector<uint32_t> mId;
+
+	std::vector<Scratch> mScratch;
+};
+
+#endif
@@ -0,0 +1,558 @@
+#pragma once
+#ifndef NBody_H
+#define NBody_H
+
+// Gravity for many particles: any number of fixed wells, and optionally
+// every particle attracting every other, approximated with a Barnes-Hut
+// octree so a step costs O(N log N) instead of O(N^2).
+//
+// Particles are stored as separate x, y, z, vx, vy, vz arrays. With mutual
+// attraction on, each step sorts them along a Morton (Z-order) curve,
+// builds the octree over the sorted arrays, and each group of up to 64
+// neighboring particles then walks the tree once: a cell far enough away
+// (its size over its distance below theta) acts as one body at its center
+// of mass, a near one is opened. The nodes are stored depth-first with a
+// skip index, so the walk is a forward scan with no stack. The bodies it
+// collects are summed 8 (AVX2) or 4 (SSE2) at a time for each particle of
+// the group. theta = 0 opens every cell, which is direct summation.
+//
+// The integrator is leapfrog (kick, drift, kick), which is symplectic: over
+// long runs orbits neither spiral in nor fly off the way they do with Euler
+// steps. Given a StealingPool, the force walks and the kicks and drifts
+// are spread over its threads; sorting and the tree build are serial.
+//
+//   NBody bodies;
+//   StealingPool pool;
+//   bodies.wells.push_back({0, 0, 0, 0.1f});
+//   bodies.resize(n);
+//   // ...fill x, y, z, vx, vy, vz...
+//   bodies.restart();
+//   bodies.step(dt, &pool);   // every frame
+//
+// Particles are reordered by the sort, so don't rely on index i staying
+// the same particle while mutual attraction is on.
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "StealingPool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NBODY_SSE2 1
+#endif
+
+namespace nbody
+{
+
+#if defined(__AVX2__)
+const unsigned kLanes = 8;
+#elif defined(NBODY_SSE2)
+const unsigned kLanes = 4;
+#else
+const unsigned kLanes = 1;
+#endif
+
+// 1 / sqrt(x) from the hardware estimate and one Newton step, within about
+// 5e-7 of the exact value for about a third of the cost of sqrt and divide
+#if defined(__AVX2__)
+inline __m256 rsqrt(__m256 x)
+{
+	__m256 y = _mm256_rsqrt_ps(x);
+	__m256 halfXyy = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), _mm256_mul_ps(y, y));
+	return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), halfXyy));
+}
+#elif defined(NBODY_SSE2)
+inline __m128 rsqrt(__m128 x)
+{
+	__m128 y = _mm_rsqrt_ps(x);
+	__m128 halfXyy = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(y, y));
+	return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), halfXyy));
+}
+#endif
+
+// Adds to (ax, ay, az) the pull of n bodies on a particle at (px, py, pz):
+// mass * r / (|r|^2 + eps2)^(3/2), or nothing where that distance is zero.
+inline void sumPulls(float px, float py, float pz, float eps2, const float *bx, const float *by,
+                     const float *bz, const float *mass, unsigned n, float &ax, float &ay, float &az)
+{
+	unsigned k = 0;
+#if defined(__AVX2__)
+	__m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps();
+	__m256 vpx = _mm256_set1_ps(px), vpy = _mm256_set1_ps(py), vpz = _mm256_set1_ps(pz);
+	__m256 veps2 = _mm256_set1_ps(eps2);
+	for (; k + 8 <= n; k += 8)
+	{
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(bx + k), vpx);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(by + k), vpy);
+		__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(bz + k), vpz);
+		__m256 r2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+		                          _mm256_add_ps(_mm256_mul_ps(dz, dz), veps2));
+		__m256 nonzero = _mm256_cmp_ps(r2, _mm256_setzero_ps(), _CMP_GT_OQ);
+		__m256 inv = _mm256_and_ps(nonzero, rsqrt(r2));
+		__m256 s = _mm256_mul_ps(_mm256_loadu_ps(mass + k), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)));
+		sx = _mm256_add_ps(sx, _mm256_mul_ps(dx, s));
+		sy = _mm256_add_ps(sy, _mm256_mul_ps(dy, s));
+		sz = _mm256_add_ps(sz, _mm256_mul_ps(dz, s));
+	}
+	float lanes[3][8];
+	_mm256_storeu_ps(lanes[0], sx);
+	_mm256_storeu_ps(lanes[1], sy);
+	_mm256_storeu_ps(lanes[2], sz);
+#elif defined(NBODY_SSE2)
+	__m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+	__m128 vpx = _mm_set1_ps(px), vpy = _mm_set1_ps(py), vpz = _mm_set1_ps(pz);
+	__m128 veps2 = _mm_set1_ps(eps2);
+	for (; k + 4 <= n; k += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(bx + k), vpx);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(by + k), vpy);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(bz + k), vpz);
+		__m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+		                       _mm_add_ps(_mm_mul_ps(dz, dz), veps2));
+		__m128 nonzero = _mm_cmpgt_ps(r2, _mm_setzero_ps());
+		__m128 inv = _mm_and_ps(nonzero, rsqrt(r2));
+		__m128 s = _mm_mul_ps(_mm_loadu_ps(mass + k), _mm_mul_ps(inv, _mm_mul_ps(inv, inv)));
+		sx = _mm_add_ps(sx, _mm_mul_ps(dx, s));
+		sy = _mm_add_ps(sy, _mm_mul_ps(dy, s));
+		sz = _mm_add_ps(sz, _mm_mul_ps(dz, s));
+	}
+	float lanes[3][4];
+	_mm_storeu_ps(lanes[0], sx);
+	_mm_storeu_ps(lanes[1], sy);
+	_mm_storeu_ps(lanes[2], sz);
+#else
+	float lanes[3][1] = {{0}, {0}, {0}};
+#endif
+	for (unsigned lane = 0; lane < kLanes; ++lane)
+	{
+		ax += lanes[0][lane];
+		ay += lanes[1][lane];
+		az += lanes[2][lane];
+	}
+	for (; k < n; ++k)
+	{
+		float dx = bx[k] - px, dy = by[k] - py, dz = bz[k] - pz;
+		float r2 = dx * dx + dy * dy + dz * dz + eps2;
+		float inv = r2 > 0 ? 1.f / std::sqrt(r2) : 0.f;
+		float s = mass[k] * inv * inv * inv;
+		ax += dx * s;
+		ay += dy * s;
+		az += dz * s;
+	}
+}
+
+} // nbody::
+
+class NBody
+{
+public:
+	// Pulls with acceleration strength / d^2, d no less than wellMinDist
+	struct Well
+	{
+		float x, y, z;
+		float strength;
+	};
+
+	std::vector<Well> wells;
+	float wellMinDist = 0.1f;  // prevents high velocities
+
+	// Mutual attraction: each particle pulls with particleMass / (d^2 + softening^2)
+	bool mutual = false;
+	float particleMass = 1e-6f;
+	float softening = 0.01f;
+	float theta = 0.5f;  // Barnes-Hut opening angle
+
+	std::vector<float> x, y, z, vx, vy, vz;
+	std::vector<float> ax, ay, az;  // as of the last computeAccelerations()
+
+	unsigned size() const { return mSize; }
+
+	void resize(unsigned n)
+	{
+		mSize = n;
+		for (auto *a : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az}) a->assign(n, 0.f);
+		mAccelerationsValid = false;
+	}
+
+	// Call after changing positions or forces other than through step()
+	void restart() { mAccelerationsValid = false; }
+
+	void step(float dt, StealingPool *pool = nullptr)
+	{
+		if (!mAccelerationsValid) computeAccelerations(pool);
+		kickDrift(dt, pool);
+		computeAccelerations(pool);
+		kick(dt * 0.5f, pool);
+	}
+
+	// Accelerations at the current positions, into ax, ay, az
+	void computeAccelerations(StealingPool *pool = nullptr)
+	{
+		if (mutual)
+		{
+			sortAlongCurve();
+			buildTree();
+			unsigned threads = pool ? pool->size() : 1;
+			if (mLists.size() < threads) mLists.resize(threads);
+			auto group = [&](unsigned g, unsigned thread) { accelerateGroup(mNodes[mGroups[g]], mLists[thread]); };
+			if (pool)
+				pool->forEach((unsigned)mGroups.size(), group);
+			else
+				for (unsigned g = 0; g < mGroups.size(); ++g) group(g, 0);
+		}
+		else
+		{
+			std::fill(ax.begin(), ax.end(), 0.f);
+			std::fill(ay.begin(), ay.end(), 0.f);
+			std::fill(az.begin(), az.end(), 0.f);
+		}
+		forEachChunk(pool, [this](unsigned begin, unsigned end)
+		{
+			for (unsigned i = begin; i < end; ++i) addWells(i);
+		});
+		mAccelerationsValid = true;
+	}
+
+	// Nodes in the last tree built, e.g. to see how deep it got
+	size_t treeSize() const { return mNodes.size(); }
+
+private:
+	static const unsigned kChunk = 1024;  // particles per pool item
+	static const unsigned kLeafSize = 8;
+	static const unsigned kGroupSize = 64; // particles sharing one tree walk
+	static const unsigned kLevels = 21;   // Morton bits per axis
+
+	// Cell of the octree. Leaves own particles [begin, end); an internal
+	// node's children follow it, and next skips past all of them.
+	struct Node
+	{
+		float cx, cy, cz, mass;  // center of mass
+		float size2;             // squared side length
+		uint32_t next;
+		uint32_t begin, end;
+		bool leaf;
+	};
+
+	template <class Fn>
+	void forEachChunk(StealingPool *pool, Fn fn)
+	{
+		unsigned chunks = (mSize + kChunk - 1) / kChunk;
+		auto chunk = [&](unsigned c, unsigned) { fn(c * kChunk, std::min(mSize, (c + 1) * kChunk)); };
+		if (pool)
+			pool->forEach(chunks, chunk);
+		else
+			for (unsigned c = 0; c < chunks; ++c) chunk(c, 0);
+	}
+
+	void kickDrift(float dt, StealingPool *pool)
+	{
+		float half = dt * 0.5f;
+		forEachChunk(pool, [&](unsigned begin, unsigned end)
+		{
+			for (unsigned i = begin; i < end; ++i)
+			{
+				vx[i] += ax[i] * half;
+				vy[i] += ay[i] * half;
+				vz[i] += az[i] * half;
+				x[i] += vx[i] * dt;
+				y[i] += vy[i] * dt;
+				z[i] += vz[i] * dt;
+			}
+		});
+	}
+
+	void kick(float dt, StealingPool *pool)
+	{
+		forEachChunk(pool, [&](unsigned begin, unsigned end)
+		{
+			for (unsigned i = begin; i < end; ++i)
+			{
+				vx[i] += ax[i] * dt;
+				vy[i] += ay[i] * dt;
+				vz[i] += az[i] * dt;
+			}
+		});
+	}
+
+	// Pull of the wells on particle i, added to ax, ay, az
+	void addWells(unsigned i)
+	{
+		const float px = x[i], py = y[i], pz = z[i];
+		float sx = 0, sy = 0, sz = 0;
+		for (const Well &w : wells)
+		{
+			float dx = w.x - px, dy = w.y - py, dz = w.z - pz;
+			float dist = std::max(std::sqrt(dx * dx + dy * dy + dz * dz), wellMinDist);
+			float s = w.strength / (dist * dist * dist);
+			sx += dx * s;
+			sy += dy * s;
+			sz += dz * s;
+		}
+		ax[i] += sx;
+		ay[i] += sy;
+		az[i] += sz;
+	}
+
+	// What one group's particles interact with: far cells as one body each,
+	// and the particles of near leaves
+	struct Interactions
+	{
+		std::vector<float> x, y, z, mass;
+
+		void clear()
+		{
+			x.clear();
+			y.clear();
+			z.clear();
+			mass.clear();
+		}
+
+		void add(float bx, float by, float bz, float m)
+		{
+			x.push_back(bx);
+			y.push_back(by);
+			z.push_back(bz);
+			mass.push_back(m);
+		}
+
+		void add(const float *bx, const float *by, const float *bz, unsigned n, float m)
+		{
+			x.insert(x.end(), bx, bx + n);
+			y.insert(y.end(), by, by + n);
+			z.insert(z.end(), bz, bz + n);
+			mass.insert(mass.end(), n, m);
+		}
+	};
+
+	// Mutual attraction on the particles of one group (a cell of at most
+	// kGroupSize). The tree is walked once for all of them, opening cells by
+	// their distance to the group's bounding box, which is never more than
+	// the distance to any of its particles; then each particle sums over
+	// the bodies collected, several at a time. Particles exactly on top of
+	// each other (including each particle and itself) don't pull.
+	void accelerateGroup(const Node &group, Interactions &list)
+	{
+		float lo[3] = {INFINITY, INFINITY, INFINITY}, hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+		for (uint32_t i = group.begin; i < group.end; ++i)
+		{
+			lo[0] = std::min(lo[0], x[i]);
+			lo[1] = std::min(lo[1], y[i]);
+			lo[2] = std::min(lo[2], z[i]);
+			hi[0] = std::max(hi[0], x[i]);
+			hi[1] = std::max(hi[1], y[i]);
+			hi[2] = std::max(hi[2], z[i]);
+		}
+
+		list.clear();
+		const float theta2 = theta * theta;
+		uint32_t n = 0;
+		while (n < mNodes.size())
+		{
+			const Node &node = mNodes[n];
+			// Cells overlapping the group (its ancestors, itself and its
+			// descendants) always open
+			bool overlaps = node.begin < group.end && group.begin < node.end;
+			if (!overlaps)
+			{
+				float dx = node.cx - std::min(std::max(node.cx, lo[0]), hi[0]);
+				float dy = node.cy - std::min(std::max(node.cy, lo[1]), hi[1]);
+				float dz = node.cz - std::min(std::max(node.cz, lo[2]), hi[2]);
+				if (node.size2 < theta2 * (dx * dx + dy * dy + dz * dz))
+				{
+					list.add(node.cx, node.cy, node.cz, node.mass);
+					n = node.next;
+					continue;
+				}
+			}
+			if (node.leaf)
+			{
+				list.add(&x[node.begin], &y[node.begin], &z[node.begin], node.end - node.begin, particleMass);
+				n = node.next;
+			}
+			else
+			{
+				++n;
+			}
+		}
+
+		const float eps2 = softening * softening;
+		for (uint32_t i = group.begin; i < group.end; ++i)
+		{
+			float sx = 0, sy = 0, sz = 0;
+			nbody::sumPulls(x[i], y[i], z[i], eps2, list.x.data(), list.y.data(), list.z.data(),
+			                list.mass.data(), (unsigned)list.x.size(), sx, sy, sz);
+			ax[i] = sx;
+			ay[i] = sy;
+			az[i] = sz;
+		}
+	}
+
+	// Interleaves the low 21 bits of v with two zero bits after each
+	static uint64_t spread(uint64_t v)
+	{
+		v &= 0x1FFFFF;
+		v = (v | v << 32) & 0x1F00000000FFFFull;
+		v = (v | v << 16) & 0x1F0000FF0000FFull;
+		v = (v | v << 8) & 0x100F00F00F00F00Full;
+		v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+		v = (v | v << 2) & 0x1249249249249249ull;
+		return v;
+	}
+
+	// Reorders the particles by the Morton code of their position in the
+	// bounding cube, with an LSD radix sort, so every octree cell is a
+	// contiguous range
+	void sortAlongCurve()
+	{
+		float lo[3] = {INFINITY, INFINITY, INFINITY}, hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+		for (unsigned i = 0; i < mSize; ++i)
+		{
+			lo[0] = std::min(lo[0], x[i]);
+			lo[1] = std::min(lo[1], y[i]);
+			lo[2] = std::min(lo[2], z[i]);
+			hi[0] = std::max(hi[0], x[i]);
+			hi[1] = std::max(hi[1], y[i]);
+			hi[2] = std::max(hi[2], z[i]);
+		}
+		float side = std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 1e-6f});
+		mSide = side;
+
+		mCodes.resize(mSize);
+		mOrder.resize(mSize);
+		float scale = (float)(1 << kLevels) / side;
+		for (unsigned i = 0; i < mSize; ++i)
+		{
+			const uint64_t top = (1u << kLevels) - 1;
+			uint64_t qx = std::min(top, (uint64_t)((x[i] - lo[0]) * scale));
+			uint64_t qy = std::min(top, (uint64_t)((y[i] - lo[1]) * scale));
+			uint64_t qz = std::min(top, (uint64_t)((z[i] - lo[2]) * scale));
+			mCodes[i] = spread(qx) << 2 | spread(qy) << 1 | spread(qz);
+			mOrder[i] = i;
+		}
+
+		// 11 bits at a time; passes where every key has the same digit are skipped
+		mCodesTmp.resize(mSize);
+		mOrderTmp.resize(mSize);
+		std::vector<unsigned> count(2048);
+		for (unsigned shift = 0; shift < 3 * kLevels; shift += 11)
+		{
+			std::fill(count.begin(), count.end(), 0);
+			for (unsigned i = 0; i < mSize; ++i) ++count[(mCodes[i] >> shift) & 2047];
+			if (mSize == 0 || count[(mCodes[0] >> shift) & 2047] == mSize) continue;
+			unsigned sum = 0;
+			for (auto &c : count)
+			{
+				unsigned k = c;
+				c = sum;
+				sum += k;
+			}
+			for (unsigned i = 0; i < mSize; ++i)
+			{
+				unsigned to = count[(mCodes[i] >> shift) & 2047]++;
+				mCodesTmp[to] = mCodes[i];
+				mOrderTmp[to] = mOrder[i];
+			}
+			mCodes.swap(mCodesTmp);
+			mOrder.swap(mOrderTmp);
+		}
+
+		mTmp.resize(mSize);
+		for (auto *a : {&x, &y, &z, &vx, &vy, &vz})
+		{
+			for (unsigned i = 0; i < mSize; ++i) mTmp[i] = (*a)[mOrder[i]];
+			a->swap(mTmp);
+		}
+	}
+
+	void buildTree()
+	{
+		mNodes.clear();
+		mGroups.clear();
+		if (mSize > 0) build(0, mSize, 0);
+	}
+
+	// Node for sorted particles [begin, end), which share their top level
+	// octant digits. Returns its index. The biggest cells of at most
+	// kGroupSize particles are listed as groups, and so are leaves at the
+	// last level that hold more (particles sharing a Morton code), which
+	// no group would cover otherwise.
+	uint32_t build(uint32_t begin, uint32_t end, unsigned level, bool inGroup = false)
+	{
+		uint32_t index = (uint32_t)mNodes.size();
+		mNodes.emplace_back();
+		bool leaf = end - begin <= kLeafSize || level == kLevels;
+		if ((end - begin <= kGroupSize || leaf) && !inGroup)
+		{
+			mGroups.push_back(index);
+			inGroup = true;
+		}
+		float side = mSide / (float)(1u << level);
+		float cx = 0, cy = 0, cz = 0, mass = 0;
+		if (leaf)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				cx += x[i];
+				cy += y[i];
+				cz += z[i];
+			}
+			mass = particleMass * (end - begin);
+			float inv = 1.f / (end - begin);
+			cx *= inv;
+			cy *= inv;
+			cz *= inv;
+		}
+		else
+		{
+			unsigned shift = 3 * (kLevels - 1 - level);
+			uint32_t childBegin = begin;
+			while (childBegin < end)
+			{
+				unsigned digit = (mCodes[childBegin] >> shift) & 7;
+				uint32_t childEnd = (uint32_t)(std::partition_point(
+					mCodes.begin() + childBegin, mCodes.begin() + end,
+					[&](uint64_t code) { return ((code >> shift) & 7) == digit; }) - mCodes.begin());
+				uint32_t child = build(childBegin, childEnd, level + 1, inGroup);
+				const Node &c = mNodes[child];
+				cx += c.cx * c.mass;
+				cy += c.cy * c.mass;
+				cz += c.cz * c.mass;
+				mass += c.mass;
+				childBegin = childEnd;
+			}
+			float inv = mass > 0 ? 1.f / mass : 0.f;
+			cx *= inv;
+			cy *= inv;
+			cz *= inv;
+		}
+		Node &node = mNodes[index];
+		node.cx = cx;
+		node.cy = cy;
+		node.cz = cz;
+		node.mass = mass;
+		node.size2 = side * side;
+		node.next = (uint32_t)mNodes.size();
+		node.begin = begin;
+		node.end = end;
+		node.leaf = leaf;
+		return index;
+	}
+
+	unsigned mSize = 0;
+	bool mAccelerationsValid = false;
+
+	float mSide = 1;
+	std::vector<uint64_t> mCodes, mCodesTmp;
+	std::vector<uint32_t> mOrder, mOrderTmp;
+	std::vector<float> mTmp;
+	std::vector<Node> mNodes;
+	std::vector<uint32_t> mGroups;
+	std::vector<Interactions> mLists;  // per thread
+};
+
+#endif
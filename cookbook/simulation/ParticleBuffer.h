@@ -0,0 +1,176 @@
+#pragma once
+#ifndef ParticleBuffer_H
+#define ParticleBuffer_H
+
+// Vertex buffer that ParticlePool writes its vertices straight into, drawn
+// as points.
+//
+// Building a Mesh of a million points every frame means pushing every
+// position and color into its arrays and then copying them all to the GPU
+// again. ParticleBuffer keeps one GL buffer with room for three frames of
+// vertices and hands out the next third, mapped, each frame: the particles
+// are written once, into memory the driver reads from directly. A fence per
+// third makes map() wait (rarely) until the GPU has finished drawing from
+// the third it is about to reuse, so the mapping needs no other
+// synchronization.
+//
+//   ParticleBuffer points;                                    // app member
+//
+//   auto *vertices = points.map(pool.size());                 // onAnimate()
+//   pool.writeVertices(vertices, look, frame, &threads);
+//   points.unmap();
+//
+//   g.blendAdd();                                             // onDraw()
+//   points.draw(g);
+//
+// Point size and blending are taken from the current GL state. Buffers
+// mapped with GL_MAP_PERSISTENT_BIT would save the map per frame but need
+// OpenGL 4.4, which allolib doesn't require (and macOS doesn't have).
+
+#include <cstddef>
+#include <cstdint>
+
+#include "al/graphics/al_Graphics.hpp"
+#include "al/graphics/al_OpenGL.hpp"
+#include "al/graphics/al_Shader.hpp"
+
+#include "ParticlePool.h"
+
+class ParticleBuffer
+{
+public:
+	typedef ParticlePool::Vertex Vertex;
+
+	ParticleBuffer() = default;
+	ParticleBuffer(const ParticleBuffer &) = delete;
+	ParticleBuffer &operator=(const ParticleBuffer &) = delete;
+
+	// Graphics thread: room for count vertices, for unmap() and draw()
+	Vertex *map(unsigned count)
+	{
+		if (!mBuffer) create();
+		if (count > mCapacity) grow(count);
+
+		mRegion = (mRegion + 1) % kRegions;
+		if (mFences[mRegion])
+		{
+			glClientWaitSync(mFences[mRegion], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			glDeleteSync(mFences[mRegion]);
+			mFences[mRegion] = nullptr;
+		}
+		mCount = count;
+		if (!count) return nullptr;
+
+		glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+		void *vertices = glMapBufferRange(
+		    GL_ARRAY_BUFFER, GLintptr(mRegion) * mCapacity * sizeof(Vertex), GLsizeiptr(count) * sizeof(Vertex),
+		    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return (Vertex *)vertices;
+	}
+
+	void unmap()
+	{
+		if (!mCount) return;
+		glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// Graphics thread: the vertices of the last map()
+	void draw(al::Graphics &g)
+	{
+		if (!mCount) return;
+
+		g.shader(mShader);
+		mShader.use();
+		mShader.uniform("modelMatrix", g.modelMatrix());
+		mShader.uniform("viewMatrix", g.viewMatrix());
+		mShader.uniform("projMatrix", g.projMatrix());
+
+		glBindVertexArray(mVertexArray);
+		glDrawArrays(GL_POINTS, GLint(mRegion * mCapacity), mCount);
+		glBindVertexArray(0);
+		mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		// Graphics only goes back to its own shaders when the coloring mode
+		// changes, so force one
+		g.meshColor();
+		g.color(1, 1, 1, 1);
+	}
+
+private:
+	static const unsigned kRegions = 3;
+
+	void create()
+	{
+		glGenBuffers(1, &mBuffer);
+		glGenVertexArrays(1, &mVertexArray);
+		mShader.compile(vertexShader(), fragmentShader());
+	}
+
+	// Reallocates all three regions, after the GPU is done with them
+	void grow(unsigned count)
+	{
+		for (auto &fence : mFences)
+		{
+			if (!fence) continue;
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+		mCapacity = count;
+		glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+		glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(kRegions) * mCapacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+
+		glBindVertexArray(mVertexArray);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, x));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void *)offsetof(Vertex, r));
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	static const char *vertexShader()
+	{
+		return R"(
+#version 330
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 vertexColor;
+out vec4 color;
+
+void main() {
+  color = vertexColor;
+  gl_Position = projMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
+}
+)";
+	}
+
+	static const char *fragmentShader()
+	{
+		return R"(
+#version 330
+in vec4 color;
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+  fragColor = color;
+}
+)";
+	}
+
+	GLuint mBuffer = 0;
+	GLuint mVertexArray = 0;
+	GLsync mFences[kRegions] = {nullptr, nullptr, nullptr};
+	unsigned mCapacity = 0;  // vertices per region
+	unsigned mRegion = 0;
+	unsigned mCount = 0;     // vertices mapped last
+	al::ShaderProgram mShader;
+};
+
+#endif
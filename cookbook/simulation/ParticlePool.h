@@ -0,0 +1,339 @@
+#pragma once
+#ifndef ParticlePool_H
+#define ParticlePool_H
+
+// Particle storage for emitters of up to millions of particles, as in
+// particleSystem.cpp.
+//
+// Particles are stored as separate x, y, z, vx, vy, vz, ax, ay, az arrays
+// used as a ring: spawning replaces the oldest particles. step() moves all
+// of them (v += a, p += v) 8 (AVX2) or 4 (SSE2) at a time, then puts the
+// particles spawned since the last step in place of the oldest. Instead of
+// an age counter per particle, each one keeps the step it was born on.
+//
+// writeVertices() fills an array of position + RGBA8 vertices (e.g. mapped
+// GL memory, see ParticleBuffer.h) with every particle colored
+// HSV(hue, s, v): v fading with age, s random per particle and frame. The
+// vector paths make four vertices at a time. Its random numbers, like
+// spawners', come from particlepool::Random, which makes them in batches.
+//
+//   ParticlePool pool;
+//   pool.resize(1000000);
+//
+//   auto &batch = pool.spawn(5000);          // every frame: new particles,
+//   for (unsigned k = 0; k < batch.size(); ++k)
+//     batch.x[k] = ...;                      // all nine arrays
+//   pool.step(&threads);
+//   pool.writeVertices(vertices, look, frame, &threads);
+//
+// Given a StealingPool, both are split over its threads in chunks that
+// draw from their own random streams, so the result doesn't depend on the
+// number of threads.
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "StealingPool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLEPOOL_SSE2 1
+#endif
+
+namespace particlepool
+{
+
+inline uint64_t mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// Uniform random floats from 8 xorshift32 generators side by side, made 8
+// (AVX2) or 2 x 4 (SSE2) at a time. Every path draws the same sequence.
+class Random
+{
+public:
+	explicit Random(uint64_t seed)
+	{
+		for (unsigned k = 0; k < 8; ++k)
+			mState[k] = (uint32_t)mix(seed + (k + 1) * 0x9E3779B97F4A7C15ull) | 1u;
+	}
+
+	// n numbers in [lo, hi)
+	void fill(float *out, unsigned n, float lo = 0.f, float hi = 1.f)
+	{
+		const float scale = (hi - lo) * (1.f / 16777216.f);
+		unsigned k = 0;
+#if defined(__AVX2__)
+		__m256i s = _mm256_loadu_si256((const __m256i *)mState);
+		const __m256 vscale = _mm256_set1_ps(scale), vlo = _mm256_set1_ps(lo);
+		for (; k < n; k += 8)
+		{
+			s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+			s = _mm256_xor_si256(s, _mm256_srli_epi32(s, 17));
+			s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 5));
+			__m256 f = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(s, 8)), vscale), vlo);
+			if (k + 8 <= n)
+			{
+				_mm256_storeu_ps(out + k, f);
+			}
+			else
+			{
+				float last[8];
+				_mm256_storeu_ps(last, f);
+				std::copy(last, last + (n - k), out + k);
+			}
+		}
+		_mm256_storeu_si256((__m256i *)mState, s);
+#elif defined(PARTICLEPOOL_SSE2)
+		__m128i s0 = _mm_loadu_si128((const __m128i *)mState);
+		__m128i s1 = _mm_loadu_si128((const __m128i *)(mState + 4));
+		const __m128 vscale = _mm_set1_ps(scale), vlo = _mm_set1_ps(lo);
+		for (; k < n; k += 8)
+		{
+			s0 = _mm_xor_si128(s0, _mm_slli_epi32(s0, 13));
+			s0 = _mm_xor_si128(s0, _mm_srli_epi32(s0, 17));
+			s0 = _mm_xor_si128(s0, _mm_slli_epi32(s0, 5));
+			s1 = _mm_xor_si128(s1, _mm_slli_epi32(s1, 13));
+			s1 = _mm_xor_si128(s1, _mm_srli_epi32(s1, 17));
+			s1 = _mm_xor_si128(s1, _mm_slli_epi32(s1, 5));
+			float block[8];
+			_mm_storeu_ps(block, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s0, 8)), vscale), vlo));
+			_mm_storeu_ps(block + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s1, 8)), vscale), vlo));
+			std::copy(block, block + std::min(8u, n - k), out + k);
+		}
+		_mm_storeu_si128((__m128i *)mState, s0);
+		_mm_storeu_si128((__m128i *)(mState + 4), s1);
+#else
+		for (; k < n; k += 8)
+		{
+			for (unsigned lane = 0; lane < 8; ++lane)
+			{
+				uint32_t &s = mState[lane];
+				s ^= s << 13;
+				s ^= s >> 17;
+				s ^= s << 5;
+				if (k + lane < n) out[k + lane] = (float)(s >> 8) * scale + lo;
+			}
+		}
+#endif
+	}
+
+private:
+	uint32_t mState[8];
+};
+
+} // particlepool::
+
+class ParticlePool
+{
+public:
+	// Per-particle state, around a ring in spawn order
+	std::vector<float> x, y, z, vx, vy, vz, ax, ay, az;
+	std::vector<uint32_t> born;  // steps() when spawned
+
+	// Particles to spawn on the next step()
+	struct Batch
+	{
+		std::vector<float> x, y, z, vx, vy, vz, ax, ay, az;
+
+		unsigned size() const { return (unsigned)x.size(); }
+
+		void resize(unsigned n)
+		{
+			for (auto *a : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az}) a->resize(n);
+		}
+	};
+
+	// 16 bytes per vertex, positions then colors
+	struct Vertex
+	{
+		float x, y, z;
+		uint8_t r, g, b, a;
+	};
+	static_assert(sizeof(Vertex) == 16, "vertices are written four floats at a time");
+
+	// Color of each vertex: HSV(hue, s, v), with s uniform in [saturationMin,
+	// saturationMax) and v = value * (1 - age / lifetime), age in steps
+	struct Look
+	{
+		float hue = 0.6f;
+		float saturationMin = 0.f, saturationMax = 1.f;
+		float value = 0.4f;
+		float lifetime = 200.f;
+	};
+
+	// All particles unborn: at the origin, at rest, and older than any
+	// lifetime, so they are drawn black
+	void resize(unsigned n)
+	{
+		mSize = n;
+		mTap = 0;
+		for (auto *a : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az}) a->assign(n, 0.f);
+		born.assign(n, mSteps - kUnborn);
+		mBatch.resize(0);
+	}
+
+	unsigned size() const { return mSize; }
+	uint32_t steps() const { return mSteps; }
+	uint32_t age(unsigned i) const { return mSteps - born[i]; }
+
+	// Room for count new particles, to be filled in before the next step().
+	// At most size() are spawned.
+	Batch &spawn(unsigned count)
+	{
+		mBatch.resize(std::min(count, mSize));
+		return mBatch;
+	}
+
+	// Moves every particle, then replaces the oldest with the spawned batch
+	void step(StealingPool *pool = nullptr)
+	{
+		++mSteps;
+		forEachChunk(pool, [&](unsigned begin, unsigned end, unsigned)
+		{
+			integrate(x.data(), vx.data(), ax.data(), begin, end);
+			integrate(y.data(), vy.data(), ay.data(), begin, end);
+			integrate(z.data(), vz.data(), az.data(), begin, end);
+		});
+
+		for (unsigned k = 0; k < mBatch.size(); ++k)
+		{
+			x[mTap] = mBatch.x[k];
+			y[mTap] = mBatch.y[k];
+			z[mTap] = mBatch.z[k];
+			vx[mTap] = mBatch.vx[k];
+			vy[mTap] = mBatch.vy[k];
+			vz[mTap] = mBatch.vz[k];
+			ax[mTap] = mBatch.ax[k];
+			ay[mTap] = mBatch.ay[k];
+			az[mTap] = mBatch.az[k];
+			born[mTap] = mSteps;
+			if (++mTap == mSize) mTap = 0;
+		}
+		mBatch.resize(0);
+	}
+
+	// size() vertices into out. seed picks the saturations, e.g. the frame.
+	void writeVertices(Vertex *out, const Look &look, uint64_t seed, StealingPool *pool = nullptr) const
+	{
+		// With the hue fixed, each channel is v * (1 - s * k) for a k set by
+		// the hue's sector
+		float h = (look.hue - std::floor(look.hue)) * 6.f;
+		int sector = std::min(5, (int)h);
+		float f = h - sector;
+		const float ks[6][3] = {{0, 1 - f, 1}, {f, 0, 1}, {1, 0, 1 - f}, {1, f, 0}, {1 - f, 1, 0}, {0, 1, f}};
+		const float kr = ks[sector][0], kg = ks[sector][1], kb = ks[sector][2];
+		const float fade = 1.f / std::max(look.lifetime, 1.f);
+		const float brightness = 255.f * look.value;
+		const float lifetime = look.lifetime;
+
+		forEachChunk(pool, [&](unsigned begin, unsigned end, unsigned chunk)
+		{
+			particlepool::Random random(particlepool::mix(seed * 0x100000001B3ull + chunk));
+			float saturation[kChunk];
+			random.fill(saturation, end - begin, look.saturationMin, look.saturationMax);
+			unsigned i = begin;
+#if defined(__AVX2__) || defined(PARTICLEPOOL_SSE2)
+			// Four vertices at a time: colors packed into one word each, then
+			// x, y, z, color transposed into four vertices
+			const __m128 vlife = _mm_set1_ps(lifetime), vfade = _mm_set1_ps(fade), vbright = _mm_set1_ps(brightness);
+			const __m128 one = _mm_set1_ps(1.f), zero = _mm_setzero_ps(), half = _mm_set1_ps(0.5f);
+			const __m128 vkr = _mm_set1_ps(kr), vkg = _mm_set1_ps(kg), vkb = _mm_set1_ps(kb);
+			const __m128i vsteps = _mm_set1_epi32((int)mSteps), alpha = _mm_set1_epi32((int)0xFF000000u);
+			for (; i + 4 <= end; i += 4)
+			{
+				__m128i age = _mm_sub_epi32(vsteps, _mm_loadu_si128((const __m128i *)(born.data() + i)));
+				__m128 t = _mm_mul_ps(_mm_min_ps(_mm_cvtepi32_ps(age), vlife), vfade);
+				__m128 v = _mm_mul_ps(vbright, _mm_max_ps(zero, _mm_sub_ps(one, t)));
+				__m128 sv = _mm_loadu_ps(saturation + (i - begin));
+				__m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(sv, vkr))), half));
+				__m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(sv, vkg))), half));
+				__m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(sv, vkb))), half));
+				__m128i rgba = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+
+				__m128 px = _mm_loadu_ps(x.data() + i), py = _mm_loadu_ps(y.data() + i);
+				__m128 pz = _mm_loadu_ps(z.data() + i), pc = _mm_castsi128_ps(rgba);
+				_MM_TRANSPOSE4_PS(px, py, pz, pc);
+				float *o = &out[i].x;
+				_mm_storeu_ps(o, px);
+				_mm_storeu_ps(o + 4, py);
+				_mm_storeu_ps(o + 8, pz);
+				_mm_storeu_ps(o + 12, pc);
+			}
+#endif
+			for (; i < end; ++i)
+			{
+				float t = std::min((float)(int32_t)age(i), lifetime) * fade;
+				float v = brightness * std::max(0.f, 1.f - t);
+				float s = saturation[i - begin];
+				Vertex &o = out[i];
+				o.x = x[i];
+				o.y = y[i];
+				o.z = z[i];
+				o.r = (uint8_t)(v * (1.f - s * kr) + 0.5f);
+				o.g = (uint8_t)(v * (1.f - s * kg) + 0.5f);
+				o.b = (uint8_t)(v * (1.f - s * kb) + 0.5f);
+				o.a = 255;
+			}
+		});
+	}
+
+private:
+	static const unsigned kChunk = 4096;
+	static const uint32_t kUnborn = 1u << 30;
+
+	// fn(begin, end, chunk) over chunks of kChunk particles
+	template <class Fn>
+	void forEachChunk(StealingPool *pool, Fn fn) const
+	{
+		unsigned chunks = (mSize + kChunk - 1) / kChunk;
+		auto chunk = [&](unsigned c, unsigned)
+		{
+			fn(c * kChunk, std::min(mSize, (c + 1) * kChunk), c);
+		};
+		if (pool)
+			pool->forEach(chunks, chunk);
+		else
+			for (unsigned c = 0; c < chunks; ++c) chunk(c, 0);
+	}
+
+	// v += a; p += v over [begin, end) of one axis
+	static void integrate(float *p, float *v, const float *a, unsigned begin, unsigned end)
+	{
+		unsigned i = begin;
+#if defined(__AVX2__)
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 nv = _mm256_add_ps(_mm256_loadu_ps(v + i), _mm256_loadu_ps(a + i));
+			_mm256_storeu_ps(v + i, nv);
+			_mm256_storeu_ps(p + i, _mm256_add_ps(_mm256_loadu_ps(p + i), nv));
+		}
+#elif defined(PARTICLEPOOL_SSE2)
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 nv = _mm_add_ps(_mm_loadu_ps(v + i), _mm_loadu_ps(a + i));
+			_mm_storeu_ps(v + i, nv);
+			_mm_storeu_ps(p + i, _mm_add_ps(_mm_loadu_ps(p + i), nv));
+		}
+#endif
+		for (; i < end; ++i)
+		{
+			v[i] += a[i];
+			p[i] += v[i];
+		}
+	}
+
+	unsigned mSize = 0;
+	unsigned mTap = 0;      // next to be replaced, the oldest
+	uint32_t mSteps = 0;
+	Batch mBatch;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#pragma once
+#ifndef StealingPool_H
+#define StealingPool_H
+
+// Thread pool for splitting one simulation step over cores, for items
+// (e.g. grid cells) that take uneven amounts of work.
+//
+// forEach(count, fn) calls fn(item, thread) once for every item in
+// [0, count) and returns when all calls are done; thread 0 is the calling
+// thread. Each thread starts on its own contiguous share of the items and
+// takes them one at a time from the front. A thread that runs out steals
+// the back half of what is left of another's share, so a few crowded cells
+// don't leave the other threads idle.
+//
+//   StealingPool pool;                    // one thread per core
+//   pool.forEach(numCells, [&](unsigned cell, unsigned thread) { ... });
+//
+// Which thread runs which item varies from run to run, so fn must not make
+// its results depend on that (per-thread scratch space is fine).
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class StealingPool
+{
+public:
+	explicit StealingPool(unsigned numThreads = std::thread::hardware_concurrency())
+	{
+		mNumThreads = std::max(1u, numThreads);
+		mShares.reset(new Share[mNumThreads]);
+		for (unsigned thread = 1; thread < mNumThreads; ++thread)
+			mWorkers.emplace_back([this, thread]() { work(thread); });
+	}
+
+	~StealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRunning = false;
+		}
+		mWake.notify_all();
+		for (auto &worker : mWorkers) worker.join();
+	}
+
+	StealingPool(const StealingPool &) = delete;
+	StealingPool &operator=(const StealingPool &) = delete;
+
+	unsigned size() const { return mNumThreads; }
+
+	template <class Fn>
+	void forEach(unsigned count, Fn fn)
+	{
+		if (mNumThreads == 1)
+		{
+			for (unsigned item = 0; item < count; ++item) fn(item, 0u);
+			return;
+		}
+		auto call = [](void *context, unsigned item, unsigned thread) { (*(Fn *)context)(item, thread); };
+		for (unsigned thread = 0; thread < mNumThreads; ++thread)
+		{
+			uint64_t begin = (uint64_t)count * thread / mNumThreads;
+			uint64_t end = (uint64_t)count * (thread + 1) / mNumThreads;
+			mShares[thread].range.store(pack((uint32_t)begin, (uint32_t)end), std::memory_order_relaxed);
+		}
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFn = call;
+			mContext = &fn;
+			mBusy = mNumThreads - 1;
+			++mGeneration;
+		}
+		mWake.notify_all();
+
+		drain(0);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [this]() { return mBusy == 0; });
+	}
+
+private:
+	// [begin, end) of a thread's remaining items, in one word so the owner
+	// and thieves can both update it with a compare-and-swap. Padded to a
+	// cache line so owners don't slow each other down.
+	struct Share
+	{
+		std::atomic<uint64_t> range{0};
+		char padding[64 - sizeof(std::atomic<uint64_t>)];
+	};
+
+	static uint64_t pack(uint32_t begin, uint32_t end) { return (uint64_t)begin << 32 | end; }
+	static uint32_t beginOf(uint64_t range) { return (uint32_t)(range >> 32); }
+	static uint32_t endOf(uint64_t range) { return (uint32_t)range; }
+
+	void work(unsigned thread)
+	{
+		uint64_t seen = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [&]() { return !mRunning || mGeneration != seen; });
+				if (!mRunning) return;
+				seen = mGeneration;
+			}
+			drain(thread);
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				--mBusy;
+			}
+			mDone.notify_one();
+		}
+	}
+
+	// Run own items, then steal until no share has any left
+	void drain(unsigned thread)
+	{
+		while (true)
+		{
+			unsigned item;
+			while (takeFront(thread, item)) mFn(mContext, item, thread);
+			if (!steal(thread)) return;
+		}
+	}
+
+	bool takeFront(unsigned thread, unsigned &item)
+	{
+		std::atomic<uint64_t> &range = mShares[thread].range;
+		uint64_t r = range.load(std::memory_order_acquire);
+		while (beginOf(r) < endOf(r))
+		{
+			if (range.compare_exchange_weak(r, pack(beginOf(r) + 1, endOf(r)), std::memory_order_acq_rel))
+			{
+				item = beginOf(r);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Move the back half of the fullest other share into this thread's
+	// (empty) one. Thieves only ever shrink non-empty shares, so storing
+	// into our own empty one can't lose anybody's update.
+	bool steal(unsigned thread)
+	{
+		while (true)
+		{
+			unsigned victim = thread;
+			uint32_t most = 0;
+			uint64_t r = 0;
+			for (unsigned other = 0; other < mNumThreads; ++other)
+			{
+				uint64_t o = mShares[other].range.load(std::memory_order_acquire);
+				uint32_t left = endOf(o) > beginOf(o) ? endOf(o) - beginOf(o) : 0;
+				if (other != thread && left > most)
+				{
+					most = left;
+					victim = other;
+					r = o;
+				}
+			}
+			if (victim == thread) return false;
+			uint32_t take = (most + 1) / 2;
+			uint32_t split = endOf(r) - take;
+			if (mShares[victim].range.compare_exchange_strong(r, pack(beginOf(r), split), std::memory_order_acq_rel))
+			{
+				mShares[thread].range.store(pack(split, endOf(r)), std::memory_order_release);
+				return true;
+			}
+		}
+	}
+
+	unsigned mNumThreads;
+	std::unique_ptr<Share[]> mShares;
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWake, mDone;
+	bool mRunning = true;
+	uint64_t mGeneration = 0;
+	unsigned mBusy = 0;
+	void (*mFn)(void *, unsigned, unsigned) = nullptr;
+	void *mContext = nullptr;
+};
+
+#endif
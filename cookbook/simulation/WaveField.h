@@ -0,0 +1,231 @@
+#pragma once
+#ifndef WaveField_H
+#define WaveField_H
+
+// Discrete 2D wave equation on a toroidal grid, as in waveEquation.cpp,
+// for grids up to 4096 x 4096.
+//
+// The two time planes are separate arrays, and the grid is updated a band
+// of rows at a time, each row as its two edge cells (whose neighbors wrap
+// around) and an interior run evaluated 8 (AVX2) or 4 (SSE2) cells at a
+// time. Given a StealingPool the bands are spread over its threads. Rows
+// only read the current plane and write their own cells of the previous
+// one, so the result doesn't depend on the number of threads.
+//
+// step() can also fill a surface mesh in the same pass: each vertex gets
+// the current height and a normal from the same neighbors the stencil
+// reads, so no separate normal pass (or Mesh::generateNormals) is needed.
+// The surface shows the field as of the start of the step, one step behind
+// the new plane.
+//
+//   WaveField field;
+//   field.resize(1024, 1024);
+//   field.add(i, j, 0.5f);                     // a drop
+//
+//   WaveField::Surface surface;                // points into a Mesh
+//   surface.z = &mesh.vertices()[0].z;
+//   surface.normal = &mesh.normals()[0].x;
+//   surface.stride = 3;                        // floats per Vec3f
+//   surface.dx = surface.dy = 2.f / (1024 - 1);
+//   field.step(&surface, &pool);               // every frame
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "StealingPool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WAVEFIELD_SSE2 1
+#endif
+
+class WaveField
+{
+public:
+	float decay = 0.96f;    // Decay factor of waves, in (0, 1]
+	float velocity = 0.5f;  // Velocity of wave propagation, in (0, 0.5]
+
+	// Vertex heights and normals to write on each step, row by row, stride
+	// floats apart. dx and dy are the vertex spacing.
+	struct Surface
+	{
+		float *z = nullptr;
+		float *normal = nullptr;  // x, y, z
+		unsigned stride = 3;
+		float dx = 1, dy = 1;
+	};
+
+	// Zeroes both planes
+	void resize(unsigned nx, unsigned ny)
+	{
+		mNx = nx;
+		mNy = ny;
+		mCurr.assign((size_t)nx * ny, 0.f);
+		mPrev.assign((size_t)nx * ny, 0.f);
+	}
+
+	unsigned nx() const { return mNx; }
+	unsigned ny() const { return mNy; }
+
+	// Adds v at (i, j) to both planes, so it starts at rest
+	void add(unsigned i, unsigned j, float v)
+	{
+		mCurr[(size_t)j * mNx + i] += v;
+		mPrev[(size_t)j * mNx + i] += v;
+	}
+
+	// Current plane, row by row
+	const float *current() const { return mCurr.data(); }
+
+	void step(const Surface *surface = nullptr, StealingPool *pool = nullptr)
+	{
+		unsigned bands = (mNy + kBandRows - 1) / kBandRows;
+		auto band = [&](unsigned b, unsigned)
+		{
+			unsigned end = std::min(mNy, (b + 1) * kBandRows);
+			for (unsigned j = b * kBandRows; j < end; ++j) updateRow(j, surface);
+		};
+		if (pool)
+			pool->forEach(bands, band);
+		else
+			for (unsigned b = 0; b < bands; ++b) band(b, 0);
+		// The next values were written over the previous ones
+		mCurr.swap(mPrev);
+	}
+
+private:
+	static const unsigned kBandRows = 16;
+
+	void updateRow(unsigned j, const Surface *surface)
+	{
+		const unsigned nx = mNx;
+		const float *c = &mCurr[(size_t)j * nx];
+		const float *d = &mCurr[(size_t)(j != 0 ? j - 1 : mNy - 1) * nx];
+		const float *u = &mCurr[(size_t)(j != mNy - 1 ? j + 1 : 0) * nx];
+		float *p = &mPrev[(size_t)j * nx];
+
+		// Edges, whose left or right neighbor wraps around
+		updateCell(c, d, u, p, 0, nx - 1, nx > 1 ? 1 : 0);
+		if (nx > 1) updateCell(c, d, u, p, nx - 1, nx - 2, 0);
+
+		// Interior
+		unsigned i = 1;
+#if defined(__AVX2__)
+		const __m256 two = _mm256_set1_ps(2.f);
+		const __m256 vel = _mm256_set1_ps(velocity), dec = _mm256_set1_ps(decay);
+		for (; i + 8 < nx; i += 8)
+		{
+			__m256 vc = _mm256_loadu_ps(c + i);
+			__m256 vc2 = _mm256_mul_ps(two, vc);
+			__m256 lr = _mm256_add_ps(_mm256_sub_ps(_mm256_loadu_ps(c + i - 1), vc2), _mm256_loadu_ps(c + i + 1));
+			__m256 du = _mm256_add_ps(_mm256_sub_ps(_mm256_loadu_ps(d + i), vc2), _mm256_loadu_ps(u + i));
+			__m256 val = _mm256_add_ps(_mm256_sub_ps(vc2, _mm256_loadu_ps(p + i)), _mm256_mul_ps(vel, _mm256_add_ps(lr, du)));
+			_mm256_storeu_ps(p + i, _mm256_mul_ps(val, dec));
+		}
+#elif defined(WAVEFIELD_SSE2)
+		const __m128 two = _mm_set1_ps(2.f);
+		const __m128 vel = _mm_set1_ps(velocity), dec = _mm_set1_ps(decay);
+		for (; i + 4 < nx; i += 4)
+		{
+			__m128 vc = _mm_loadu_ps(c + i);
+			__m128 vc2 = _mm_mul_ps(two, vc);
+			__m128 lr = _mm_add_ps(_mm_sub_ps(_mm_loadu_ps(c + i - 1), vc2), _mm_loadu_ps(c + i + 1));
+			__m128 du = _mm_add_ps(_mm_sub_ps(_mm_loadu_ps(d + i), vc2), _mm_loadu_ps(u + i));
+			__m128 val = _mm_add_ps(_mm_sub_ps(vc2, _mm_loadu_ps(p + i)), _mm_mul_ps(vel, _mm_add_ps(lr, du)));
+			_mm_storeu_ps(p + i, _mm_mul_ps(val, dec));
+		}
+#endif
+		for (; i + 1 < nx; ++i) updateCell(c, d, u, p, i, i - 1, i + 1);
+
+		if (surface) writeSurface(*surface, j, c, d, u);
+	}
+
+	// Same arithmetic, in the same order, as the vector loops
+	void updateCell(const float *c, const float *d, const float *u, float *p, unsigned i, unsigned left,
+	                unsigned right) const
+	{
+		float vc2 = 2.f * c[i];
+		float val = (vc2 - p[i]) + velocity * ((c[left] - vc2 + c[right]) + (d[i] - vc2 + u[i]));
+		p[i] = val * decay;
+	}
+
+	// Heights and central-difference normals of row j of the current plane
+	void writeSurface(const Surface &s, unsigned j, const float *c, const float *d, const float *u) const
+	{
+		const unsigned nx = mNx;
+		const float sx = -0.5f / s.dx, sy = -0.5f / s.dy;
+		float *z = s.z ? s.z + (size_t)j * nx * s.stride : nullptr;
+		float *n = s.normal ? s.normal + (size_t)j * nx * s.stride : nullptr;
+		auto normal = [&](unsigned i, float gx, float gy)
+		{
+			float inv = 1.f / std::sqrt(gx * gx + gy * gy + 1.f);
+			float *out = n + (size_t)i * s.stride;
+			out[0] = gx * inv;
+			out[1] = gy * inv;
+			out[2] = inv;
+		};
+
+		if (z)
+			for (unsigned i = 0; i < nx; ++i) z[(size_t)i * s.stride] = c[i];
+		if (!n) return;
+
+		normal(0, (c[nx > 1 ? 1 : 0] - c[nx - 1]) * sx, (u[0] - d[0]) * sy);
+		if (nx > 1) normal(nx - 1, (c[0] - c[nx - 2]) * sx, (u[nx - 1] - d[nx - 1]) * sy);
+		unsigned i = 1;
+#if defined(__AVX2__)
+		const __m256 vsx = _mm256_set1_ps(sx), vsy = _mm256_set1_ps(sy), one = _mm256_set1_ps(1.f);
+		const __m256 half = _mm256_set1_ps(0.5f), three = _mm256_set1_ps(3.f);
+		for (; i + 8 < nx; i += 8)
+		{
+			__m256 gx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(c + i + 1), _mm256_loadu_ps(c + i - 1)), vsx);
+			__m256 gy = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(u + i), _mm256_loadu_ps(d + i)), vsy);
+			__m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy)), one);
+			// rsqrt plus one Newton step
+			__m256 inv = _mm256_rsqrt_ps(len2);
+			inv = _mm256_mul_ps(_mm256_mul_ps(half, inv), _mm256_sub_ps(three, _mm256_mul_ps(len2, _mm256_mul_ps(inv, inv))));
+			float lanes[3][8];
+			_mm256_storeu_ps(lanes[0], _mm256_mul_ps(gx, inv));
+			_mm256_storeu_ps(lanes[1], _mm256_mul_ps(gy, inv));
+			_mm256_storeu_ps(lanes[2], inv);
+			for (unsigned k = 0; k < 8; ++k)
+			{
+				float *out = n + (size_t)(i + k) * s.stride;
+				out[0] = lanes[0][k];
+				out[1] = lanes[1][k];
+				out[2] = lanes[2][k];
+			}
+		}
+#elif defined(WAVEFIELD_SSE2)
+		const __m128 vsx = _mm_set1_ps(sx), vsy = _mm_set1_ps(sy), one = _mm_set1_ps(1.f);
+		const __m128 half = _mm_set1_ps(0.5f), three = _mm_set1_ps(3.f);
+		for (; i + 4 < nx; i += 4)
+		{
+			__m128 gx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(c + i + 1), _mm_loadu_ps(c + i - 1)), vsx);
+			__m128 gy = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(u + i), _mm_loadu_ps(d + i)), vsy);
+			__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy)), one);
+			__m128 inv = _mm_rsqrt_ps(len2);
+			inv = _mm_mul_ps(_mm_mul_ps(half, inv), _mm_sub_ps(three, _mm_mul_ps(len2, _mm_mul_ps(inv, inv))));
+			float lanes[3][4];
+			_mm_storeu_ps(lanes[0], _mm_mul_ps(gx, inv));
+			_mm_storeu_ps(lanes[1], _mm_mul_ps(gy, inv));
+			_mm_storeu_ps(lanes[2], inv);
+			for (unsigned k = 0; k < 4; ++k)
+			{
+				float *out = n + (size_t)(i + k) * s.stride;
+				out[0] = lanes[0][k];
+				out[1] = lanes[1][k];
+				out[2] = lanes[2][k];
+			}
+		}
+#endif
+		for (; i + 1 < nx; ++i) normal(i, (c[i + 1] - c[i - 1]) * sx, (u[i] - d[i]) * sy);
+	}
+
+	unsigned mNx = 0, mNy = 0;
+	std::vector<float> mCurr, mPrev;
+};
+
+#endif
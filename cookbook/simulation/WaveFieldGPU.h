@@ -0,0 +1,339 @@
+#pragma once
+#ifndef WaveFieldGPU_H
+#define WaveFieldGPU_H
+
+// WaveField (WaveField.h) run entirely on the GPU.
+//
+// The field lives in two RG32F textures, red the current plane and green
+// the previous one. Each step draws one full-grid pass from one texture
+// into the other (ping-pong), with the same arithmetic as WaveField, so
+// nothing comes back to the CPU. A surface mesh can take its heights and
+// normals from texture() in its vertex shader, as waveEquation.cpp does.
+//
+//   WaveFieldGPU field;                 // app member
+//   field.resize(1024, 1024);
+//   field.add(i, j, 0.5f);              // a drop, applied by the next step
+//   field.step();                       // onAnimate(), graphics thread
+//
+//   glBindTexture(GL_TEXTURE_2D, field.texture());   // onDraw()
+//
+// add() queues values that the next step() draws as points, blended onto
+// both planes. GL objects are (re)created by step() after resize(), so
+// resize() and add() may be called before there is a context; step(),
+// texture() and read() need it current. step() leaves the framebuffer,
+// viewport, program and blend state as it found them.
+//
+// read() copies the current plane back, row by row, for checking against
+// WaveField; see wave_gpu_check.cpp.
+
+#include <cstdio>
+#include <vector>
+
+#include "al/graphics/al_OpenGL.hpp"
+
+class WaveFieldGPU
+{
+public:
+	float decay = 0.96f;    // Decay factor of waves, in (0, 1]
+	float velocity = 0.5f;  // Velocity of wave propagation, in (0, 0.5]
+
+	WaveFieldGPU() = default;
+	WaveFieldGPU(const WaveFieldGPU &) = delete;
+	WaveFieldGPU &operator=(const WaveFieldGPU &) = delete;
+
+	// Zeroes both planes (on the next step)
+	void resize(unsigned nx, unsigned ny)
+	{
+		mNx = nx;
+		mNy = ny;
+		mResized = true;
+		mAdds.clear();
+	}
+
+	unsigned nx() const { return mNx; }
+	unsigned ny() const { return mNy; }
+
+	// Adds v at (i, j) to both planes, so it starts at rest
+	void add(unsigned i, unsigned j, float v)
+	{
+		mAdds.push_back(float(i));
+		mAdds.push_back(float(j));
+		mAdds.push_back(v);
+	}
+
+	void step()
+	{
+		SavedState saved;
+		if (mResized) create();
+		if (!mNx || !mNy) return;
+
+		glBindVertexArray(mVertexArray);
+		glViewport(0, 0, mNx, mNy);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_SCISSOR_TEST);
+
+		if (!mAdds.empty())
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers[mCurrent]);
+			glUseProgram(mAddProgram);
+			glUniform2f(glGetUniformLocation(mAddProgram, "size"), float(mNx), float(mNy));
+			glBindBuffer(GL_ARRAY_BUFFER, mAddBuffer);
+			glBufferData(GL_ARRAY_BUFFER, mAdds.size() * sizeof(float), mAdds.data(), GL_STREAM_DRAW);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+			glEnable(GL_PROGRAM_POINT_SIZE);
+			glEnable(GL_BLEND);
+			glBlendEquation(GL_FUNC_ADD);
+			glBlendFunc(GL_ONE, GL_ONE);
+			glDrawArrays(GL_POINTS, 0, GLsizei(mAdds.size() / 3));
+			glDisable(GL_BLEND);
+			glDisable(GL_PROGRAM_POINT_SIZE);
+			glDisableVertexAttribArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			mAdds.clear();
+		}
+
+		// One triangle covering the grid; each fragment is one cell
+		glDisable(GL_BLEND);
+		glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers[1 - mCurrent]);
+		glUseProgram(mStepProgram);
+		glUniform1f(glGetUniformLocation(mStepProgram, "decay"), decay);
+		glUniform1f(glGetUniformLocation(mStepProgram, "velocity"), velocity);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, mTextures[mCurrent]);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		mCurrent = 1 - mCurrent;
+	}
+
+	// RG32F texture of the current (red) and previous (green) planes
+	GLuint texture() const { return mTextures[mCurrent]; }
+
+	// Current plane, row by row
+	void read(std::vector<float> &current) const
+	{
+		current.resize((size_t)mNx * mNy);
+		if (!mTextures[0]) return;
+		GLint framebuffer;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &framebuffer);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffers[mCurrent]);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, mNx, mNy, GL_RED, GL_FLOAT, current.data());
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	}
+
+private:
+	// GL state step() changes and puts back
+	struct SavedState
+	{
+		GLint framebuffer, program, vertexArray, texture, activeTexture, viewport[4];
+		GLint blendSrc, blendDst, blendSrcAlpha, blendDstAlpha, blendEquation, blendEquationAlpha;
+		GLboolean blend, depthTest, cullFace, scissorTest, programPointSize;
+
+		SavedState()
+		{
+			glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+			glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+			glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+			glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+			glActiveTexture(GL_TEXTURE0);
+			glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+			glGetIntegerv(GL_VIEWPORT, viewport);
+			glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+			glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+			glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+			glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+			glGetIntegerv(GL_BLEND_EQUATION_RGB, &blendEquation);
+			glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &blendEquationAlpha);
+			blend = glIsEnabled(GL_BLEND);
+			depthTest = glIsEnabled(GL_DEPTH_TEST);
+			cullFace = glIsEnabled(GL_CULL_FACE);
+			scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+			programPointSize = glIsEnabled(GL_PROGRAM_POINT_SIZE);
+		}
+
+		~SavedState()
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glUseProgram(program);
+			glBindVertexArray(vertexArray);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glActiveTexture(activeTexture);
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+			glBlendFuncSeparate(blendSrc, blendDst, blendSrcAlpha, blendDstAlpha);
+			glBlendEquationSeparate(blendEquation, blendEquationAlpha);
+			enable(GL_BLEND, blend);
+			enable(GL_DEPTH_TEST, depthTest);
+			enable(GL_CULL_FACE, cullFace);
+			enable(GL_SCISSOR_TEST, scissorTest);
+			enable(GL_PROGRAM_POINT_SIZE, programPointSize);
+		}
+
+		static void enable(GLenum cap, GLboolean on)
+		{
+			if (on)
+				glEnable(cap);
+			else
+				glDisable(cap);
+		}
+	};
+
+	void create()
+	{
+		mResized = false;
+		if (!mStepProgram)
+		{
+			mStepProgram = link(fullGridShader(), stepShader());
+			mAddProgram = link(addVertexShader(), addFragmentShader());
+			glUseProgram(mStepProgram);
+			glUniform1i(glGetUniformLocation(mStepProgram, "field"), 0);
+			glUseProgram(0);
+			glGenVertexArrays(1, &mVertexArray);
+			glGenBuffers(1, &mAddBuffer);
+		}
+		if (mTextures[0])
+		{
+			glDeleteFramebuffers(2, mFramebuffers);
+			glDeleteTextures(2, mTextures);
+			mTextures[0] = mTextures[1] = 0;
+		}
+		mCurrent = 0;
+		if (!mNx || !mNy) return;
+
+		GLint framebuffer;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+		std::vector<float> zeros((size_t)mNx * mNy * 2, 0.f);
+		glGenTextures(2, mTextures);
+		glGenFramebuffers(2, mFramebuffers);
+		for (int k = 0; k < 2; ++k)
+		{
+			glBindTexture(GL_TEXTURE_2D, mTextures[k]);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, mNx, mNy, 0, GL_RG, GL_FLOAT, zeros.data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffers[k]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextures[k], 0);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				fprintf(stderr, "WaveFieldGPU: RG32F framebuffer incomplete\n");
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+
+	static GLuint compile(GLenum type, const char *source)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+		GLint ok;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+		if (!ok)
+		{
+			char log[1024];
+			glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+			fprintf(stderr, "WaveFieldGPU: shader compile error\n%s\n", log);
+		}
+		return shader;
+	}
+
+	static GLuint link(const char *vertex, const char *fragment)
+	{
+		GLuint program = glCreateProgram();
+		GLuint v = compile(GL_VERTEX_SHADER, vertex), f = compile(GL_FRAGMENT_SHADER, fragment);
+		glAttachShader(program, v);
+		glAttachShader(program, f);
+		glLinkProgram(program);
+		glDeleteShader(v);
+		glDeleteShader(f);
+		GLint ok;
+		glGetProgramiv(program, GL_LINK_STATUS, &ok);
+		if (!ok)
+		{
+			char log[1024];
+			glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+			fprintf(stderr, "WaveFieldGPU: shader link error\n%s\n", log);
+		}
+		return program;
+	}
+
+	static const char *fullGridShader()
+	{
+		return R"(
+#version 330
+void main() {
+  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+	}
+
+	// Same arithmetic, in the same order, as WaveField::updateCell
+	static const char *stepShader()
+	{
+		return R"(
+#version 330
+uniform sampler2D field;
+uniform float decay;
+uniform float velocity;
+
+layout (location = 0) out vec2 next;
+
+void main() {
+  ivec2 size = textureSize(field, 0);
+  ivec2 ij = ivec2(gl_FragCoord.xy);
+  vec2 here = texelFetch(field, ij, 0).rg;
+  float l = texelFetch(field, ivec2((ij.x + size.x - 1) % size.x, ij.y), 0).r;
+  float r = texelFetch(field, ivec2((ij.x + 1) % size.x, ij.y), 0).r;
+  float d = texelFetch(field, ivec2(ij.x, (ij.y + size.y - 1) % size.y), 0).r;
+  float u = texelFetch(field, ivec2(ij.x, (ij.y + 1) % size.y), 0).r;
+  float vc2 = 2.0 * here.r;
+  float val = (vc2 - here.g) + velocity * ((l - vc2 + r) + (d - vc2 + u));
+  next = vec2(val * decay, here.r);
+}
+)";
+	}
+
+	static const char *addVertexShader()
+	{
+		return R"(
+#version 330
+uniform vec2 size;
+layout (location = 0) in vec3 cell;  // i, j, value
+out float value;
+
+void main() {
+  value = cell.z;
+  gl_Position = vec4((cell.xy + 0.5) / size * 2.0 - 1.0, 0.0, 1.0);
+  gl_PointSize = 1.0;
+}
+)";
+	}
+
+	static const char *addFragmentShader()
+	{
+		return R"(
+#version 330
+in float value;
+layout (location = 0) out vec2 added;
+
+void main() {
+  added = vec2(value);
+}
+)";
+	}
+
+	unsigned mNx = 0, mNy = 0;
+	bool mResized = false;
+	std::vector<float> mAdds;  // i, j, value of the adds for the next step
+
+	int mCurrent = 0;
+	GLuint mTextures[2] = {0, 0};
+	GLuint mFramebuffers[2] = {0, 0};
+	GLuint mStepProgram = 0, mAddProgram = 0;
+	GLuint mVertexArray = 0, mAddBuffer = 0;
+};
+
+#endif
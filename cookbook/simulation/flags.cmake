@@ -0,0 +1,4 @@
+# wave_gpu_check.cpp makes its own headless GL context through EGL
+if(${CMAKE_SYSTEM_NAME} MATCHES "Linux" AND app_name STREQUAL "wave_gpu_check")
+  set(app_link_libs EGL)
+endif()
@@ -29,21 +29,20 @@ Lance Putnam, Oct. 2014
 #include "al/math/al_Functions.hpp"
 #include "al/math/al_Random.hpp"
 
-using namespace al;
-
-// A "boid" (play on bird) is one member of a flock.
-class Boid {
- public:
-  // Each boid has a position and velocity.
-  Vec2d pos, vel;
+#include "BoidFlock.h"
 
-  // Update position based on velocity and delta time
-  void update(double dt) { pos += vel * dt; }
-};
+using namespace al;
 
 struct MyApp : public App {
-  static const int Nb = 32;  // Number of boids
-  Boid boids[Nb];
+  // A "boid" (play on bird) is one member of a flock. Each boid has a
+  // position and velocity, kept by the flock in separate arrays. Only
+  // flockmates within a few radii interact, so the flock can grow to tens of
+  // thousands of boids ('=' and '-' double and halve it), and every boid is
+  // updated from the flock's previous state, so they are spread over cores.
+  unsigned Nb = 32;  // Number of boids
+  BoidFlock flock;
+  StealingPool pool;
+  uint64_t seed = 0;
   Mesh heads, tails;
   Mesh box;
 
@@ -60,65 +59,18 @@ struct MyApp : public App {
 
   // Randomize boid positions/velocities uniformly inside unit disc
   void resetBoids() {
-    for (auto& b : boids) {
-      b.pos = rnd::ball<Vec2f>();
-      b.vel = rnd::ball<Vec2f>();
-    }
+    // Smaller radii for bigger flocks keep the flocks looking the same
+    flock.params = BoidFlock::scaledFor(Nb);
+    flock.resize(Nb);
+    flock.reset(++seed);
   }
 
   void onAnimate(double dt_ms) {
     double dt = dt_ms;
 
-    // Compute boid-boid interactions
-    for (int i = 0; i < Nb - 1; ++i) {
-      for (int j = i + 1; j < Nb; ++j) {
-        // printf("checking boids %d and %d\n", i,j);
-
-        auto ds = boids[i].pos - boids[j].pos;
-        auto dist = ds.mag();
-
-        // Collision avoidance
-        double pushRadius = 0.05;
-        double pushStrength = 1;
-        double push = exp(-al::pow2(dist / pushRadius)) * pushStrength;
-
-        auto pushVector = ds.normalized() * push;
-        boids[i].pos += pushVector;
-        boids[j].pos -= pushVector;
-
-        // Velocity matching
-        double matchRadius = 0.125;
-        double nearness = exp(-al::pow2(dist / matchRadius));
-        Vec2d veli = boids[i].vel;
-        Vec2d velj = boids[j].vel;
-
-        // Take a weighted average of velocities according to nearness
-        boids[i].vel = veli * (1 - 0.5 * nearness) + velj * (0.5 * nearness);
-        boids[j].vel = velj * (1 - 0.5 * nearness) + veli * (0.5 * nearness);
-
-        // TODO: Flock centering
-      }
-    }
-
-    // Update boid independent behaviors
-    for (auto& b : boids) {
-      // Random "hunting" motion
-      float huntUrge = 0.2f;
-      auto hunt = rnd::ball<Vec2f>();
-      // Use cubed distribution to make small jumps more frequent
-      hunt *= hunt.magSqr();
-      b.vel += hunt * huntUrge;
-
-      // Bound boid into a box
-      if (b.pos.x > 1 || b.pos.x < -1) {
-        b.pos.x = b.pos.x > 0 ? 1 : -1;
-        b.vel.x = -b.vel.x;
-      }
-      if (b.pos.y > 1 || b.pos.y < -1) {
-        b.pos.y = b.pos.y > 0 ? 1 : -1;
-        b.vel.y = -b.vel.y;
-      }
-    }
+    // Boid-boid interactions, random "hunting" motion and bounding into the
+    // box, then moving each boid by its velocity
+    flock.step(dt, &pool);
 
     // Generate meshes
     heads.reset();
@@ -127,14 +79,17 @@ struct MyApp : public App {
     tails.reset();
     tails.primitive(Mesh::LINES);
 
+    // Shorter tails for smaller radii
+    float tailLength = 0.07f * std::sqrt(flock.params.matchRadius / 0.125f);
     for (size_t i = 0; i < Nb; ++i) {
-      boids[i].update(dt);
+      Vec2f pos(flock.x[i], flock.y[i]);
+      Vec2f vel(flock.vx[i], flock.vy[i]);
 
-      heads.vertex(boids[i].pos);
-      heads.color(HSV(float(i) / Nb * 0.3f + 0.3f, 0.7f));
+      heads.vertex(pos);
+      heads.color(HSV(float(flock.id[i]) / Nb * 0.3f + 0.3f, 0.7f));
 
-      tails.vertex(boids[i].pos);
-      tails.vertex(boids[i].pos - boids[i].vel.normalized(0.07));
+      tails.vertex(pos);
+      tails.vertex(pos - vel.normalized(tailLength));
 
       tails.color(heads.colors()[i]);
       tails.color(RGB(0.5));
@@ -161,6 +116,14 @@ struct MyApp : public App {
       case 'r':
         resetBoids();
         break;
+      case '=':
+        if (Nb < 102400) Nb *= 2;
+        resetBoids();
+        break;
+      case '-':
+        if (Nb > 32) Nb /= 2;
+        resetBoids();
+        break;
     }
     return true;
   }
@@ -0,0 +1,199 @@
+// Times one flocking step with the all-pairs loop flocking.cpp used to run
+// and with the grid in BoidFlock.h, on one thread and on all cores, for
+// flocks of 32 to 100k boids. Checks that the grid finds every pair the
+// all-pairs loop would, also for pairs placed across cell boundaries, and
+// that the flock moves the same on any number of threads.
+//
+//   ./run.sh cookbook/simulation/flocking_bench.cpp
+//
+// Radii shrink with the flock (BoidFlock::scaledFor) so every size has the
+// same density of flockmates as the original 32 boids. The all-pairs loop
+// is skipped above 10k boids, where one step takes seconds.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "BoidFlock.h"
+
+using namespace std;
+
+// The interaction loop flocking.cpp used to run, on the same arrays
+void stepAllPairs(BoidFlock &f)
+{
+  const BoidFlock::Params &p = f.params;
+  unsigned n = f.size();
+  for (unsigned i = 0; i + 1 < n; ++i)
+  {
+    for (unsigned j = i + 1; j < n; ++j)
+    {
+      double dx = f.x[i] - f.x[j], dy = f.y[i] - f.y[j];
+      double dist = sqrt(dx * dx + dy * dy);
+      double push = exp(-pow(dist / p.pushRadius, 2)) * p.pushStrength;
+      double s = dist > 0 ? push / dist : 0;
+      f.x[i] += dx * s;
+      f.y[i] += dy * s;
+      f.x[j] -= dx * s;
+      f.y[j] -= dy * s;
+      double w = 0.5 * exp(-pow(dist / p.matchRadius, 2));
+      double vxi = f.vx[i], vyi = f.vy[i];
+      f.vx[i] = vxi * (1 - w) + f.vx[j] * w;
+      f.vy[i] = vyi * (1 - w) + f.vy[j] * w;
+      f.vx[j] = f.vx[j] * (1 - w) + vxi * w;
+      f.vy[j] = f.vy[j] * (1 - w) + vyi * w;
+    }
+  }
+}
+
+uint64_t countPairsAllPairs(const BoidFlock &f)
+{
+  float cutoff2 = f.cutoff() * f.cutoff();
+  uint64_t pairs = 0;
+  for (unsigned i = 0; i + 1 < f.size(); ++i)
+  {
+    for (unsigned j = i + 1; j < f.size(); ++j)
+    {
+      float dx = f.x[i] - f.x[j], dy = f.y[i] - f.y[j];
+      pairs += dx * dx + dy * dy < cutoff2;
+    }
+  }
+  return pairs;
+}
+
+// Milliseconds per call, over at least a quarter of a second
+template <typename F>
+double msPerCall(F f)
+{
+  int calls = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    f();
+    ++calls;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.25);
+  return elapsed.count() * 1000 / calls;
+}
+
+bool sameState(const BoidFlock &a, const BoidFlock &b)
+{
+  size_t bytes = a.size() * sizeof(float);
+  return memcmp(a.x.data(), b.x.data(), bytes) == 0 && memcmp(a.y.data(), b.y.data(), bytes) == 0 &&
+         memcmp(a.vx.data(), b.vx.data(), bytes) == 0 && memcmp(a.vy.data(), b.vy.data(), bytes) == 0 &&
+         a.id == b.id;
+}
+
+// 100 steps of 10k boids on 1 to 8 threads against the serial step
+bool deterministic()
+{
+  const unsigned n = 10000;
+  BoidFlock serial;
+  serial.params = BoidFlock::scaledFor(n);
+  serial.resize(n);
+  serial.reset(7);
+  for (int i = 0; i < 100; ++i) serial.step(1 / 60.f);
+
+  bool same = true;
+  for (unsigned threads : {1u, 2u, 3u, 8u})
+  {
+    StealingPool pool(threads);
+    BoidFlock flock;
+    flock.params = serial.params;
+    flock.resize(n);
+    flock.reset(7);
+    for (int i = 0; i < 100; ++i) flock.step(1 / 60.f, &pool);
+    bool match = sameState(flock, serial);
+    printf("%u threads: %s\n", threads, match ? "same as serial" : "DIFFERENT FROM SERIAL");
+    same = same && match;
+  }
+  return same;
+}
+
+// Two boids a little closer than cutoff(), slid along x, y and the diagonal
+// across the box so the pair straddles every cell boundary: the grid must
+// find the pair wherever it lies
+bool straddling()
+{
+  bool found = true;
+  for (unsigned n : {32u, 100u, 1000u, 10000u})
+  {
+    BoidFlock flock;
+    flock.params = BoidFlock::scaledFor(n);
+    flock.resize(2);
+    const float d = 0.98f * flock.cutoff();
+    const float dx[] = {d, 0, d * 0.7071f}, dy[] = {0, d, d * 0.7071f};
+    unsigned missed = 0, tried = 0;
+    for (int dir = 0; dir < 3; ++dir)
+    {
+      for (float s = -0.99f; s + d < 0.99f; s += d / 37)
+      {
+        flock.x[0] = s, flock.y[0] = s;
+        flock.x[1] = s + dx[dir], flock.y[1] = s + dy[dir];
+        missed += flock.countPairs() != 1;
+        ++tried;
+      }
+    }
+    if (missed)
+    {
+      printf("%8u: grid missed %u of %u pairs straddling cells\n", n, missed, tried);
+      found = false;
+    }
+  }
+  return found;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+  const char *path = "AVX2";
+#elif defined(BOIDFLOCK_SSE2)
+  const char *path = "SSE2";
+#else
+  const char *path = "scalar";
+#endif
+  bool same = straddling();
+  same = deterministic() && same;
+
+  StealingPool pool;
+  printf("%8s %10s %14s %14s %14s\n", "boids", "pairs", "all-pairs ms", "grid ms",
+         "threads ms");
+
+  for (unsigned n : {32u, 100u, 1000u, 10000u, 100000u})
+  {
+    BoidFlock flock;
+    flock.params = BoidFlock::scaledFor(n);
+    flock.resize(n);
+    flock.reset(1);
+    // Let the flock clump up a little before measuring
+    for (int i = 0; i < 20; ++i) flock.step(1 / 60.f);
+
+    uint64_t pairs = flock.countPairs();
+    bool allPairs = n <= 10000;
+    if (allPairs && countPairsAllPairs(flock) != pairs)
+    {
+      printf("%8u: grid found %llu pairs, all-pairs %llu\n", n,
+             (unsigned long long)pairs, (unsigned long long)countPairsAllPairs(flock));
+      same = false;
+    }
+
+    BoidFlock copy = flock;
+    double grid = msPerCall([&]() { flock.step(1 / 60.f); });
+    double threads = msPerCall([&]() { flock.step(1 / 60.f, &pool); });
+    if (allPairs)
+    {
+      double brute = msPerCall([&]() { stepAllPairs(copy); });
+      printf("%8u %10llu %14.3f %14.3f %14.3f\n", n, (unsigned long long)pairs, brute,
+             grid, threads);
+    }
+    else
+    {
+      printf("%8u %10llu %14s %14.3f %14.3f\n", n, (unsigned long long)pairs, "-", grid,
+             threads);
+    }
+  }
+  printf("grid path: %s, %u threads\n", path, pool.size());
+  return same ? 0 : 1;
+}
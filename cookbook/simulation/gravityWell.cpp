@@ -6,6 +6,9 @@ The demonstrates how to make many lightweight bodies interact with the
 gravitational pull of a single heavy body.
 
 Press the number keys to reset the particles with different initial conditions.
+Keys 7 and 8 start bigger scenes: 100k particles around three wells, and a
+galaxy of 1M particles that also attract each other. Press m to toggle mutual
+attraction between particles in any scene.
 
 Author:
 Lance Putnam, Nov. 2015
@@ -20,30 +23,21 @@ Lance Putnam, Nov. 2015
 #include <algorithm> // max
 #include <cmath>
 
+#include "NBody.h"
+
 using namespace al;
 using namespace std;
 
-// A particle with acceleration
-class Particle {
-public:
-  Vec3f pos;
-  Vec3f vel;
-  Vec3f acc;
-
-  void update(double dt) {
-    // Semi-implicit Euler method:
-    vel += acc * dt;
-    pos += vel * dt;
-  }
-};
-
 class MyApp : public App {
 public:
   static const int M = 20;
   static const int N = M * M;
-  Particle particles[N];
-  Particle well;
+  // Particles and wells, integrated with leapfrog; mutual attraction goes
+  // through a Barnes-Hut tree
+  NBody bodies;
+  StealingPool pool;
   Mesh body1, body2;
+  Mesh points; // particles of the big scenes
   Light light1, light2;
 
   void onCreate() override {
@@ -57,69 +51,116 @@ public:
     nav().faceToward(Vec3f(0, 0.7, -1));
   }
 
+  void setParticle(int i, const Vec3f &pos, const Vec3f &vel) {
+    bodies.x[i] = pos.x;
+    bodies.y[i] = pos.y;
+    bodies.z[i] = pos.z;
+    bodies.vx[i] = vel.x;
+    bodies.vy[i] = vel.y;
+    bodies.vz[i] = vel.z;
+  }
+
+  // One well of mass 1 at the origin pulling particles of mass 10
+  void singleWell() {
+    bodies.wells.assign(1, {0, 0, 0, 1. / 10});
+    bodies.mutual = false;
+    bodies.resize(N);
+  }
+
   void reset(int preset = '1') {
     switch (preset) {
     case '1': // dust cloud
-      for (auto &p : particles) {
-        p.pos = rnd::ball<Vec3f>() * 0.2 + Vec3f(-0.7, 0, 0);
-        p.vel = Vec3f(0, -0.3, 0);
+      singleWell();
+      for (int i = 0; i < N; ++i) {
+        setParticle(i, rnd::ball<Vec3f>() * 0.2 + Vec3f(-0.7, 0, 0),
+                    Vec3f(0, -0.3, 0));
       }
       break;
     case '2': // hourglass
-      for (auto &p : particles) {
-        p.pos = rnd::ball<Vec3f>().mag(1);
-        p.vel = clone(p.pos).rotate(M_PI / 2) * Vec3f(1, 1, -1) * 0.2;
+      singleWell();
+      for (int i = 0; i < N; ++i) {
+        Vec3f pos = rnd::ball<Vec3f>().mag(1);
+        setParticle(i, pos,
+                    clone(pos).rotate(M_PI / 2) * Vec3f(1, 1, -1) * 0.2);
       }
       break;
     case '3': // line orbit 1
+      singleWell();
       for (int i = 0; i < N; ++i) {
-        particles[i].pos = Vec3f(float(i) / N * 0.5 - 1, 0, 0);
-        particles[i].vel = Vec3f(0, -0.3, 0);
+        setParticle(i, Vec3f(float(i) / N * 0.5 - 1, 0, 0), Vec3f(0, -0.3, 0));
       }
       break;
     case '4': // line orbit 2
+      singleWell();
       for (int i = 0; i < N; ++i) {
         float frac = float(i) / N;
-        particles[i].pos = Vec3f(-0.8, frac, 0);
-        particles[i].vel = Vec3f(-0.1, -0.2, 0.2);
+        setParticle(i, Vec3f(-0.8, frac, 0), Vec3f(-0.1, -0.2, 0.2));
       }
       break;
     case '5': // grid formation (side)
+      singleWell();
       for (int i = 0; i < N; ++i) {
-        particles[i].pos = Vec3f(-1, float(i % M) / (M - 1) * 2 - 1,
-                                 float(i / M) / (M - 1) * 2 - 1);
-        particles[i].vel = Vec3f(0, 0, 0);
+        setParticle(i,
+                    Vec3f(-1, float(i % M) / (M - 1) * 2 - 1,
+                          float(i / M) / (M - 1) * 2 - 1),
+                    Vec3f(0, 0, 0));
       }
       break;
     case '6': // grid formation (front)
+      singleWell();
       for (int i = 0; i < N; ++i) {
-        particles[i].pos = Vec3f(float(i % M) / (M - 1) - 0.5,
-                                 float(i / M) / (M - 1) - 0.5, 1);
-        particles[i].vel = Vec3f(0.1, 0, 0);
+        setParticle(i,
+                    Vec3f(float(i % M) / (M - 1) - 0.5,
+                          float(i / M) / (M - 1) - 0.5, 1),
+                    Vec3f(0.1, 0, 0));
       }
       break;
+    case '7': // dust between three wells
+      bodies.wells = {{-0.5, 0, 0, 0.1}, {0.5, 0, 0, 0.1}, {0, 0.8, 0, 0.1}};
+      bodies.mutual = false;
+      bodies.resize(100000);
+      for (int i = 0; i < 100000; ++i) {
+        setParticle(i, rnd::ball<Vec3f>() * 1.5, rnd::ball<Vec3f>() * 0.1);
+      }
+      break;
+    case '8': { // self-gravitating galaxy around a central well
+      const int count = 1000000;
+      bodies.wells.assign(1, {0, 0, 0, 0.1});
+      bodies.mutual = true;
+      bodies.particleMass = 0.1 / count;
+      bodies.resize(count);
+      for (int i = 0; i < count; ++i) {
+        float r = 0.1 + 0.9 * sqrt(rnd::uniform());
+        float a = rnd::uniform() * 2 * M_PI;
+        float speed = sqrt(0.1 / r);
+        setParticle(i, Vec3f(r * cos(a), rnd::normal() * 0.02, r * sin(a)),
+                    Vec3f(-speed * sin(a), 0, speed * cos(a)));
+      }
+    } break;
+    case 'm':
+      bodies.mutual = !bodies.mutual;
+      break;
+    default:
+      return;
     }
+    bodies.restart();
   }
 
   void onAnimate(double dt_ms) override {
     // convert millisecond to second
     float dt = dt_ms;
 
-    // Compute forces
-    for (auto &p : particles) {
-      // Newton's law of gravity
-      auto r21 = well.pos - p.pos; // distance vector between well and particle
-      auto dist = r21.mag();       // distance between well and particle
-      dist = std::max(dist, 0.1f); // prevent high velocities
-      auto F = r21 / (dist * dist * dist); // force vector acting on particle
+    // Newton's law of gravity from the wells (and between particles when
+    // mutual), then a leapfrog step
+    bodies.step(dt, &pool);
 
-      // Newton's second law of motion, F = ma -> a = F/m
-      p.acc = F * (1. / 10); // mass of particle is 10
+    if (bodies.size() > unsigned(N)) {
+      points.primitive(Mesh::POINTS);
+      auto &verts = points.vertices();
+      verts.resize(bodies.size());
+      for (unsigned i = 0; i < bodies.size(); ++i)
+        verts[i].set(bodies.x[i], bodies.y[i], bodies.z[i]);
     }
-
-    // Update particles
-    for (auto &p : particles)
-      p.update(dt);
   }
 
   void onDraw(Graphics &g) override {
@@ -143,17 +184,28 @@ public:
     l3.diffuse({1, 0, 0});
     g.light(l3, 2);
 
-    // Draw the well
+    // Draw the wells
     g.color(HSV(0.2));
-    g.draw(body2);
+    for (auto &w : bodies.wells) {
+      g.pushMatrix();
+      g.translate(w.x, w.y, w.z);
+      g.draw(body2);
+      g.popMatrix();
+    }
 
     // Draw the particles
     g.color(HSV(0.67, 0.2, 0.5));
-    for (auto &p : particles) {
-      g.pushMatrix();
-      g.translate(p.pos);
-      g.draw(body1);
-      g.popMatrix();
+    if (bodies.size() > unsigned(N)) {
+      g.lighting(false);
+      gl::pointSize(1);
+      g.draw(points);
+    } else {
+      for (unsigned i = 0; i < bodies.size(); ++i) {
+        g.pushMatrix();
+        g.translate(bodies.x[i], bodies.y[i], bodies.z[i]);
+        g.draw(body1);
+        g.popMatrix();
+      }
     }
 
     // cout << "\rfps: " << fps() << rnd::uniform() << flush;
@@ -0,0 +1,190 @@
+// Checks the Barnes-Hut forces in NBody.h against direct summation and on
+// particles stacked on one point, and times a step for 10k to 1M mutually
+// attracting particles.
+//
+//   ./run.sh cookbook/simulation/nbody_bench.cpp
+//
+// The scene is a rotating disc around one well, like gravityWell.cpp's
+// galaxy preset. Direct summation (theta = 0) is only timed up to 20k
+// particles; beyond that it is extrapolated as N^2.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "NBody.h"
+
+using namespace std;
+
+void galaxy(NBody &bodies, unsigned n)
+{
+  mt19937 rng(1);
+  uniform_real_distribution<float> uniform(0, 1);
+  normal_distribution<float> thickness(0, 0.02f);
+  bodies.wells.assign(1, {0, 0, 0, 0.1f});
+  bodies.mutual = true;
+  bodies.particleMass = 0.1f / n;
+  bodies.resize(n);
+  for (unsigned i = 0; i < n; ++i)
+  {
+    float r = 0.1f + 0.9f * sqrt(uniform(rng));
+    float a = 6.2831853f * uniform(rng);
+    float speed = sqrt(0.1f / r);
+    bodies.x[i] = r * cos(a);
+    bodies.y[i] = thickness(rng);
+    bodies.z[i] = r * sin(a);
+    bodies.vx[i] = -speed * sin(a);
+    bodies.vz[i] = speed * cos(a);
+  }
+  bodies.restart();
+}
+
+// Milliseconds per call, over at least half a second
+template <typename F>
+double msPerCall(F f)
+{
+  int calls = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    f();
+    ++calls;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1000 / calls;
+}
+
+// Median and 99th percentile relative error of theta = 0.5 against direct
+// summation, without the well so only particle forces count
+bool accurate()
+{
+  NBody bodies;
+  galaxy(bodies, 20000);
+  bodies.wells.clear();
+  bodies.theta = 0;
+  bodies.computeAccelerations();
+  vector<float> dx = bodies.ax, dy = bodies.ay, dz = bodies.az;
+  bodies.theta = 0.5f;
+  bodies.computeAccelerations();
+
+  vector<float> errors(bodies.size());
+  for (unsigned i = 0; i < bodies.size(); ++i)
+  {
+    float ex = bodies.ax[i] - dx[i], ey = bodies.ay[i] - dy[i], ez = bodies.az[i] - dz[i];
+    float mag = sqrt(dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i]);
+    errors[i] = sqrt(ex * ex + ey * ey + ez * ez) / mag;
+  }
+  sort(errors.begin(), errors.end());
+  float median = errors[errors.size() / 2];
+  float p99 = errors[errors.size() * 99 / 100];
+  bool ok = p99 < 0.05f;
+  printf("theta 0.5 vs direct, 20k particles: median error %.2g, 99th percentile %.2g: %s\n",
+         median, p99, ok ? "ok" : "TOO LARGE");
+  return ok;
+}
+
+// 200 of 1000 particles stacked on one point, more than a group, share a
+// Morton code and end up in one leaf at the last level: their
+// accelerations must still be computed (pulled toward the others, along +x)
+bool stacked()
+{
+  NBody bodies;
+  galaxy(bodies, 1000);
+  bodies.wells.clear();
+  for (unsigned i = 0; i < 200; ++i) bodies.x[i] = -2, bodies.y[i] = bodies.z[i] = 0;
+  fill(bodies.ax.begin(), bodies.ax.end(), NAN);
+  bodies.computeAccelerations();
+  unsigned pulled = 0, finite = 0;
+  for (unsigned i = 0; i < bodies.size(); ++i)
+  {
+    finite += isfinite(bodies.ax[i]) && isfinite(bodies.ay[i]) && isfinite(bodies.az[i]);
+    pulled += bodies.x[i] == -2 && bodies.ax[i] > 0;
+  }
+  bool ok = finite == bodies.size() && pulled == 200;
+  printf("200 particles on one point: %u of 200 pulled, %u of %u computed: %s\n", pulled, finite,
+         bodies.size(), ok ? "ok" : "MISSED");
+  return ok;
+}
+
+// Largest relative energy error over 1000 steps around one well, without
+// mutual forces, for leapfrog and for the semi-implicit Euler step
+// gravityWell.cpp used to take
+void energyError()
+{
+  NBody bodies;
+  galaxy(bodies, 1000);
+  bodies.mutual = false;
+  auto energy = [&]()
+  {
+    double e = 0;
+    for (unsigned i = 0; i < bodies.size(); ++i)
+    {
+      double r = sqrt(bodies.x[i] * bodies.x[i] + bodies.y[i] * bodies.y[i] + bodies.z[i] * bodies.z[i]);
+      double v2 = bodies.vx[i] * bodies.vx[i] + bodies.vy[i] * bodies.vy[i] + bodies.vz[i] * bodies.vz[i];
+      e += 0.5 * v2 - 0.1 / r;
+    }
+    return e;
+  };
+  NBody start = bodies;
+  const float dt = 1 / 60.f;
+
+  double e0 = energy(), leapfrog = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    bodies.step(dt);
+    leapfrog = max(leapfrog, fabs(energy() / e0 - 1));
+  }
+
+  bodies = start;
+  double euler = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    bodies.computeAccelerations();
+    for (unsigned j = 0; j < bodies.size(); ++j)
+    {
+      bodies.vx[j] += bodies.ax[j] * dt;
+      bodies.vy[j] += bodies.ay[j] * dt;
+      bodies.vz[j] += bodies.az[j] * dt;
+      bodies.x[j] += bodies.vx[j] * dt;
+      bodies.y[j] += bodies.vy[j] * dt;
+      bodies.z[j] += bodies.vz[j] * dt;
+    }
+    euler = max(euler, fabs(energy() / e0 - 1));
+  }
+  printf("energy error over 1000 steps: leapfrog %.2g%%, semi-implicit Euler %.2g%%\n",
+         100 * leapfrog, 100 * euler);
+}
+
+int main()
+{
+  bool ok = accurate();
+  ok = stacked() && ok;
+  energyError();
+
+  StealingPool pool;
+  printf("%9s %10s %14s %14s\n", "particles", "tree nodes", "direct ms", "tree ms");
+  double directPerPair = 0;
+  for (unsigned n : {10000u, 20000u, 100000u, 1000000u})
+  {
+    NBody bodies;
+    galaxy(bodies, n);
+    double tree = msPerCall([&]() { bodies.step(1 / 60.f, &pool); });
+    if (n <= 20000)
+    {
+      bodies.theta = 0;
+      double direct = msPerCall([&]() { bodies.step(1 / 60.f, &pool); });
+      directPerPair = direct / (double(n) * n);
+      printf("%9u %10zu %14.1f %14.1f\n", n, bodies.treeSize(), direct, tree);
+    }
+    else
+    {
+      printf("%9u %10zu %13.0f* %14.1f\n", n, bodies.treeSize(), directPerPair * n * n, tree);
+    }
+  }
+  printf("* extrapolated; %u threads\n", pool.size());
+  return ok ? 0 : 1;
+}
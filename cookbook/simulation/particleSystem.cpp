@@ -5,93 +5,113 @@ Description:
 This demonstrates how to build a particle system with a simple fountain-like
 behavior.
 
+Particles are kept in a ParticlePool (ParticlePool.h), which moves them and
+writes their vertices straight into a ParticleBuffer (ParticleBuffer.h).
+Press '=' or '-' to double or halve the number of particles, from 8000 up
+to 8 million; each lives for 200 updates.
+
 Author(s):
 Lance Putnam, 4/25/2011
 */
 
 #include "al/app/al_App.hpp"
-#include "al/math/al_Random.hpp"
+#include "ParticleBuffer.h"
+#include "ParticlePool.h"
+#include "StealingPool.h"
 
 using namespace al;
 
-struct Particle {
-  Vec3f pos, vel, acc;
-  int age = 0;
-
-  void update(int ageInc) {
-    vel += acc;
-    pos += vel;
-    age += ageInc;
-  }
-};
-
-template <int N> struct Emitter {
-  Particle particles[N];
-  int tap = 0;
+struct Emitter {
+  ParticlePool particles;
+  unsigned perUpdate = 40;  // particles spawned per update
+  uint64_t seed = 1;
+  std::vector<float> choice, u1, u2, u3;
 
-  Emitter() {
-    for (auto &p : particles)
-      p.age = N;
+  // n particles, each living for the same number of updates
+  void resize(unsigned n) {
+    particles.resize(n);
+    perUpdate = std::max(1u, n / 200);
   }
 
-  template <int M> void update() {
-    for (auto &p : particles)
-      p.update(M);
-
-    for (int i = 0; i < M; ++i) {
-      auto &p = particles[tap];
-
+  void update(StealingPool *threads) {
+    auto &batch = particles.spawn(perUpdate);
+    unsigned n = batch.size();
+    for (auto *u : {&choice, &u1, &u2, &u3}) u->resize(n);
+    particlepool::Random random(particlepool::mix(seed + particles.steps()));
+    random.fill(choice.data(), n);
+    random.fill(u1.data(), n);
+    random.fill(u2.data(), n);
+    random.fill(u3.data(), n);
+
+    for (unsigned k = 0; k < n; ++k) {
       // fountain
-      if (rnd::prob(0.95)) {
-        p.vel.set(rnd::uniform(-0.1, -0.05), rnd::uniform(0.12, 0.14),
-                  rnd::uniform(0.01));
-        p.acc.set(0, -0.002, 0);
+      if (choice[k] < 0.95f) {
+        batch.vx[k] = -0.1f + 0.05f * u1[k];
+        batch.vy[k] = 0.12f + 0.02f * u2[k];
+        batch.vz[k] = 0.01f * u3[k];
+        batch.ay[k] = -0.002f;
 
         // spray
       } else {
-        p.vel.set(rnd::uniformS(0.01), rnd::uniformS(0.01),
-                  rnd::uniformS(0.01));
-        p.acc.set(0, 0, 0);
+        batch.vx[k] = 0.02f * u1[k] - 0.01f;
+        batch.vy[k] = 0.02f * u2[k] - 0.01f;
+        batch.vz[k] = 0.02f * u3[k] - 0.01f;
+        batch.ay[k] = 0;
       }
-      p.pos.set(4, -2, 0);
-
-      p.age = 0;
-      ++tap;
-      if (tap >= N)
-        tap = 0;
+      batch.ax[k] = batch.az[k] = 0;
+      batch.x[k] = 4;
+      batch.y[k] = -2;
+      batch.z[k] = 0;
     }
+    particles.step(threads);
   }
 
-  int size() { return N; }
+  int size() { return particles.size(); }
 };
 
 struct MyApp : public App {
-  Emitter<8000> em1;
-  Mesh mesh;
-
-  void onCreate() { nav().pullBack(16); }
+  unsigned N = 8000;
+  Emitter em1;
+  StealingPool threads;
+  ParticleBuffer points;
+  uint64_t frame = 0;
+
+  void onCreate() {
+    em1.resize(N);
+    nav().pullBack(16);
+  }
 
   void onAnimate(double dt) {
-    em1.update<40>();
-
-    mesh.reset();
-    mesh.primitive(Mesh::POINTS);
-
-    for (int i = 0; i < em1.size(); ++i) {
-      Particle &p = em1.particles[i];
-      float age = float(p.age) / em1.size();
-
-      mesh.vertex(p.pos);
-      mesh.color(HSV(0.6, rnd::uniform(), (1 - age) * 0.4));
-    }
+    em1.update(&threads);
+
+    ParticlePool::Look look;
+    look.hue = 0.6;
+    look.value = 0.4;
+    look.lifetime = float(em1.size()) / em1.perUpdate;
+    auto *vertices = points.map(em1.size());
+    if (vertices) em1.particles.writeVertices(vertices, look, ++frame, &threads);
+    points.unmap();
   }
 
   void onDraw(Graphics &g) {
     g.clear(0);
     g.blendAdd();
     gl::pointSize(6);
-    g.meshColor();
-    g.draw(mesh);
+    points.draw(g);
+  }
+
+  bool onKeyDown(const Keyboard &k) {
+    switch (k.key()) {
+      case '=':
+        if (N < 8192000) N *= 2;
+        em1.resize(N);
+        break;
+      case '-':
+        if (N > 8000) N /= 2;
+        em1.resize(N);
+        break;
+    }
+    return true;
   }
 };
 
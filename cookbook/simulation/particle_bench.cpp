@@ -0,0 +1,229 @@
+// Checks ParticlePool.h against a plain loop and times a frame of
+// particleSystem.cpp (update plus vertices) for 8000 to 4 million particles,
+// before and after.
+//
+//   ./run.sh cookbook/simulation/particle_bench.cpp
+//
+// "before" is the Emitter<N> particleSystem.cpp used to have: an array of
+// Particle structs, a random number call per value, and a mesh rebuilt from
+// a vertex and an HSV color per particle. Random numbers come from
+// std::mt19937 instead of al::rnd, and the mesh is a pair of vectors that
+// keep their capacity, like Mesh::reset(). Vertices after go to a plain
+// array, standing in for the mapped GL buffer.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "ParticlePool.h"
+
+using namespace std;
+
+// The emitter and mesh particleSystem.cpp used to have
+struct Before
+{
+  struct Vec3
+  {
+    float x, y, z;
+  };
+  struct Particle
+  {
+    Vec3 pos, vel, acc;
+    int age;
+  };
+
+  vector<Particle> particles;
+  int tap = 0;
+  mt19937 rng{1};
+  vector<Vec3> vertices;
+  vector<float> colors;  // RGBA
+
+  Before(int n) : particles(n, Particle{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, n}) {}
+
+  float uniform(float lo, float hi) { return uniform_real_distribution<float>(lo, hi)(rng); }
+
+  void frame(int m)
+  {
+    int n = (int)particles.size();
+    for (auto &p : particles)
+    {
+      p.vel.x += p.acc.x;
+      p.vel.y += p.acc.y;
+      p.vel.z += p.acc.z;
+      p.pos.x += p.vel.x;
+      p.pos.y += p.vel.y;
+      p.pos.z += p.vel.z;
+      p.age += m;
+    }
+    for (int i = 0; i < m; ++i)
+    {
+      auto &p = particles[tap];
+      if (uniform(0, 1) < 0.95f)
+      {
+        p.vel = {uniform(-0.1f, -0.05f), uniform(0.12f, 0.14f), uniform(0, 0.01f)};
+        p.acc = {0, -0.002f, 0};
+      }
+      else
+      {
+        p.vel = {uniform(-0.01f, 0.01f), uniform(-0.01f, 0.01f), uniform(-0.01f, 0.01f)};
+        p.acc = {0, 0, 0};
+      }
+      p.pos = {4, -2, 0};
+      p.age = 0;
+      if (++tap >= n) tap = 0;
+    }
+
+    vertices.clear();
+    colors.clear();
+    for (auto &p : particles)
+    {
+      float age = float(p.age) / n;
+      vertices.push_back(p.pos);
+      // HSV(0.6, s, v) to RGB, as al::Color does
+      float s = uniform(0, 1), v = (1 - age) * 0.4f;
+      float h = 0.6f * 6, f = h - 3;
+      colors.push_back(v * (1 - s));
+      colors.push_back(v * (1 - s * f));
+      colors.push_back(v);
+      colors.push_back(1);
+    }
+  }
+};
+
+// The fountain of particleSystem.cpp's Emitter
+void fountain(ParticlePool &pool, unsigned perStep, uint64_t seed, vector<float> &u)
+{
+  auto &batch = pool.spawn(perStep);
+  unsigned n = batch.size();
+  u.resize(4 * n);
+  particlepool::Random random(particlepool::mix(seed + pool.steps()));
+  random.fill(u.data(), 4 * n);
+  for (unsigned k = 0; k < n; ++k)
+  {
+    const float *r = &u[4 * k];
+    bool up = r[0] < 0.95f;
+    batch.x[k] = 4;
+    batch.y[k] = -2;
+    batch.z[k] = 0;
+    batch.vx[k] = up ? -0.1f + 0.05f * r[1] : 0.02f * r[1] - 0.01f;
+    batch.vy[k] = up ? 0.12f + 0.02f * r[2] : 0.02f * r[2] - 0.01f;
+    batch.vz[k] = up ? 0.01f * r[3] : 0.02f * r[3] - 0.01f;
+    batch.ax[k] = batch.az[k] = 0;
+    batch.ay[k] = up ? -0.002f : 0;
+  }
+}
+
+// Moves and spawns like a plain loop would, and the vertices don't depend
+// on the number of threads
+bool same()
+{
+  const unsigned n = 10007, perStep = 50;
+  ParticlePool pool;
+  pool.resize(n);
+  vector<float> x(n), y(n), z(n), vx(n), vy(n), vz(n), ax(n), ay(n), az(n), u;
+  unsigned tap = 0;
+  bool moves = true;
+  for (int s = 0; s < 300; ++s)
+  {
+    fountain(pool, perStep, 7, u);
+    auto batch = pool.spawn(perStep);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      vx[i] += ax[i], vy[i] += ay[i], vz[i] += az[i];
+      x[i] += vx[i], y[i] += vy[i], z[i] += vz[i];
+    }
+    for (unsigned k = 0; k < batch.size(); ++k, tap = (tap + 1) % n)
+    {
+      x[tap] = batch.x[k], y[tap] = batch.y[k], z[tap] = batch.z[k];
+      vx[tap] = batch.vx[k], vy[tap] = batch.vy[k], vz[tap] = batch.vz[k];
+      ax[tap] = batch.ax[k], ay[tap] = batch.ay[k], az[tap] = batch.az[k];
+    }
+    pool.step();
+  }
+  for (unsigned i = 0; i < n; ++i)
+    moves = moves && x[i] == pool.x[i] && y[i] == pool.y[i] && z[i] == pool.z[i] && vx[i] == pool.vx[i] &&
+            vy[i] == pool.vy[i] && vz[i] == pool.vz[i];
+
+  ParticlePool::Look look;
+  look.lifetime = float(n) / perStep;
+  vector<ParticlePool::Vertex> serial(n), threaded(n);
+  StealingPool threads(3);
+  pool.writeVertices(serial.data(), look, 5);
+  pool.writeVertices(threaded.data(), look, 5, &threads);
+  bool colors = memcmp(serial.data(), threaded.data(), n * sizeof(ParticlePool::Vertex)) == 0;
+
+  vector<float> r(1000003);
+  particlepool::Random random(3);
+  random.fill(r.data(), (unsigned)r.size());
+  double mean = 0;
+  bool inRange = true;
+  for (float v : r)
+  {
+    mean += v;
+    inRange = inRange && v >= 0 && v < 1;
+  }
+  mean /= r.size();
+  bool uniform = inRange && fabs(mean - 0.5) < 0.002;
+
+  printf("300 steps of %u particles: motion %s, vertices %s with 3 threads, random mean %.4f %s\n", n,
+         moves ? "same as plain loop" : "DIFFERS", colors ? "same" : "DIFFER", mean,
+         uniform ? "ok" : "BAD");
+  return moves && colors && uniform;
+}
+
+// Milliseconds per call, over at least half a second
+template <typename F>
+double msPerCall(F f)
+{
+  int calls = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    f();
+    ++calls;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1000 / calls;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+  const char *path = "AVX2";
+#elif defined(PARTICLEPOOL_SSE2)
+  const char *path = "SSE2";
+#else
+  const char *path = "scalar";
+#endif
+  bool ok = same();
+
+  StealingPool threads;
+  printf("%9s %11s %11s %14s\n", "particles", "before ms", "after ms", "after ns/each");
+  for (unsigned n : {8000u, 100000u, 1000000u, 4000000u})
+  {
+    unsigned perStep = max(1u, n / 200);
+    Before before(n);
+    double old = msPerCall([&]() { before.frame(perStep); });
+
+    ParticlePool pool;
+    pool.resize(n);
+    ParticlePool::Look look;
+    look.lifetime = float(n) / perStep;
+    vector<ParticlePool::Vertex> vertices(n);
+    vector<float> u;
+    uint64_t frame = 0;
+    double now = msPerCall([&]()
+    {
+      fountain(pool, perStep, 1, u);
+      pool.step(&threads);
+      pool.writeVertices(vertices.data(), look, ++frame, &threads);
+    });
+    printf("%9u %11.2f %11.2f %14.2f\n", n, old, now, now * 1e6 / n);
+  }
+  printf("path: %s, %u threads\n", path, threads.size());
+  return ok ? 0 : 1;
+}
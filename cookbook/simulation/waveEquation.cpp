@@ -17,6 +17,15 @@ The simulation adds random Gaussian-shaped drops to simulate water droplets
 falling into a pool. A minor artifact is increased rippling along the wavefronts
 in the x and y directions.
 
+The grid is updated by WaveField (WaveField.h), which also writes the mesh
+heights and normals. Press '=' or '-' to double or halve the grid size,
+from 64 x 64 up to 4096 x 4096.
+
+Press 'g' to switch to WaveFieldGPU (WaveFieldGPU.h), which runs the same
+update in float textures on the GPU; the mesh then stays flat and is
+displaced by its vertex shader, so nothing is sent each frame. Switching
+restarts the pool.
+
 See also: http://locklessinc.com/articles/wave_eqn/
 
 Author:
@@ -26,24 +35,75 @@ Lance Putnam, Oct. 2014
 #include "al/app/al_App.hpp"
 #include "al/graphics/al_Shapes.hpp"
 #include "al/math/al_Random.hpp"
+#include "StealingPool.h"
+#include "WaveField.h"
+#include "WaveFieldGPU.h"
 using namespace al;
 
-struct MyApp : public App {
-  static const int Nx = 256, Ny = Nx;
-  float wave[Nx * Ny * 2];  // Values of wave for current and previous time step
-  int zcurr = 0;            // The current "plane" coordinate representing time
-  float decay = 0.96f;      // Decay factor of waves, in (0, 1]
-  float velocity = 0.5f;    // Velocity of wave propagation, in (0, 0.5]
+// Surface for WaveFieldGPU: heights and normals from the field texture, at
+// each vertex's grid cell (addSurface() lays them out row by row)
+const std::string surface_vert = R"(
+#version 330
+uniform mat4 al_ModelViewMatrix;
+uniform mat4 al_ProjectionMatrix;
+uniform sampler2D field;
+uniform vec2 spacing;
+
+layout (location = 0) in vec3 position;
+
+out vec3 normal;
+out vec3 eye;
+
+float at(ivec2 ij, ivec2 size) {
+  return texelFetch(field, (ij + size) % size, 0).r;
+}
+
+void main() {
+  ivec2 size = textureSize(field, 0);
+  ivec2 ij = ivec2(gl_VertexID % size.x, gl_VertexID / size.x);
+  float gx = -(at(ij + ivec2(1, 0), size) - at(ij - ivec2(1, 0), size)) * 0.5 / spacing.x;
+  float gy = -(at(ij + ivec2(0, 1), size) - at(ij - ivec2(0, 1), size)) * 0.5 / spacing.y;
+  vec4 p = al_ModelViewMatrix * vec4(position.xy, at(ij, size), 1.0);
+  normal = mat3(al_ModelViewMatrix) * vec3(gx, gy, 1.0);
+  eye = p.xyz;
+  gl_Position = al_ProjectionMatrix * p;
+}
+)";
+
+const std::string surface_frag = R"(
+#version 330
+uniform vec3 color;
+uniform vec3 lightDir;
+uniform float shininess;
+
+in vec3 normal;
+in vec3 eye;
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+  vec3 n = normalize(normal);
+  vec3 l = normalize(lightDir);
+  float diffuse = max(dot(n, l), 0.0);
+  float specular = pow(max(dot(reflect(-l, n), normalize(-eye)), 0.0), shininess);
+  fragColor = vec4(color * (0.2 + 0.8 * diffuse) + vec3(specular), 1.0);
+}
+)";
 
-  Mesh mesh;
+struct MyApp : public App {
+  int Nx = 256, Ny = Nx;
+  WaveField field;  // Values of wave for current and previous time step
+  StealingPool pool;
+  WaveFieldGPU gpuField;
+  bool onGPU = false;
+
+  VAOMesh mesh;
+  ShaderProgram surfaceShader;
   Light light;
   Material mtrl;
 
   void onCreate() {
-    for (auto& v : wave) v = 0;
-
-    // Add a tessellated plane
-    addSurface(mesh, Nx, Ny);
+    resetGrid();
+    surfaceShader.compile(surface_vert, surface_frag);
 
     nav().pullBack(4);
 
@@ -52,14 +112,25 @@ struct MyApp : public App {
     mtrl.shininess(30);
   }
 
-  int indexAt(int x, int y, int z) {
-    // return (z*Nx + y)*Ny + x;
-    return (y * Nx + x) * 2 + z;  // may give slightly faster accessing
+  void resetGrid() {
+    field.resize(onGPU ? 0 : Nx, onGPU ? 0 : Ny);
+    gpuField.resize(onGPU ? Nx : 0, onGPU ? Ny : 0);
+
+    // Add a tessellated plane, with normals for the field to write into
+    mesh.reset();
+    addSurface(mesh, Nx, Ny);
+    mesh.normals().resize(mesh.vertices().size());
+    mesh.update();
   }
 
-  void onAnimate(double /*dt*/) {
-    int zprev = 1 - zcurr;
+  void add(int i, int j, float v) {
+    if (onGPU)
+      gpuField.add(i, j, v);
+    else
+      field.add(i, j, v);
+  }
 
+  void onAnimate(double /*dt*/) {
     // Add some random droplets
     for (int k = 0; k < 3; ++k) {
       if (rnd::prob(0.01)) {
@@ -71,55 +142,70 @@ struct MyApp : public App {
             float x = float(i) / 4;
             float y = float(j) / 4;
             float v = 0.5 * exp(-(x * x + y * y) / (0.5 * 0.5));
-            wave[indexAt(ix + i, iy + j, zcurr)] += v;
-            wave[indexAt(ix + i, iy + j, zprev)] += v;
+            add(ix + i, iy + j, v);
           }
         }
       }
     }
 
-    // Update wave equation
-    for (int j = 0; j < Ny; ++j) {
-      for (int i = 0; i < Nx; ++i) {
-        // Neighbor indices; wrap toroidally
-        int im1 = i != 0 ? i - 1 : Nx - 1;
-        int ip1 = i != Nx - 1 ? i + 1 : 0;
-        int jm1 = j != 0 ? j - 1 : Ny - 1;
-        int jp1 = j != Nx - 1 ? j + 1 : 0;
-
-        // Get neighborhood of samples
-        auto vp = wave[indexAt(i, j, zprev)];    // previous value
-        auto vc = wave[indexAt(i, j, zcurr)];    // current value
-        auto vl = wave[indexAt(im1, j, zcurr)];  // neighbor left
-        auto vr = wave[indexAt(ip1, j, zcurr)];  // neighbor right
-        auto vd = wave[indexAt(i, jm1, zcurr)];  // neighbor up
-        auto vu = wave[indexAt(i, jp1, zcurr)];  // neighbor down
-
-        // Compute next value of wave equation at (i,j)
-        auto val =
-            2 * vc - vp + velocity * ((vl - 2 * vc + vr) + (vd - 2 * vc + vu));
-
-        // Store in previous value since we don't need it again
-        wave[indexAt(i, j, zprev)] = val * decay;
-
-        int idx = j * Nx + i;
-        mesh.vertices()[idx].z = val;
-      }
+    if (onGPU) {
+      gpuField.step();
+      return;
     }
 
-    mesh.generateNormals();
-
-    zcurr = zprev;
+    // Update wave equation, writing heights and normals into the mesh
+    WaveField::Surface surface;
+    surface.z = &mesh.vertices()[0].z;
+    surface.normal = &mesh.normals()[0].x;
+    surface.stride = 3;
+    surface.dx = 2.f / (Nx - 1);
+    surface.dy = 2.f / (Ny - 1);
+    field.step(&surface, &pool);
+    mesh.update();
   }
 
   void onDraw(Graphics& g) {
     g.clear(0);
+    if (onGPU) {
+      Color tint = HSV(0.6, 0.2, 0.9);
+      g.shader(surfaceShader);
+      g.shader().uniform("field", 0);
+      g.shader().uniform("spacing", 2.f / (Nx - 1), 2.f / (Ny - 1));
+      g.shader().uniform("color", tint.r, tint.g, tint.b);
+      g.shader().uniform("lightDir", 1.f, 1.f, 1.f);
+      g.shader().uniform("shininess", 30.f);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, gpuField.texture());
+      g.draw(mesh);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      return;
+    }
     g.lighting(true);
     g.light(light);
     g.tint(HSV(0.6, 0.2, 0.9));
     g.material(mtrl);
     g.draw(mesh);
   }
+
+  bool onKeyDown(const Keyboard& k) {
+    switch (k.key()) {
+      case '=':
+        if (Nx < 4096) Nx *= 2;
+        Ny = Nx;
+        resetGrid();
+        break;
+      case '-':
+        if (Nx > 64) Nx /= 2;
+        Ny = Nx;
+        resetGrid();
+        break;
+      case 'g':
+        onGPU = !onGPU;
+        resetGrid();
+        break;
+    }
+    return true;
+  }
 };
 
 int main() { MyApp().start(); }
@@ -0,0 +1,162 @@
+// Compares the stencil loop waveEquation.cpp used to run with WaveField.h:
+// whether they agree after a few hundred steps with drops, and how long a
+// step takes from 256 x 256 to 4096 x 4096, with heights and normals for a
+// surface mesh written in the same pass.
+//
+//   ./run.sh cookbook/simulation/wave_bench.cpp
+//
+// "stencil" is WaveField::step without a surface, comparable to the old
+// loop; the two columns after it include the surface. The old loop's time
+// doesn't include Mesh::generateNormals, which it also ran every frame.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "WaveField.h"
+
+using namespace std;
+
+// The loop waveEquation.cpp used to run, on interleaved planes
+struct OldWave
+{
+  int Nx, Ny;
+  vector<float> wave;
+  int zcurr = 0;
+  float decay = 0.96f, velocity = 0.5f;
+
+  OldWave(int n) : Nx(n), Ny(n), wave(n * n * 2) {}
+
+  int indexAt(int x, int y, int z) { return (y * Nx + x) * 2 + z; }
+
+  void add(int i, int j, float v)
+  {
+    wave[indexAt(i, j, 0)] += v;
+    wave[indexAt(i, j, 1)] += v;
+  }
+
+  void step(vector<float> &heights)
+  {
+    int zprev = 1 - zcurr;
+    for (int j = 0; j < Ny; ++j)
+    {
+      for (int i = 0; i < Nx; ++i)
+      {
+        int im1 = i != 0 ? i - 1 : Nx - 1;
+        int ip1 = i != Nx - 1 ? i + 1 : 0;
+        int jm1 = j != 0 ? j - 1 : Ny - 1;
+        int jp1 = j != Nx - 1 ? j + 1 : 0;
+        auto vp = wave[indexAt(i, j, zprev)];
+        auto vc = wave[indexAt(i, j, zcurr)];
+        auto vl = wave[indexAt(im1, j, zcurr)];
+        auto vr = wave[indexAt(ip1, j, zcurr)];
+        auto vd = wave[indexAt(i, jm1, zcurr)];
+        auto vu = wave[indexAt(i, jp1, zcurr)];
+        auto val = 2 * vc - vp + velocity * ((vl - 2 * vc + vr) + (vd - 2 * vc + vu));
+        wave[indexAt(i, j, zprev)] = val * decay;
+        heights[j * Nx + i] = val;
+      }
+    }
+    zcurr = zprev;
+  }
+};
+
+// Gaussian drop as in waveEquation.cpp
+template <class Wave>
+void drop(Wave &w, int ix, int iy)
+{
+  for (int j = -4; j <= 4; ++j)
+  {
+    for (int i = -4; i <= 4; ++i)
+    {
+      float x = float(i) / 4, y = float(j) / 4;
+      w.add(ix + i, iy + j, 0.5 * exp(-(x * x + y * y) / (0.5 * 0.5)));
+    }
+  }
+}
+
+bool same()
+{
+  const int n = 256;
+  OldWave before(n);
+  WaveField after;
+  after.resize(n, n);
+  vector<float> heights(n * n);
+  for (int s = 0; s < 300; ++s)
+  {
+    if (s % 20 == 0)
+    {
+      int ix = 4 + (s * 37) % (n - 8), iy = 4 + (s * 91) % (n - 8);
+      drop(before, ix, iy);
+      drop(after, ix, iy);
+    }
+    before.step(heights);
+    after.step();
+  }
+  float maxDiff = 0, peak = 0;
+  for (int j = 0; j < n; ++j)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      float a = before.wave[before.indexAt(i, j, before.zcurr)];
+      maxDiff = max(maxDiff, fabs(a - after.current()[j * n + i]));
+      peak = max(peak, fabs(a));
+    }
+  }
+  bool ok = maxDiff <= 1e-5f * peak;
+  printf("300 steps at 256 x 256: max difference %g (peak %g): %s\n", maxDiff, peak,
+         ok ? "same within tolerance" : "FIELDS DIFFER");
+  return ok;
+}
+
+// Milliseconds per call, over at least half a second
+template <typename F>
+double msPerCall(F f)
+{
+  int calls = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    f();
+    ++calls;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1000 / calls;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+  const char *path = "AVX2";
+#elif defined(WAVEFIELD_SSE2)
+  const char *path = "SSE2";
+#else
+  const char *path = "scalar";
+#endif
+  bool ok = same();
+
+  StealingPool pool;
+  printf("%10s %10s %14s %14s %14s\n", "grid", "old ms", "stencil ms", "1 thread ms", "threads ms");
+  for (int n : {256, 1024, 4096})
+  {
+    OldWave before(n);
+    vector<float> heights(size_t(n) * n);
+    double old = msPerCall([&]() { before.step(heights); });
+
+    WaveField after;
+    after.resize(n, n);
+    vector<float> vertices(size_t(n) * n * 3), normals(size_t(n) * n * 3);
+    WaveField::Surface surface;
+    surface.z = &vertices[2];
+    surface.normal = &normals[0];
+    surface.dx = surface.dy = 2.f / (n - 1);
+    double stencil = msPerCall([&]() { after.step(); });
+    double serial = msPerCall([&]() { after.step(&surface); });
+    double threaded = msPerCall([&]() { after.step(&surface, &pool); });
+    printf("%5d^2 %13.2f %14.2f %14.2f %14.2f\n", n, old, stencil, serial, threaded);
+  }
+  printf("stencil path: %s, %u threads\n", path, pool.size());
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// Checks WaveFieldGPU.h against the CPU WaveField.h on a headless GL
+// context, and times a GPU step from 256 x 256 to 4096 x 4096.
+//
+//   ./run.sh cookbook/simulation/wave_gpu_check.cpp
+//
+// The context comes from EGL without a window (flags.cmake links libEGL on
+// Linux), so this runs on a machine without a display, e.g. with Mesa's
+// software renderer:
+//
+//   EGL_PLATFORM=surfaceless LIBGL_ALWAYS_SOFTWARE=1 ./run.sh cookbook/simulation/wave_gpu_check.cpp
+//
+// Both fields take the same drops and steps, then their current planes
+// are compared. GPU times are from glFinish() after a batch of steps.
+
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "WaveField.h"
+#include "WaveFieldGPU.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+using namespace std;
+
+// An OpenGL 3.3 core context with no surface, or false
+bool makeContext()
+{
+  EGLDisplay display = EGL_NO_DISPLAY;
+  auto getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (getPlatformDisplay)
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) return false;
+  if (!eglBindAPI(EGL_OPENGL_API)) return false;
+
+  const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE,
+                                     EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config;
+  EGLint configs = 0;
+  if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0)
+    return false;
+
+  const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3,
+                                      EGL_CONTEXT_MINOR_VERSION, 3,
+                                      EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+  EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+  if (context == EGL_NO_CONTEXT) return false;
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return false;
+  return gladLoadGLLoader((GLADloadproc)eglGetProcAddress) != 0;
+}
+
+// Gaussian drop as in waveEquation.cpp
+template <class Wave>
+void drop(Wave &w, int ix, int iy)
+{
+  for (int j = -4; j <= 4; ++j)
+  {
+    for (int i = -4; i <= 4; ++i)
+    {
+      float x = float(i) / 4, y = float(j) / 4;
+      w.add(ix + i, iy + j, 0.5 * exp(-(x * x + y * y) / (0.5 * 0.5)));
+    }
+  }
+}
+
+// 300 steps at 256 x 256 with a drop every 20, on both; the GPU may fuse
+// multiplies and adds, so allow a little rounding
+bool same()
+{
+  const int n = 256;
+  WaveField cpu;
+  WaveFieldGPU gpu;
+  cpu.resize(n, n);
+  gpu.resize(n, n);
+  for (int s = 0; s < 300; ++s)
+  {
+    if (s % 20 == 0)
+    {
+      int ix = 4 + (s * 37) % (n - 8), iy = 4 + (s * 91) % (n - 8);
+      drop(cpu, ix, iy);
+      drop(gpu, ix, iy);
+    }
+    cpu.step();
+    gpu.step();
+  }
+  vector<float> current;
+  gpu.read(current);
+
+  float maxDiff = 0, peak = 0;
+  for (size_t k = 0; k < current.size(); ++k)
+  {
+    maxDiff = max(maxDiff, fabs(current[k] - cpu.current()[k]));
+    peak = max(peak, fabs(cpu.current()[k]));
+  }
+  bool ok = glGetError() == GL_NO_ERROR && peak > 0 && maxDiff <= 1e-4f * peak;
+  printf("300 steps at 256 x 256: max difference %g (peak %g): %s\n", maxDiff, peak,
+         ok ? "same within tolerance" : "FIELDS DIFFER");
+  return ok;
+}
+
+// Milliseconds per step, over at least half a second
+double msPerStep(WaveFieldGPU &field)
+{
+  int steps = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    for (int k = 0; k < 10; ++k) field.step();
+    glFinish();
+    steps += 10;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1000 / steps;
+}
+
+int main()
+{
+  if (!makeContext())
+  {
+    printf("no headless OpenGL 3.3 context from EGL\n");
+    return 1;
+  }
+  printf("renderer: %s\n", (const char *)glGetString(GL_RENDERER));
+  bool ok = same();
+
+  printf("%10s %10s\n", "grid", "gpu ms");
+  for (int n : {256, 1024, 4096})
+  {
+    WaveFieldGPU field;
+    field.resize(n, n);
+    drop(field, n / 2, n / 2);
+    field.step();
+    printf("%5d^2 %13.2f\n", n, msPerStep(field));
+  }
+  return ok ? 0 : 1;
+}
@@ -10,6 +10,9 @@ OSC backup for this. However, the size of the state is severly limited due
 to a small buffer size managed by OSC and it also makes interoperability
 between Windows and *nix machines impossible)
 
+(Cuttlebone also caps the size of its packets. For a state bigger than either
+can carry, see 06_large_state.cpp)
+
 The DistributedAppWithState must be templated on a struct that defines the
 state data. you can then get the state using state().
 
@@ -32,6 +35,12 @@ You should use parameters when you need near instantaneous updates (usually
 good for audio), or if your state is getting large and you don't require
 updating values on every frame.
 
+Renderers draw at their own frame rate, and states arrive at the primary's,
+a little early or late. Instead of jumping to each state as it arrives, the
+renderers here keep the last few in a StateHistory (from the cookbook) and
+draw what is in between the last two, one state interval behind. The primary
+sends its clock in the state for that.
+
 */
 
 #include "Gamma/Oscillator.h"
@@ -40,14 +49,26 @@ updating values on every frame.
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "../../cookbook/distributed/StateHistory.h"
+
 using namespace al;
 
 struct CommonState {
+  double time = 0; // primary's clock when sent
   float xPosition = 0.0;
   float mod = 0.5; // modulation value
   Nav nav;
 };
 
+// What is drawn: the state itself on the primary, and in between the last two
+// received on renderers. It's all floats, so StateHistory can blend it.
+struct Shown {
+  float xPosition = 0.0;
+  float mod = 0.5;
+  float pos[3]; // nav
+  float quat[4];
+};
+
 class MyApp : public DistributedAppWithState<CommonState> {
 public:
   Mesh m;
@@ -61,7 +82,13 @@ public:
   Parameter mod{"mod", "", 0.5};
   ControlGUI gui;
 
-  void onInit() override {}
+  StateHistory history;
+  Shown shown;
+
+  void onInit() override {
+    history.resize(sizeof(Shown) / sizeof(float));
+    history.quaternion(offsetof(Shown, quat) / sizeof(float));
+  }
   void onCreate() override {
     addIcosphere(m);
     gui.init();
@@ -88,19 +115,38 @@ public:
 
       state().xPosition = factor * 10;
       state().nav = nav();
+      state().time = StateHistory::now();
+      shown.xPosition = state().xPosition;
+      shown.mod = state().mod;
     } else {
-      nav() = state().nav;
+      // state().time stays 0 until the first state arrives
+      float *latest = state().time > 0 ? history.push(state().time) : nullptr;
+      if (latest) {
+        Vec3d pos = state().nav.pos();
+        Quatd quat = state().nav.quat();
+        Shown received = {state().xPosition,
+                          state().mod,
+                          {float(pos.x), float(pos.y), float(pos.z)},
+                          {float(quat.w), float(quat.x), float(quat.y),
+                           float(quat.z)}};
+        memcpy(latest, &received, sizeof(Shown));
+      }
+      if (history.sample((float *)&shown)) {
+        nav().pos(shown.pos[0], shown.pos[1], shown.pos[2]);
+        nav().quat().set(shown.quat[0], shown.quat[1], shown.quat[2],
+                         shown.quat[3]);
+      }
     }
   }
 
   void onDraw(Graphics &g) override {
     g.clear(0);
     g.pushMatrix();
-    // Notice that I query variables through state(). In the case of the primary
-    // node, this is local data, in the case of renderers, this is data
-    // received through state synchronization.
-    g.translate(state().xPosition, 0, -4);
-    g.scale(state().mod);
+    // Notice that I query variables through shown. In the case of the primary
+    // node, this is a copy of the state, in the case of renderers, this is
+    // data received through state synchronization, blended over time.
+    g.translate(shown.xPosition, 0, -4);
+    g.scale(shown.mod);
     g.polygonLine();
     g.draw(m);
     if (hasCapability(Capability::CAP_2DGUI)) {
@@ -0,0 +1,115 @@
+
+/*
+The state that DistributedAppWithState shares has to fit what its transport
+can carry: cuttlebone caps its packet size, and the OSC fallback's buffer is
+small (see 04_state.cpp). This example shares a state of over a megabyte, a
+cloud of 100000 points and the primary's pose, with StateTransport.h from the
+cookbook.
+
+The primary's StateSender splits the state into datagrams that fit in an
+Ethernet frame and numbers them. Each renderer's StateReceiver puts them back
+together as they arrive and only hands over whole states. A state that is
+missing a datagram is never shown: the renderer keeps drawing the last whole
+one, and moves on to the next whole one.
+
+The primary also writes each state once into shared memory. Renderers on the
+primary's machine find it there and read it in place instead of receiving
+datagrams, which costs them (and the primary) much less.
+
+Try it by launching the application a few times on one machine: the first
+instance is the primary and the others are renderers. In the Allosphere, send
+to the renderers' broadcast address instead of 127.255.255.255.
+*/
+
+#include <cstring>
+#include <memory>
+
+#include "al/app/al_DistributedApp.hpp"
+#include "al/graphics/al_Mesh.hpp"
+#include "al/math/al_Random.hpp"
+
+#include "../../cookbook/distributed/StateTransport.h"
+
+using namespace al;
+
+const char *kRenderers = "127.255.255.255"; // broadcast address of renderers
+const uint16_t kPort = 63059;
+const char *kRing = "/large_state"; // shared memory, for renderers here
+const int kPoints = 100000;
+
+struct CloudState {
+  Pose pose;
+  float time = 0;
+  Vec3f points[kPoints];
+};
+
+class MyApp : public DistributedApp {
+public:
+  Mesh m{Mesh::POINTS};
+  std::vector<float> radius, speed, height;
+
+  // Too big for the stack: the state lives on the heap. Renderers copy the
+  // newest whole one into it, and only use it if the copy is whole too.
+  std::unique_ptr<CloudState> cloud{new CloudState};
+  StateSender sender;
+  StateReceiver receiver;
+
+  void onInit() override {
+    if (isPrimary()) {
+      sender.open(kRing, sizeof(CloudState), kRenderers, kPort);
+      for (int i = 0; i < kPoints; i++) {
+        radius.push_back(rnd::uniform(0.2f, 2.0f));
+        speed.push_back(rnd::uniform(0.1f, 1.0f) / radius.back());
+        height.push_back(rnd::normal() * 0.1f);
+      }
+    } else {
+      receiver.open(kRing, kPort);
+    }
+  }
+
+  void onCreate() override {
+    m.vertices().resize(kPoints);
+    nav().pos(0, 1, 5);
+    nav().faceToward(Vec3d(0, 0, 0));
+  }
+
+  void onAnimate(double dt) override {
+    if (isPrimary()) {
+      cloud->time += dt;
+      for (int i = 0; i < kPoints; i++) {
+        float a = speed[i] * cloud->time + i;
+        cloud->points[i] = Vec3f(radius[i] * cos(a), height[i], radius[i] * sin(a));
+      }
+      cloud->pose = nav();
+      sender.send(cloud.get(), sizeof(CloudState));
+      memcpy(&m.vertices()[0], cloud->points, sizeof(cloud->points));
+    } else {
+      // A state read from shared memory can be overwritten by the primary
+      // while it is copied: newest() then returns false and the copy is
+      // dropped
+      bool whole = false;
+      bool intact = receiver.newest([&](const uint8_t *data, size_t size) {
+        whole = size == sizeof(CloudState);
+        if (whole)
+          memcpy(cloud.get(), data, sizeof(CloudState));
+      });
+      if (intact && whole) {
+        pose() = cloud->pose;
+        memcpy(&m.vertices()[0], cloud->points, sizeof(cloud->points));
+      }
+    }
+  }
+
+  void onDraw(Graphics &g) override {
+    g.clear(0);
+    g.pointSize(2);
+    g.color(0.8f, 0.9f, 1.0f);
+    g.draw(m);
+  }
+};
+
+int main() {
+  MyApp app;
+  app.start();
+  return 0;
+}
@@ -0,0 +1,4 @@
+# 06_large_state.cpp: shm_open() needs librt on Linux with glibc before 2.34
+if(${CMAKE_SYSTEM_NAME} MATCHES "Linux" AND app_name STREQUAL "06_large_state")
+  set(app_link_libs rt)
+endif()
@@ -23,6 +23,8 @@
 #include "al/math/al_Random.hpp"
 #include <cstdio>  
 
+#include "../synthesis/ScrollingHistory.h"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -258,8 +260,8 @@ class MyApp : public App, public MIDIMessageHandler {
  public:
   OscEnv oscenv;
   RtMidiIn midiIn; // MIDI input carrier
-  Mesh mSpectrogram;
-  vector<float> spectrum;
+  // Spectra go to the GPU as they come in; see ScrollingHistory.h
+  ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
   bool showGUI = true;
   bool showSpectro = true;
   bool navi = false;
@@ -282,8 +284,8 @@ class MyApp : public App, public MIDIMessageHandler {
     {
       printf("Error: No MIDI devices found.\n");
     }
-    // Declare the size of the spectrum 
-    spectrum.resize(FFT_SIZE / 2 + 1);
+    // Colors, as hue + value * hue gain
+    spectrogram.color(0.5, -100);
   }
 
   void onCreate() override {
@@ -306,17 +308,21 @@ class MyApp : public App, public MIDIMessageHandler {
     {
       if (stft(io.out(0)))
       { // Loop through all the frequency bins
+        float spectrum[FFT_SIZE / 2 + 1];
         for (unsigned k = 0; k < stft.numBins(); ++k)
         {
           // Here we simply scale the complex sample
           spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3) );
           //spectrum[k] = stft.bin(k).real();
         }
+        spectrogram.push(spectrum);
       }
     }
   }
 
   void onAnimate(double dt) override {
+    // Upload the spectra pushed since the last frame
+    spectrogram.update();
     navControl().active(navi);  // Disable navigation via keyboard, since we
     // Draw GUI
     imguiBeginFrame();
@@ -330,20 +336,18 @@ class MyApp : public App, public MIDIMessageHandler {
     g.clear();
     synthManager.render(g);
     // // Draw Spectrum
-    mSpectrogram.reset();
-    mSpectrogram.primitive(Mesh::LINE_STRIP);
     if (showSpectro)
     {
-      for (int i = 0; i < FFT_SIZE / 2; i++)
-      {
-        mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-        mSpectrogram.vertex(i, spectrum[i], 0.0);
-      }
-      g.meshColor(); // Use the color in the mesh
+      // Spectrogram below the spectrum, newest on the right
+      g.pushMatrix();
+      g.translate(-3, -4.5, 0);
+      g.scale(10.0, 1.25, 1.0);
+      spectrogram.drawImage(g, 1000);
+      g.popMatrix();
       g.pushMatrix();
       g.translate(-3, -3, 0);
-      g.scale(20.0 / FFT_SIZE, 100, 1.0);
-      g.draw(mSpectrogram);
+      g.scale(10.0, 100, 1.0);
+      spectrogram.drawTrace(g, spectrogram.rows());
       g.popMatrix();
     }
     // GUI is drawn here
@@ -23,6 +23,8 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
+#include "../synthesis/ScrollingHistory.h"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -44,8 +46,8 @@ public:
     gam::Env<2> mPanEnv;
     gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
     // This time, let's use spectrograms for each notes as the visual components.
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // Spectra go to the GPU as they come in; see ScrollingHistory.h
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kTraceColumns};
     double a = 0;
     double b = 0;
     double timepose = 10;
@@ -54,10 +56,8 @@ public:
 
     virtual void init() override
     {
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
-        // mSpectrogram.primitive(Mesh::POINTS);
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
+        // Colors, as hue + value * hue gain
+        spectrogram.color(0, 1000);
         mAmpEnv.levels(0, 1, 1, 0);
         mPanEnv.curve(4);
         env.decay(0.1);
@@ -102,11 +102,13 @@ public:
             // STFT for each notes
             if (stft(s1))
             { // Loop through all the frequency bins
+                float spectrum[FFT_SIZE / 2 + 1];
                 for (unsigned k = 0; k < stft.numBins(); ++k)
                 {
                     // Here we simply scale the complex sample
                     spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
                 }
+                spectrogram.push(spectrum);
             }
         }
         if (mAmpEnv.done() && (mEnvFollow.value() < 0.001))
@@ -121,21 +123,14 @@ public:
         b += 0.23;
         timepose -= 0.1;
 
-        mSpectrogram.reset();
-        // mSpectrogram.primitive(Mesh::LINE_STRIP);
-
-        for (int i = 0; i < FFT_SIZE / 2; i++)
-        {
-            mSpectrogram.color(HSV(spectrum[i] * 1000 + al::rnd::uniform()));
-            mSpectrogram.vertex(i, spectrum[i], 0.0);
-        }
-        g.meshColor(); // Use the color in the mesh
+        // Upload this note's spectra pushed since the last frame
+        spectrogram.update();
         g.pushMatrix();
         g.translate(0, 0, -10);
         g.rotate(a, Vec3f(0, 1, 0));
         g.rotate(b, Vec3f(1));
-        g.scale(10.0 / FFT_SIZE, 500, 1.0);
-        g.draw(mSpectrogram);
+        g.scale(5.0, 500, 1.0);
+        spectrogram.drawTrace(g, spectrogram.rows());
         g.popMatrix();
     }
 
@@ -177,8 +172,8 @@ public:
     SynthGUIManager<PluckedString> synthManager{"plunk"};
     //    ParameterMIDI parameterMIDI;
     RtMidiIn midiIn; // MIDI input carrier
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // Spectra go to the GPU as they come in; see ScrollingHistory.h
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
     bool showGUI = true;
     bool showSpectro = true;
     bool navi = false;
@@ -207,8 +202,8 @@ public:
         {
             printf("Error: No MIDI devices found.\n");
         }
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
+        // Colors, as hue + value * hue gain
+        spectrogram.color(0.5, -100);
     }
 
     void onCreate() override
@@ -226,18 +221,22 @@ public:
         {
             if (stft(io.out(0)))
             { // Loop through all the frequency bins
+                float spectrum[FFT_SIZE / 2 + 1];
                 for (unsigned k = 0; k < stft.numBins(); ++k)
                 {
                     // Here we simply scale the complex sample
                     spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
                     // spectrum[k] = stft.bin(k).real();
                 }
+                spectrogram.push(spectrum);
             }
         }        
     }
 
     void onAnimate(double dt) override
     {
+        // Upload the spectra pushed since the last frame
+        spectrogram.update();
         navControl().active(navi); // Disable navigation via keyboard, since we
         imguiBeginFrame();
         synthManager.drawSynthControlPanel();
@@ -249,20 +248,18 @@ public:
         g.clear();
         synthManager.render(g);
         // // Draw Spectrum
-        mSpectrogram.reset();
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
         if (showSpectro)
         {
-            for (int i = 0; i < FFT_SIZE / 2; i++)
-            {
-                mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-                mSpectrogram.vertex(i, spectrum[i], 0.0);
-            }
-            g.meshColor(); // Use the color in the mesh
+            // Spectrogram below the spectrum, newest on the right
+            g.pushMatrix();
+            g.translate(-3, -4.5, 0);
+            g.scale(10.0, 1.25, 1.0);
+            spectrogram.drawImage(g, 1000);
+            g.popMatrix();
             g.pushMatrix();
             g.translate(-3, -3, 0);
-            g.scale(20.0 / FFT_SIZE, 100, 1.0);
-            g.draw(mSpectrogram);
+            g.scale(10.0, 100, 1.0);
+            spectrogram.drawTrace(g, spectrogram.rows());
             g.popMatrix();
         }
         // Draw GUI
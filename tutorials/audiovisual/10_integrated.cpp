@@ -48,12 +48,12 @@ public:
   float halfStepInterval = 1.05946309; // 2^(1/12)
   RtMidiIn midiIn;                     // MIDI input carrier
 
-  Mesh mSpectrogram;
-  vector<float> spectrum;
+  // The analyzer pushes the mix's spectra to the GPU; see ScrollingHistory.h
+  SpectrumBus mixSpectrum{FFT_SIZE, FFT_SIZE / 4};
+  ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
   bool showGUI = true;
   bool showSpectro = true;
   bool navi = false;
-  gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
 
   virtual void onInit() override
   {
@@ -73,14 +73,19 @@ public:
     {
       printf("Error: No MIDI devices found.\n");
     }
-    // Declare the size of the spectrum
-    spectrum.resize(FFT_SIZE / 2 + 1);
-
     imguiInit();
     navControl().active(false); // Disable navigation via keyboard, since we
                                 // will be using keyboard for note triggering
     // Set sampling rate for Gamma objects from app's audio
     gam::sampleRate(audioIO().framesPerSecond());
+    // Spectra colored as hue + value * hue gain
+    spectrumHistory.color(0.5, -100);
+    spectrogram.color(0.5, -100);
+    spectrumBus.feed(spectrumHistory);
+    mixSpectrum.feed(spectrogram);
+    // Run the analyzers now that the sample rate is set
+    spectrumBus.start();
+    mixSpectrum.start();
   }
 
   void onCreate() override
@@ -104,23 +109,17 @@ public:
   void onSound(AudioIOData &io) override
   {
     synthManager.render(io); // Render audio
-    // STFT
-    while (io())
-    {
-      if (stft(io.out(0)))
-      { // Loop through all the frequency bins
-        for (unsigned k = 0; k < stft.numBins(); ++k)
-        {
-          // Here we simply scale the complex sample
-          spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
-          // spectrum[k] = stft.bin(k).real();
-        }
-      }
-    }
+    spectrumBus.commit(io.framesPerBuffer());
+    // STFT of the mix runs on the analyzer thread
+    mixSpectrum.add(io.outBuffer(0), io.framesPerBuffer());
+    mixSpectrum.commit(io.framesPerBuffer());
   }
 
   void onAnimate(double dt) override
   {
+    // Upload the spectra pushed since the last frame
+    spectrumHistory.update();
+    spectrogram.update();
     navControl().active(navi); // Disable navigation via keyboard, since we
     imguiBeginFrame();
     synthManager.drawSynthControlPanel();
@@ -130,23 +129,22 @@ public:
   void onDraw(Graphics &g) override
   {
     g.clear();
-    // Render the synth's graphics
+    // Render the synth's graphics; voices batch their shapes, drawn here
     synthManager.render(g);
+    voiceVisuals.draw(g);
     // // Draw Spectrum
-    mSpectrogram.reset();
-    mSpectrogram.primitive(Mesh::LINE_STRIP);
     if (showSpectro)
     {
-      for (int i = 0; i < FFT_SIZE / 2; i++)
-      {
-        mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-        mSpectrogram.vertex(i, spectrum[i], 0.0);
-      }
-      g.meshColor(); // Use the color in the mesh
+      // Spectrogram below the spectrum, newest on the right
+      g.pushMatrix();
+      g.translate(-3.0, -4.5, -15);
+      g.scale(5.0, 1.25, 1.0);
+      spectrogram.drawImage(g, 1000);
+      g.popMatrix();
       g.pushMatrix();
       g.translate(-3.0, -3, -15);
-      g.scale(10.0 / FFT_SIZE, 1000, 1.0);
-      g.draw(mSpectrogram);
+      g.scale(5.0, 1000, 1.0);
+      spectrogram.drawTrace(g, spectrogram.rows());
       g.popMatrix();
     }
     // GUI is drawn here
@@ -237,7 +235,12 @@ public:
     return true;
   }
 
-  void onExit() override { imguiShutdown(); }
+  void onExit() override
+  {
+    spectrumBus.stop();
+    mixSpectrum.stop();
+    imguiShutdown();
+  }
 };
 
 int main()
@@ -19,13 +19,93 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
+#include "../synthesis/FMBlock.h"
+#include "../synthesis/ParamHandle.h"
+#include "../synthesis/PartialBank.h"
+#include "../synthesis/SharedMesh.h"
+#include "../synthesis/SpectrumBus.h"
+#include "../synthesis/VoiceVisuals.h"
+
 using namespace gam;
 using namespace al;
 using namespace std;
 #define FFT_SIZE 4048
+// Spectrum of all PluckedString voices. The app feeds it spectrumHistory and
+// starts it, commits a block after each render and updates the history once
+// per frame; every voice then draws the same texture.
+SpectrumBus spectrumBus{FFT_SIZE, FFT_SIZE / 4};
+ScrollingHistory spectrumHistory{FFT_SIZE / 2 + 1, ScrollingHistory::kTraceColumns};
+// Voices add their shapes here; the app draws them after the synth
+VoiceVisuals voiceVisuals;
 // tables for oscillator
 gam::ArrayPow2<float> tbSaw(2048), tbSqr(2048), tbImp(2048), tbSin(2048), tbDin(2048),
     tbPls(2048), tb__1(2048), tb__2(2048), tb__3(2048), tb__4(2048);
+// Visual for each of the tables above, indexed like the "table" parameter.
+// Built once and shared by every OscEnv, Vib, FMWT and OscTrm voice.
+SharedMesh::Ptr waveformMesh(int table)
+{
+  return SharedMesh::get("waveform " + to_string(table), [table](Mesh &m) {
+    float scaler = 0.15;
+    float hscaler = 1;
+    switch (table) {
+    case 0: addCone(m, 1, Vec3f(0, 0, 5), 40, 1); break;  // tbSaw
+    case 1: addCube(m); break;                             // tbSquare
+    case 2: addPrism(m, 1, 1, 1, 100); break;              // tbImp
+    case 3: addSphere(m, 0.3, 16, 100); break;             // tbSin
+    case 4: addWireBox(m, 2); break;                       // tbPls
+    case 5: {  // tb__1
+      float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
+      float C[] = {1, 4, 7, 11, 15, 18, 0, 0};
+      for (int i = 0; i < 7; i++)
+        addWireBox(m, scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
+      break;
+    }
+    case 6: {  // tb__2
+      float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
+      float C[] = {3, 4, 7, 8, 11, 12, 15, 16};
+      for (int i = 0; i < 7; i++)
+        addWireBox(m, scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
+      break;
+    }
+    case 7: {  // tb__3
+      float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0, 0};
+      float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
+      for (int i = 0; i < 7; i++)
+        addWireBox(m, scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
+      break;
+    }
+    case 8: {  // tb__4
+      float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
+      for (int i = 0; i < 7; i++)
+        addWireBox(m, hscaler * A[i], hscaler * A[i + 1], 1 + 0.3 * i);
+      break;
+    }
+    }
+
+    // Scale and generate normals
+    m.scale(0.4);
+    int Nv = m.vertices().size();
+    for (int k = 0; k < Nv; ++k) {
+      m.color(HSV(float(k) / Nv, 0.3, 1));
+    }
+    if (m.primitive() == Mesh::TRIANGLES) {
+      m.decompress();
+    }
+    m.generateNormals();
+  });
+}
+
+// Sphere with normals, shared by all voices of the given size and detail
+SharedMesh::Ptr sphereMesh(double radius, int slices, int stacks)
+{
+  string key = "sphere " + to_string(radius) + " " + to_string(slices) + " " + to_string(stacks);
+  return SharedMesh::get(key, [=](Mesh &m) {
+    addSphere(m, radius, slices, stacks);
+    m.decompress();
+    m.generateNormals();
+  });
+}
+
 Vec3f randomVec3f(float scale)
 {
   return Vec3f(al::rnd::uniformS(), al::rnd::uniformS(), al::rnd::uniformS()) * scale;
@@ -34,6 +114,12 @@ Vec3f randomVec3f(float scale)
 class SineEnv : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc;
@@ -41,7 +127,7 @@ public:
   // envelope follower to connect audio output to graphics
   gam::EnvFollow<> mEnvFollow;
   // Draw parameters
-  Mesh mMesh;
+  VoiceShape mMesh;
   double a = 0;
   double b = 0;
   double timepose = 0;
@@ -59,9 +145,7 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a sphere
-    addSphere(mMesh, 0.3, 50, 50);
-    mMesh.decompress();
-    mMesh.generateNormals();
+    mMesh = voiceVisuals.mesh(sphereMesh(0.3, 50, 50), true);
 
     // This is a quick way to create parameters for the voice. Trigger
     // parameters are meant to be set only when the voice starts, i.e. they
@@ -69,11 +153,11 @@ public:
     // change them while you are prototyping, but their changes will only be
     // stored and aplied when a note is triggered.)
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     // Initalize MIDI device input
   }
@@ -87,13 +171,14 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam);
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
+    float amp = mAmplitudeParam;
     while (io())
     {
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * amp;
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -115,18 +200,16 @@ public:
     timepose += 0.02;
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
     // Now draw
     g.pushMatrix();
     g.depthTesting(true);
-    g.lighting(true);
     g.translate(note_position + note_direction * timepose);
     g.rotate(a, Vec3f(0, 1, 0));
     g.rotate(b, Vec3f(1));
     g.scale(0.3 + mAmpEnv() * 0.2, 0.3 + mAmpEnv() * 0.5, amplitude);
-    g.color(HSV(frequency / 1000, 0.5 + mAmpEnv() * 0.1, 0.3 + 0.5 * mAmpEnv()));
-    g.draw(mMesh);
+    voiceVisuals.add(mMesh, g, Color(HSV(frequency / 1000, 0.5 + mAmpEnv() * 0.1, 0.3 + 0.5 * mAmpEnv())));
     g.popMatrix();
   }
 
@@ -135,7 +218,7 @@ public:
   // the voice from the processing chain.
   void onTriggerOn() override
   {
-    float angle = getInternalParameterValue("frequency") / 200;
+    float angle = mFrequencyParam / 200;
     mAmpEnv.reset();
     a = al::rnd::uniform();
     b = al::rnd::uniform();
@@ -150,6 +233,15 @@ public:
 // 02_OscEnv
 class OscEnv : public SynthVoice {
  public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mCurveParam;
+  ParamHandle mPanParam;
+  ParamHandle mTableParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Osc<> mOsc;
@@ -159,9 +251,8 @@ class OscEnv : public SynthVoice {
   int mtable;
   // Additional members
   static const int numb_waveform = 9;
-  Mesh mMesh[numb_waveform];
+  VoiceShape mMesh[numb_waveform];
   bool wireframe = false;
-  bool vertexLight = false;
   double a_rotate = 0;
   double b_rotate = 0;
   double timepose = 0;
@@ -174,74 +265,49 @@ class OscEnv : public SynthVoice {
                    0);  // These tables are not normalized, so scale to 0.3
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-
-    // Table & Visual meshes
-    // Now We have the mesh according to the waveform
-    gam::addSinesPow<1>(tbSaw, 9, 1);
-    addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
 
+    // Tables; the matching meshes are shared by all voices
+    gam::addSinesPow<1>(tbSaw, 9, 1);
     gam::addSinesPow<1>(tbSqr, 9, 2);
-    addCube(mMesh[1]);  // tbSquare
-
     gam::addSinesPow<0>(tbImp, 9, 1);
-    addPrism(mMesh[2],1,1,1,100); // tbImp
-
     gam::addSine(tbSin);
-    addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
 // About: addSines (dst, amps, cycs, numh)
 // \param[out] dst		destination array
 // \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
 // \param[in] cycs		harmonic numbers of series, size must be numh - C[]
 // \param[in] numh		total number of harmonics
-    float scaler = 0.15;
-    float hscaler = 1;
 
     { //tbPls
       float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
       gam::addSines(tbPls, A, 8); 
-      addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
       gam::addSines(tb__1, A, C, 6);
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-
-        // addSphere(mMesh[5],scaler * A[i], 16, 30); // tb__1
-      }
     }
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
       gam::addSines(tb__2, A, C, 8); // tb__2
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-      }
     }
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
       gam::addSines(tb__3, A, C, 6); // tb__3
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-      }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
       gam::addSines(tb__4, A, 8, 20); // tb__4
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
-      }
     }
     // { // Write your own waveform!
     //   float A[] = {1, 1, 1, 1, 1, 1};
@@ -255,28 +321,14 @@ class OscEnv : public SynthVoice {
 
 //int addSurfaceLoop(Mesh& m, int Nx, int Ny, int loopMode, double width, double height, double x, double y) 
 
-
-    // Scale and generate normals
-    for (int i = 0; i < numb_waveform; ++i) {
-      mMesh[i].scale(0.4);
-
-      int Nv = mMesh[i].vertices().size();
-      for (int k = 0; k < Nv; ++k) {
-        mMesh[i].color(HSV(float(k) / Nv, 0.3, 1));
-      }
-
-      if (!vertexLight && mMesh[i].primitive() == Mesh::TRIANGLES) {
-        mMesh[i].decompress();
-      }
-      mMesh[i].generateNormals();
-    }
+    for (int i = 0; i < numb_waveform; ++i) mMesh[i] = voiceVisuals.mesh(waveformMesh(i), true);
   }
 
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
+    float amp = mAmplitudeParam;
     while (io()) {
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * amp;
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -293,24 +345,22 @@ class OscEnv : public SynthVoice {
     a_rotate += 0.81;
     b_rotate += 0.78;
     timepose -= 0.06;
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
-    int shape = getInternalParameterValue("table");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
+    int shape = mTableParam;
 
     // static Light light;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
     gl::depthTesting(true);
-    g.lighting(true);
     // g.light(light);
     g.pushMatrix();
     g.depthTesting(true);
-    g.translate( timepose, getInternalParameterValue("frequency") / 200 - 3 , -15);
+    g.translate( timepose, mFrequencyParam / 200 - 3 , -15);
     g.rotate(a_rotate, Vec3f(0, 1, 1));
     g.rotate(b_rotate, Vec3f(1));    
     g.scale(0.5 + mAmpEnv() * 2, 0.5 + mAmpEnv() * 2, 0.03 + 0.1*mAmpEnv() );
-    g.color(HSV(frequency / 1000, 0.6 + mAmpEnv() * 0.1, 0.6 + 0.5 * mAmpEnv()));
-    g.draw(mMesh[shape]);
+    voiceVisuals.add(mMesh[shape], g, Color(HSV(frequency / 1000, 0.6 + mAmpEnv() * 0.1, 0.6 + 0.5 * mAmpEnv())));
     g.popMatrix();
   } 
 
@@ -324,17 +374,17 @@ class OscEnv : public SynthVoice {
   virtual void onTriggerOff() override { mAmpEnv.triggerRelease(); }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam);
+    mAmpEnv.attack(mAttackTimeParam);
+    mAmpEnv.decay(mAttackTimeParam);
+    mAmpEnv.release(mReleaseTimeParam);
+    mAmpEnv.sustain(mSustainParam);
+    mAmpEnv.curve(mCurveParam);
+    mPan.pos(mPanParam);
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam)) {
       case 0:
         mOsc.source(tbSaw);
         break;
@@ -370,6 +420,19 @@ class OscEnv : public SynthVoice {
 // 03_Vib
 class Vib : public SynthVoice {
  public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mCurveParam;
+  ParamHandle mPanParam;
+  ParamHandle mTableParam;
+  ParamHandle mVibRate1Param;
+  ParamHandle mVibRate2Param;
+  ParamHandle mVibRiseParam;
+  ParamHandle mVibDepthParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Osc<> mOsc;
@@ -380,9 +443,8 @@ class Vib : public SynthVoice {
   int mtable;
   // Additional members
   static const int numb_waveform = 9;
-  Mesh mMesh[numb_waveform];
+  VoiceShape mMesh[numb_waveform];
   bool wireframe = false;
-  bool vertexLight = false;
   double a_rotate = 0;
   double b_rotate = 0;
   double timepose = 0;
@@ -398,108 +460,70 @@ class Vib : public SynthVoice {
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
     mVibEnv.curve(0);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-    createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
-    createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
-    createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
-
-    // Table & Visual meshes
-    // Now We have the mesh according to the waveform
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
+
+    // Tables; the matching meshes are shared by all voices
     gam::addSinesPow<1>(tbSaw, 9, 1);
-    addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
-
     gam::addSinesPow<1>(tbSqr, 9, 2);
-    addCube(mMesh[1]);  // tbSquare
-
     gam::addSinesPow<0>(tbImp, 9, 1);
-    addPrism(mMesh[2],1,1,1,100); // tbImp
-
     gam::addSine(tbSin);
-    addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
 // About: addSines (dst, amps, cycs, numh)
 // \param[out] dst		destination array
 // \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
 // \param[in] cycs		harmonic numbers of series, size must be numh - C[]
 // \param[in] numh		total number of harmonics
-    float scaler = 0.15;
-    float hscaler = 1;
 
     { //tbPls
       float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
       gam::addSines(tbPls, A, 8); 
-      addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
       gam::addSines(tb__1, A, C, 6);
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-
-        // addSphere(mMesh[5],scaler * A[i], 16, 30); // tb__1
-      }
     }
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
       gam::addSines(tb__2, A, C, 8); // tb__2
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-      }
     }
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
       gam::addSines(tb__3, A, C, 6); // tb__3
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-      }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
       gam::addSines(tb__4, A, 8, 20); // tb__4
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
-      }
     }
 
-    // Scale and generate normals
-    for (int i = 0; i < numb_waveform; ++i) {
-      mMesh[i].scale(0.4);
-
-      int Nv = mMesh[i].vertices().size();
-      for (int k = 0; k < Nv; ++k) {
-        mMesh[i].color(HSV(float(k) / Nv, 0.3, 1));
-      }
-
-      if (!vertexLight && mMesh[i].primitive() == Mesh::TRIANGLES) {
-        mMesh[i].decompress();
-      }
-      mMesh[i].generateNormals();
-    }
+    for (int i = 0; i < numb_waveform; ++i) mMesh[i] = voiceVisuals.mesh(waveformMesh(i), true);
   }
 
   //
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
-    float oscFreq = getInternalParameterValue("frequency");
-    float vibDepth = getInternalParameterValue("vibDepth");
+    float oscFreq = mFrequencyParam;
+    float vibDepth = mVibDepthParam;
     outFreq = oscFreq + vibValue * vibDepth * oscFreq;
+    float amp = mAmplitudeParam;
     while (io()) {
       mVib.freq(mVibEnv());
       vibValue = mVib();
        mOsc.freq(outFreq);
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * amp;
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -516,12 +540,11 @@ class Vib : public SynthVoice {
     a_rotate += 0.81;
     b_rotate += 0.78;
     timepose -= 0.06;
-    int shape = getInternalParameterValue("table");
+    int shape = mTableParam;
     // static Light light;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
     gl::depthTesting(true);
-    g.lighting(true);
     // g.light(light);
     g.pushMatrix();
     g.depthTesting(true);
@@ -529,8 +552,7 @@ class Vib : public SynthVoice {
     g.rotate(a_rotate, Vec3f(0, 1, 1));
     g.rotate(b_rotate, Vec3f(1));    
     g.scale(0.5 + mAmpEnv() * 2, 0.5 + mAmpEnv() * 2, 0.03 + 0.1*mAmpEnv() );
-    g.color(HSV(outFreq / 1000, 0.6 + mAmpEnv() * 0.1, 0.6 + 0.5 * mAmpEnv()));
-    g.draw(mMesh[shape]);
+    voiceVisuals.add(mMesh[shape], g, Color(HSV(outFreq / 1000, 0.6 + mAmpEnv() * 0.1, 0.6 + 0.5 * mAmpEnv())));
     g.popMatrix();
   } 
 
@@ -548,24 +570,24 @@ class Vib : public SynthVoice {
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
+    mOsc.freq(mFrequencyParam);
+    mAmpEnv.attack(mAttackTimeParam);
+    mAmpEnv.decay(mAttackTimeParam);
+    mAmpEnv.release(mReleaseTimeParam);
+    mAmpEnv.sustain(mSustainParam);
+    mAmpEnv.curve(mCurveParam);
+    mPan.pos(mPanParam);
+    mVibEnv.levels(mVibRate1Param,
+                   mVibRate2Param,
+                   mVibRate2Param,
+                   mVibRate1Param);
+    mVibEnv.lengths()[0] = mVibRiseParam;
+    mVibEnv.lengths()[1] = mVibRiseParam;
+    mVibEnv.lengths()[3] = mVibRiseParam;
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam)) {
       case 0:
         mOsc.source(tbSaw);
         break;
@@ -602,6 +624,22 @@ class Vib : public SynthVoice {
 class FM : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mFrequencyParam;
+  ParamHandle mAmplitudeParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mIdx1Param;
+  ParamHandle mIdx2Param;
+  ParamHandle mIdx3Param;
+  ParamHandle mCarMulParam;
+  ParamHandle mModMulParam;
+  ParamHandle mVibRate1Param;
+  ParamHandle mVibRate2Param;
+  ParamHandle mVibRiseParam;
+  ParamHandle mVibDepthParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::ADSR<> mAmpEnv;
@@ -609,11 +647,12 @@ public:
   gam::EnvFollow<> mEnvFollow;
   gam::ADSR<> mVibEnv;
 
-  gam::Sine<> car, mod, mVib; // carrier, modulator sine oscillators
+  FMBlock mFM;     // carrier, modulator and their per-frame inputs
+  BlockSine mVib;
   double a = 0;
   double b = 0;
   double timepose = 10;
-  Mesh ball;
+  VoiceShape ball;
 
   // Additional members
   float mVibFrq;
@@ -629,53 +668,63 @@ public:
     mModEnv.levels(0, 1, 1, 0);
     mVibEnv.levels(0, 1, 1, 0);
     //      mVibEnv.curve(0);
-    addSphere(ball, 1, 100, 100);
-    ball.decompress();
-    ball.generateNormals();
+    ball = voiceVisuals.mesh(sphereMesh(1, 100, 100), true);
 
     // We have the mesh be a sphere
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.05, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.5, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.05, 0.0, 1.0);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.5, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData &io) override
   {
-    mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
-    while (io())
+    float carBaseFreq = mFrequencyParam * mCarMulParam;
+    float modScale = mFrequencyParam * mModMulParam;
+    float amp = mAmplitudeParam;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0)
     {
-      mVib.freq(mVibEnv());
-      car.freq((1 + mVib() * mVibDepth) * carBaseFreq +
-               mod() * mModEnv() * modScale);
-      float s1 = car() * mAmpEnv() * amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+      unsigned n = frames < FMBlock::kMaxFrames ? frames : FMBlock::kMaxFrames;
+      for (unsigned i = 0; i < n; ++i)
+      {
+        mFM.carFreq[i] = mVibEnv();
+        mFM.modDepth[i] = mModEnv() * modScale;
+        mFM.amp[i] = mAmpEnv() * amp;
+      }
+      // vibrato rate in, vibrato out
+      mVib.render(mFM.carFreq, mFM.carFreq, n);
+      for (unsigned i = 0; i < n; ++i)
+        mFM.carFreq[i] = (1 + mFM.carFreq[i] * mVibDepth) * carBaseFreq;
+      mFM.render(n);
+      for (unsigned i = 0; i < n && io(); ++i)
+      {
+        float s1 = mFM.out[i];
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     if (mAmpEnv.done() && (mEnvFollow.value() < 0.001))
       free();
@@ -688,14 +737,12 @@ public:
     timepose -= 0.06;
     g.pushMatrix();
     g.depthTesting(true);
-    g.lighting(true);
-    g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -15);
-    g.rotate(mVib() + a, Vec3f(0, 1, 0));
+    g.translate(timepose, mFrequencyParam / 200 - 3, -15);
+    g.rotate(mVib.value() + a, Vec3f(0, 1, 0));
     g.rotate(mVibDepth + b, Vec3f(1));
-    float scaling = getInternalParameterValue("amplitude") / 10;
-    g.scale(scaling + getInternalParameterValue("modMul") / 10, scaling + getInternalParameterValue("carMul") / 30, scaling + mEnvFollow.value() * 5);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, getInternalParameterValue("carMul") / 20, 0.5 + getInternalParameterValue("attackTime")));
-    g.draw(ball);
+    float scaling = mAmplitudeParam / 10;
+    g.scale(scaling + mModMulParam / 10, scaling + mCarMulParam / 30, scaling + mEnvFollow.value() * 5);
+    voiceVisuals.add(ball, g, Color(HSV(mModMulParam / 20, mCarMulParam / 20, 0.5 + mAttackTimeParam)));
     g.popMatrix();
   }
 
@@ -706,12 +753,11 @@ public:
     mVibEnv.reset();
     mModEnv.reset();
     mVib.phase(0);
-    mod.phase(0);
+    mFM.mod.phase(0);
     updateFromParameters();
 
-    float modFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
-    mod.freq(modFreq);
+    float modFreq = mFrequencyParam * mModMulParam;
+    mFM.mod.freq(modFreq);
   }
   void onTriggerOff() override
   {
@@ -722,28 +768,28 @@ public:
 
   void updateFromParameters()
   {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
-
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
-    mVibDepth = getInternalParameterValue("vibDepth");
+    mModEnv.levels()[0] = mIdx1Param;
+    mModEnv.levels()[1] = mIdx2Param;
+    mModEnv.levels()[2] = mIdx2Param;
+    mModEnv.levels()[3] = mIdx3Param;
+
+    mAmpEnv.attack(mAttackTimeParam);
+    mAmpEnv.release(mReleaseTimeParam);
+    mAmpEnv.sustain(mSustainParam);
+
+    mModEnv.lengths()[0] = mAttackTimeParam;
+    mModEnv.lengths()[3] = mReleaseTimeParam;
+
+    mVibEnv.levels(mVibRate1Param,
+                   mVibRate2Param,
+                   mVibRate2Param,
+                   mVibRate1Param);
+    mVibEnv.lengths()[0] = mVibRiseParam;
+    mVibEnv.lengths()[1] = mVibRiseParam;
+    mVibEnv.lengths()[3] = mVibRiseParam;
+    mVibDepth = mVibDepthParam;
     
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam);
   }
 };
 
@@ -751,6 +797,23 @@ public:
 class FMWT : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mFrequencyParam;
+  ParamHandle mAmplitudeParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mIdx1Param;
+  ParamHandle mIdx2Param;
+  ParamHandle mIdx3Param;
+  ParamHandle mCarMulParam;
+  ParamHandle mModMulParam;
+  ParamHandle mVibRate1Param;
+  ParamHandle mVibRate2Param;
+  ParamHandle mVibRiseParam;
+  ParamHandle mVibDepthParam;
+  ParamHandle mPanParam;
+  ParamHandle mTableParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::ADSR<> mAmpEnv;
@@ -758,7 +821,8 @@ public:
   gam::EnvFollow<> mEnvFollow;
   gam::ADSR<> mVibEnv;
 
-  gam::Sine<> mod, mVib; // carrier, modulator sine oscillators
+  FMBlock mFM;     // modulator and per-frame inputs (car is a wavetable)
+  BlockSine mVib;
   gam::Osc<> car;
   double a = 0;
   double b = 0;
@@ -769,9 +833,8 @@ public:
   float mVibRise;
   int mtable;
   static const int numb_waveform = 9;
-  Mesh mMesh[numb_waveform];
+  VoiceShape mMesh[numb_waveform];
   bool wireframe = false;
-  bool vertexLight = false;
 
   void init() override
   {
@@ -782,103 +845,65 @@ public:
     mAmpEnv.sustainPoint(2);
 
     // We have the mesh be a sphere
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.3, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.3, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
 
-    // Table & Visual meshes
-    // Now We have the mesh according to the waveform
+    // Tables; the matching meshes are shared by all voices
     gam::addSinesPow<1>(tbSaw, 9, 1);
-    addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
-
     gam::addSinesPow<1>(tbSqr, 9, 2);
-    addCube(mMesh[1]);  // tbSquare
-
     gam::addSinesPow<0>(tbImp, 9, 1);
-    addPrism(mMesh[2],1,1,1,100); // tbImp
-
     gam::addSine(tbSin);
-    addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
 // About: addSines (dst, amps, cycs, numh)
 // \param[out] dst		destination array
 // \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
 // \param[in] cycs		harmonic numbers of series, size must be numh - C[]
 // \param[in] numh		total number of harmonics
-    float scaler = 0.15;
-    float hscaler = 1;
 
     { //tbPls
       float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
       gam::addSines(tbPls, A, 8); 
-      addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
       gam::addSines(tb__1, A, C, 6);
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-
-        // addSphere(mMesh[5],scaler * A[i], 16, 30); // tb__1
-      }
     }
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
       gam::addSines(tb__2, A, C, 8); // tb__2
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-      }
     }
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
       gam::addSines(tb__3, A, C, 6); // tb__3
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
-      }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
       gam::addSines(tb__4, A, 8, 20); // tb__4
-      for (int i = 0; i < 7; i++){
-        addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
-      }
     }
 
-    // Scale and generate normals
-    for (int i = 0; i < numb_waveform; ++i) {
-      mMesh[i].scale(0.4);
-
-      int Nv = mMesh[i].vertices().size();
-      for (int k = 0; k < Nv; ++k) {
-        mMesh[i].color(HSV(float(k) / Nv, 0.3, 1));
-      }
-
-      if (!vertexLight && mMesh[i].primitive() == Mesh::TRIANGLES) {
-        mMesh[i].decompress();
-      }
-      mMesh[i].generateNormals();
-    }
+    for (int i = 0; i < numb_waveform; ++i) mMesh[i] = voiceVisuals.mesh(waveformMesh(i), true);
 
 
   }
@@ -886,22 +911,36 @@ public:
   //
   void onProcess(AudioIOData &io) override
   {
-    mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("carMul");
-    float modScale = getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude") * 0.01;
-    while (io())
+    float carBaseFreq = mFrequencyParam * mCarMulParam;
+    float modScale = mFrequencyParam * mModMulParam;
+    float amp = mAmplitudeParam * 0.01;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0)
     {
-      mVib.freq(mVibEnv());
-      car.freq((1 + mVib() * mVibDepth) * carBaseFreq +
-               mod() * mModEnv() * modScale);
-      float s1 = car() * mAmpEnv() * amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+      unsigned n = frames < FMBlock::kMaxFrames ? frames : FMBlock::kMaxFrames;
+      for (unsigned i = 0; i < n; ++i)
+      {
+        mFM.carFreq[i] = mVibEnv();
+        mFM.modDepth[i] = mModEnv() * modScale;
+        mFM.amp[i] = mAmpEnv() * amp;
+      }
+      // vibrato rate in, vibrato out
+      mVib.render(mFM.carFreq, mFM.carFreq, n);
+      for (unsigned i = 0; i < n; ++i)
+        mFM.carFreq[i] = (1 + mFM.carFreq[i] * mVibDepth) * carBaseFreq;
+      mFM.modulate(n);
+      for (unsigned i = 0; i < n && io(); ++i)
+      {
+        car.freq(mFM.carFreq[i]);
+        float s1 = car() * mFM.amp[i];
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     if (mAmpEnv.done() && (mEnvFollow.value() < 0.001))
       free();
@@ -912,20 +951,18 @@ public:
     a += 0.29;
     b += 0.23;
     timepose -= 0.06;
-    int shape = getInternalParameterValue("table");
+    int shape = mTableParam;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
     gl::depthTesting(true);
     g.pushMatrix();
     g.depthTesting(true);
-    g.lighting(true);
-    g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -15);
-    g.rotate(mVib() + a, Vec3f(0, 1, 0));
-    g.rotate(mVib() * mVibDepth + b, Vec3f(1));
-    float scaling = getInternalParameterValue("amplitude") * 10;
-    g.scale(scaling + getInternalParameterValue("modMul") / 2, scaling + getInternalParameterValue("carMul") / 20, scaling + mEnvFollow.value() * 5);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, getInternalParameterValue("carMul") / 20, 0.5 + getInternalParameterValue("attackTime")));
-    g.draw(mMesh[shape]);
+    g.translate(timepose, mFrequencyParam / 200 - 3, -15);
+    g.rotate(mVib.value() + a, Vec3f(0, 1, 0));
+    g.rotate(mVib.value() * mVibDepth + b, Vec3f(1));
+    float scaling = mAmplitudeParam * 10;
+    g.scale(scaling + mModMulParam / 2, scaling + mCarMulParam / 20, scaling + mEnvFollow.value() * 5);
+    voiceVisuals.add(mMesh[shape], g, Color(HSV(mModMulParam / 20, mCarMulParam / 20, 0.5 + mAttackTimeParam)));
     g.popMatrix();
   }
 
@@ -936,13 +973,12 @@ public:
     mVibEnv.reset();
     mModEnv.reset();
     mVib.phase(0);
-    mod.phase(0);
+    mFM.mod.phase(0);
     updateFromParameters();
     updateWaveform();
 
-    float modFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
-    mod.freq(modFreq);
+    float modFreq = mFrequencyParam * mModMulParam;
+    mFM.mod.freq(modFreq);
   }
   void onTriggerOff() override
   {
@@ -953,32 +989,32 @@ public:
 
   void updateFromParameters()
   {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
-
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
-    mVibDepth = getInternalParameterValue("vibDepth");
+    mModEnv.levels()[0] = mIdx1Param;
+    mModEnv.levels()[1] = mIdx2Param;
+    mModEnv.levels()[2] = mIdx2Param;
+    mModEnv.levels()[3] = mIdx3Param;
+
+    mAmpEnv.attack(mAttackTimeParam);
+    mAmpEnv.release(mReleaseTimeParam);
+    mAmpEnv.sustain(mSustainParam);
+
+    mModEnv.lengths()[0] = mAttackTimeParam;
+    mModEnv.lengths()[3] = mReleaseTimeParam;
+
+    mVibEnv.levels(mVibRate1Param,
+                   mVibRate2Param,
+                   mVibRate2Param,
+                   mVibRate1Param);
+    mVibEnv.lengths()[0] = mVibRiseParam;
+    mVibEnv.lengths()[1] = mVibRiseParam;
+    mVibEnv.lengths()[3] = mVibRiseParam;
+    mVibDepth = mVibDepthParam;
     
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam);
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam)) {
       case 0:
         car.source(tbSaw);
         break;
@@ -1016,6 +1052,19 @@ public:
 class OscTrm : public SynthVoice
 {
 public:
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mCurveParam;
+    ParamHandle mPanParam;
+    ParamHandle mTableParam;
+    ParamHandle mTrm1Param;
+    ParamHandle mTrm2Param;
+    ParamHandle mTrmRiseParam;
+    ParamHandle mTrmDepthParam;
     // Unit generators
     gam::Pan<> mPan;
     gam::Sine<> mTrm;
@@ -1027,9 +1076,8 @@ public:
     // Additional members
     int mtable;
     static const int numb_waveform = 9;
-    Mesh mMesh[numb_waveform];
+    VoiceShape mMesh[numb_waveform];
     bool wireframe = false;
-    bool vertexLight = false;
     double a_rotate = 0;
     double b_rotate = 0;
     double timepose = 0;
@@ -1041,110 +1089,65 @@ public:
         mAmpEnv.levels(0, 0.3, 0.3, 0); // These tables are not normalized, so scale to 0.3
         mTrmEnv.curve(0);
         mTrmEnv.levels(0, 1, 1, 0);
-        createInternalTriggerParameter("amplitude", 0.03, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 2.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.6, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("table", 0, 0, 8);
-        createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
-        createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
-        createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
-
-        // Table & Visual meshes
-        // Now We have the mesh according to the waveform
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.03, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 2.0, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.6, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+        mTrm1Param = createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
+        mTrm2Param = createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
+        mTrmRiseParam = createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
+        mTrmDepthParam = createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
+
+        // Tables; the matching meshes are shared by all voices
         gam::addSinesPow<1>(tbSaw, 9, 1);
-        addCone(mMesh[0], 1, Vec3f(0, 0, 5), 40, 1); // tbSaw
-
         gam::addSinesPow<1>(tbSqr, 9, 2);
-        addCube(mMesh[1]); // tbSquare
-
         gam::addSinesPow<0>(tbImp, 9, 1);
-        addPrism(mMesh[2], 1, 1, 1, 100); // tbImp
-
         gam::addSine(tbSin);
-        addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
         // About: addSines (dst, amps, cycs, numh)
         // \param[out] dst		destination array
         // \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
         // \param[in] cycs		harmonic numbers of series, size must be numh - C[]
         // \param[in] numh		total number of harmonics
-        float scaler = 0.15;
-        float hscaler = 1;
 
         { // tbPls
             float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
             gam::addSines(tbPls, A, 8);
-            addWireBox(mMesh[4], 2); // tbPls
         }
         { // tb__1
             float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
             float C[] = {1, 4, 7, 11, 15, 18, 0, 0};
             gam::addSines(tb__1, A, C, 6);
-            for (int i = 0; i < 7; i++)
-            {
-                addWireBox(mMesh[5], scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
-
-                // addSphere(mMesh[5],scaler * A[i], 16, 30); // tb__1
-            }
         }
         { // inharmonic partials
             float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
             float C[] = {3, 4, 7, 8, 11, 12, 15, 16};
             gam::addSines(tb__2, A, C, 8); // tb__2
-            for (int i = 0; i < 7; i++)
-            {
-                addWireBox(mMesh[6], scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
-            }
         }
         { // inharmonic partials
             float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0, 0};
             float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
             gam::addSines(tb__3, A, C, 6); // tb__3
-            for (int i = 0; i < 7; i++)
-            {
-                addWireBox(mMesh[7], scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
-            }
         }
         { // harmonics 20-27
             float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
             gam::addSines(tb__4, A, 8, 20); // tb__4
-            for (int i = 0; i < 7; i++)
-            {
-                addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i + 1], 1 + 0.3 * i);
-            }
         }
 
-        // Scale and generate normals
-        for (int i = 0; i < numb_waveform; ++i)
-        {
-            mMesh[i].scale(0.4);
-
-            int Nv = mMesh[i].vertices().size();
-            for (int k = 0; k < Nv; ++k)
-            {
-                mMesh[i].color(HSV(float(k) / Nv, 0.3, 1));
-            }
-
-            if (!vertexLight && mMesh[i].primitive() == Mesh::TRIANGLES)
-            {
-                mMesh[i].decompress();
-            }
-            mMesh[i].generateNormals();
-        }
+        for (int i = 0; i < numb_waveform; ++i) mMesh[i] = voiceVisuals.mesh(waveformMesh(i), true);
     }
 
     //
     virtual void onProcess(AudioIOData &io) override
     {
         // updateFromParameters();
-        float oscFreq = getInternalParameterValue("frequency");
-        float amp = getInternalParameterValue("amplitude");
-        float trmDepth = getInternalParameterValue("trmDepth");
+        float oscFreq = mFrequencyParam;
+        float amp = mAmplitudeParam;
+        float trmDepth = mTrmDepthParam;
         while (io())
         {
 
@@ -1170,24 +1173,22 @@ public:
         a_rotate += 0.81;
         b_rotate += 0.78;
         timepose -= 0.06;
-        float frequency = getInternalParameterValue("frequency");
-        int shape = getInternalParameterValue("table");
+        float frequency = mFrequencyParam;
+        int shape = mTableParam;
 
         // static Light light;
         g.polygonMode(wireframe ? GL_LINE : GL_FILL);
         // light.pos(0, 0, 0);
         gl::depthTesting(true);
-        g.lighting(true);
         // g.light(light);
         g.pushMatrix();
         g.depthTesting(true);
-        g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -15);
+        g.translate(timepose, mFrequencyParam / 200 - 3, -15);
         g.rotate(a_rotate, Vec3f(0, 1, 1));
         g.rotate(b_rotate, Vec3f(1));
         g.scale(0.2 + mAmpEnv() * 0.2 + 0.01 * mTrm(), 0.3 + mAmpEnv() * 0.5 + 0.01 * mTrm(), 0.1 + 0.01 * mTrm());
         g.scale(3 + mAmpEnv() * 0.5, 3 + mAmpEnv() * 0.5, 5 + mAmpEnv());
-        g.color(HSV(frequency / 1000, 0.6 + mAmpEnv() * 0.1, 0.6 + 0.5 * mAmpEnv()));
-        g.draw(mMesh[shape]);
+        voiceVisuals.add(mMesh[shape], g, Color(HSV(frequency / 1000, 0.6 + mAmpEnv() * 0.1, 0.6 + 0.5 * mAmpEnv())));
         g.popMatrix();
     }
 
@@ -1210,27 +1211,27 @@ public:
 
     void updateFromParameters()
     {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-        mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.sustain(getInternalParameterValue("sustain"));
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-
-        mTrmEnv.levels(getInternalParameterValue("trm1"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm1"));
-
-        mTrmEnv.attack(getInternalParameterValue("trmRise"));
-        mTrmEnv.decay(getInternalParameterValue("trmRise"));
-        mTrmEnv.release(getInternalParameterValue("trmRise"));
+        mOsc.freq(mFrequencyParam);
+        mAmpEnv.attack(mAttackTimeParam);
+        mAmpEnv.decay(mAttackTimeParam);
+        mAmpEnv.release(mReleaseTimeParam);
+        mAmpEnv.sustain(mSustainParam);
+        mAmpEnv.curve(mCurveParam);
+        mPan.pos(mPanParam);
+
+        mTrmEnv.levels(mTrm1Param,
+                       mTrm2Param,
+                       mTrm2Param,
+                       mTrm1Param);
+
+        mTrmEnv.attack(mTrmRiseParam);
+        mTrmEnv.decay(mTrmRiseParam);
+        mTrmEnv.release(mTrmRiseParam);
     }
     void updateWaveform()
     {
         // Map table number to table in memory
-        switch (int(getInternalParameterValue("table")))
+        switch (int(mTableParam))
         {
         case 0:
             mOsc.source(tbSaw);
@@ -1267,6 +1268,18 @@ public:
 class OscAM : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mPanParam;
+  ParamHandle mAmFuncParam;
+  ParamHandle mAm1Param;
+  ParamHandle mAm2Param;
+  ParamHandle mAmRiseParam;
+  ParamHandle mAmRatioParam;
   gam::Osc<> mAM;
   gam::ADSR<> mAMEnv;
   gam::Sine<> mOsc;
@@ -1274,7 +1287,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
   gam::Pan<> mPan;
   int mtable;
-  Mesh mMesh;
+  VoiceShape mMesh;
   float a = 0.f; // current rotation angle
   bool wireframe = false;
   bool vertexLight = false;
@@ -1285,9 +1298,7 @@ public:
   // Initialize voice. This function will nly be called once per voice
   virtual void init()
   {
-    addSphere(mMesh, 1, 100, 100);
-    mMesh.decompress();
-    mMesh.generateNormals();
+    mMesh = voiceVisuals.mesh(sphereMesh(1, 100, 100), true);
     mAmpEnv.levels(0, 1, 1, 0);
     //    mAmpEnv.sustainPoint(1);
 
@@ -1297,25 +1308,25 @@ public:
 
     // We have the mesh be a sphere
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 4, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.3, 0.1, 1.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
-    createInternalTriggerParameter("am1", 0.75, 0.0, 1.0);
-    createInternalTriggerParameter("am2", 0.75, 0.0, 1.0);
-    createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRatio", 0.75, 0.0, 2.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 4, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.3, 0.1, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmFuncParam = createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
+    mAm1Param = createInternalTriggerParameter("am1", 0.75, 0.0, 1.0);
+    mAm2Param = createInternalTriggerParameter("am2", 0.75, 0.0, 1.0);
+    mAmRiseParam = createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
+    mAmRatioParam = createInternalTriggerParameter("amRatio", 0.75, 0.0, 2.0);
   }
 
   virtual void onProcess(AudioIOData &io) override
   {
-    mOsc.freq(getInternalParameterValue("frequency"));
+    mOsc.freq(mFrequencyParam);
 
-    float amp = getInternalParameterValue("amplitude");
-    float amRatio = getInternalParameterValue("amRatio");
+    float amp = mAmplitudeParam;
+    float amRatio = mAmRatioParam;
     while (io())
     {
 
@@ -1342,9 +1353,9 @@ public:
 
   virtual void onProcess(Graphics &g)
   {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
-    float pan = getInternalParameterValue("pan");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
+    float pan = mPanParam;
     int shape = getInternalParameterValue("table");
     float radius = frequency / 300;
     b_rotate += 1.1;
@@ -1353,7 +1364,6 @@ public:
     // g.rotate(b_rotate, Vec3f(1));
 
     gl::depthTesting(true);
-    g.lighting(true);
     // g.light().dir(1.f, 1.f, 2.f);
     g.pushMatrix();
     g.translate(radius * sin(timepose) + 2, radius * cos(timepose), -15 + pan);
@@ -1362,29 +1372,28 @@ public:
     g.rotate(b_rotate, spinner);
     g.scale(0.05 * mAM() + 0.3);
     // center the model
-    g.color(HSV(mOsc.freq() * getInternalParameterValue("amRatio") / 1000 + mAM() * 0.01, 0.5 + mAmpEnv() * 0.5, 0.05 + 5 * mAmpEnv()));
-    g.draw(mMesh);
+    voiceVisuals.add(mMesh, g, Color(HSV(mOsc.freq() * mAmRatioParam / 1000 + mAM() * 0.01, 0.5 + mAmpEnv() * 0.5, 0.05 + 5 * mAmpEnv())));
     g.popMatrix();
   }
 
   virtual void onTriggerOn() override
   {
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
+    mAmpEnv.attack(mAttackTimeParam);
     mAmpEnv.lengths()[1] = 0.001;
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
+    mAmpEnv.release(mReleaseTimeParam);
 
-    mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
+    mAmpEnv.levels()[1] = mSustainParam;
+    mAmpEnv.levels()[2] = mSustainParam;
 
-    mAMEnv.levels(getInternalParameterValue("am1"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am1"));
+    mAMEnv.levels(mAm1Param,
+                  mAm2Param,
+                  mAm2Param,
+                  mAm1Param);
 
-    mAMEnv.lengths(getInternalParameterValue("amRise"),
-                   1 - getInternalParameterValue("amRise"));
+    mAMEnv.lengths(mAmRiseParam,
+                   1 - mAmRiseParam);
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam);
 
     mAmpEnv.reset();
     mAMEnv.reset();
@@ -1392,7 +1401,7 @@ public:
     b_rotate = al::rnd::uniform(0, 360);
     spinner = randomVec3f(1);
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("amFunc")))
+    switch (int(mAmFuncParam))
     {
     case 0:
       mAM.source(tbSin);
@@ -1420,16 +1429,36 @@ public:
 class AddSyn : public SynthVoice
 {
 public:
-  gam::Sine<> mOsc;
-  gam::Sine<> mOsc1;
-  gam::Sine<> mOsc2;
-  gam::Sine<> mOsc3;
-  gam::Sine<> mOsc4;
-  gam::Sine<> mOsc5;
-  gam::Sine<> mOsc6;
-  gam::Sine<> mOsc7;
-  gam::Sine<> mOsc8;
-  gam::Sine<> mOsc9;
+  // Trigger parameters
+  ParamHandle mAmpParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAmpStriParam;
+  ParamHandle mAttackStriParam;
+  ParamHandle mReleaseStriParam;
+  ParamHandle mSustainStriParam;
+  ParamHandle mAmpLowParam;
+  ParamHandle mAttackLowParam;
+  ParamHandle mReleaseLowParam;
+  ParamHandle mSustainLowParam;
+  ParamHandle mAmpUpParam;
+  ParamHandle mAttackUpParam;
+  ParamHandle mReleaseUpParam;
+  ParamHandle mSustainUpParam;
+  ParamHandle mFreqStri1Param;
+  ParamHandle mFreqStri2Param;
+  ParamHandle mFreqStri3Param;
+  ParamHandle mFreqLow1Param;
+  ParamHandle mFreqLow2Param;
+  ParamHandle mFreqUp1Param;
+  ParamHandle mFreqUp2Param;
+  ParamHandle mFreqUp3Param;
+  ParamHandle mFreqUp4Param;
+  ParamHandle mPanParam;
+  // Partials 0-2 follow mEnvStri, 3-4 mEnvLow, 5-8 mEnvUp
+  PartialBank mPartials;
+  float mStri[PartialBank::kMaxFrames];
+  float mLow[PartialBank::kMaxFrames];
+  float mUp[PartialBank::kMaxFrames];
   gam::ADSR<> mEnvStri;
   gam::ADSR<> mEnvLow;
   gam::ADSR<> mEnvUp;
@@ -1437,7 +1466,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh ball;
+  VoiceShape ball;
   double a = 0;
   double b = 0;
   double timepose = 0;
@@ -1461,66 +1490,75 @@ public:
     mEnvUp.sustain(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a sphere
-    addSphere(ball, 1, 100, 100);
-    ball.decompress();
-    ball.generateNormals();
-
-    createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
-    createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
-    createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
-    createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
-    createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
-    createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
-    createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
-    createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
-    createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
-    createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
-    createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    ball = voiceVisuals.mesh(sphereMesh(1, 100, 100), true);
+
+    mPartials.resize(9);
+
+    mAmpParam = createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAmpStriParam = createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
+    mAttackStriParam = createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
+    mReleaseStriParam = createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
+    mSustainStriParam = createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
+    mAmpLowParam = createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
+    mAttackLowParam = createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
+    mReleaseLowParam = createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
+    mSustainLowParam = createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
+    mAmpUpParam = createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
+    mAttackUpParam = createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
+    mReleaseUpParam = createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
+    mSustainUpParam = createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
+    mFreqStri1Param = createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
+    mFreqStri2Param = createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
+    mFreqStri3Param = createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
+    mFreqLow1Param = createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
+    mFreqLow2Param = createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
+    mFreqUp1Param = createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
+    mFreqUp2Param = createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
+    mFreqUp3Param = createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
+    mFreqUp4Param = createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   virtual void onProcess(AudioIOData &io) override
   {
     // Parameters will update values once per audio callback
-    float freq = getInternalParameterValue("frequency");
-    mOsc.freq(freq);
-    mOsc1.freq(getInternalParameterValue("freqStri1") * freq);
-    mOsc2.freq(getInternalParameterValue("freqStri2") * freq);
-    mOsc3.freq(getInternalParameterValue("freqStri3") * freq);
-    mOsc4.freq(getInternalParameterValue("freqLow1") * freq);
-    mOsc5.freq(getInternalParameterValue("freqLow2") * freq);
-    mOsc6.freq(getInternalParameterValue("freqUp1") * freq);
-    mOsc7.freq(getInternalParameterValue("freqUp2") * freq);
-    mOsc8.freq(getInternalParameterValue("freqUp3") * freq);
-    mOsc9.freq(getInternalParameterValue("freqUp4") * freq);
-    mPan.pos(getInternalParameterValue("pan"));
-    float ampStri = getInternalParameterValue("ampStri");
-    float ampUp = getInternalParameterValue("ampUp");
-    float ampLow = getInternalParameterValue("ampLow");
-    float amp = getInternalParameterValue("amp");
-    while (io())
+    float freq = mFrequencyParam;
+    mPartials.freq(0, mFreqStri1Param * freq);
+    mPartials.freq(1, mFreqStri2Param * freq);
+    mPartials.freq(2, mFreqStri3Param * freq);
+    mPartials.freq(3, mFreqLow1Param * freq);
+    mPartials.freq(4, mFreqLow2Param * freq);
+    mPartials.freq(5, mFreqUp1Param * freq);
+    mPartials.freq(6, mFreqUp2Param * freq);
+    mPartials.freq(7, mFreqUp3Param * freq);
+    mPartials.freq(8, mFreqUp4Param * freq);
+    mPan.pos(mPanParam);
+    float ampStri = mAmpStriParam;
+    float ampUp = mAmpUpParam;
+    float ampLow = mAmpLowParam;
+    float amp = mAmpParam;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0)
     {
-      float s1 = (mOsc1() + mOsc2() + mOsc3()) * mEnvStri() * ampStri;
-      s1 += (mOsc4() + mOsc5()) * mEnvLow() * ampLow;
-      s1 += (mOsc6() + mOsc7() + mOsc8() + mOsc9()) * mEnvUp() * ampUp;
-      s1 *= amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+      unsigned n = frames < PartialBank::kMaxFrames ? frames : PartialBank::kMaxFrames;
+      mPartials.render(mStri, n, 0, 3);
+      mPartials.render(mLow, n, 3, 5);
+      mPartials.render(mUp, n, 5, 9);
+      for (unsigned i = 0; i < n && io(); ++i)
+      {
+        float s1 = mStri[i] * mEnvStri() * ampStri;
+        s1 += mLow[i] * mEnvLow() * ampLow;
+        s1 += mUp[i] * mEnvUp() * ampUp;
+        s1 *= amp;
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     // if(mEnvStri.done()) free();
     if (mEnvStri.done() && mEnvUp.done() && mEnvLow.done() && (mEnvFollow.value() < 0.001))
@@ -1534,46 +1572,44 @@ public:
     timepose += 0.02;
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
+    float frequency = mFrequencyParam;
     float amplitude = getInternalParameterValue("amplitude");
     // Now draw
     g.pushMatrix();
     g.depthTesting(true);
-    g.lighting(true);
     g.translate(Vec3f(0, 0, -15));
     // g.translate(note_position + note_direction * timepose);
     g.rotate(a, Vec3f(0, 1, 0));
     g.rotate(b, Vec3f(1));
     g.scale(0.3 + mEnvStri() * 0.2, 0.3 + mEnvStri() * 0.5, 1);
-    g.color(HSV(frequency / 1000, 0.5 + mEnvStri() * 0.1, 0.3 + 0.5 * mEnvStri()));
-    g.draw(ball);
+    voiceVisuals.add(ball, g, Color(HSV(frequency / 1000, 0.5 + mEnvStri() * 0.1, 0.3 + 0.5 * mEnvStri())));
     g.popMatrix();
   }
 
   virtual void onTriggerOn() override
   {
 
-    mEnvStri.attack(getInternalParameterValue("attackStri"));
-    mEnvStri.decay(getInternalParameterValue("attackStri"));
-    mEnvStri.sustain(getInternalParameterValue("sustainStri"));
-    mEnvStri.release(getInternalParameterValue("releaseStri"));
+    mEnvStri.attack(mAttackStriParam);
+    mEnvStri.decay(mAttackStriParam);
+    mEnvStri.sustain(mSustainStriParam);
+    mEnvStri.release(mReleaseStriParam);
 
-    mEnvLow.attack(getInternalParameterValue("attackLow"));
-    mEnvLow.decay(getInternalParameterValue("attackLow"));
-    mEnvLow.sustain(getInternalParameterValue("sustainLow"));
-    mEnvLow.release(getInternalParameterValue("releaseLow"));
+    mEnvLow.attack(mAttackLowParam);
+    mEnvLow.decay(mAttackLowParam);
+    mEnvLow.sustain(mSustainLowParam);
+    mEnvLow.release(mReleaseLowParam);
 
-    mEnvUp.attack(getInternalParameterValue("attackUp"));
-    mEnvUp.decay(getInternalParameterValue("attackUp"));
-    mEnvUp.sustain(getInternalParameterValue("sustainUp"));
-    mEnvUp.release(getInternalParameterValue("releaseUp"));
+    mEnvUp.attack(mAttackUpParam);
+    mEnvUp.decay(mAttackUpParam);
+    mEnvUp.sustain(mSustainUpParam);
+    mEnvUp.release(mReleaseUpParam);
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam);
 
     mEnvStri.reset();
     mEnvLow.reset();
     mEnvUp.reset();
-    float angle = getInternalParameterValue("frequency") / 200;
+    float angle = mFrequencyParam / 200;
 
     a = al::rnd::uniform();
     b = al::rnd::uniform();
@@ -1594,6 +1630,24 @@ public:
 class Sub : public SynthVoice
 {
 public:
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mCurveParam;
+    ParamHandle mNoiseParam;
+    ParamHandle mEnvDurParam;
+    ParamHandle mCf1Param;
+    ParamHandle mCf2Param;
+    ParamHandle mCfRiseParam;
+    ParamHandle mBw1Param;
+    ParamHandle mBw2Param;
+    ParamHandle mBwRiseParam;
+    ParamHandle mHmnumParam;
+    ParamHandle mHmampParam;
+    ParamHandle mPanParam;
     // Unit generators
     float mNoiseMix;
     gam::Pan<> mPan;
@@ -1605,7 +1659,7 @@ public:
     gam::Env<2> mCFEnv;
     gam::Env<2> mBWEnv;
     // Additional members
-    Mesh mMesh;
+    VoiceShape mMesh;
     double a = 0;
     double b = 0;
     double timepose = 0;
@@ -1621,27 +1675,25 @@ public:
         mBWEnv.curve(0);
         mOsc.harmonics(12);
         // We have the mesh be a sphere
-        addSphere(mMesh, 1, 100, 100);
-        mMesh.decompress();
-        mMesh.generateNormals();
-
-        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
-        createInternalTriggerParameter("envDur", 1, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
-        createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mMesh = voiceVisuals.mesh(sphereMesh(1, 100, 100), true);
+
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur", 1, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
     }
 
     //
@@ -1649,8 +1701,8 @@ public:
     virtual void onProcess(AudioIOData &io) override
     {
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam;
+        float noiseMix = mNoiseParam;
         while (io())
         {
             // mix oscillator with noise
@@ -1680,19 +1732,17 @@ public:
         timepose += 0.02;
         // Get the paramter values on every video frame, to apply changes to the
         // current instance
-        float frequency = getInternalParameterValue("frequency");
-        float amplitude = getInternalParameterValue("amplitude");
+        float frequency = mFrequencyParam;
+        float amplitude = mAmplitudeParam;
         // Now draw
         g.pushMatrix();
         g.depthTesting(true);
-        g.lighting(true);
         // g.translate(note_position);
         g.translate(note_position + note_direction * timepose);
         g.rotate(a, Vec3f(mCFEnv(), mBWEnv(), 0));
         g.rotate(b, Vec3f(mNoise()));
         g.scale(mCFEnv()/ 10000, mBWEnv()/ 10000,  0.3 + 0.1*mNoise());
-        g.color(HSV(frequency / 1000, 0.5 + mOsc() * 0.1, 0.3 + 0.1*mNoise()));
-        g.draw(mMesh);
+        voiceVisuals.add(mMesh, g, Color(HSV(frequency / 1000, 0.5 + mOsc() * 0.1, 0.3 + 0.1*mNoise())));
         g.popMatrix();
     }
     virtual void onTriggerOn() override
@@ -1705,7 +1755,7 @@ public:
         b = al::rnd::uniform();
         timepose = 0;
         note_position = {0, 0, -15};
-        float angle = getInternalParameterValue("frequency") / 200;
+        float angle = mFrequencyParam / 200;
         note_direction = {sin(angle), cos(angle), 0};
     }
 
@@ -1718,31 +1768,31 @@ public:
 
     void updateFromParameters()
     {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-        //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1 - getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam);
+        mOsc.harmonics(mHmnumParam);
+        mOsc.ampRatio(mHmampParam);
+        mAmpEnv.attack(mAttackTimeParam);
+        //    mAmpEnv.decay(mAttackTimeParam);
+        mAmpEnv.release(mReleaseTimeParam);
+        mAmpEnv.levels()[1] = mSustainParam;
+        mAmpEnv.levels()[2] = mSustainParam;
+
+        mAmpEnv.curve(mCurveParam);
+        mPan.pos(mPanParam);
+        mCFEnv.levels(mCf1Param,
+                      mCf2Param,
+                      mCf1Param);
+
+        mCFEnv.lengths()[0] = mCfRiseParam;
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam;
+        mBWEnv.levels(mBw1Param,
+                      mBw2Param,
+                      mBw1Param);
+        mBWEnv.lengths()[0] = mBwRiseParam;
+        mBWEnv.lengths()[1] = 1 - mBwRiseParam;
+
+        mCFEnv.totalLength(mEnvDurParam);
+        mBWEnv.totalLength(mEnvDurParam);
     }
 };
 
@@ -1750,6 +1800,15 @@ public:
 class PluckedString : public SynthVoice
 {
 public:
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mPan1Param;
+    ParamHandle mPan2Param;
+    ParamHandle mPanRiseParam;
     float mAmp;
     float mDur;
     float mPanRise;
@@ -1761,36 +1820,31 @@ public:
     gam::ADSR<> mAmpEnv;
     gam::EnvFollow<> mEnvFollow;
     gam::Env<2> mPanEnv;
-    gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
-    // This time, let's use spectrograms for each notes as the visual components.
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // This time, let's use spectrograms for each notes as the visual
+    // components: spectrumHistory, drawn as points.
     double a = 0;
     double b = 0;
     double timepose = 10;
     // Additional members
-    Mesh mMesh;
+    SharedMesh::Ptr mMesh;
 
     virtual void init() override
     {
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
-        mSpectrogram.primitive(Mesh::POINTS);
         mAmpEnv.levels(0, 1, 1, 0);
         mPanEnv.curve(4);
         env.decay(0.1);
         delay.maxDelay(1. / 27.5);
         delay.delay(1. / 440.0);
 
-        addDisc(mMesh, 1.0, 30);
-        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("PanRise", 0.0, 0, 3.0); // range check
+        mMesh = SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); });
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mPan1Param = createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
+        mPan2Param = createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
+        mPanRiseParam = createInternalTriggerParameter("PanRise", 0.0, 0, 3.0); // range check
     }
 
     //    void reset(){ env.reset(); }
@@ -1817,15 +1871,8 @@ public:
             mPan(s1, s1, s2);
             io.out(0) += s1;
             io.out(1) += s2;
-            // STFT for each notes
-            if (stft(s1))
-            { // Loop through all the frequency bins
-                for (unsigned k = 0; k < stft.numBins(); ++k)
-                {
-                    // Here we simply scale the complex sample
-                    spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
-                }
-            }
+            // Feed the shared analyzer
+            spectrumBus.add(io.frame(), s1);
         }
         if (mAmpEnv.done() && (mEnvFollow.value() < 0.001))
             free();
@@ -1833,28 +1880,19 @@ public:
 
     virtual void onProcess(Graphics &g) override
     {
-        float frequency = getInternalParameterValue("frequency");
-        float amplitude = getInternalParameterValue("amplitude");
+        float frequency = mFrequencyParam;
+        float amplitude = mAmplitudeParam;
         a += 0.29;
         b += 0.23;
         timepose -= 0.1;
 
-        mSpectrogram.reset();
-        // mSpectrogram.primitive(Mesh::LINE_STRIP);
-
-        for (int i = 0; i < FFT_SIZE / 2; i++)
-        {
-            mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-            mSpectrogram.vertex(i, spectrum[i], 0.0);
-        }
-        g.meshColor(); // Use the color in the mesh
         g.pushMatrix();
         g.translate(0, 0, -15);
         g.rotate(a, Vec3f(0, 1, 0));
         g.rotate(b, Vec3f(1));
-        g.scale(10.0 / FFT_SIZE, 500, 1.0);
+        g.scale(5.0, 500, 1.0);
         g.pointSize(1);
-        g.draw(mSpectrogram);
+        spectrumHistory.drawTrace(g, spectrumHistory.rows(), true);
         g.popMatrix();
     }
 
@@ -1875,16 +1913,16 @@ public:
 
     void updateFromParameters()
     {
-        mPanEnv.levels(getInternalParameterValue("Pan1"),
-                       getInternalParameterValue("Pan2"),
-                       getInternalParameterValue("Pan1"));
-        mPanRise = getInternalParameterValue("PanRise");
-        delay.freq(getInternalParameterValue("frequency"));
-        mAmp = getInternalParameterValue("amplitude");
+        mPanEnv.levels(mPan1Param,
+                       mPan2Param,
+                       mPan1Param);
+        mPanRise = mPanRiseParam;
+        delay.freq(mFrequencyParam);
+        mAmp = mAmplitudeParam;
         mAmpEnv.levels()[1] = 1.0;
-        mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-        mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-        mAmpEnv.lengths()[3] = getInternalParameterValue("releaseTime");
+        mAmpEnv.levels()[2] = mSustainParam;
+        mAmpEnv.lengths()[0] = mAttackTimeParam;
+        mAmpEnv.lengths()[3] = mReleaseTimeParam;
         mPanEnv.lengths()[0] = mPanRise;
         mPanEnv.lengths()[1] = mPanRise;
     }
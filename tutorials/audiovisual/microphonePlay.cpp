@@ -8,12 +8,15 @@
 #include "al/math/al_Random.hpp"
 #include "Gamma/DFT.h"
 
+#include "../synthesis/ScrollingHistory.h"
+
 using namespace al;
 using namespace std;
 #define FFT_SIZE 1024
 #define BLOCK_SIZE 512
 #define CHANNEL_COUNT 2
 #define SAMPLE_RATE 48000.0f
+#define WAVEFORM_BLOCKS 4 // Blocks shown by the waveforms
 
 struct MyApp : public App
 {
@@ -24,12 +27,13 @@ struct MyApp : public App
   // Window type: HAMMING, HANN, WELCH, NYQUIST, or etc
   // Format of frequency samples: COMPLEX, MAG_PHASE, or MAG_FREQ
   gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
-  Mesh mSpectrogram;
-  vector<float> spectrum;
-  float i_waveformData[BLOCK_SIZE * CHANNEL_COUNT]{0}; // Waveform variables
-  float o_waveformData[BLOCK_SIZE * CHANNEL_COUNT]{0}; // Waveform variables
-  Mesh i_waveformMesh[2]{Mesh::LINE_STRIP, Mesh::LINE_STRIP};
-  Mesh o_waveformMesh[2]{Mesh::POINTS, Mesh::POINTS};
+  // Spectra and waveform blocks go to the GPU as they come in, and are
+  // drawn from there; see ScrollingHistory.h
+  ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
+  ScrollingHistory i_waveform[CHANNEL_COUNT]{{BLOCK_SIZE, 2 * WAVEFORM_BLOCKS},
+                                             {BLOCK_SIZE, 2 * WAVEFORM_BLOCKS}};
+  ScrollingHistory o_waveform[CHANNEL_COUNT]{{BLOCK_SIZE, 2 * WAVEFORM_BLOCKS},
+                                             {BLOCK_SIZE, 2 * WAVEFORM_BLOCKS}};
 
   void onInit() override
   {
@@ -40,35 +44,23 @@ struct MyApp : public App
       quit();
       return;
     }
-    // Declare the size of the spectrum
-    spectrum.resize(FFT_SIZE / 2 + 1);
-    mSpectrogram.primitive(Mesh::LINE_STRIP);
+    // Colors, as hue + value * hue gain
+    spectrogram.color(0.5, -100);
+    for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+      i_waveform[ch].color(0, 10);
+      o_waveform[ch].color(0, 1000);
+    }
     nav().pos(Vec3f(0, 0, 0));
   }
 
   void onAnimate(double dt)
   {
-    // Waveform i/o
+    // Upload what the audio thread pushed since the last frame
     for(int ch = 0; ch < CHANNEL_COUNT; ch++) {
-      i_waveformMesh[ch].reset();
-      o_waveformMesh[ch].reset();
-      for(int i = 0; i < BLOCK_SIZE; i++) {
-        float x = i / float(BLOCK_SIZE);
-        float iy = (i_waveformData[ch * BLOCK_SIZE + i]);
-        float oy = (o_waveformData[ch * BLOCK_SIZE + i]);
-        i_waveformMesh[ch].vertex(10 * x, 100 * iy, 0);
-        i_waveformMesh[ch].color(HSV(iy*10, 1., 1.));
-        o_waveformMesh[ch].vertex(10 * x, 10 * oy, 0);
-        o_waveformMesh[ch].color(HSV(al::rnd::uniform(oy*1000), 1., 1.));
-      }
-    }
-    // Spectrogram
-    mSpectrogram.reset();
-    for (int i = 0; i < FFT_SIZE / 2; i++)
-    {
-      mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-      mSpectrogram.vertex(i, spectrum[i], 0.0);
+      i_waveform[ch].update();
+      o_waveform[ch].update();
     }
+    spectrogram.update();
   }
   void onSound(AudioIOData &io) override
   {
@@ -76,35 +68,47 @@ struct MyApp : public App
     {
       if (stft(io.in(0)))
       { // Loop through all the frequency bins
+        float spectrum[FFT_SIZE / 2 + 1];
         for (unsigned k = 0; k < stft.numBins(); ++k)
         {
           // Here we simply scale the complex sample
           spectrum[k] = stft.bin(k).real();
         }
+        spectrogram.push(spectrum);
       }
       // // Process the outputs - Randomized
       io.out(0) = al::rnd::uniform(io.in(0)*10);
       io.out(1) = al::rnd::uniform(io.in(1)*10);
     }
-    memcpy(&i_waveformData, io.inBuffer(), BLOCK_SIZE * CHANNEL_COUNT * sizeof(float));
-    memcpy(&o_waveformData, io.outBuffer(), BLOCK_SIZE * CHANNEL_COUNT * sizeof(float));
+    if (io.framesPerBuffer() == BLOCK_SIZE) {
+      for (int ch = 0; ch < CHANNEL_COUNT; ch++) {
+        i_waveform[ch].push(io.inBuffer(ch));
+        o_waveform[ch].push(io.outBuffer(ch));
+      }
+    }
   }
   // The graphics callback function.
   void onDraw(Graphics &g) override
   {
     g.clear();
+    // Draw Spectrogram history, newest spectrum on the right
+    g.pushMatrix();
+    g.translate(-25, -15, -40);
+    g.scale(50, 30, 1.0);
+    spectrogram.drawImage(g, 1000);
+    g.popMatrix();
     // Draw Spectrum
-    g.meshColor(); // Use the color in the mesh
     g.pushMatrix();
     g.translate(-5, 0, -20);
-    g.scale(100.0 / FFT_SIZE, 1000, 1.0);
-    g.draw(mSpectrogram);
+    g.scale(50, 1000, 1.0);
+    spectrogram.drawTrace(g, spectrogram.rows());
     g.popMatrix();
     // Input Waveform
     for(int ch = 0; ch < CHANNEL_COUNT; ch++) { 
       g.pushMatrix();
       g.translate(-5, 3 * (ch+1), -20);
-      g.draw(i_waveformMesh[ch]);
+      g.scale(10, 100, 1.0);
+      i_waveform[ch].drawTrace(g, WAVEFORM_BLOCKS * BLOCK_SIZE);
       g.popMatrix();
     }
     // Output Waveform
@@ -112,7 +116,8 @@ struct MyApp : public App
       g.pushMatrix();
       g.pointSize(3);
       g.translate(-5, - 3 * (ch+1), -20);
-      g.draw(o_waveformMesh[ch]);
+      g.scale(10, 10, 1.0);
+      o_waveform[ch].drawTrace(g, WAVEFORM_BLOCKS * BLOCK_SIZE, true);
       g.popMatrix();
     }    
   }
@@ -13,22 +13,36 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "ParamHandle.h"
+#include "PartialBank.h"
+
 using namespace gam;
 using namespace al;
 using namespace std;
 
 class AddSyn : public SynthVoice {
 public:
-  gam::Sine<> mOsc;
-  gam::Sine<> mOsc1;
-  gam::Sine<> mOsc2;
-  gam::Sine<> mOsc3;
-  gam::Sine<> mOsc4;
-  gam::Sine<> mOsc5;
-  gam::Sine<> mOsc6;
-  gam::Sine<> mOsc7;
-  gam::Sine<> mOsc8;
-  gam::Sine<> mOsc9;
+  // Trigger parameters
+  ParamHandle mAmpParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAmpStriParam;
+  ParamHandle mAmpLowParam;
+  ParamHandle mAmpUpParam;
+  ParamHandle mFreqStri1Param;
+  ParamHandle mFreqStri2Param;
+  ParamHandle mFreqStri3Param;
+  ParamHandle mFreqLow1Param;
+  ParamHandle mFreqLow2Param;
+  ParamHandle mFreqUp1Param;
+  ParamHandle mFreqUp2Param;
+  ParamHandle mFreqUp3Param;
+  ParamHandle mFreqUp4Param;
+  ParamHandle mPanParam;
+  // Partials 0-2 follow mEnvStri, 3-4 mEnvLow, 5-8 mEnvUp
+  PartialBank mPartials;
+  float mStri[PartialBank::kMaxFrames];
+  float mLow[PartialBank::kMaxFrames];
+  float mUp[PartialBank::kMaxFrames];
   gam::ADSR<> mEnvStri;
   gam::ADSR<> mEnvLow;
   gam::ADSR<> mEnvUp;
@@ -57,60 +71,70 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
+    mPartials.resize(9);
+
+    mAmpParam = createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAmpStriParam = createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
     createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
     createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
     createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
+    mAmpLowParam = createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
     createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
     createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
     createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
+    mAmpUpParam = createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
     createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
     createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
     createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
-    createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
-    createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
-    createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
-    createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
-    createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
-    createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mFreqStri1Param = createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
+    mFreqStri2Param = createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
+    mFreqStri3Param = createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
+    mFreqLow1Param = createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
+    mFreqLow2Param = createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
+    mFreqUp1Param = createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
+    mFreqUp2Param = createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
+    mFreqUp3Param = createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
+    mFreqUp4Param = createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   virtual void onProcess(AudioIOData &io) override {
     // Parameters will update values once per audio callback
-    float freq = getInternalParameterValue("frequency");
-    mOsc.freq(freq);
-    mOsc1.freq(getInternalParameterValue("freqStri1") * freq);
-    mOsc2.freq(getInternalParameterValue("freqStri2") * freq);
-    mOsc3.freq(getInternalParameterValue("freqStri3") * freq);
-    mOsc4.freq(getInternalParameterValue("freqLow1") * freq);
-    mOsc5.freq(getInternalParameterValue("freqLow2") * freq);
-    mOsc6.freq(getInternalParameterValue("freqUp1") * freq);
-    mOsc7.freq(getInternalParameterValue("freqUp2") * freq);
-    mOsc8.freq(getInternalParameterValue("freqUp3") * freq);
-    mOsc9.freq(getInternalParameterValue("freqUp4") * freq);
-    mPan.pos(getInternalParameterValue("pan"));
-    float ampStri = getInternalParameterValue("ampStri");
-    float ampUp = getInternalParameterValue("ampUp");
-    float ampLow = getInternalParameterValue("ampLow");
-    float amp = getInternalParameterValue("amp");
-    while (io()) {
-      float s1 = (mOsc1() + mOsc2() + mOsc3()) * mEnvStri() * ampStri;
-      s1 += (mOsc4() + mOsc5()) * mEnvLow() * ampLow;
-      s1 += (mOsc6() + mOsc7() + mOsc8() + mOsc9()) * mEnvUp() * ampUp;
-      s1 *= amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+    float freq = mFrequencyParam;
+    mPartials.freq(0, mFreqStri1Param * freq);
+    mPartials.freq(1, mFreqStri2Param * freq);
+    mPartials.freq(2, mFreqStri3Param * freq);
+    mPartials.freq(3, mFreqLow1Param * freq);
+    mPartials.freq(4, mFreqLow2Param * freq);
+    mPartials.freq(5, mFreqUp1Param * freq);
+    mPartials.freq(6, mFreqUp2Param * freq);
+    mPartials.freq(7, mFreqUp3Param * freq);
+    mPartials.freq(8, mFreqUp4Param * freq);
+    mPan.pos(mPanParam);
+    float ampStri = mAmpStriParam;
+    float ampUp = mAmpUpParam;
+    float ampLow = mAmpLowParam;
+    float amp = mAmpParam;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0) {
+      unsigned n = frames < PartialBank::kMaxFrames ? frames : PartialBank::kMaxFrames;
+      mPartials.render(mStri, n, 0, 3);
+      mPartials.render(mLow, n, 3, 5);
+      mPartials.render(mUp, n, 5, 9);
+      for (unsigned i = 0; i < n && io(); ++i) {
+        float s1 = mStri[i] * mEnvStri() * ampStri;
+        s1 += mLow[i] * mEnvLow() * ampLow;
+        s1 += mUp[i] * mEnvUp() * ampUp;
+        s1 *= amp;
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     // if(mEnvStri.done()) free();
     if (mEnvStri.done() && mEnvUp.done() && mEnvLow.done() &&
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef AudioClock_H
+#define AudioClock_H
+
+// Seconds of audio rendered so far, advanced from the audio callback.
+//
+// A SynthSequencer's "from now" is its own time, which moves a buffer at a
+// time on the audio thread. Code on other threads that schedules against it
+// (ScoreStreamer, VoicePool) reads the time from here rather than the wall
+// clock, so the two never drift apart:
+//
+//   AudioClock audioClock;                          // app member
+//   audioClock.tick(io);                            // onSound(), after render
+
+#include <stdint.h>
+#include <atomic>
+
+#include "al/io/al_AudioIOData.hpp"
+
+class AudioClock
+{
+public:
+	// Audio thread, once per callback after the synth has rendered
+	void tick(const al::AudioIOData &io)
+	{
+		mBufferSeconds.store(io.framesPerBuffer() / io.framesPerSecond(), std::memory_order_relaxed);
+		mSeconds.store(mSeconds.load(std::memory_order_relaxed) + mBufferSeconds.load(std::memory_order_relaxed),
+		               std::memory_order_relaxed);
+		mTicks.fetch_add(1, std::memory_order_release);
+	}
+
+	double seconds() const { return mSeconds.load(std::memory_order_relaxed); }
+	double bufferSeconds() const { return mBufferSeconds.load(std::memory_order_relaxed); }
+	uint64_t ticks() const { return mTicks.load(std::memory_order_acquire); }
+
+private:
+	std::atomic<double> mSeconds{0};
+	std::atomic<double> mBufferSeconds{0};
+	std::atomic<uint64_t> mTicks{0};
+};
+
+#endif
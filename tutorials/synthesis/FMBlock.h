@@ -0,0 +1,56 @@
+#pragma once
+#ifndef FMBlock_H
+#define FMBlock_H
+
+// Block-rendered two-operator FM.
+//
+// The FM voices used to set the carrier frequency and pull one sample from
+// each gam::Sine per frame. FMBlock renders a whole block instead: the
+// caller fills the per-frame carrier frequency, modulation depth and
+// amplitude (usually straight from its envelopes), then render() runs the
+// modulator, the phase accumulation and the sine evaluation over the block
+// with SSE2/AVX2 when the compiler targets them and plain loops otherwise.
+//
+//   for (unsigned i = 0; i < n; ++i) {
+//     mFM.carFreq[i]  = carBaseFreq;
+//     mFM.modDepth[i] = mModEnv() * modScale;
+//     mFM.amp[i]      = mAmpEnv() * amp;
+//   }
+//   mFM.render(n);          // mFM.out[0..n) holds the voice
+//
+// The oscillators are BlockSine (BlockSine.h).
+
+#include "BlockSine.h"
+
+// Carrier + modulator with per-frame control buffers
+class FMBlock
+{
+public:
+	enum { kMaxFrames = 256 };
+
+	BlockSine car, mod;
+
+	// Filled by the caller for each block
+	float carFreq[kMaxFrames];  // carrier frequency before modulation (Hz)
+	float modDepth[kMaxFrames]; // modulator output scale (Hz)
+	float amp[kMaxFrames];
+
+	float out[kMaxFrames];
+
+	// carFreq[i] += mod * modDepth[i]. For voices with their own carrier.
+	void modulate(unsigned n)
+	{
+		mod.render(out, n);
+		for (unsigned i = 0; i < n; ++i) carFreq[i] += out[i] * modDepth[i];
+	}
+
+	// out[i] = car(carFreq[i] + mod * modDepth[i]) * amp[i]
+	void render(unsigned n)
+	{
+		modulate(n);
+		car.render(out, carFreq, n);
+		for (unsigned i = 0; i < n; ++i) out[i] *= amp[i];
+	}
+};
+
+#endif
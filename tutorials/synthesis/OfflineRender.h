@@ -0,0 +1,132 @@
+#pragma once
+#ifndef OfflineRender_H
+#define OfflineRender_H
+
+// Renders an app's audio graph to a WAV file without an audio device.
+//
+// OfflineRender owns an AudioIOData and hands it, one buffer at a time, to
+// a callback that does what onSound() does (usually it just calls onSound).
+// Buffers are produced as fast as the CPU allows and written as 32-bit
+// float WAV, so the result is the same on every run and every machine,
+// sound card or not.
+//
+//   OfflineRender render(48000, 512, 2);
+//   render.toWav("fugue.wav",
+//                [&](AudioIOData &io) { onSound(io); },
+//                [&](double seconds) { return seconds >= end; });
+//   render.report("fugue.wav");
+//
+// Gamma objects still take their rate from gam::sampleRate(), so set that
+// to the same value before triggering anything.
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+
+class OfflineRender
+{
+public:
+	OfflineRender(double sampleRate = 48000, unsigned framesPerBuffer = 512, unsigned channels = 2)
+	:	mSampleRate(sampleRate), mChannels(channels)
+	{
+		mIO.framesPerSecond(sampleRate);
+		mIO.framesPerBuffer(framesPerBuffer);
+		mIO.channelsIn(0);
+		mIO.channelsOut(channels);
+	}
+
+	al::AudioIOData &io() { return mIO; }
+
+	// Audio rendered so far and the wall-clock time it took
+	double seconds() const { return (double)mFrames / mSampleRate; }
+	double wallSeconds() const { return mWallSeconds; }
+
+	// Calls block(io) for each buffer until finished(seconds()) is true or
+	// maxSeconds of audio have been rendered. Returns false if the file
+	// could not be written.
+	template <class Block, class Finished>
+	bool toWav(const std::string &path, Block block, Finished finished, double maxSeconds = 3600)
+	{
+		FILE *f = fopen(path.c_str(), "wb");
+		if (!f)
+		{
+			printf("Could not open %s for writing\n", path.c_str());
+			return false;
+		}
+		writeHeader(f, 0);
+
+		unsigned framesPerBuffer = mIO.framesPerBuffer();
+		std::vector<float> interleaved(framesPerBuffer * mChannels);
+		mFrames = 0;
+		auto start = std::chrono::steady_clock::now();
+		while (!finished(seconds()) && seconds() < maxSeconds)
+		{
+			mIO.zeroOut();
+			mIO.frame(0);
+			block(mIO);
+			for (unsigned c = 0; c < mChannels; ++c)
+			{
+				const float *out = mIO.outBuffer(c);
+				for (unsigned i = 0; i < framesPerBuffer; ++i) interleaved[i * mChannels + c] = out[i];
+			}
+			fwrite(interleaved.data(), sizeof(float), interleaved.size(), f);
+			mFrames += framesPerBuffer;
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		mWallSeconds = elapsed.count();
+
+		fseek(f, 0, SEEK_SET);
+		writeHeader(f, mFrames);
+		bool ok = !ferror(f);
+		fclose(f);
+		return ok;
+	}
+
+	// Prints how much faster than real time the render ran
+	void report(const std::string &name) const
+	{
+		printf("%s: %.1f s of audio in %.2f s (%.1fx real time)\n", name.c_str(), seconds(),
+		       mWallSeconds, mWallSeconds > 0 ? seconds() / mWallSeconds : 0.0);
+	}
+
+private:
+	// RIFF/WAVE header for IEEE float samples
+	void writeHeader(FILE *f, uint64_t frames)
+	{
+		uint32_t dataBytes = (uint32_t)(frames * mChannels * sizeof(float));
+		uint32_t rate = (uint32_t)mSampleRate;
+		uint16_t channels = (uint16_t)mChannels;
+		uint16_t format = 3, bits = 32, blockAlign = (uint16_t)(mChannels * sizeof(float)), extra = 0;
+		uint32_t byteRate = rate * blockAlign, fmtBytes = 18, factBytes = 4, numFrames = (uint32_t)frames;
+		uint32_t riffBytes = 4 + (8 + fmtBytes) + (8 + factBytes) + (8 + dataBytes);
+
+		fwrite("RIFF", 1, 4, f);
+		fwrite(&riffBytes, 4, 1, f);
+		fwrite("WAVEfmt ", 1, 8, f);
+		fwrite(&fmtBytes, 4, 1, f);
+		fwrite(&format, 2, 1, f);
+		fwrite(&channels, 2, 1, f);
+		fwrite(&rate, 4, 1, f);
+		fwrite(&byteRate, 4, 1, f);
+		fwrite(&blockAlign, 2, 1, f);
+		fwrite(&bits, 2, 1, f);
+		fwrite(&extra, 2, 1, f);
+		fwrite("fact", 1, 4, f);
+		fwrite(&factBytes, 4, 1, f);
+		fwrite(&numFrames, 4, 1, f);
+		fwrite("data", 1, 4, f);
+		fwrite(&dataBytes, 4, 1, f);
+	}
+
+	al::AudioIOData mIO;
+	double mSampleRate;
+	unsigned mChannels;
+	uint64_t mFrames{0};
+	double mWallSeconds{0};
+};
+
+#endif
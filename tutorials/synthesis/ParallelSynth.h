@@ -0,0 +1,152 @@
+#pragma once
+#ifndef ParallelSynth_H
+#define ParallelSynth_H
+
+// Opt-in parallel voice rendering.
+//
+// A PolySynth renders its active voices one after another on the audio
+// thread. ParallelSynth keeps several SynthSequencer lanes, each with its
+// own PolySynth, hands new voices to the lanes in turn, and renders every
+// lane into its own bus on a RenderPool thread. The buses are then summed
+// into the output in lane order, so a given score always mixes the same
+// way no matter how the threads were scheduled.
+//
+//   ParallelSynth parallelSynth{4};
+//
+//   SynthSequencer &seq = parallelSynth.next();
+//   auto *voice = seq.synth().getVoice<Marimba>();
+//   ...
+//   seq.addVoiceFromNow(voice, time, duration);
+//
+//   // onSound():  parallelSynth.render(io);
+//   // onDraw():   parallelSynth.render(g);
+//
+// Voices rendered this way run concurrently, so they must not write to
+// shared state (a global SpectrumBus, say) from onProcess().
+//
+// The worker threads only start with the first lane handed out, so an app
+// that never turns parallel rendering on never wakes them: until then
+// render(io) returns straight away. After that, callbacks where no lane has
+// a voice sounding (parallel mode switched off again, say) advance the
+// lanes on the audio thread without waking the workers either. The workers
+// run at real-time priority where the OS allows; see RenderPool.h.
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/scene/al_SynthSequencer.hpp"
+
+#include "RenderPool.h"
+
+class ParallelSynth
+{
+public:
+	// spin: how long workers stay awake after a job (RenderPool)
+	ParallelSynth(unsigned numThreads = 4, std::chrono::microseconds spin = std::chrono::microseconds(1000))
+	:	mSpin(spin)
+	{
+		if (numThreads < 1) numThreads = 1;
+		for (unsigned i = 0; i < numThreads; ++i)
+		{
+			mLanes.emplace_back(new al::SynthSequencer);
+			mBuses.emplace_back(new al::AudioIOData);
+		}
+	}
+
+	~ParallelSynth() { delete mPool.load(); }
+
+	ParallelSynth(const ParallelSynth &) = delete;
+	ParallelSynth &operator=(const ParallelSynth &) = delete;
+
+	unsigned size() const { return (unsigned)mLanes.size(); }
+
+	// Workers running at real-time priority (0 before the first lane)
+	unsigned realtime() const
+	{
+		RenderPool *pool = mPool.load(std::memory_order_acquire);
+		return pool ? pool->realtime() : 0;
+	}
+
+	// Not from the audio thread: the first call starts the workers
+	al::SynthSequencer &lane(unsigned i)
+	{
+		start();
+		return *mLanes[i];
+	}
+
+	// Lane for the next voice (round robin). Not from the audio thread.
+	al::SynthSequencer &next()
+	{
+		start();
+		al::SynthSequencer &seq = *mLanes[mNext];
+		mNext = (mNext + 1) % mLanes.size();
+		return seq;
+	}
+
+	// Audio thread: render all lanes in parallel and add them to io
+	void render(al::AudioIOData &io)
+	{
+		RenderPool *pool = mPool.load(std::memory_order_acquire);
+		if (!pool) return;  // no lane handed out yet: nothing to play
+		unsigned frames = io.framesPerBuffer();
+		int channels = io.channelsOut();
+		for (auto &bus : mBuses)
+		{
+			// Only reallocates when the audio configuration changes
+			if (bus->framesPerBuffer() != frames || bus->channelsOut() != channels)
+			{
+				bus->framesPerBuffer(frames);
+				bus->channelsOut(channels);
+			}
+			bus->framesPerSecond(io.framesPerSecond());
+		}
+
+		auto job = [this](unsigned i) {
+			al::AudioIOData &bus = *mBuses[i];
+			bus.zeroOut();
+			bus.frame(0);
+			mLanes[i]->render(bus);
+		};
+		// Lanes with nothing sounding only advance their sequencers (which
+		// may start a note), not worth waking the workers for. The same job
+		// runs here instead, so the mix comes out the same either way.
+		bool sounding = false;
+		for (auto &seq : mLanes) sounding = sounding || seq->synth().getActiveVoices();
+		if (sounding)
+			pool->run(job);
+		else
+			for (unsigned i = 0; i < mLanes.size(); ++i) job(i);
+
+		for (auto &bus : mBuses)
+			for (int c = 0; c < channels; ++c)
+			{
+				float *out = io.outBuffer(c);
+				const float *in = bus->outBuffer(c);
+				for (unsigned i = 0; i < frames; ++i) out[i] += in[i];
+			}
+	}
+
+	// Graphics thread
+	void render(al::Graphics &g)
+	{
+		for (auto &seq : mLanes) seq->render(g);
+	}
+
+private:
+	void start()
+	{
+		if (!mPool.load(std::memory_order_relaxed))
+			mPool.store(new RenderPool((unsigned)mLanes.size(), mSpin), std::memory_order_release);
+	}
+
+	std::chrono::microseconds mSpin;
+	std::atomic<RenderPool *> mPool{nullptr};
+	std::vector<std::unique_ptr<al::SynthSequencer>> mLanes;
+	std::vector<std::unique_ptr<al::AudioIOData>> mBuses;
+	unsigned mNext = 0;
+};
+
+#endif
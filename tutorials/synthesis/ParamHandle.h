@@ -0,0 +1,50 @@
+#pragma once
+#ifndef ParamHandle_H
+#define ParamHandle_H
+
+// Cached handle to a SynthVoice internal trigger parameter.
+//
+// getInternalParameterValue("freq") looks the parameter up by name in the
+// voice's parameter map every time it is called. In a voice that reads
+// several parameters per block (or, worse, per sample) that lookup ends up
+// dominating the audio thread once many voices are playing.
+//
+// createInternalTriggerParameter() already hands back the parameter it
+// registers, so we keep that around and read the value straight from it:
+//
+//   ParamHandle mFreq;
+//
+//   void init() override {
+//     mFreq = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+//   }
+//
+//   void onProcess(AudioIOData& io) override {
+//     mOsc.freq(mFreq);  // no string lookup
+//   }
+//
+// Values written through setInternalParameterValue("freq", ...) or
+// setTriggerParams() land in the same Parameter, so the handle always sees
+// the current value. The parameter itself is owned by the voice, which
+// outlives its members, so the raw pointer is safe.
+
+#include <memory>
+
+#include "al/ui/al_Parameter.hpp"
+
+class ParamHandle
+{
+public:
+  ParamHandle() {}
+  ParamHandle(const std::shared_ptr<al::Parameter> &param) : mParam(param.get()) {}
+
+  float get() const { return mParam->get(); }
+  operator float() const { return mParam->get(); }
+
+  void set(float value) { mParam->set(value); }
+  bool valid() const { return mParam != nullptr; }
+
+private:
+  al::Parameter *mParam{nullptr};
+};
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef PartialBank_H
+#define PartialBank_H
+
+// Bank of sine partials for additive voices.
+//
+// Each partial is one slot in three contiguous arrays (phase, phase
+// increment, amplitude) instead of a gam::Sine member, so a voice can hold
+// a handful or several hundred of them and render them all with one call.
+// Every partial is evaluated a vector of frames at a time using the
+// BlockSine.h kernels and summed straight into the output block.
+//
+//   PartialBank mPartials;            // in the voice
+//   mPartials.resize(64);             // in init()
+//   mPartials.freq(k, ratio * freq);  // once per block
+//   mPartials.render(buf, n);         // buf[i] = sum of amp * sine
+//
+// render(buf, n, begin, end) sums just the partials in [begin, end), for
+// voices that put separate envelopes on groups of partials.
+
+#include <algorithm>
+#include <vector>
+
+#include "BlockSine.h"
+
+class PartialBank
+{
+public:
+	enum { kMaxFrames = 256 };
+
+	// Allocates, so call from init() rather than the audio thread
+	void resize(unsigned numPartials)
+	{
+		mPhase.resize(numPartials, 0);
+		mInc.resize(numPartials, 0);
+		mAmp.resize(numPartials, 1.f);
+	}
+
+	unsigned size() const { return (unsigned)mPhase.size(); }
+
+	// Partials at or past Nyquist are clamped there, like BlockSine's
+	void freq(unsigned k, float hz) { mInc[k] = blocksine::increment(hz, 4294967296.f / (float)gam::sampleRate()); }
+	void amp(unsigned k, float a) { mAmp[k] = a; }
+	float amp(unsigned k) const { return mAmp[k]; }
+
+	// Restart every partial at phase 0
+	void reset() { std::fill(mPhase.begin(), mPhase.end(), 0); }
+
+	void render(float *out, unsigned n) { render(out, n, 0, size()); }
+
+	// out[0..n) = sum of the partials in [begin, end)
+	void render(float *out, unsigned n, unsigned begin, unsigned end)
+	{
+		std::fill(out, out + n, 0.f);
+		for (unsigned k = begin; k < end; ++k)
+		{
+			uint32_t phase = mPhase[k];
+			uint32_t inc = mInc[k];
+			float a = mAmp[k];
+			mPhase[k] = phase + inc * n;
+			if (a == 0) continue;
+
+			unsigned i = 0;
+#if defined(__AVX2__)
+			__m256i vphase = _mm256_add_epi32(_mm256_set1_epi32((int)phase),
+			                 _mm256_mullo_epi32(_mm256_set1_epi32((int)inc), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+			__m256i step = _mm256_set1_epi32((int)(inc * 8));
+			__m256 va = _mm256_set1_ps(a);
+			for (; i + 8 <= n; i += 8)
+			{
+				__m256 s = _mm256_mul_ps(blocksine::sinPhase(vphase), va);
+				_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), s));
+				vphase = _mm256_add_epi32(vphase, step);
+			}
+#elif defined(BLOCKSINE_SSE2)
+			__m128i vphase = _mm_add_epi32(_mm_set1_epi32((int)phase),
+			                 _mm_setr_epi32(0, (int)inc, (int)(inc * 2), (int)(inc * 3)));
+			__m128i step = _mm_set1_epi32((int)(inc * 4));
+			__m128 va = _mm_set1_ps(a);
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128 s = _mm_mul_ps(blocksine::sinPhase(vphase), va);
+				_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), s));
+				vphase = _mm_add_epi32(vphase, step);
+			}
+#endif
+			for (phase += inc * i; i < n; ++i)
+			{
+				out[i] += blocksine::sinPhase(phase) * a;
+				phase += inc;
+			}
+		}
+	}
+
+private:
+	std::vector<uint32_t> mPhase; // one turn = 2^32
+	std::vector<uint32_t> mInc;
+	std::vector<float> mAmp;
+};
+
+#endif
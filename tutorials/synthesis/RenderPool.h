@@ -0,0 +1,202 @@
+#pragma once
+#ifndef RenderPool_H
+#define RenderPool_H
+
+// Fixed set of worker threads for splitting one audio callback's work.
+//
+// run(job) calls job(lane) once for every lane in [0, size()), lane 0 on
+// the calling (audio) thread and the others on the workers, and returns
+// when all of them have finished. No locks or allocation happen on the
+// calling thread: work is published through an atomic generation counter
+// and completion is counted down atomically.
+//
+// The calling thread waits for the workers, so they run at real-time
+// priority as well. On Linux and other POSIX systems they take the calling
+// thread's own SCHED_FIFO or SCHED_RR priority with its first job (equal, so
+// that yielding on either side hands the core over); on macOS they use the
+// time-constraint policy CoreAudio gives its threads, on Windows
+// time-critical priority. An audio thread at normal priority leaves them at
+// normal priority too, and if the OS refuses (Linux without an rtprio limit
+// or CAP_SYS_NICE) they stay there; realtime() counts the ones that made it.
+//
+// Workers at normal priority spin (yielding) for `spin` after each job, so
+// back-to-back callbacks find them awake, then fall back to polling every
+// 100 us while idle so they don't hold a core when nothing is playing.
+// Real-time workers go straight to polling: they wake on time anyway, and
+// spinning at that priority would keep everything else off the core.
+//
+// If the workers don't get the core at all (a real-time caller sharing one
+// with normal priority workers), the calling thread stops yielding after a
+// while and sleeps in short steps until they finish, rather than spinning
+// on forever.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+class RenderPool
+{
+public:
+	RenderPool(unsigned numLanes, std::chrono::microseconds spin = std::chrono::microseconds(1000))
+	:	mSpin(spin)
+	{
+		if (numLanes < 1) numLanes = 1;
+		mNumLanes = numLanes;
+		for (unsigned lane = 1; lane < numLanes; ++lane)
+			mWorkers.emplace_back([this, lane]() { work(lane); });
+	}
+
+	~RenderPool()
+	{
+		mRunning.store(false);
+		for (auto &worker : mWorkers) worker.join();
+	}
+
+	RenderPool(const RenderPool &) = delete;
+	RenderPool &operator=(const RenderPool &) = delete;
+
+	unsigned size() const { return mNumLanes; }
+
+	// Workers running at real-time priority
+	unsigned realtime() const { return mRealtime.load(); }
+
+	template <class Job>
+	void run(Job &job)
+	{
+		run([](void *context, unsigned lane) { (*(Job *)context)(lane); }, &job);
+	}
+
+	void run(void (*fn)(void *, unsigned), void *context)
+	{
+		// Published with the job, for the workers to follow
+		if (mCallerPriority.load(std::memory_order_relaxed) == kUnknown)
+			mCallerPriority.store(callerPriority(), std::memory_order_relaxed);
+
+		mFn = fn;
+		mContext = context;
+		mPending.store(mNumLanes - 1, std::memory_order_relaxed);
+		mGeneration.fetch_add(1, std::memory_order_release);
+		fn(context, 0);
+		for (unsigned waits = 0; mPending.load(std::memory_order_acquire) != 0; ++waits)
+		{
+			if (waits < 10000)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+		}
+	}
+
+private:
+	enum { kUnknown = -2, kNormal = -1 };
+
+	void work(unsigned lane)
+	{
+		bool realtime = false;
+#if defined(_WIN32) || defined(__APPLE__)
+		realtime = raisePriority(0);
+		if (realtime) mRealtime.fetch_add(1);
+#else
+		int following = kUnknown;
+#endif
+
+		// Not a load: run() may already have published work before we get here
+		unsigned seen = 0;
+		auto lastJob = std::chrono::steady_clock::now();
+		while (mRunning.load(std::memory_order_relaxed))
+		{
+			unsigned generation = mGeneration.load(std::memory_order_acquire);
+			if (generation == seen)
+			{
+				if (!realtime && std::chrono::steady_clock::now() - lastJob < mSpin)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				continue;
+			}
+			seen = generation;
+#if !defined(_WIN32) && !defined(__APPLE__)
+			int priority = mCallerPriority.load(std::memory_order_relaxed);
+			if (priority != following)
+			{
+				following = priority;
+				bool raised = priority != kNormal && raisePriority(priority);
+				if (raised != realtime) mRealtime.fetch_add(raised ? 1 : -1);
+				realtime = raised;
+			}
+#endif
+			mFn(mContext, lane);
+			lastJob = std::chrono::steady_clock::now();
+			mPending.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+#if defined(_WIN32)
+	static int callerPriority() { return kNormal; }
+
+	static bool raisePriority(int)
+	{
+		return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+	}
+#elif defined(__APPLE__)
+	static int callerPriority() { return kNormal; }
+
+	static bool raisePriority(int)
+	{
+		// About one 512-frame callback; up to half of it working
+		mach_timebase_info_data_t timebase;
+		mach_timebase_info(&timebase);
+		auto ticks = [&timebase](double ms) { return (uint32_t)(ms * 1e6 * timebase.denom / timebase.numer); };
+		thread_time_constraint_policy_data_t policy;
+		policy.period = ticks(10);
+		policy.computation = ticks(5);
+		policy.constraint = ticks(10);
+		policy.preemptible = 1;
+		return thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+		                         (thread_policy_t)&policy, THREAD_TIME_CONSTRAINT_POLICY_COUNT) == KERN_SUCCESS;
+	}
+#else
+	// The calling thread's policy and priority as policy << 8 | priority, or
+	// kNormal if it isn't real-time
+	static int callerPriority()
+	{
+		int policy;
+		sched_param param;
+		if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) return kNormal;
+		if (policy != SCHED_FIFO && policy != SCHED_RR) return kNormal;
+		return policy << 8 | param.sched_priority;
+	}
+
+	static bool raisePriority(int priority)
+	{
+		sched_param param;
+		param.sched_priority = priority & 0xFF;
+		return pthread_setschedparam(pthread_self(), priority >> 8, &param) == 0;
+	}
+#endif
+
+	unsigned mNumLanes;
+	std::chrono::microseconds mSpin;
+	std::atomic<int> mCallerPriority{kUnknown};
+	std::atomic<unsigned> mRealtime{0};
+	std::vector<std::thread> mWorkers;
+	std::atomic<bool> mRunning{true};
+	std::atomic<unsigned> mGeneration{0};
+	std::atomic<unsigned> mPending{0};
+	void (*mFn)(void *, unsigned) = nullptr;
+	void *mContext = nullptr;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+#ifndef Score_H
+#define Score_H
+
+// Compact binary note score.
+//
+// The Tone.js-style JSON files (fugue.json, miniboss.json, ...) are several
+// hundred KB of text that nlohmann::json has to parse and walk note by note
+// before anything can be scheduled. A .score file holds the same notes as
+// plain arrays that are memory-mapped and used in place:
+//
+//   ScoreHeader                 16 bytes
+//   float    time[numNotes]     seconds from start
+//   float    duration[numNotes] seconds
+//   float    velocity[numNotes] 0..1
+//   uint8_t  midi[numNotes]     MIDI note number
+//   uint8_t  track[numNotes]    index of the JSON track the note came from
+//
+// Notes are sorted by start time. Everything is stored in native (little
+// endian) byte order. Use ScoreJson.h to convert from the JSON files.
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct ScoreHeader
+{
+	char magic[4];      // "ALSC"
+	uint32_t version;
+	uint32_t numNotes;
+	uint32_t numTracks;
+};
+
+struct ScoreNote
+{
+	float time;
+	float duration;
+	float velocity;
+	uint8_t midi;
+	uint8_t track;
+};
+
+class Score
+{
+public:
+	static const uint32_t kVersion = 1;
+
+	Score() {}
+	~Score() { close(); }
+	Score(const Score &) = delete;
+	Score &operator=(const Score &) = delete;
+
+	// Map a .score file. Returns false if it is missing or malformed.
+	bool open(const std::string &path)
+	{
+		close();
+#ifndef _WIN32
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ScoreHeader))
+		{
+			::close(fd);
+			return false;
+		}
+		void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (data == MAP_FAILED) return false;
+		mMapped = data;
+		mMappedSize = st.st_size;
+		return bind((const char *)data, st.st_size);
+#else
+		std::ifstream f(path, std::ios::binary | std::ios::ate);
+		if (!f) return false;
+		mBuffer.resize((size_t)f.tellg());
+		f.seekg(0);
+		f.read(mBuffer.data(), mBuffer.size());
+		return bind(mBuffer.data(), mBuffer.size());
+#endif
+	}
+
+	void close()
+	{
+#ifndef _WIN32
+		if (mMapped) munmap(mMapped, mMappedSize);
+		mMapped = nullptr;
+		mMappedSize = 0;
+#endif
+		mBuffer.clear();
+		mNumNotes = mNumTracks = 0;
+		mTime = mDuration = mVelocity = nullptr;
+		mMidi = mTrack = nullptr;
+	}
+
+	bool valid() const { return mTime != nullptr; }
+	uint32_t size() const { return mNumNotes; }
+	uint32_t numTracks() const { return mNumTracks; }
+
+	float time(uint32_t i) const { return mTime[i]; }
+	float duration(uint32_t i) const { return mDuration[i]; }
+	float velocity(uint32_t i) const { return mVelocity[i]; }
+	int midi(uint32_t i) const { return mMidi[i]; }
+	int track(uint32_t i) const { return mTrack[i]; }
+
+	// Length of the piece in seconds (end of the last sounding note)
+	float length() const
+	{
+		float end = 0;
+		for (uint32_t i = 0; i < mNumNotes; ++i)
+			if (mTime[i] + mDuration[i] > end) end = mTime[i] + mDuration[i];
+		return end;
+	}
+
+	// Write notes (in any order) to a .score file
+	static bool write(const std::string &path, std::vector<ScoreNote> notes, uint32_t numTracks)
+	{
+		std::stable_sort(notes.begin(), notes.end(),
+		                 [](const ScoreNote &a, const ScoreNote &b) { return a.time < b.time; });
+		ScoreHeader header;
+		std::memcpy(header.magic, "ALSC", 4);
+		header.version = kVersion;
+		header.numNotes = (uint32_t)notes.size();
+		header.numTracks = numTracks;
+
+		std::ofstream f(path, std::ios::binary | std::ios::trunc);
+		if (!f) return false;
+		f.write((const char *)&header, sizeof(header));
+		for (auto &n : notes) f.write((const char *)&n.time, sizeof(float));
+		for (auto &n : notes) f.write((const char *)&n.duration, sizeof(float));
+		for (auto &n : notes) f.write((const char *)&n.velocity, sizeof(float));
+		for (auto &n : notes) f.write((const char *)&n.midi, 1);
+		for (auto &n : notes) f.write((const char *)&n.track, 1);
+		return (bool)f;
+	}
+
+private:
+	// Checks every size against the bytes there are, without overflow: the
+	// file may be short or its header corrupt
+	bool bind(const char *data, size_t size)
+	{
+		const size_t bytesPerNote = 3 * sizeof(float) + 2;
+		ScoreHeader header;
+		if (size < sizeof(header))
+		{
+			close();
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		size_t n = header.numNotes;
+		if (std::memcmp(header.magic, "ALSC", 4) != 0 || header.version != kVersion ||
+		    n > (size - sizeof(header)) / bytesPerNote)
+		{
+			close();
+			return false;
+		}
+		const char *p = data + sizeof(header);
+		mTime = (const float *)p;
+		mDuration = mTime + n;
+		mVelocity = mDuration + n;
+		mMidi = (const uint8_t *)(mVelocity + n);
+		mTrack = mMidi + n;
+		mNumNotes = header.numNotes;
+		mNumTracks = header.numTracks;
+		return true;
+	}
+
+	void *mMapped{nullptr};
+	size_t mMappedSize{0};
+	std::vector<char> mBuffer;  // used where mmap is not available
+
+	uint32_t mNumNotes{0};
+	uint32_t mNumTracks{0};
+	const float *mTime{nullptr};
+	const float *mDuration{nullptr};
+	const float *mVelocity{nullptr};
+	const uint8_t *mMidi{nullptr};
+	const uint8_t *mTrack{nullptr};
+};
+
+#endif
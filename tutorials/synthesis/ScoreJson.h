@@ -0,0 +1,79 @@
+#pragma once
+#ifndef ScoreJson_H
+#define ScoreJson_H
+
+// Conversion from Tone.js MIDI JSON (music["tracks"][i]["notes"]) to the
+// binary .score format in Score.h.
+//
+// loadScore("fugue.json", score) maps fugue.score if it is up to date and
+// otherwise converts the JSON once and writes fugue.score next to it, so only
+// the first run pays for the parse.
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Score.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+inline std::string scorePathFor(const std::string &jsonPath)
+{
+	size_t dot = jsonPath.find_last_of('.');
+	if (dot == std::string::npos || jsonPath.find('/', dot) != std::string::npos)
+		return jsonPath + ".score";
+	return jsonPath.substr(0, dot) + ".score";
+}
+
+inline bool convertJsonScore(const std::string &jsonPath, const std::string &scorePath)
+{
+	std::ifstream f(jsonPath);
+	if (!f) return false;
+	nlohmann::json music = nlohmann::json::parse(f, nullptr, false);
+	if (music.is_discarded() || !music.contains("tracks")) return false;
+
+	std::vector<ScoreNote> notes;
+	const nlohmann::json &tracks = music["tracks"];
+	for (size_t t = 0; t < tracks.size() && t < 256; ++t)
+	{
+		if (!tracks[t].contains("notes")) continue;
+		for (auto &note : tracks[t]["notes"])
+		{
+			ScoreNote n;
+			n.time = note["time"];
+			n.duration = note["duration"];
+			n.velocity = note["velocity"];
+			n.midi = (uint8_t)note["midi"].get<int>();
+			n.track = (uint8_t)t;
+			notes.push_back(n);
+		}
+	}
+	return Score::write(scorePath, notes, (uint32_t)tracks.size());
+}
+
+// Map the .score that belongs to jsonPath, converting it first if needed
+inline bool loadScore(const std::string &jsonPath, Score &score)
+{
+	std::string scorePath = scorePathFor(jsonPath);
+#ifndef _WIN32
+	struct stat js, ss;
+	bool stale = stat(scorePath.c_str(), &ss) != 0 ||
+	             (stat(jsonPath.c_str(), &js) == 0 && js.st_mtime > ss.st_mtime);
+#else
+	bool stale = !std::ifstream(scorePath).good();
+#endif
+	if (!stale && score.open(scorePath)) return true;
+	if (!convertJsonScore(jsonPath, scorePath))
+	{
+		printf("Could not read score %s\n", jsonPath.c_str());
+		return false;
+	}
+	return score.open(scorePath);
+}
+
+#endif
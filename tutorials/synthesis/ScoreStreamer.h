@@ -0,0 +1,97 @@
+#pragma once
+#ifndef ScoreStreamer_H
+#define ScoreStreamer_H
+
+// Plays a Score by feeding the sequencer a small look-ahead window at a time.
+//
+// Calling addVoiceFromNow() for every note of a piece up front takes a voice
+// per note before anything sounds, so memory and the sequencer queue grow
+// with the length of the score. ScoreStreamer keeps a cursor into the
+// (time-sorted) score instead, and each update() only schedules the notes
+// that start within the next `lookahead` seconds. The number of voices
+// waiting in the sequencer then depends on the density of the music, not on
+// its length.
+//
+//   AudioClock audioClock;          // ticked in onSound(), see AudioClock.h
+//   ScoreStreamer streamer{audioClock};
+//   streamer.onNote([this](const Score &s, uint32_t i, float fromNow) {
+//     playGuitar(freq_of(s.midi(i)), fromNow, s.duration(i), s.velocity(i));
+//   });
+//   streamer.start("fugue.json");   // on key press
+//   streamer.update();              // in onAnimate()
+//
+// Positions are in audio time, not wall time: fromNow is handed to the
+// sequencer, whose "now" only moves as audio is rendered, so notes scheduled
+// in different update() calls keep their spacing however late a frame is,
+// and nothing is scheduled ahead while audio is stalled.
+//
+// update() must keep being called more often than the look-ahead window
+// (once per frame is plenty). update(seconds) takes the time from the caller
+// instead of the clock, for offline rendering (OfflineRender.h).
+
+#include <functional>
+#include <string>
+
+#include "AudioClock.h"
+#include "Score.h"
+#include "ScoreJson.h"
+
+class ScoreStreamer
+{
+public:
+	typedef std::function<void(const Score &score, uint32_t note, float fromNow)> NoteCallback;
+
+	ScoreStreamer(const AudioClock &clock, float lookahead = 2.0f) : mClock(clock), mLookahead(lookahead) {}
+
+	void onNote(NoteCallback callback) { mCallback = callback; }
+	void lookahead(float seconds) { mLookahead = seconds; }
+
+	// Load (converting the JSON if needed) and start from the beginning
+	bool start(const std::string &jsonPath)
+	{
+		mPlaying = false;
+		if (!loadScore(jsonPath, mScore)) return false;
+		mCursor = 0;
+		mStart = mClock.seconds();
+		mPlaying = true;
+		update();
+		return true;
+	}
+
+	void stop() { mPlaying = false; }
+	bool playing() const { return mPlaying; }
+
+	// Seconds of audio rendered since start()
+	float position() const { return (float)(mClock.seconds() - mStart); }
+
+	// Length of the loaded score in seconds
+	float length() const { return mScore.length(); }
+
+	// Schedule every note that starts before position() + lookahead
+	void update() { update(position()); }
+
+	// Same, but with the caller's clock (seconds since start()), e.g. the
+	// audio rendered so far when rendering offline
+	void update(float now)
+	{
+		if (!mPlaying) return;
+		while (mCursor < mScore.size() && mScore.time(mCursor) < now + mLookahead)
+		{
+			float fromNow = mScore.time(mCursor) - now;
+			if (mCallback) mCallback(mScore, mCursor, fromNow > 0 ? fromNow : 0);
+			++mCursor;
+		}
+		if (mCursor >= mScore.size()) mPlaying = false;
+	}
+
+private:
+	const AudioClock &mClock;
+	Score mScore;
+	uint32_t mCursor{0};
+	float mLookahead;
+	bool mPlaying{false};
+	double mStart{0};
+	NoteCallback mCallback;
+};
+
+#endif
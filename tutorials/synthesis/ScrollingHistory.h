@@ -0,0 +1,300 @@
+#pragma once
+#ifndef ScrollingHistory_H
+#define ScrollingHistory_H
+
+// Waveform or spectrogram history kept on the GPU.
+//
+// Rebuilding a Mesh from the latest block or spectrum every frame costs
+// CPU time in proportion to what is shown, and only ever shows the latest
+// one. ScrollingHistory keeps the last `columns` blocks (or spectra) of
+// `rows` values each in a float texture used as a ring: the audio thread
+// push()es a column, update() uploads only the columns pushed since the
+// last frame, and the drawing is done by a shader reading the texture, so
+// the CPU work per frame doesn't grow with the amount of history drawn.
+//
+//   ScrollingHistory spectrogram{FFT_SIZE / 2 + 1,           // app member
+//                                ScrollingHistory::kSpectrogramColumns};
+//   spectrogram.color(0.5, -100);                           // hue, hue gain
+//
+//   spectrogram.push(spectrum);                              // audio thread
+//
+//   spectrogram.update();                                    // onAnimate()
+//   spectrogram.drawImage(g, 1000);                          // onDraw()
+//   spectrogram.drawTrace(g, spectrogram.rows());
+//
+// drawImage() draws the whole history as an image on the unit square, time
+// along x (newest on the right) and rows along y. drawTrace() draws the
+// newest `samples` values as a line (or points) from x = 0 to 1 with y the
+// value, running on from column to column, so it shows the latest spectrum
+// or a waveform as long as the history. Values are colored by hue + value *
+// hue gain, like HSV(hue + value * hueGain) on the CPU.
+//
+// push() only writes to memory; the graphics thread uploads from it. If
+// the audio thread pushes more than half the columns between two frames,
+// the older ones are skipped, so a history needs at least two columns.
+// One that only ever draws its trace (a voice's spectrum, say) needs no
+// more than kTraceColumns.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "al/graphics/al_Graphics.hpp"
+#include "al/graphics/al_OpenGL.hpp"
+#include "al/graphics/al_Shader.hpp"
+
+class ScrollingHistory
+{
+public:
+	enum
+	{
+		// Spectra a spectrogram image shows: 5 s at the tutorials' hop of
+		// FFT_SIZE / 4 = 1012 frames at 48 kHz
+		kSpectrogramColumns = 256,
+		// For a history that only draws its newest column: spare columns
+		// the audio thread can fill while the newest one is being uploaded
+		kTraceColumns = 8
+	};
+
+	ScrollingHistory(unsigned rows, unsigned columns)
+	    : mRows(rows), mColumns(columns), mData(size_t(rows) * columns, 0.f)
+	{
+		// update() uploads at most half the columns
+		assert(columns >= 2);
+	}
+
+	~ScrollingHistory()
+	{
+		if (mTexture) glDeleteTextures(1, &mTexture);
+	}
+
+	ScrollingHistory(const ScrollingHistory &) = delete;
+	ScrollingHistory &operator=(const ScrollingHistory &) = delete;
+
+	unsigned rows() const { return mRows; }
+	unsigned columns() const { return mColumns; }
+
+	void color(float hue, float hueGain)
+	{
+		mHue = hue;
+		mHueGain = hueGain;
+	}
+
+	// Audio thread: append a column of rows() values
+	void push(const float *column)
+	{
+		uint64_t pushed = mPushed.load(std::memory_order_relaxed);
+		std::copy(column, column + mRows, &mData[(pushed % mColumns) * mRows]);
+		mPushed.store(pushed + 1, std::memory_order_release);
+	}
+
+	// Graphics thread: upload the columns pushed since the last update()
+	void update()
+	{
+		if (!mTexture) create();
+
+		uint64_t pushed = mPushed.load(std::memory_order_acquire);
+		uint64_t from = std::max(mUploaded, pushed - std::min<uint64_t>(pushed, mColumns / 2));
+		if (from == pushed) return;
+
+		// Columns are texture rows, so each contiguous run is one upload
+		glBindTexture(GL_TEXTURE_2D, mTexture);
+		while (from < pushed)
+		{
+			unsigned first = from % mColumns;
+			unsigned count = (unsigned)std::min<uint64_t>(pushed - from, mColumns - first);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, mRows, count, GL_RED, GL_FLOAT,
+			                &mData[size_t(first) * mRows]);
+			from += count;
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		mUploaded = pushed;
+	}
+
+	// Graphics thread: the whole history as an image; brightness is value *
+	// brightnessGain, or full with 0
+	void drawImage(al::Graphics &g, float brightnessGain = 0)
+	{
+		draw(g, kImage, GL_TRIANGLE_STRIP, 4, uint64_t(mRows) * mColumns, brightnessGain);
+	}
+
+	// Graphics thread: the newest `samples` values as a line, or points
+	void drawTrace(al::Graphics &g, unsigned samples, bool points = false)
+	{
+		samples = std::min(samples, mRows * mColumns);
+		draw(g, kTrace, points ? GL_POINTS : GL_LINE_STRIP, samples, samples, 0);
+	}
+
+private:
+	enum Mode { kImage = 0, kTrace = 1 };
+
+	// Every history draws with the same program and sets all of its uniforms
+	// per draw, so voices that each keep one don't compile one each
+	struct Program
+	{
+		GLuint vertexArray = 0;
+		al::ShaderProgram shader;
+	};
+
+	static Program &shared()
+	{
+		static Program *program = new Program;  // never destroyed: outlives the GL context
+		return *program;
+	}
+
+	void create()
+	{
+		glGenTextures(1, &mTexture);
+		glBindTexture(GL_TEXTURE_2D, mTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, mRows, mColumns, 0, GL_RED, GL_FLOAT, mData.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// Vertices come from gl_VertexID, but GL still wants a VAO bound
+		Program &program = shared();
+		if (!program.vertexArray)
+		{
+			glGenVertexArrays(1, &program.vertexArray);
+			program.shader.compile(vertexShader(), fragmentShader());
+		}
+	}
+
+	void draw(al::Graphics &g, Mode mode, GLenum primitive, unsigned vertices, uint64_t samples,
+	          float brightnessGain)
+	{
+		if (!mTexture || vertices == 0) return;
+
+		// Stream position of the oldest sample drawn, as the ring index of
+		// its column and its row within it. Before the ring has filled up
+		// that is one of the never written (zero) columns.
+		uint64_t first = (mUploaded + mColumns) * mRows - samples;
+		int firstColumn = int((first / mRows) % mColumns);
+		int firstRow = int(first % mRows);
+
+		al::ShaderProgram &shader = shared().shader;
+		g.shader(shader);
+		shader.use();
+		shader.uniform("modelMatrix", g.modelMatrix());
+		shader.uniform("viewMatrix", g.viewMatrix());
+		shader.uniform("projMatrix", g.projMatrix());
+		shader.uniform("history", 0);
+		shader.uniform("mode", int(mode));
+		shader.uniform("rows", int(mRows));
+		shader.uniform("columns", int(mColumns));
+		shader.uniform("firstColumn", firstColumn);
+		shader.uniform("firstRow", firstRow);
+		shader.uniform("count", int(vertices));
+		shader.uniform("hue", mHue);
+		shader.uniform("hueGain", mHueGain);
+		shader.uniform("brightnessGain", brightnessGain);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, mTexture);
+		glBindVertexArray(shared().vertexArray);
+		glDrawArrays(primitive, 0, vertices);
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// Graphics only goes back to its own shaders when the coloring mode
+		// changes, so force one
+		g.meshColor();
+		g.color(1, 1, 1, 1);
+	}
+
+	static const char *vertexShader()
+	{
+		return R"(
+#version 330
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+uniform sampler2D history;
+uniform int mode;
+uniform int rows;
+uniform int columns;
+uniform int firstColumn;
+uniform int firstRow;
+uniform int count;
+uniform float hue;
+uniform float hueGain;
+
+out vec2 texcoord;
+out vec4 color;
+
+vec3 hsv2rgb(vec3 c) {
+  vec3 p = abs(fract(c.xxx + vec3(1.0, 2.0 / 3.0, 1.0 / 3.0)) * 6.0 - 3.0);
+  return c.z * mix(vec3(1.0), clamp(p - 1.0, 0.0, 1.0), c.y);
+}
+
+void main() {
+  vec2 position;
+  if (mode == 0) {
+    // Unit square as a triangle strip
+    position = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    texcoord = position;
+    color = vec4(1.0);
+  } else {
+    int index = firstRow + gl_VertexID;
+    int column = (firstColumn + index / rows) % columns;
+    float value = texelFetch(history, ivec2(index % rows, column), 0).r;
+    position = vec2(float(gl_VertexID) / float(max(count - 1, 1)), value);
+    texcoord = vec2(0.0);
+    color = vec4(hsv2rgb(vec3(hue + value * hueGain, 1.0, 1.0)), 1.0);
+  }
+  gl_Position = projMatrix * viewMatrix * modelMatrix * vec4(position, 0.0, 1.0);
+}
+)";
+	}
+
+	static const char *fragmentShader()
+	{
+		return R"(
+#version 330
+uniform sampler2D history;
+uniform int mode;
+uniform int rows;
+uniform int columns;
+uniform int firstColumn;
+uniform float hue;
+uniform float hueGain;
+uniform float brightnessGain;
+
+in vec2 texcoord;
+in vec4 color;
+layout (location = 0) out vec4 fragColor;
+
+vec3 hsv2rgb(vec3 c) {
+  vec3 p = abs(fract(c.xxx + vec3(1.0, 2.0 / 3.0, 1.0 / 3.0)) * 6.0 - 3.0);
+  return c.z * mix(vec3(1.0), clamp(p - 1.0, 0.0, 1.0), c.y);
+}
+
+void main() {
+  if (mode != 0) {
+    fragColor = color;
+    return;
+  }
+  int column = (firstColumn + min(int(texcoord.x * float(columns)), columns - 1)) % columns;
+  int row = min(int(texcoord.y * float(rows)), rows - 1);
+  float value = texelFetch(history, ivec2(row, column), 0).r;
+  float brightness = brightnessGain != 0.0 ? clamp(value * brightnessGain, 0.0, 1.0) : 1.0;
+  fragColor = vec4(hsv2rgb(vec3(hue + value * hueGain, 1.0, brightness)), 1.0);
+}
+)";
+	}
+
+	unsigned mRows;
+	unsigned mColumns;
+	std::vector<float> mData;              // the same ring as the texture, written by push()
+	std::atomic<uint64_t> mPushed{0};      // columns pushed
+	uint64_t mUploaded = 0;                // columns uploaded (graphics thread)
+	float mHue = 0;
+	float mHueGain = 1;
+
+	GLuint mTexture = 0;
+};
+
+#endif
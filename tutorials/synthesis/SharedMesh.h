@@ -0,0 +1,89 @@
+#pragma once
+#ifndef SharedMesh_H
+#define SharedMesh_H
+
+// One copy of a mesh for every voice that draws the same shape.
+//
+// A voice that builds its own Mesh in init() keeps a private copy of the
+// vertices, and g.draw(Mesh&) uploads them to the GPU again on every frame.
+// SharedMesh::get() instead looks the shape up by name and only runs the
+// builder the first time; everyone asking for the same key shares the one
+// VAOMesh, which is uploaded on its first draw and then drawn from the GPU.
+//
+//   SharedMesh::Ptr mMesh;                                   // voice member
+//
+//   mMesh = SharedMesh::get("disc 1 30", [](Mesh &m) {      // init()
+//     addDisc(m, 1.0, 30);
+//   });
+//   mMesh->draw(g);                                          // onProcess(g)
+//
+// The key has to name everything the builder depends on. Meshes are
+// reference counted: the cache only holds weak pointers, so a shape is
+// freed when the last voice using it goes away and rebuilt if it's needed
+// again.
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "al/graphics/al_Graphics.hpp"
+#include "al/graphics/al_VAOMesh.hpp"
+
+class SharedMesh
+{
+public:
+	typedef std::shared_ptr<SharedMesh> Ptr;
+
+	// Mesh for `key`, running build() if nobody holds it yet
+	static Ptr get(const std::string &key, const std::function<void(al::Mesh &)> &build)
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		std::weak_ptr<SharedMesh> &entry = cache()[key];
+		Ptr mesh = entry.lock();
+		if (!mesh)
+		{
+			mesh = Ptr(new SharedMesh);
+			build(mesh->mMesh);
+			entry = mesh;
+		}
+		return mesh;
+	}
+
+	// Graphics thread; the first call uploads the vertices
+	void draw(al::Graphics &g) { g.draw(uploaded()); }
+
+	// The mesh, uploaded if it wasn't yet (graphics thread)
+	al::VAOMesh &uploaded()
+	{
+		if (!mUploaded)
+		{
+			mMesh.update();
+			mUploaded = true;
+		}
+		return mMesh;
+	}
+
+	const al::VAOMesh &mesh() const { return mMesh; }
+
+private:
+	SharedMesh() {}
+
+	static std::mutex &mutex()
+	{
+		static std::mutex m;
+		return m;
+	}
+
+	static std::map<std::string, std::weak_ptr<SharedMesh>> &cache()
+	{
+		static std::map<std::string, std::weak_ptr<SharedMesh>> c;
+		return c;
+	}
+
+	al::VAOMesh mMesh;
+	bool mUploaded = false;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+#ifndef SpectrumBus_H
+#define SpectrumBus_H
+
+// Shared spectrum analyzer.
+//
+// Instead of every voice (or app) owning a gam::STFT and running a full FFT
+// in the audio callback, sources add their samples into one SpectrumBus.
+// The audio thread only sums samples into a block and copies that block into
+// a lock-free ring. A worker thread runs a single STFT over the ring, one FFT
+// per hop no matter how many voices are playing, and publishes each
+// magnitude frame through a TripleBuffer that the graphics thread reads
+// without ever blocking the audio thread.
+//
+// Usage:
+//
+//   SpectrumBus spectrumBus{FFT_SIZE, FFT_SIZE / 4};
+//
+//   // voice, audio thread:   spectrumBus.add(io.frame(), s1);
+//   // app, audio thread:     spectrumBus.commit(io.framesPerBuffer());
+//   // app, graphics thread:  const vector<float> &spectrum = spectrumBus.spectrum();
+//
+// To draw the spectrum, feed() it a ScrollingHistory before start(): the
+// worker pushes every frame there too, and the graphics thread only has to
+// update() and draw the history.
+//
+// Call start() once the audio sample rate is known and stop() on exit.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "Gamma/DFT.h"
+
+#include "ScrollingHistory.h"
+#include "TripleBuffer.h"
+
+class SpectrumBus
+{
+public:
+	SpectrumBus(unsigned fftSize = 4048, unsigned hopSize = 1024, unsigned maxBlockSize = 8192)
+	:	mSTFT(fftSize, hopSize, 0, gam::HANN, gam::MAG_FREQ),
+		mBlock(maxBlockSize, 0.f)
+	{
+		unsigned capacity = 1;
+		while (capacity < fftSize * 4) capacity <<= 1;
+		mRing.assign(capacity, 0.f);
+		mRingMask = capacity - 1;
+		mFrames.reset(std::vector<float>(mSTFT.numBins(), 0.f));
+	}
+
+	~SpectrumBus() { stop(); }
+
+	void start()
+	{
+		if (mRunning.exchange(true)) return;
+		mWorker = std::thread([this]() { run(); });
+	}
+
+	void stop()
+	{
+		if (!mRunning.exchange(false)) return;
+		if (mWorker.joinable()) mWorker.join();
+	}
+
+	unsigned numBins() const { return mSTFT.numBins(); }
+
+	// Also push every frame into history, which needs numBins() rows.
+	// Before start().
+	void feed(ScrollingHistory &history) { mHistory = &history; }
+
+	// Audio thread: mix one sample into the current block at frame index
+	void add(int frame, float sample)
+	{
+		if (frame >= 0 && frame < (int)mBlock.size()) mBlock[frame] += sample;
+	}
+
+	// Audio thread: mix a whole buffer into the current block
+	void add(const float *samples, unsigned numFrames)
+	{
+		numFrames = std::min(numFrames, (unsigned)mBlock.size());
+		for (unsigned i = 0; i < numFrames; ++i) mBlock[i] += samples[i];
+	}
+
+	// Audio thread: hand the current block to the analyzer and clear it.
+	// If the worker has fallen behind the block is dropped, never waited on.
+	void commit(unsigned numFrames)
+	{
+		numFrames = std::min(numFrames, (unsigned)mBlock.size());
+		size_t w = mWritePos.load(std::memory_order_relaxed);
+		size_t r = mReadPos.load(std::memory_order_acquire);
+		if (mRing.size() - (w - r) >= numFrames)
+		{
+			for (unsigned i = 0; i < numFrames; ++i)
+				mRing[(w + i) & mRingMask] = mBlock[i];
+			mWritePos.store(w + numFrames, std::memory_order_release);
+		}
+		std::fill(mBlock.begin(), mBlock.begin() + numFrames, 0.f);
+	}
+
+	// Graphics thread: latest complete magnitude frame (numBins() values)
+	const std::vector<float> &spectrum() { return mFrames.latest(); }
+
+private:
+	void run()
+	{
+		while (mRunning.load())
+		{
+			size_t r = mReadPos.load(std::memory_order_relaxed);
+			size_t w = mWritePos.load(std::memory_order_acquire);
+			if (r == w)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				continue;
+			}
+			for (; r != w; ++r)
+			{
+				if (mSTFT(mRing[r & mRingMask]))
+				{
+					std::vector<float> &frame = mFrames.back();
+					for (unsigned k = 0; k < mSTFT.numBins(); ++k)
+						frame[k] = std::tanh(std::pow(mSTFT.bin(k).real(), 1.3f));
+					if (mHistory) mHistory->push(frame.data());
+					mFrames.publish();
+				}
+			}
+			mReadPos.store(r, std::memory_order_release);
+		}
+	}
+
+	gam::STFT mSTFT;                 // only touched by the worker
+	std::vector<float> mBlock;       // audio thread accumulator
+	std::vector<float> mRing;        // audio -> worker
+	size_t mRingMask;
+	std::atomic<size_t> mWritePos{0};
+	std::atomic<size_t> mReadPos{0};
+
+	TripleBuffer<std::vector<float>> mFrames;  // worker -> graphics
+	ScrollingHistory *mHistory = nullptr;      // worker -> graphics, if fed
+
+	std::atomic<bool> mRunning{false};
+	std::thread mWorker;
+};
+
+#endif
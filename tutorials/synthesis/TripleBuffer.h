@@ -0,0 +1,66 @@
+#pragma once
+#ifndef TripleBuffer_H
+#define TripleBuffer_H
+
+// Lock-free hand-off of whole frames from one writer thread to one reader.
+//
+// Three copies of T: the writer fills back() and publish()es it, the reader
+// takes latest(), and the third sits in the middle, swapped atomically with
+// whichever side comes next. Neither side ever blocks, allocates or sees a
+// half-written frame; the reader just gets the newest complete one (again,
+// if nothing new was published since).
+//
+//   TripleBuffer<vector<float>> spectrumBuffer;
+//   spectrumBuffer.reset(vector<float>(numBins));            // init
+//
+//   vector<float> &spectrum = spectrumBuffer.back();         // audio thread
+//   for (unsigned k = 0; k < numBins; ++k) spectrum[k] = ...;
+//   spectrumBuffer.publish();
+//
+//   const vector<float> &spectrum = spectrumBuffer.latest(); // graphics thread
+//
+// back() holds an older frame, not the last one published, so the writer
+// has to fill all of it every time.
+
+#include <atomic>
+
+template <class T>
+class TripleBuffer
+{
+public:
+	TripleBuffer(const T &value = T()) { reset(value); }
+
+	// Set all three frames, e.g. to size them. Not while either side runs.
+	void reset(const T &value)
+	{
+		for (auto &frame : mFrames) frame = value;
+	}
+
+	// Writer: the frame to fill next
+	T &back() { return mFrames[mBack]; }
+
+	// Writer: make back() the latest frame
+	void publish()
+	{
+		mBack = mMiddle.exchange(mBack | kFresh, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	// Reader: the most recently published frame
+	const T &latest()
+	{
+		if (mMiddle.load(std::memory_order_acquire) & kFresh)
+			mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+		return mFrames[mFront];
+	}
+
+private:
+	static const int kIndexMask = 3;
+	static const int kFresh = 4;
+
+	T mFrames[3];
+	std::atomic<int> mMiddle{1};
+	int mBack = 0;    // writer side
+	int mFront = 2;   // reader side
+};
+
+#endif
@@ -0,0 +1,261 @@
+#pragma once
+#ifndef VoicePool_H
+#define VoicePool_H
+
+// Pre-allocated voices with a hard polyphony cap and voice stealing.
+//
+// PolySynth::getVoice<T>() constructs a new voice (meshes, envelopes, ...)
+// whenever it has no free one, which on a dense score means allocating in
+// the middle of a performance. A VoicePool<T> allocates everything up front
+// with allocatePolyphony() and then keeps count of the voices it has handed
+// out, so getVoice() always finds a free one:
+//
+//   AudioClock audioClock;                                   // app member
+//   VoicePool<PluckedString> plucks{synthManager.synth(), audioClock, 24, 20};
+//
+//   plucks.reserve();                              // onInit()
+//   audioClock.tick(io);                           // onSound(), after render
+//   plucks.update();                               // onAnimate()
+//   auto *voice = plucks.acquire(time);            // instead of getVoice()
+//   if (!voice) return;                            // note dropped
+//
+// maxVoices caps the notes sounding at once. Notes scheduled ahead of time
+// (ScoreStreamer hands the sequencer a couple of seconds of the score) hold
+// a voice too but don't count until they start, so the pool also keeps
+// maxWaiting voices for them: the most notes of the score that start within
+// the look-ahead. Only when those run out is a new note dropped.
+//
+// When a note starts with maxVoices already sounding, update() steals one
+// of the others according to the pool's policy:
+//
+//   Oldest          the voice that started first
+//   Quietest        lowest level(voice), e.g. its EnvFollow value
+//   LowestPriority  lowest priority passed to acquire(), oldest on a tie
+//
+// The pool never touches a voice while the audio thread may be rendering
+// it. Each pooled voice has a PooledVoice member named `pooled`, and starts
+// its onProcess(AudioIOData &) with
+//
+//   if (pooled.process(*this)) return;
+//
+// which frees the voice there if the pool stole it, and otherwise counts
+// the block so the pool can tell from its own thread when a voice has
+// stopped being rendered. A stolen voice is back on the synth's free list
+// within two callbacks, which a few spare voices cover; the pool never
+// allocates after reserve().
+//
+// Voices of the same type triggered some other way (e.g. from the keyboard
+// through SynthGUIManager) are not counted, which is what the spares absorb.
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "al/scene/al_PolySynth.hpp"
+
+#include "AudioClock.h"
+
+enum class StealPolicy { Oldest, Quietest, LowestPriority };
+
+// The part of a voice its VoicePool talks to, through atomics only
+class PooledVoice
+{
+public:
+	// Audio thread, first thing in onProcess(AudioIOData &): true if the
+	// voice was stolen and has been freed, in which case return right away
+	bool process(al::SynthVoice &voice)
+	{
+		mBlocks.fetch_add(1, std::memory_order_relaxed);
+		if (!mSteal.load(std::memory_order_acquire)) return false;
+		voice.free();
+		return true;
+	}
+
+	// Pool side
+	void steal() { mSteal.store(true, std::memory_order_release); }
+	void reset() { mSteal.store(false, std::memory_order_relaxed); }
+	uint64_t blocks() const { return mBlocks.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<bool> mSteal{false};
+	std::atomic<uint64_t> mBlocks{0};
+};
+
+template <class TVoice>
+class VoicePool
+{
+public:
+	VoicePool(al::PolySynth &synth, AudioClock &clock, unsigned maxVoices, unsigned maxWaiting,
+	          StealPolicy policy = StealPolicy::Oldest, unsigned spareVoices = 4)
+	:	mSynth(synth), mClock(clock), mMaxVoices(maxVoices), mPolicy(policy),
+		mSlots(maxVoices + maxWaiting + spareVoices)
+	{}
+
+	// How loud a voice is, for StealPolicy::Quietest
+	void level(std::function<float(TVoice &)> level) { mLevel = level; }
+
+	// Allocate all voices. Main thread, before any notes are played.
+	void reserve()
+	{
+		if (mReserved) return;
+		mSynth.allocatePolyphony<TVoice>((int)mSlots.size());
+		mReserved = true;
+	}
+
+	// Voice for a note starting `fromNow` seconds from now, or nullptr if the
+	// note has to be dropped. Never allocates once reserve() has run.
+	TVoice *acquire(float fromNow, int priority = 0)
+	{
+		update();
+
+		Slot *slot = nullptr;
+		for (auto &s : mSlots)
+			if (s.state == Slot::Free)
+			{
+				slot = &s;
+				break;
+			}
+		if (!slot)
+		{
+			++mDropped;
+			return nullptr;
+		}
+
+		slot->voice = mSynth.getVoice<TVoice>();
+		slot->voice->pooled.reset();
+		slot->start = mClock.seconds() + fromNow;
+		slot->priority = priority;
+		slot->state = Slot::Held;
+		slot->sounding = false;
+		return slot->voice;
+	}
+
+	// Reclaims finished voices and holds the notes that have started to
+	// maxVoices. Once per frame, on the thread that calls acquire().
+	void update()
+	{
+		double now = mClock.seconds();
+		uint64_t ticks = mClock.ticks();
+		unsigned sounding = 0;
+		for (auto &s : mSlots)
+		{
+			if (s.state == Slot::Returning && ticks >= s.returnTick) s.state = Slot::Free;
+			if (s.state != Slot::Held || !started(s, now)) continue;
+			uint64_t blocks = s.voice->pooled.blocks();
+			if (!s.sounding || blocks != s.blocks)
+			{
+				// Just started, or rendered since the last look
+				s.fresh = !s.sounding;
+				s.sounding = true;
+				s.blocks = blocks;
+				s.seenTick = ticks;
+			}
+			else if (ticks >= s.seenTick + 2)
+			{
+				// Not rendered for a whole callback: it freed itself and the
+				// synth has already taken it back
+				s.state = Slot::Free;
+				continue;
+			}
+			++sounding;
+		}
+
+		while (sounding > mMaxVoices)
+		{
+			Slot *victim = pickVictim(now);
+			if (!victim) break;
+			victim->voice->pooled.steal();
+			victim->state = Slot::Returning;
+			victim->returnTick = ticks + 2;
+			--sounding;
+			++mStolen;
+		}
+		for (auto &s : mSlots) s.fresh = false;
+	}
+
+	// Notes sounding or waiting to start
+	unsigned held() const
+	{
+		unsigned n = 0;
+		for (auto &s : mSlots) n += s.state == Slot::Held;
+		return n;
+	}
+
+	unsigned maxVoices() const { return mMaxVoices; }
+	unsigned stolen() const { return mStolen; }
+	unsigned dropped() const { return mDropped; }
+
+private:
+	struct Slot
+	{
+		enum State { Free, Held, Returning };
+		State state = Free;
+		TVoice *voice = nullptr;
+		double start = 0;
+		int priority = 0;
+		bool sounding = false;  // started, and seen being rendered
+		bool fresh = false;     // started in this update()
+		uint64_t blocks = 0;    // its pooled.blocks() when last seen changing
+		uint64_t seenTick = 0;  // clock ticks then
+		uint64_t returnTick = 0;
+	};
+
+	// A voice has started once a whole callback has passed its start time
+	bool started(const Slot &s, double now) const { return now > s.start + mClock.bufferSeconds(); }
+
+	// A sounding voice to cut, by policy. Voices that only just started are
+	// the ones making room, so they are only taken when there is no other.
+	Slot *pickVictim(double now)
+	{
+		// Without a level function, Quietest falls back to Oldest
+		StealPolicy policy = mPolicy;
+		if (policy == StealPolicy::Quietest && !mLevel) policy = StealPolicy::Oldest;
+
+		Slot *victim = nullptr;
+		float victimLevel = 0;
+		for (auto &s : mSlots)
+		{
+			if (s.state != Slot::Held || !s.sounding || !started(s, now)) continue;
+			float level = policy == StealPolicy::Quietest ? mLevel(*s.voice) : 0;
+			if (!victim || (victim->fresh && !s.fresh))
+			{
+				victim = &s;
+				victimLevel = level;
+				continue;
+			}
+			if (s.fresh && !victim->fresh) continue;
+			switch (policy)
+			{
+			case StealPolicy::Quietest:
+				if (level < victimLevel)
+				{
+					victim = &s;
+					victimLevel = level;
+				}
+				break;
+			case StealPolicy::Oldest:
+				if (s.start < victim->start) victim = &s;
+				break;
+			case StealPolicy::LowestPriority:
+				if (s.priority < victim->priority ||
+				    (s.priority == victim->priority && s.start < victim->start))
+					victim = &s;
+				break;
+			}
+		}
+		return victim;
+	}
+
+	al::PolySynth &mSynth;
+	AudioClock &mClock;
+	unsigned mMaxVoices;
+	StealPolicy mPolicy;
+	std::vector<Slot> mSlots;
+	std::function<float(TVoice &)> mLevel;
+	bool mReserved = false;
+	unsigned mStolen = 0;
+	unsigned mDropped = 0;
+};
+
+#endif
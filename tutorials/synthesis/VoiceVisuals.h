@@ -0,0 +1,246 @@
+#pragma once
+#ifndef VoiceVisuals_H
+#define VoiceVisuals_H
+
+// Batched, instanced drawing of voice visuals.
+//
+// A voice that draws itself with g.color() + g.draw(mesh) costs a draw call
+// and a round of state changes per shape, so hundreds of voices mean
+// hundreds of draw calls per frame. With VoiceVisuals the voice still
+// positions its shape with pushMatrix/translate/rotate/scale, but instead
+// of drawing it appends a record (the current model matrix and a color) to
+// the batch for that mesh. After the synth has rendered, the app draws
+// every batch with a single instanced call:
+//
+//   VoiceVisuals voiceVisuals;                               // global
+//
+//   VoiceShape mDisc;                                        // voice member
+//
+//   mDisc = voiceVisuals.mesh(SharedMesh::get("disc 1 30", [](Mesh &m) {
+//     addDisc(m, 1.0, 30);
+//   }));                                                     // voice init()
+//
+//   g.pushMatrix();                                          // onProcess(g)
+//   g.translate(x, y, -10);
+//   voiceVisuals.add(mDisc, g, Color(r, g, b, 0.4));
+//   g.popMatrix();
+//
+//   synthManager.render(g);                                  // app onDraw()
+//   voiceVisuals.draw(g);
+//
+// The VoiceShape holds the voice's reference to the mesh; the batches only
+// hold weak ones, so a shape no voice uses any more is still freed.
+//
+// draw(g, mesh, instances) draws a voice's own (non-shared) mesh several
+// times in one call instead, e.g. the copies of a spectrum line.
+//
+// Batched meshes are drawn with the batch shader below rather than the
+// Graphics one: a uniform color per instance, or the mesh colors, and for
+// lit meshes a simple head-light shading from the normals.
+
+#include <memory>
+#include <vector>
+
+#include "al/graphics/al_Graphics.hpp"
+#include "al/graphics/al_OpenGL.hpp"
+#include "al/graphics/al_Shader.hpp"
+#include "al/graphics/al_VAOMesh.hpp"
+
+#include "SharedMesh.h"
+
+struct VoiceInstance
+{
+	al::Mat4f model;
+	al::Color color;
+
+	VoiceInstance() {}
+	VoiceInstance(al::Graphics &g, const al::Color &c) : model(g.modelMatrix()), color(c) {}
+};
+
+// A voice's handle on a batch, keeping its mesh alive
+struct VoiceShape
+{
+	SharedMesh::Ptr mesh;
+	int batch = -1;
+};
+
+class VoiceVisuals
+{
+public:
+	// The instance buffer lives as long as the GL context, which usually
+	// outlives a global VoiceVisuals anyway
+	VoiceVisuals() {}
+
+	VoiceVisuals(const VoiceVisuals &) = delete;
+	VoiceVisuals &operator=(const VoiceVisuals &) = delete;
+
+	// Shape for `mesh`, in the same batch for every voice passing the same mesh
+	VoiceShape mesh(SharedMesh::Ptr mesh, bool lit = false)
+	{
+		VoiceShape shape;
+		shape.mesh = mesh;
+		// A batch whose mesh is gone has no shape pointing at it; reuse it
+		int unused = -1;
+		for (size_t i = 0; i < mBatches.size(); ++i)
+		{
+			SharedMesh::Ptr batchMesh = mBatches[i].mesh.lock();
+			if (batchMesh == mesh && mBatches[i].lit == lit) shape.batch = (int)i;
+			if (!batchMesh && unused < 0) unused = (int)i;
+		}
+		if (shape.batch >= 0) return shape;
+		if (unused < 0)
+		{
+			mBatches.emplace_back();
+			unused = (int)mBatches.size() - 1;
+		}
+		mBatches[unused].mesh = mesh;
+		mBatches[unused].lit = lit;
+		mBatches[unused].instances.clear();
+		shape.batch = unused;
+		return shape;
+	}
+
+	// Graphics thread: draw `shape` with g's current model matrix
+	void add(const VoiceShape &shape, al::Graphics &g, const al::Color &color)
+	{
+		mBatches[shape.batch].instances.emplace_back(g, color);
+	}
+
+	// Graphics thread: draw and clear all batches
+	void draw(al::Graphics &g)
+	{
+		mDrawCalls = 0;
+		mInstances = 0;
+		for (auto &batch : mBatches)
+		{
+			if (batch.instances.empty()) continue;
+			// Held only for the draw: the voices own the mesh
+			if (SharedMesh::Ptr mesh = batch.mesh.lock())
+				draw(g, mesh->uploaded(), batch.instances, false, batch.lit);
+			batch.instances.clear();
+		}
+	}
+
+	// Graphics thread: draw an uploaded mesh once per instance, now
+	void draw(al::Graphics &g, al::VAOMesh &mesh, const std::vector<VoiceInstance> &instances,
+	          bool meshColor = false, bool lit = false)
+	{
+		if (instances.empty()) return;
+		if (!mInstanceBuffer)
+		{
+			mShader.compile(vertexShader(), fragmentShader());
+			glGenBuffers(1, &mInstanceBuffer);
+		}
+
+		g.shader(mShader);
+		mShader.use();
+		mShader.uniform("viewMatrix", g.viewMatrix());
+		mShader.uniform("projMatrix", g.projMatrix());
+		mShader.uniform("meshColor", meshColor ? 1 : 0);
+		mShader.uniform("lit", lit ? 1 : 0);
+
+		mesh.vaoWrapper->vao.bind();
+		glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+		// Orphan and refill; the instance list changes every frame
+		glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(VoiceInstance), instances.data(),
+		             GL_STREAM_DRAW);
+		GLsizei stride = sizeof(VoiceInstance);
+		for (unsigned col = 0; col < 4; ++col)
+		{
+			glEnableVertexAttribArray(kModelLocation + col);
+			glVertexAttribPointer(kModelLocation + col, 4, GL_FLOAT, GL_FALSE, stride,
+			                      (void *)(sizeof(float) * 4 * col));
+			glVertexAttribDivisor(kModelLocation + col, 1);
+		}
+		glEnableVertexAttribArray(kColorLocation);
+		glVertexAttribPointer(kColorLocation, 4, GL_FLOAT, GL_FALSE, stride, (void *)sizeof(al::Mat4f));
+		glVertexAttribDivisor(kColorLocation, 1);
+
+		GLsizei count = (GLsizei)instances.size();
+		if (mesh.indices().size() > 0)
+		{
+			mesh.vaoWrapper->indexBuffer.bind();
+			glDrawElementsInstanced(mesh.vaoWrapper->GLPrimMode, (GLsizei)mesh.indices().size(),
+			                        GL_UNSIGNED_INT, 0, count);
+		}
+		else
+		{
+			glDrawArraysInstanced(mesh.vaoWrapper->GLPrimMode, 0, (GLsizei)mesh.vertices().size(), count);
+		}
+		mesh.vaoWrapper->vao.unbind();
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// Graphics only goes back to its own shaders when the coloring mode
+		// changes, so force one
+		g.meshColor();
+		g.color(1, 1, 1, 1);
+
+		++mDrawCalls;
+		mInstances += count;
+	}
+
+	// Draw calls and instances of the last draw(g)
+	unsigned drawCalls() const { return mDrawCalls; }
+	unsigned instances() const { return mInstances; }
+
+private:
+	// VAOMesh puts positions at 0, colors at 1 and normals at 3
+	enum { kModelLocation = 8, kColorLocation = 12 };
+
+	struct Batch
+	{
+		std::weak_ptr<SharedMesh> mesh;
+		bool lit = false;
+		std::vector<VoiceInstance> instances;
+	};
+
+	static const char *vertexShader()
+	{
+		return R"(
+#version 330
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+uniform int meshColor;
+uniform int lit;
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 vertexColor;
+layout (location = 3) in vec3 normal;
+layout (location = 8) in mat4 instanceModel;
+layout (location = 12) in vec4 instanceColor;
+
+out vec4 color;
+
+void main() {
+  mat4 modelView = viewMatrix * instanceModel;
+  color = meshColor != 0 ? vertexColor : instanceColor;
+  if (lit != 0) {
+    vec3 n = normalize(transpose(inverse(mat3(modelView))) * normal);
+    color.rgb *= 0.3 + 0.7 * abs(n.z);
+  }
+  gl_Position = projMatrix * modelView * vec4(position, 1.0);
+}
+)";
+	}
+
+	static const char *fragmentShader()
+	{
+		return R"(
+#version 330
+in vec4 color;
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+  fragColor = color;
+}
+)";
+	}
+
+	std::vector<Batch> mBatches;
+	al::ShaderProgram mShader;
+	GLuint mInstanceBuffer = 0;
+	unsigned mDrawCalls = 0;
+	unsigned mInstances = 0;
+};
+
+#endif
@@ -19,6 +19,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "OfflineRender.h"
+
 using namespace gam;
 using namespace al;
 using namespace std;
@@ -452,6 +454,7 @@ class MyApp : public App
 {
 public:
   SynthGUIManager<SineEnv> synthManager {"synth8"};
+  float compEnd = 0; // end of the last note scheduled by playComp()
   //    ParameterMIDI parameterMIDI;
 
   virtual void onInit( ) override {
@@ -533,6 +536,7 @@ public:
     vector<VariantValue> params = vector<VariantValue>({amp, freq, 0.0, 0.0, 0.0});
     voice->setTriggerParams(params);
     synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+    compEnd = max(compEnd, time + duration);
     }
 
     void playWireBox(float freq, float time, float duration, float amp = .2, float attack = 0.01, float decay = 0.01) {
@@ -540,6 +544,7 @@ public:
     vector<VariantValue> params = vector<VariantValue>({amp, freq, 0.0, 0.0, 0.0});
     voice->setTriggerParams(params);
     synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+    compEnd = max(compEnd, time + duration);
     }
 
     void playSine(float freq, float time, float duration, float amp = .2, float attack = 0.01, float decay = 0.01) {
@@ -547,6 +552,7 @@ public:
     vector<VariantValue> params = vector<VariantValue>({amp, freq, 0.0, 0.0, 0.0});
     voice->setTriggerParams(params);
     synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+    compEnd = max(compEnd, time + duration);
     }
 
     void playOsc(float freq, float time, float duration, float amp = .2, float attack = 0.01, float decay = 0.01) {
@@ -554,6 +560,7 @@ public:
     vector<VariantValue> params = vector<VariantValue>({amp, freq, 0.0, 0.0, 0.0});
     voice->setTriggerParams(params);
     synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+    compEnd = max(compEnd, time + duration);
     }
 
   void arpeggiator(int bpm, float startTime, int measures, const std::vector<float>& frequencies, int octaves) {
@@ -815,12 +822,31 @@ public:
 
       // interlude(bpm, timeElapsed(bpm, 48));
     }
+
+    // Render the piece to a WAV file as fast as possible, no audio device
+    bool renderOffline(const std::string &path) {
+      gam::sampleRate(48000);
+      OfflineRender render(48000, 512, 2);
+      compEnd = 0;
+      playComp();
+      bool ok = render.toWav(
+          path, [&](AudioIOData &io) { onSound(io); },
+          [&](double seconds) {
+            return seconds >= compEnd && !synthManager.synth().getActiveVoices();
+          });
+      render.report(path);
+      return ok;
+    }
   
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   MyApp app;
 
+  // ./cornfield_chase --render cornfield.wav writes the piece to disk instead
+  if (argc > 2 && std::string(argv[1]) == "--render")
+    return app.renderOffline(argv[2]) ? 0 : 1;
+
   // Set up audio
   app.configureAudio(48000., 512, 2, 0);
 
@@ -0,0 +1,134 @@
+// Compares the per-sample FM voice loop with the block renderer in FMBlock.h:
+// how far apart their outputs are and how many voices each fits on one core.
+//
+//   ./run.sh tutorials/synthesis/fm_block_bench.cpp
+//
+// The voice is electricBass from miniboss.cpp without the pan and envelope
+// follower, which both versions run per sample anyway.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Gamma/Domain.h"
+#include "Gamma/Envelope.h"
+#include "Gamma/Oscillator.h"
+
+#include "FMBlock.h"
+
+using namespace std;
+
+const float kSampleRate = 48000;
+const unsigned kBufferSize = 512;
+const float kSeconds = 4;
+
+const float freq = 110, carMul = 0.5, modMul = 0.25, amplitude = 0.161;
+
+void setupEnvelopes(gam::ADSR<> &ampEnv, gam::ADSR<> &modEnv)
+{
+  ampEnv.levels(0, 1, 1, 0);
+  ampEnv.lengths()[0] = 0.01;
+  ampEnv.lengths()[1] = 0.001;
+  ampEnv.lengths()[2] = 0.2;
+  modEnv.levels(10.0, 1.816, 1.816, 1.684);
+  modEnv.lengths()[0] = 0.01;
+  modEnv.lengths()[1] = 0.001;
+  modEnv.lengths()[2] = 0.2;
+  ampEnv.reset();
+  modEnv.reset();
+}
+
+// The loop the voices used to run
+void renderPerSample(vector<float> &out)
+{
+  gam::ADSR<> ampEnv, modEnv;
+  gam::Sine<> car, mod;
+  setupEnvelopes(ampEnv, modEnv);
+  mod.freq(freq * modMul);
+  float carBaseFreq = freq * carMul;
+  float modScale = freq * modMul;
+  for (size_t start = 0; start < out.size(); start += kBufferSize)
+  {
+    for (size_t i = start; i < start + kBufferSize && i < out.size(); i++)
+    {
+      car.freq(carBaseFreq + mod() * modEnv() * modScale);
+      out[i] = car() * ampEnv() * amplitude;
+    }
+  }
+}
+
+void renderBlock(vector<float> &out)
+{
+  gam::ADSR<> ampEnv, modEnv;
+  FMBlock fm;
+  setupEnvelopes(ampEnv, modEnv);
+  fm.mod.freq(freq * modMul);
+  float carBaseFreq = freq * carMul;
+  float modScale = freq * modMul;
+  for (size_t start = 0; start < out.size(); start += kBufferSize)
+  {
+    unsigned frames = (unsigned)min((size_t)kBufferSize, out.size() - start);
+    float *dst = out.data() + start;
+    while (frames > 0)
+    {
+      unsigned n = frames < FMBlock::kMaxFrames ? frames : FMBlock::kMaxFrames;
+      for (unsigned i = 0; i < n; ++i)
+      {
+        fm.carFreq[i] = carBaseFreq;
+        fm.modDepth[i] = modEnv() * modScale;
+        fm.amp[i] = ampEnv() * amplitude;
+      }
+      fm.render(n);
+      for (unsigned i = 0; i < n; ++i) dst[i] = fm.out[i];
+      dst += n;
+      frames -= n;
+    }
+  }
+}
+
+// Real-time voices one core can run: seconds of audio per second of CPU
+template <typename F>
+double voicesPerCore(F render, vector<float> &out, int runs)
+{
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < runs; i++)
+  {
+    render(out);
+  }
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+  return runs * kSeconds / elapsed.count();
+}
+
+int main()
+{
+  gam::sampleRate(kSampleRate);
+  vector<float> before(size_t(kSeconds * kSampleRate));
+  vector<float> after(before.size());
+
+  renderPerSample(before);
+  renderBlock(after);
+  float maxDiff = 0, peak = 0;
+  for (size_t i = 0; i < before.size(); i++)
+  {
+    maxDiff = max(maxDiff, fabs(before[i] - after[i]));
+    peak = max(peak, fabs(before[i]));
+  }
+  // Both accumulate phase differently, so allow a little drift
+  bool same = maxDiff <= 1e-3f * peak;
+  printf("max difference %g (peak %g): %s\n", maxDiff, peak,
+         same ? "same within tolerance" : "OUTPUTS DIFFER");
+
+#if defined(__AVX2__)
+  const char *path = "AVX2";
+#elif defined(BLOCKSINE_SSE2)
+  const char *path = "SSE2";
+#else
+  const char *path = "scalar";
+#endif
+  double perSample = voicesPerCore(renderPerSample, before, 20);
+  double block = voicesPerCore(renderBlock, after, 20);
+  printf("voices per core: per-sample %.0f, block (%s) %.0f, %.2fx\n",
+         perSample, path, block, block / perSample);
+  return same ? 0 : 1;
+}
@@ -26,17 +26,23 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
-// #include <json/json.h>
-// #include "json.hpp"
-#include <nlohmann/json.hpp>
-#include <fstream>
-using json = nlohmann::json;
+#include "OfflineRender.h"
+#include "Score.h"
+#include "ScoreStreamer.h"
+#include "SpectrumBus.h"
+#include "VoicePool.h"
 
 // using namespace gam;
 using namespace al;
 using namespace std;
 #define FFT_SIZE 4048
 
+// Spectrum of all PluckedString voices, analyzed once off the audio thread.
+// The analyzer pushes it to spectrumHistory, which the app updates once per
+// frame and every voice draws.
+SpectrumBus spectrumBus{FFT_SIZE, FFT_SIZE / 4};
+ScrollingHistory spectrumHistory{FFT_SIZE / 2 + 1, ScrollingHistory::kTraceColumns};
+
 float freq_of(int midi) {
     float freq = pow(2, ((midi-69)/12.0)) * 440;
     return freq;
@@ -45,6 +51,7 @@ float freq_of(int midi) {
 class PluckedString : public SynthVoice
 {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
     float mAmp;
     float mDur;
     float mPanRise;
@@ -56,10 +63,8 @@ public:
     gam::ADSR<> mAmpEnv;
     gam::EnvFollow<> mEnvFollow;
     gam::Env<2> mPanEnv;
-    gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
-    // This time, let's use spectrograms for each notes as the visual components.
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // This time, let's use spectrograms for each notes as the visual
+    // components: spectrumHistory.
     double a = 0;
     double b = 0;
     double timepose = 10;
@@ -68,10 +73,6 @@ public:
 
     virtual void init() override
     {
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
-        // mSpectrogram.primitive(Mesh::POINTS);
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
         mAmpEnv.levels(1, 0.5, 0.2, 0.1);
         mPanEnv.curve(4);
         env.decay(0.1);
@@ -103,6 +104,7 @@ public:
 
     virtual void onProcess(AudioIOData &io) override
     {
+        if (pooled.process(*this)) return;
 
         while (io())
         {
@@ -113,15 +115,8 @@ public:
             mPan(s1, s1, s2);
             io.out(0) += s1;
             io.out(1) += s2;
-            // STFT for each notes
-            if (stft(s1))
-            { // Loop through all the frequency bins
-                for (unsigned k = 0; k < stft.numBins(); ++k)
-                {
-                    // Here we simply scale the complex sample
-                    spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
-                }
-            }
+            // Feed the shared analyzer
+            spectrumBus.add(io.frame(), s1);
         }
         if (mAmpEnv.done() && (mEnvFollow.value() < 0.001))
             free();
@@ -135,21 +130,12 @@ public:
         b += 0.23;
         timepose -= 0.1;
 
-        mSpectrogram.reset();
-        // mSpectrogram.primitive(Mesh::LINE_STRIP);
-
-        for (int i = 0; i < FFT_SIZE / 2; i++)
-        {
-            mSpectrogram.color(HSV(spectrum[i] * 1000 + al::rnd::uniform()));
-            mSpectrogram.vertex(i, spectrum[i], 0.0);
-        }
-        g.meshColor(); // Use the color in the mesh
         g.pushMatrix();
         g.translate(0, 0, -10);
         g.rotate(a, Vec3f(0, 1, 0));
         g.rotate(b, Vec3f(1));
-        g.scale(10.0 / FFT_SIZE, 500, 1.0);
-        g.draw(mSpectrogram);
+        g.scale(5.0, 500, 1.0);
+        spectrumHistory.drawTrace(g, spectrumHistory.rows());
         g.popMatrix();
     }
 
@@ -188,6 +174,7 @@ public:
 class SquareWave : public SynthVoice
 {
 public:
+  PooledVoice pooled; // lets its VoicePool cut it from the audio thread
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc1;
@@ -224,6 +211,7 @@ public:
   // The audio processing function
   void onProcess(AudioIOData &io) override
   {
+    if (pooled.process(*this)) return;
     // Get the values from the parameters and apply them to the corresponding
     // unit generators. You could place these lines in the onTrigger() function,
     // but placing them here allows for realtime prototyping on a running
@@ -429,12 +417,21 @@ public:
     SynthGUIManager<PluckedString> synthManager{"plunk"};
     //    ParameterMIDI parameterMIDI;
     RtMidiIn midiIn; // MIDI input carrier
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // The analyzer pushes the mix's spectra to the GPU; see ScrollingHistory.h
+    SpectrumBus mixSpectrum{FFT_SIZE, FFT_SIZE / 4};
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
+    AudioClock audioClock; // audio time, for the score and the voice pools
+    ScoreStreamer scoreStreamer{audioClock};
+    // Voices are allocated up front; past the cap on sounding notes the
+    // quietest pluck or the oldest square is cut to make room. The second
+    // number is how many notes wait for their start: the most per part that
+    // start within any 2 s of fugue.json (the streamer's look-ahead), with
+    // some margin.
+    VoicePool<PluckedString> plucks{synthManager.synth(), audioClock, 24, 20, StealPolicy::Quietest};
+    VoicePool<SquareWave> squares{synthManager.synth(), audioClock, 16, 28};
     bool showGUI = true;
     bool showSpectro = true;
     bool navi = false;
-    gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
 
     virtual void onInit() override
     {
@@ -459,13 +456,35 @@ public:
         {
             printf("Error: No MIDI devices found.\n");
         }
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
+        // Spectra colored as hue + value * hue gain
+        spectrumHistory.color(0, 1000);
+        spectrogram.color(0.5, -100);
+        spectrumBus.feed(spectrumHistory);
+        mixSpectrum.feed(spectrogram);
+        // Run the analyzers now that the sample rate is set
+        spectrumBus.start();
+        mixSpectrum.start();
+        reserveVoices();
+    }
+
+    void reserveVoices()
+    {
+        plucks.level([](PluckedString &voice) { return voice.mEnvFollow.value(); });
+        plucks.reserve();
+        squares.reserve();
+    }
+
+    // Frees finished voices and cuts notes past each part's cap
+    void updateVoices()
+    {
+        plucks.update();
+        squares.update();
     }
 
     void playGuitar(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<PluckedString>();
+        auto *voice = plucks.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("frequency", freq);
         voice->setInternalParameterValue("amplitude", amp);
@@ -476,7 +495,8 @@ public:
 
     void playSquare(float freq, float time, float duration, float amp = .1, float attack = 0.1, float decay = 0.2)
     {
-        auto *voice = synthManager.synth().getVoice<SquareWave>();
+        auto *voice = squares.acquire(time);
+        if (!voice) return;
         // amp, freq, attack, release, pan
         vector<VariantValue> params = vector<VariantValue>({amp, freq, attack, decay, 0.0});
         voice->setTriggerParams(params);
@@ -485,35 +505,43 @@ public:
 
 
     void playFugue() {
-        // read json file
-        std::ifstream f("/Users/gracefeng/allolib/demo1-gracefeng05/tutorials/synthesis/fugue.json");
-        // cout << "FILE" << endl;
-        // cout << f.rdbuf();
-        json music = json::parse(f);
-
-        json treble = music["tracks"][0]["notes"];
-        json bass = music["tracks"][1]["notes"];
-
-        auto t = treble.begin();
-        auto b = bass.begin();
-
-
-    while(t != treble.end() || b != bass.end())
-    {
-        if(t != treble.end())
-        {
-            auto note = *t;
-            playSquare(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++t;
-        }
-        if(b != bass.end())
-        {
-            auto note = *b;
-            playGuitar(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++b;
-        }
+        // Notes are handed to the sequencer a couple of seconds ahead of
+        // time from onAnimate() instead of all at once
+        scoreStreamer.onNote([this](const Score &score, uint32_t i, float fromNow) {
+            float freq = freq_of(score.midi(i));
+            switch (score.track(i))
+            {
+            case 0: // treble
+                playSquare(freq, fromNow, score.duration(i), score.velocity(i));
+                break;
+            case 1: // bass
+                playGuitar(freq, fromNow, score.duration(i), score.velocity(i));
+                break;
+            }
+        });
+        scoreStreamer.start("/Users/gracefeng/allolib/demo1-gracefeng05/tutorials/synthesis/fugue.json");
     }
 
+    // Render the fugue to a WAV file as fast as possible, no audio device
+    bool renderOffline(const std::string &path)
+    {
+        gam::sampleRate(48000);
+        OfflineRender render(48000, 512, 2);
+        reserveVoices();
+        playFugue();
+        float end = scoreStreamer.length();
+        bool ok = render.toWav(
+            path,
+            [&](AudioIOData &io) {
+                scoreStreamer.update(render.seconds());
+                updateVoices();
+                onSound(io);
+            },
+            [&](double seconds) {
+                return seconds >= end && !synthManager.synth().getActiveVoices();
+            });
+        render.report(path);
+        return ok;
     }
 
     void onCreate() override
@@ -526,23 +554,20 @@ public:
     void onSound(AudioIOData &io) override
     {
         synthManager.render(io); // Render audio
-        // STFT
-        while (io())
-        {
-            if (stft(io.out(0)))
-            { // Loop through all the frequency bins
-                for (unsigned k = 0; k < stft.numBins(); ++k)
-                {
-                    // Here we simply scale the complex sample
-                    spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
-                    // spectrum[k] = stft.bin(k).real();
-                }
-            }
-        }        
+        audioClock.tick(io);
+        spectrumBus.commit(io.framesPerBuffer());
+        // STFT of the mix runs on the analyzer thread
+        mixSpectrum.add(io.outBuffer(0), io.framesPerBuffer());
+        mixSpectrum.commit(io.framesPerBuffer());
     }
 
     void onAnimate(double dt) override
     {
+        scoreStreamer.update();
+        updateVoices();
+        // Upload the spectra pushed since the last frame
+        spectrumHistory.update();
+        spectrogram.update();
         navControl().active(navi); // Disable navigation via keyboard, since we
         imguiBeginFrame();
         synthManager.drawSynthControlPanel();
@@ -554,20 +579,18 @@ public:
         g.clear();
         synthManager.render(g);
         // // Draw Spectrum
-        mSpectrogram.reset();
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
         if (showSpectro)
         {
-            for (int i = 0; i < FFT_SIZE / 2; i++)
-            {
-                mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-                mSpectrogram.vertex(i, spectrum[i], 0.0);
-            }
-            g.meshColor(); // Use the color in the mesh
+            // Spectrogram below the spectrum, newest on the right
+            g.pushMatrix();
+            g.translate(-3, -4.5, 0);
+            g.scale(10.0, 1.25, 1.0);
+            spectrogram.drawImage(g, 1000);
+            g.popMatrix();
             g.pushMatrix();
             g.translate(-3, -3, 0);
-            g.scale(20.0 / FFT_SIZE, 100, 1.0);
-            g.draw(mSpectrogram);
+            g.scale(10.0, 100, 1.0);
+            spectrogram.drawTrace(g, spectrogram.rows());
             g.popMatrix();
         }
         // Draw GUI
@@ -657,13 +680,22 @@ public:
         return true;
     }
 
-    void onExit() override { imguiShutdown(); }
+    void onExit() override
+    {
+        spectrumBus.stop();
+        mixSpectrum.stop();
+        imguiShutdown();
+    }
 };
 
-int main()
+int main(int argc, char *argv[])
 {
     MyApp app;
 
+    // ./fugue --render fugue.wav writes the piece to disk instead
+    if (argc > 2 && std::string(argv[1]) == "--render")
+        return app.renderOffline(argv[2]) ? 0 : 1;
+
     // Set up audio
     app.configureAudio(48000., 512, 2, 0);
 
@@ -17,9 +17,15 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "SharedMesh.h"
+#include "VoiceVisuals.h"
+
 using namespace gam;
 using namespace al;
 using namespace std;
+
+// Voices add their shapes here; the app draws them after the synth
+VoiceVisuals voiceVisuals;
 class Sub : public SynthVoice {
 public:
 
@@ -34,7 +40,7 @@ public:
     gam::Env<2> mCFEnv;
     gam::Env<2> mBWEnv;
     // Additional members
-    Mesh mMesh;
+    VoiceShape mShape;
 
     // Initialize voice. This function will nly be called once per voice
     void init() override {
@@ -45,7 +51,7 @@ public:
         mBWEnv.curve(0);
         mOsc.harmonics(12);
         // We have the mesh be a sphere
-        addDisc(mMesh, 1.0, 30);
+        mShape = voiceVisuals.mesh(SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); }));
 
         createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
         createInternalTriggerParameter("frequency", 60, 20, 5000);
@@ -102,8 +108,7 @@ public:
           //g.scale(frequency/2000, frequency/4000, 1);
           float scaling = 0.1;
           g.scale(scaling * frequency/200, scaling * frequency/400, scaling* 1);
-          g.color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4);
-          g.draw(mMesh);
+          voiceVisuals.add(mShape, g, Color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4));
           g.popMatrix();
    }
     virtual void onTriggerOn() override {
@@ -165,7 +170,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -177,7 +182,7 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a rectangle
-    addTorus(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("torus", [](Mesh &m) { addTorus(m); }));
 
     createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
     createInternalTriggerParameter("frequency", 440, 20, 5000);
@@ -230,8 +235,7 @@ public:
     g.pushMatrix();
     g.translate(sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -8);
     g.scale(amplitude, amplitude, amplitude);
-    g.color(frequency / 1000, frequency / 1000, 10, 0.4);
-    g.draw(mMesh);
+    voiceVisuals.add(mShape, g, Color(frequency / 1000, frequency / 1000, 10, 0.4));
     g.popMatrix();
   }
 
@@ -257,7 +261,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -269,7 +273,7 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a rectangle
-    addTorus(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("torus", [](Mesh &m) { addTorus(m); }));
 
     createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
     createInternalTriggerParameter("frequency", 440, 20, 5000);
@@ -324,8 +328,7 @@ public:
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), -16);
   g.scale(5 * frequency/1000, 5 * frequency/1000, 1);
-  g.color(10, frequency / 1000,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mShape, g, Color(10, frequency / 1000,  frequency / 1000, 0.4));
   g.popMatrix();
   }
 
@@ -346,7 +349,7 @@ class SineEnv : public SynthVoice {
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -357,7 +360,7 @@ class SineEnv : public SynthVoice {
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
 
     // We have the mesh be a sphere
-    addTorus(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("torus", [](Mesh &m) { addTorus(m); }));
 
     // This is a quick way to create parameters for the voice. Trigger
     // parameters are meant to be set only when the voice starts, i.e. they
@@ -408,8 +411,7 @@ class SineEnv : public SynthVoice {
     g.pushMatrix();
     g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), -4);
     g.scale(0.1, 0.1, 0.1);
-    g.color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4);
-    g.draw(mMesh);
+    voiceVisuals.add(mShape, g, Color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4));
     g.popMatrix();
   }
 
@@ -436,7 +438,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -448,7 +450,7 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a rectangle
-    addTorus(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("torus", [](Mesh &m) { addTorus(m); }));
 
     createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
     createInternalTriggerParameter("frequency", 440, 20, 5000);
@@ -503,16 +505,14 @@ public:
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), 0);
   g.scale(5 * frequency/10000, 5 * frequency/10000, 1);
-  g.color(10, frequency / 1000,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mShape, g, Color(10, frequency / 1000,  frequency / 1000, 0.4));
   g.popMatrix();
 
   /*addSurfaceLoop(mMesh, 4, 4, 2);
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -24);
   g.scale(3 * frequency/10000, 3 * frequency/10000, 0.4);
-  g.color(10, 10,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mShape, g, Color(10, 10,  frequency / 1000, 0.4));
   g.popMatrix();
   */
   
@@ -568,6 +568,7 @@ public:
     void onDraw(Graphics& g) override {
         g.clear();
         synthManager.render(g);
+        voiceVisuals.draw(g);
 
         // Draw GUI
         imguiDraw();
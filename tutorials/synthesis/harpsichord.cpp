@@ -30,6 +30,9 @@
 // #include "json.hpp"
 #include <nlohmann/json.hpp>
 #include <fstream>
+
+#include "ScrollingHistory.h"
+
 using json = nlohmann::json;
 
 // using namespace gam;
@@ -58,8 +61,8 @@ public:
     gam::Env<2> mPanEnv;
     gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
     // This time, let's use spectrograms for each notes as the visual components.
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // Spectra go to the GPU as they come in; see ScrollingHistory.h
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kTraceColumns};
     double a = 0;
     double b = 0;
     double timepose = 10;
@@ -68,10 +71,8 @@ public:
 
     virtual void init() override
     {
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
-        // mSpectrogram.primitive(Mesh::POINTS);
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
+        // Colors, as hue + value * hue gain
+        spectrogram.color(0, 1000);
         mAmpEnv.levels(1, 0.5, 0.2, 0);
         mPanEnv.curve(5);
         env.decay(0.05);
@@ -116,11 +117,13 @@ public:
             // STFT for each notes
             if (stft(s1))
             { // Loop through all the frequency bins
+                float spectrum[FFT_SIZE / 2 + 1];
                 for (unsigned k = 0; k < stft.numBins(); ++k)
                 {
                     // Here we simply scale the complex sample
                     spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
                 }
+                spectrogram.push(spectrum);
             }
         }
         if (mAmpEnv.done() && (mEnvFollow.value() < 0.001))
@@ -135,21 +138,14 @@ public:
         b += 0.23;
         timepose -= 0.1;
 
-        mSpectrogram.reset();
-        // mSpectrogram.primitive(Mesh::LINE_STRIP);
-
-        for (int i = 0; i < FFT_SIZE / 2; i++)
-        {
-            mSpectrogram.color(HSV(spectrum[i] * 1000 + al::rnd::uniform()));
-            mSpectrogram.vertex(i, spectrum[i], 0.0);
-        }
-        g.meshColor(); // Use the color in the mesh
+        // Upload this note's spectra pushed since the last frame
+        spectrogram.update();
         g.pushMatrix();
         g.translate(0, 0, -10);
         g.rotate(a, Vec3f(0, 1, 0));
         g.rotate(b, Vec3f(1));
-        g.scale(10.0 / FFT_SIZE, 500, 1.0);
-        g.draw(mSpectrogram);
+        g.scale(5.0, 500, 1.0);
+        spectrogram.drawTrace(g, spectrogram.rows());
         g.popMatrix();
     }
 
@@ -191,8 +187,8 @@ public:
     SynthGUIManager<PluckedString> synthManager{"plunk"};
     //    ParameterMIDI parameterMIDI;
     RtMidiIn midiIn; // MIDI input carrier
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // Spectra go to the GPU as they come in; see ScrollingHistory.h
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
     bool showGUI = true;
     bool showSpectro = true;
     bool navi = false;
@@ -221,8 +217,8 @@ public:
         {
             printf("Error: No MIDI devices found.\n");
         }
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
+        // Colors, as hue + value * hue gain
+        spectrogram.color(0.5, -100);
     }
 
     void playHarpsichord(float freq, float time, float duration, float amp = 0.4)
@@ -283,18 +279,22 @@ public:
         {
             if (stft(io.out(0)))
             { // Loop through all the frequency bins
+                float spectrum[FFT_SIZE / 2 + 1];
                 for (unsigned k = 0; k < stft.numBins(); ++k)
                 {
                     // Here we simply scale the complex sample
                     spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
                     // spectrum[k] = stft.bin(k).real();
                 }
+                spectrogram.push(spectrum);
             }
         }        
     }
 
     void onAnimate(double dt) override
     {
+        // Upload the spectra pushed since the last frame
+        spectrogram.update();
         navControl().active(navi); // Disable navigation via keyboard, since we
         imguiBeginFrame();
         synthManager.drawSynthControlPanel();
@@ -306,20 +306,18 @@ public:
         g.clear();
         synthManager.render(g);
         // // Draw Spectrum
-        mSpectrogram.reset();
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
         if (showSpectro)
         {
-            for (int i = 0; i < FFT_SIZE / 2; i++)
-            {
-                mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-                mSpectrogram.vertex(i, spectrum[i], 0.0);
-            }
-            g.meshColor(); // Use the color in the mesh
+            // Spectrogram below the spectrum, newest on the right
+            g.pushMatrix();
+            g.translate(-3, -4.5, 0);
+            g.scale(10.0, 1.25, 1.0);
+            spectrogram.drawImage(g, 1000);
+            g.popMatrix();
             g.pushMatrix();
             g.translate(-3, -3, 0);
-            g.scale(20.0 / FFT_SIZE, 100, 1.0);
-            g.draw(mSpectrogram);
+            g.scale(10.0, 100, 1.0);
+            spectrogram.drawTrace(g, spectrogram.rows());
             g.popMatrix();
         }
         // Draw GUI
@@ -23,22 +23,36 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "ParamHandle.h"
+#include "SharedMesh.h"
+#include "SpectrumBus.h"
+#include "VoiceVisuals.h"
+
 using namespace gam;
 using namespace al;
 using namespace std;
 #define FFT_SIZE 4048
 
+// Spectrum of all Spectrogram voices, analyzed once off the audio thread
+SpectrumBus spectrumBus{FFT_SIZE, FFT_SIZE / 4};
+// Voices add their shapes here; the app draws them after the synth
+VoiceVisuals voiceVisuals;
+
 class Spectrogram : public SynthVoice {
   public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   gam::Pan<> mPan;
   gam::Sine<> mOsc;
   gam::Env<3> mAmpEnv;
   gam::EnvFollow<> mEnvFollow;
 
-  gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE/4, 0, gam::HANN, gam::MAG_FREQ);
-
-  Mesh mSpectrogram;
-  vector<float> spectrum;
+  VAOMesh mSpectrogram;
+  vector<VoiceInstance> mLines;  // copies of the spectrum line
   Mesh mMesh;
 
   void init() override {
@@ -46,18 +60,16 @@ class Spectrogram : public SynthVoice {
     mAmpEnv.levels(0,1,1,0);
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
-    // Declare the size of the spectrum
-    spectrum.resize(FFT_SIZE);
     mSpectrogram.primitive(Mesh::LINE_LOOP);
     // mSpectrogram.primitive(Mesh::POINTS);
 
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   void onProcess(AudioIOData& io) override {
@@ -67,25 +79,22 @@ class Spectrogram : public SynthVoice {
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    float f = getInternalParameterValue("frequency");
+    float f = mFrequencyParam;
     mOsc.freq(f);
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
+    float amp = mAmplitudeParam;
     while(io()){
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * amp;
       float s2;
       mPan(s1, s1, s2);
       mEnvFollow(s1);
       io.out(0) += s1;
       io.out(1) += s2;
 
-      if(stft(s1)){
-        // loop through all frequency bins and scale the complex sample
-        for(unsigned k = 0; k < stft.numBins(); ++k){
-          spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
-        }
-      }
+      // the shared analyzer does the STFT for all voices
+      spectrumBus.add(io.frame(), s1);
     }
     // We need to let the synth know that this voice is done
     // by calling the free(). This takes the voice out of the
@@ -96,9 +105,10 @@ class Spectrogram : public SynthVoice {
   void onProcess(Graphics& g) override {
     // Figure out graphics for chords later
 
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
 
+    const vector<float> &spectrum = spectrumBus.spectrum();
     mSpectrogram.reset();
 
     for(int i = 0; i < FFT_SIZE / 90; i++){
@@ -106,18 +116,22 @@ class Spectrogram : public SynthVoice {
       mSpectrogram.vertex(i, spectrum[i], 0.0);
     }
 
+    mSpectrogram.update();
+
+    // All ten copies in one instanced draw
+    mLines.clear();
     for(int i = -5; i <= 4; i++) {
-      g.meshColor();
       g.pushMatrix();
       // g.translate(-0.5f, 1, -10);
       // g.translate(cos(static_cast<double>(frequency)), sin(static_cast<double>(frequency)), -4);
       g.translate(i, -2.7, -10);
       g.scale(50.0/FFT_SIZE, 250, 1.0);
-      // g.pointSize(1 + 5 * mEnvFollow.value() * 10);
-      g.lineWidth(1 + 5 * mEnvFollow.value() * 100);
-      g.draw(mSpectrogram);
+      mLines.emplace_back(g, Color(1));
       g.popMatrix();
     }
+    // g.pointSize(1 + 5 * mEnvFollow.value() * 10);
+    g.lineWidth(1 + 5 * mEnvFollow.value() * 100);
+    voiceVisuals.draw(g, mSpectrogram, mLines, true);
   }
 
   void onTriggerOn() override {
@@ -132,6 +146,12 @@ class Spectrogram : public SynthVoice {
 class SquareWave : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc1;
@@ -144,7 +164,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -156,13 +176,13 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a rectangle
-    addTorus(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("torus", [](Mesh &m) { addTorus(m); }));
 
-    createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   // The audio processing function
@@ -174,15 +194,15 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    float f = getInternalParameterValue("frequency");
+    float f = mFrequencyParam;
     mOsc1.freq(f);
     mOsc3.freq(f * 3);
     mOsc5.freq(f * 5);
 
-    float a = getInternalParameterValue("amplitude");
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    float a = mAmplitudeParam;
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
     while (io())
     {
       float s1 = mAmpEnv() * (mOsc1() * a +
@@ -203,28 +223,25 @@ public:
 
   // The graphics processing function
   void onProcess(Graphics &g) override {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
 
     g.pushMatrix();
     g.translate(sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -8);
     g.scale(frequency / 5000, frequency / 5000, frequency / 5000);
-    g.color(frequency / 1000, frequency / 1000, 10, 0.4);
-    g.draw(mMesh);
+    voiceVisuals.add(mShape, g, Color(frequency / 1000, frequency / 1000, 10, 0.4));
     g.popMatrix();
 
     g.pushMatrix();
     g.translate(sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -12);
     g.scale(frequency / 5000, 2 * frequency / 5000, frequency / 5000);
-    g.color(frequency / 1000, 10, 10, 0.4);
-    g.draw(mMesh);
+    voiceVisuals.add(mShape, g, Color(frequency / 1000, 10, 10, 0.4));
     g.popMatrix();
 
     g.pushMatrix();
     g.translate(cos(static_cast<double>(frequency)), sin(static_cast<double>(frequency)), -14);
     g.scale(frequency / 5000, 3 * frequency / 5000, frequency / 5000);
-    g.color(frequency / 1000, 10, frequency / 10, 0.4);
-    g.draw(mMesh);
+    voiceVisuals.add(mShape, g, Color(frequency / 1000, 10, frequency / 10, 0.4));
     g.popMatrix();
   }
 
@@ -238,6 +255,12 @@ public:
 class WireBox : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc1;
@@ -250,7 +273,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -262,13 +285,13 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a rectangle
-    addWireBox(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("wire box", [](Mesh &m) { addWireBox(m); }));
 
-    createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   // The audio processing function
@@ -280,15 +303,15 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    float f = getInternalParameterValue("frequency");
+    float f = mFrequencyParam;
     mOsc1.freq(f);
     mOsc3.freq(f * 3);
     mOsc5.freq(f * 5);
 
-    float a = getInternalParameterValue("amplitude");
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    float a = mAmplitudeParam;
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
     while (io())
     {
       float s1 = mAmpEnv() * (mOsc1() * a +
@@ -311,29 +334,26 @@ public:
   void onProcess(Graphics &g) override {
     // Get the paramter values on every video frame, to apply changes to the
   // current instance
-  float frequency = getInternalParameterValue("frequency");
-  float amplitude = getInternalParameterValue("amplitude");
+  float frequency = mFrequencyParam;
+  float amplitude = mAmplitudeParam;
   // Now draw
 
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), -16);
   g.scale(5 * frequency/1000, 5 * frequency/1000, 1);
-  g.color(10, frequency / 1000,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mShape, g, Color(10, frequency / 1000,  frequency / 1000, 0.4));
   g.popMatrix();
 
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -16);
   g.scale(3 * frequency/1000, 3 * frequency/1000, 0.4);
-  g.color(10, 10,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mShape, g, Color(10, 10,  frequency / 1000, 0.4));
   g.popMatrix();
 
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -24);
   g.scale(3 * frequency/1000, 3 * frequency/1000, 0.4);
-  g.color(10, 10,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mShape, g, Color(10, 10,  frequency / 1000, 0.4));
   g.popMatrix();
   }
 
@@ -346,6 +366,12 @@ public:
 
 class SineEnv : public SynthVoice {
  public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc;
@@ -354,7 +380,7 @@ class SineEnv : public SynthVoice {
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mShape;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -365,7 +391,7 @@ class SineEnv : public SynthVoice {
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
 
     // We have the mesh be a sphere
-    addRect(mMesh);
+    mShape = voiceVisuals.mesh(SharedMesh::get("rect", [](Mesh &m) { addRect(m); }));
 
     // This is a quick way to create parameters for the voice. Trigger
     // parameters are meant to be set only when the voice starts, i.e. they
@@ -373,11 +399,11 @@ class SineEnv : public SynthVoice {
     // change them while you are prototyping, but their changes will only be
     // stored and aplied when a note is triggered.)
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   // The audio processing function
@@ -388,12 +414,13 @@ class SineEnv : public SynthVoice {
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam);
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
+    float amp = mAmplitudeParam;
     while (io()) {
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * amp;
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -410,14 +437,13 @@ class SineEnv : public SynthVoice {
   void onProcess(Graphics& g) override {
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
     // Now draw
     g.pushMatrix();
     g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), -10);
     g.scale(0.1, 0.1, 0.1);
-    g.color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4);
-    g.draw(mMesh);
+    voiceVisuals.add(mShape, g, Color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4));
     g.popMatrix();
   }
 
@@ -432,6 +458,12 @@ class SineEnv : public SynthVoice {
 class OscAM : public SynthVoice
 {
 public:
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc1;
@@ -444,7 +476,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  VoiceShape mBox, mBoxLoop, mBoxLoopTetra;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -455,14 +487,24 @@ public:
     mAmpEnv.levels(0, 1, 1, 0);
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
-    // We have the mesh be a rectangle
-    addWireBox(mMesh);
-
-    createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    // Wire box, then with a surface loop, then also a tetrahedron for high
+    // notes. (These used to be appended to one mesh on every frame.)
+    mBox = voiceVisuals.mesh(SharedMesh::get("wire box", [](Mesh &m) { addWireBox(m); }));
+    mBoxLoop = voiceVisuals.mesh(SharedMesh::get("wire box + loop", [](Mesh &m) {
+      addWireBox(m);
+      addSurfaceLoop(m, 4, 4, 2);
+    }));
+    mBoxLoopTetra = voiceVisuals.mesh(SharedMesh::get("wire box + loop + tetrahedron", [](Mesh &m) {
+      addWireBox(m);
+      addSurfaceLoop(m, 4, 4, 2);
+      addTetrahedron(m);
+    }));
+
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   // The audio processing function
@@ -474,15 +516,15 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    float f = getInternalParameterValue("frequency");
+    float f = mFrequencyParam;
     mOsc1.freq(f);
     mOsc3.freq(f * 3);
     mOsc5.freq(f * 5);
 
-    float a = getInternalParameterValue("amplitude");
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    float a = mAmplitudeParam;
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
     while (io())
     {
       float s1 = mAmpEnv() * (mOsc1() * a +
@@ -505,45 +547,39 @@ public:
   void onProcess(Graphics &g) override {
   // Get the paramter values on every video frame, to apply changes to the
   // current instance
-  float frequency = getInternalParameterValue("frequency");
-  float amplitude = getInternalParameterValue("amplitude");
+  float frequency = mFrequencyParam;
+  float amplitude = mAmplitudeParam;
   // Now draw
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), -16);
   g.scale(5 * frequency/10000, 5 * frequency/10000, 1);
-  g.color(10, frequency / 1000,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mBox, g, Color(10, frequency / 1000,  frequency / 1000, 0.4));
   g.popMatrix();
 
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -16);
   g.scale(3 * frequency/10000, 3 * frequency/10000, 0.4);
-  g.color(10, 10,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mBox, g, Color(10, 10,  frequency / 1000, 0.4));
   g.popMatrix();
 
-  addSurfaceLoop(mMesh, 4, 4, 2);
   g.pushMatrix();
   g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -24);
   g.scale(3 * frequency/10000, 3 * frequency/10000, 0.4);
-  g.color(10, 10,  frequency / 1000, 0.4);
-  g.draw(mMesh);
+  voiceVisuals.add(mBoxLoop, g, Color(10, 10,  frequency / 1000, 0.4));
   g.popMatrix();
   
   if (frequency > 800) {
-    addTetrahedron(mMesh); // high notes have jagged edges
+    // high notes have jagged edges
     g.pushMatrix();
     g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -2); // outer edges
     g.scale(frequency/10000, 0.5 * frequency/10000, 0.4);
-    g.color(255, 145, 215, 0.4); // pink
-    g.draw(mMesh);
+    voiceVisuals.add(mBoxLoopTetra, g, Color(255, 145, 215, 0.4)); // pink
     g.popMatrix();
 
     g.pushMatrix();
     g.translate(sin(static_cast<double>(frequency)), tan(static_cast<double>(frequency)), -3); // outer edges
     g.scale(0.5 * frequency/10000, frequency/10000, 0.4);
-    g.color(214, 0, 186, 0.4); // pink
-    g.draw(mMesh);
+    voiceVisuals.add(mBoxLoopTetra, g, Color(214, 0, 186, 0.4)); // pink
     g.popMatrix();
   }
 }
@@ -563,9 +599,6 @@ public:
 
   SynthGUIManager<Spectrogram> synthManager {"Spectrogram"};
 
-    Mesh mSpectrogram;
-    vector<float> spectrum;
-    
     // Time constants
     const float beat = 0.5;
     const float measure = beat * 4.0f;
@@ -591,6 +624,7 @@ public:
                               // will be using keyboard for note triggering
     // Set sampling rate for Gamma objects from app's audio
     gam::sampleRate(audioIO().framesPerSecond());
+    spectrumBus.start();
   }
 
     void onCreate() override {
@@ -604,6 +638,7 @@ public:
 
     void onSound(AudioIOData& io) override {
         synthManager.render(io);  // Render audio
+        spectrumBus.commit(io.framesPerBuffer());
     }
 
     void onAnimate(double dt) override {
@@ -615,6 +650,7 @@ public:
     void onDraw(Graphics& g) override {
         g.clear();
         synthManager.render(g);
+        voiceVisuals.draw(g);
 
         // Draw GUI
         imguiDraw();
@@ -652,7 +688,10 @@ public:
         return true;
     }
 
-    void onExit() override { imguiShutdown(); }
+    void onExit() override {
+        spectrumBus.stop();
+        imguiShutdown();
+    }
 
     // From Esme's code
     float timeElapsed(int bpm, float beatsElapsed){
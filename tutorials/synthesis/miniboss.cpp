@@ -22,9 +22,13 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
-#include <nlohmann/json.hpp>
-#include <fstream>
-using json = nlohmann::json;
+#include "FMBlock.h"
+#include "ParamHandle.h"
+#include "Score.h"
+#include "ScoreStreamer.h"
+#include "SharedMesh.h"
+#include "SpectrumBus.h"
+#include "VoicePool.h"
 
 // using namespace gam;
 using namespace al;
@@ -39,90 +43,112 @@ float freq_of(int midi) {
 // house bass 2
 class electricBass : public SynthVoice {
  public:
+  PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+  // Trigger parameters
+  ParamHandle mFreqParam;
+  ParamHandle mAmplitudeParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mIdx1Param;
+  ParamHandle mIdx2Param;
+  ParamHandle mIdx3Param;
+  ParamHandle mCarMulParam;
+  ParamHandle mModMulParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::ADSR<> mAmpEnv;
   gam::ADSR<> mModEnv;
   gam::EnvFollow<> mEnvFollow;
 
-  gam::Sine<> car, mod;  // carrier, modulator sine oscillators
+  FMBlock mFM;  // carrier, modulator and their per-frame inputs
 
   // Additional members
-  Mesh mMesh;
+  SharedMesh::Ptr mMesh;
 
   void init() override {
     //      mAmpEnv.curve(0); // linear segments
     mAmpEnv.levels(0, 1, 1, 0);
 
     // We have the mesh be a sphere
-    addDisc(mMesh, 1.0, 30);
+    mMesh = SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); });
 
-    createInternalTriggerParameter("freq", 384.868225, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.161, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.2, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.735, 0.1, 1.0);  // Unused
+    mFreqParam = createInternalTriggerParameter("freq", 384.868225, 10, 4000.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.161, 0.0, 1.0);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.2, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.735, 0.1, 1.0);  // Unused
 
     // FM index
-    createInternalTriggerParameter("idx1", 10.0, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 1.816, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 1.684, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 10.0, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 1.816, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 1.684, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 0.5, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 0.25, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 0.5, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 0.25, 0.0, 20.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData& io) override {
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    mod.freq(modFreq);
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
-    while (io()) {
-      car.freq(carBaseFreq + mod() * mModEnv() * modScale);
-      float s1 = car() * mAmpEnv() * amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+    if (pooled.process(*this)) return;
+    float modFreq = mFreqParam * mModMulParam;
+    mFM.mod.freq(modFreq);
+    float carBaseFreq = mFreqParam * mCarMulParam;
+    float modScale = mFreqParam * mModMulParam;
+    float amp = mAmplitudeParam;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0) {
+      unsigned n = frames < FMBlock::kMaxFrames ? frames : FMBlock::kMaxFrames;
+      for (unsigned i = 0; i < n; ++i) {
+        mFM.carFreq[i] = carBaseFreq;
+        mFM.modDepth[i] = mModEnv() * modScale;
+        mFM.amp[i] = mAmpEnv() * amp;
+      }
+      mFM.render(n);
+      for (unsigned i = 0; i < n && io(); ++i) {
+        float s1 = mFM.out[i];
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     if (mAmpEnv.done() && (mEnvFollow.value() < 0.001)) free();
   }
 
   void onProcess(Graphics& g) override {
     g.pushMatrix();
-    g.translate(getInternalParameterValue("freq") / 300 - 2,
+    g.translate(mFreqParam / 300 - 2,
                 getInternalParameterValue("modAmt") / 25 - 1, -4);
-    float scaling = getInternalParameterValue("amplitude") * 1;
+    float scaling = mAmplitudeParam * 1;
     g.scale(scaling, scaling, scaling * 1);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, 1,
+    g.color(HSV(mModMulParam / 20, 1,
                 mEnvFollow.value() * 10));
-    g.draw(mMesh);
+    mMesh->draw(g);
     g.popMatrix();
   }
 
   void onTriggerOn() override {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
+    mModEnv.levels()[0] = mIdx1Param;
+    mModEnv.levels()[1] = mIdx2Param;
+    mModEnv.levels()[2] = mIdx2Param;
+    mModEnv.levels()[3] = mIdx3Param;
 
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mModEnv.lengths()[0] = mAttackTimeParam;
 
     mAmpEnv.lengths()[1] = 0.001;
     mModEnv.lengths()[1] = 0.001;
 
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mModEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mModEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
 
     //        mModEnv.lengths()[1] = mAmpEnv.lengths()[1];
 
@@ -138,90 +164,112 @@ class electricBass : public SynthVoice {
 // duck bass
 class moonBass : public SynthVoice {
  public:
+  PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+  // Trigger parameters
+  ParamHandle mFreqParam;
+  ParamHandle mAmplitudeParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mIdx1Param;
+  ParamHandle mIdx2Param;
+  ParamHandle mIdx3Param;
+  ParamHandle mCarMulParam;
+  ParamHandle mModMulParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::ADSR<> mAmpEnv;
   gam::ADSR<> mModEnv;
   gam::EnvFollow<> mEnvFollow;
 
-  gam::Sine<> car, mod;  // carrier, modulator sine oscillators
+  FMBlock mFM;  // carrier, modulator and their per-frame inputs
 
   // Additional members
-  Mesh mMesh;
+  SharedMesh::Ptr mMesh;
 
   void init() override {
     //      mAmpEnv.curve(0); // linear segments
     mAmpEnv.levels(0, 1, 1, 0);
 
     // We have the mesh be a sphere
-    addSphere(mMesh, 1.0);
+    mMesh = SharedMesh::get("sphere 1", [](Mesh &m) { addSphere(m, 1.0); });
 
-    createInternalTriggerParameter("freq", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.161, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.010, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.465, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.735, 0.1, 1.0);  // Unused
+    mFreqParam = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.161, 0.0, 1.0);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.010, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.465, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.735, 0.1, 1.0);  // Unused
 
     // FM index
-    createInternalTriggerParameter("idx1", 8.605, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 0.711, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 0.816, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 8.605, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 0.711, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 0.816, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 0.25, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 0.25, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0, 0.0, 20.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData& io) override {
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    mod.freq(modFreq);
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
-    while (io()) {
-      car.freq(carBaseFreq + mod() * mModEnv() * modScale);
-      float s1 = car() * mAmpEnv() * amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+    if (pooled.process(*this)) return;
+    float modFreq = mFreqParam * mModMulParam;
+    mFM.mod.freq(modFreq);
+    float carBaseFreq = mFreqParam * mCarMulParam;
+    float modScale = mFreqParam * mModMulParam;
+    float amp = mAmplitudeParam;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0) {
+      unsigned n = frames < FMBlock::kMaxFrames ? frames : FMBlock::kMaxFrames;
+      for (unsigned i = 0; i < n; ++i) {
+        mFM.carFreq[i] = carBaseFreq;
+        mFM.modDepth[i] = mModEnv() * modScale;
+        mFM.amp[i] = mAmpEnv() * amp;
+      }
+      mFM.render(n);
+      for (unsigned i = 0; i < n && io(); ++i) {
+        float s1 = mFM.out[i];
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     if (mAmpEnv.done() && (mEnvFollow.value() < 0.001)) free();
   }
 
   void onProcess(Graphics& g) override {
-    double frequency = getInternalParameterValue("freq");
+    double frequency = mFreqParam;
     g.pushMatrix();
     g.translate(sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -4);
-    float scaling = getInternalParameterValue("amplitude") * 0.7;
+    float scaling = mAmplitudeParam * 0.7;
     g.scale(scaling, scaling, scaling * 1);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, 1,
+    g.color(HSV(mModMulParam / 20, 1,
                 mEnvFollow.value() * 10));
-    g.draw(mMesh);
+    mMesh->draw(g);
     g.popMatrix();
   }
 
   void onTriggerOn() override {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
+    mModEnv.levels()[0] = mIdx1Param;
+    mModEnv.levels()[1] = mIdx2Param;
+    mModEnv.levels()[2] = mIdx2Param;
+    mModEnv.levels()[3] = mIdx3Param;
 
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mModEnv.lengths()[0] = mAttackTimeParam;
 
     mAmpEnv.lengths()[1] = 0.001;
     mModEnv.lengths()[1] = 0.001;
 
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mModEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mModEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
 
     //        mModEnv.lengths()[1] = mAmpEnv.lengths()[1];
 
@@ -236,6 +284,25 @@ class moonBass : public SynthVoice {
 
 class longPluck : public SynthVoice {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mCurveParam;
+    ParamHandle mNoiseParam;
+    ParamHandle mEnvDurParam;
+    ParamHandle mCf1Param;
+    ParamHandle mCf2Param;
+    ParamHandle mCfRiseParam;
+    ParamHandle mBw1Param;
+    ParamHandle mBw2Param;
+    ParamHandle mBwRiseParam;
+    ParamHandle mHmnumParam;
+    ParamHandle mHmampParam;
+    ParamHandle mPanParam;
 
     // Unit generators
     float mNoiseMix;
@@ -248,7 +315,7 @@ public:
     gam::Env<2> mCFEnv;
     gam::Env<2> mBWEnv;
     // Additional members
-    Mesh mMesh;
+    SharedMesh::Ptr mMesh;
 
     // Initialize voice. This function will nly be called once per voice
     void init() override {
@@ -259,34 +326,35 @@ public:
         mBWEnv.curve(0);
         mOsc.harmonics(12);
         // We have the mesh be a sphere
-        addDisc(mMesh, 1.0, 30);
-
-        createInternalTriggerParameter("amplitude", 0.385, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.752, 0.0, 1.0);
-        createInternalTriggerParameter("curve", -7.276, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.056, 0.0, 1.0);
-        createInternalTriggerParameter("envDur", 0.013, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 3119.154, 10.0, 5000);
-        createInternalTriggerParameter("cf2", 662.539, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 1.447, 0.1, 2);
-        createInternalTriggerParameter("bw1", 624.154, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 3503.000, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.465, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 20.0, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 1.00, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mMesh = SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); });
+
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.385, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.752, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", -7.276, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.056, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur", 0.013, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 3119.154, 10.0, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 662.539, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 1.447, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 624.154, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 3503.000, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.465, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 20.0, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 1.00, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     }
 
     //
     
     virtual void onProcess(AudioIOData& io) override {
+        if (pooled.process(*this)) return;
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam;
+        float noiseMix = mNoiseParam;
         while(io()){
             // mix oscillator with noise
             float s1 = mOsc()*(1-noiseMix) + mNoise()*noiseMix;
@@ -309,15 +377,15 @@ public:
     }
 
    virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam;
+          float amplitude = mAmplitudeParam;
           g.pushMatrix();
           g.translate(amplitude,  amplitude, -4);
           //g.scale(frequency/2000, frequency/4000, 1);
           float scaling = 0.1;
           g.scale(scaling * amplitude, scaling * amplitude, scaling * 1);
           g.color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4);
-          g.draw(mMesh);
+          mMesh->draw(g);
           g.popMatrix();
    }
     virtual void onTriggerOn() override {
@@ -335,122 +403,144 @@ public:
     }
 
     void updateFromParameters() {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1]=getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2]=getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1- getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam);
+        mOsc.harmonics(mHmnumParam);
+        mOsc.ampRatio(mHmampParam);
+        mAmpEnv.attack(mAttackTimeParam);
+    //    mAmpEnv.decay(mAttackTimeParam);
+        mAmpEnv.release(mReleaseTimeParam);
+        mAmpEnv.levels()[1]=mSustainParam;
+        mAmpEnv.levels()[2]=mSustainParam;
+
+        mAmpEnv.curve(mCurveParam);
+        mPan.pos(mPanParam);
+        mCFEnv.levels(mCf1Param,
+                      mCf2Param,
+                      mCf1Param);
+
+
+        mCFEnv.lengths()[0] = mCfRiseParam;
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam;
+        mBWEnv.levels(mBw1Param,
+                      mBw2Param,
+                      mBw1Param);
+        mBWEnv.lengths()[0] = mBwRiseParam;
+        mBWEnv.lengths()[1] = 1- mBwRiseParam;
+
+        mCFEnv.totalLength(mEnvDurParam);
+        mBWEnv.totalLength(mEnvDurParam);
     }
 };
 
 // harp like 2
 class piano : public SynthVoice {
  public:
+  PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+  // Trigger parameters
+  ParamHandle mFreqParam;
+  ParamHandle mAmplitudeParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mSustainParam;
+  ParamHandle mIdx1Param;
+  ParamHandle mIdx2Param;
+  ParamHandle mIdx3Param;
+  ParamHandle mCarMulParam;
+  ParamHandle mModMulParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::ADSR<> mAmpEnv;
   gam::ADSR<> mModEnv;
   gam::EnvFollow<> mEnvFollow;
 
-  gam::Sine<> car, mod;  // carrier, modulator sine oscillators
+  FMBlock mFM;  // carrier, modulator and their per-frame inputs
 
   // Additional members
-  Mesh mMesh;
+  SharedMesh::Ptr mMesh;
 
   void init() override {
     //      mAmpEnv.curve(0); // linear segments
     mAmpEnv.levels(0, 1, 1, 0);
 
     // We have the mesh be a sphere
-    addDisc(mMesh, 1.0, 30);
+    mMesh = SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); });
 
-    createInternalTriggerParameter("freq", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.485, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.735, 0.1, 1.0);  // Unused
+    mFreqParam = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.485, 0.0, 1.0);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.735, 0.1, 1.0);  // Unused
 
     // FM index
-    createInternalTriggerParameter("idx1", 7.923, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 0.0, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 0.0, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 7.923, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 0.0, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 0.0, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1.0, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 13.077, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1.0, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 13.077, 0.0, 20.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData& io) override {
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    mod.freq(modFreq);
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
-    while (io()) {
-      car.freq(carBaseFreq + mod() * mModEnv() * modScale);
-      float s1 = car() * mAmpEnv() * amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+    if (pooled.process(*this)) return;
+    float modFreq = mFreqParam * mModMulParam;
+    mFM.mod.freq(modFreq);
+    float carBaseFreq = mFreqParam * mCarMulParam;
+    float modScale = mFreqParam * mModMulParam;
+    float amp = mAmplitudeParam;
+    // io.frame() is one before the first frame this voice writes
+    unsigned frames = io.framesPerBuffer() - (io.frame() + 1);
+    while (frames > 0) {
+      unsigned n = frames < FMBlock::kMaxFrames ? frames : FMBlock::kMaxFrames;
+      for (unsigned i = 0; i < n; ++i) {
+        mFM.carFreq[i] = carBaseFreq;
+        mFM.modDepth[i] = mModEnv() * modScale;
+        mFM.amp[i] = mAmpEnv() * amp;
+      }
+      mFM.render(n);
+      for (unsigned i = 0; i < n && io(); ++i) {
+        float s1 = mFM.out[i];
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
+      frames -= n;
     }
     if (mAmpEnv.done() && (mEnvFollow.value() < 0.001)) free();
   }
 
   void onProcess(Graphics& g) override {
     g.pushMatrix();
-    g.translate(getInternalParameterValue("freq") / 300 - 2,
+    g.translate(mFreqParam / 300 - 2,
                 getInternalParameterValue("modAmt") / 25 - 1, -4);
-    float scaling = getInternalParameterValue("amplitude") * 1;
+    float scaling = mAmplitudeParam * 1;
     g.scale(scaling, scaling, scaling * 1);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, 1,
+    g.color(HSV(mModMulParam / 20, 1,
                 mEnvFollow.value() * 10));
-    g.draw(mMesh);
+    mMesh->draw(g);
     g.popMatrix();
   }
 
   void onTriggerOn() override {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
+    mModEnv.levels()[0] = mIdx1Param;
+    mModEnv.levels()[1] = mIdx2Param;
+    mModEnv.levels()[2] = mIdx2Param;
+    mModEnv.levels()[3] = mIdx3Param;
 
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mModEnv.lengths()[0] = mAttackTimeParam;
 
     mAmpEnv.lengths()[1] = 0.001;
     mModEnv.lengths()[1] = 0.001;
 
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mModEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mModEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
 
     //        mModEnv.lengths()[1] = mAmpEnv.lengths()[1];
 
@@ -466,6 +556,25 @@ class piano : public SynthVoice {
 // SubSyn
 class funkyBass : public SynthVoice {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mCurveParam;
+    ParamHandle mNoiseParam;
+    ParamHandle mEnvDurParam;
+    ParamHandle mCf1Param;
+    ParamHandle mCf2Param;
+    ParamHandle mCfRiseParam;
+    ParamHandle mBw1Param;
+    ParamHandle mBw2Param;
+    ParamHandle mBwRiseParam;
+    ParamHandle mHmnumParam;
+    ParamHandle mHmampParam;
+    ParamHandle mPanParam;
 
     // Unit generators
     float mNoiseMix;
@@ -478,7 +587,7 @@ public:
     gam::Env<2> mCFEnv;
     gam::Env<2> mBWEnv;
     // Additional members
-    Mesh mMesh;
+    SharedMesh::Ptr mMesh;
 
     // Initialize voice. This function will nly be called once per voice
     void init() override {
@@ -489,34 +598,35 @@ public:
         mBWEnv.curve(0);
         mOsc.harmonics(12);
         // We have the mesh be a sphere
-        addPrism(mMesh);
-
-        createInternalTriggerParameter("amplitude", 0.385, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.695, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 2.721, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.012, 0.0, 1.0);
-        createInternalTriggerParameter("envDur", 0.569, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 10.0, 10.0, 5000);
-        createInternalTriggerParameter("cf2", 4828.875, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 0.556, 0.1, 2);
-        createInternalTriggerParameter("bw1", 10.0, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 13124.472, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.520, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 16.564, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 0.706, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mMesh = SharedMesh::get("prism", [](Mesh &m) { addPrism(m); });
+
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.385, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.695, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 2.721, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.012, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur", 0.569, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 10.0, 10.0, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 4828.875, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 0.556, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 10.0, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 13124.472, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.520, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 16.564, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 0.706, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     }
 
     //
     
     virtual void onProcess(AudioIOData& io) override {
+        if (pooled.process(*this)) return;
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam;
+        float noiseMix = mNoiseParam;
         while(io()){
             // mix oscillator with noise
             float s1 = mOsc()*(1-noiseMix) + mNoise()*noiseMix;
@@ -539,15 +649,15 @@ public:
     }
 
    virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam;
+          float amplitude = mAmplitudeParam;
           g.pushMatrix();
           g.translate(sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -6);
           //g.scale(frequency/2000, frequency/4000, 1);
           float scaling = 0.1;
           g.scale(scaling * frequency/200, scaling * frequency/400, scaling* 1);
           g.color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4);
-          g.draw(mMesh);
+          mMesh->draw(g);
           g.popMatrix();
    }
     virtual void onTriggerOn() override {
@@ -565,38 +675,57 @@ public:
     }
 
     void updateFromParameters() {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1]=getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2]=getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1- getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam);
+        mOsc.harmonics(mHmnumParam);
+        mOsc.ampRatio(mHmampParam);
+        mAmpEnv.attack(mAttackTimeParam);
+    //    mAmpEnv.decay(mAttackTimeParam);
+        mAmpEnv.release(mReleaseTimeParam);
+        mAmpEnv.levels()[1]=mSustainParam;
+        mAmpEnv.levels()[2]=mSustainParam;
+
+        mAmpEnv.curve(mCurveParam);
+        mPan.pos(mPanParam);
+        mCFEnv.levels(mCf1Param,
+                      mCf2Param,
+                      mCf1Param);
+
+
+        mCFEnv.lengths()[0] = mCfRiseParam;
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam;
+        mBWEnv.levels(mBw1Param,
+                      mBw2Param,
+                      mBw1Param);
+        mBWEnv.lengths()[0] = mBwRiseParam;
+        mBWEnv.lengths()[1] = 1- mBwRiseParam;
+
+        mCFEnv.totalLength(mEnvDurParam);
+        mBWEnv.totalLength(mEnvDurParam);
     }
 };
 
 // chiptune lead (SubSyn)
 class chiptuneLead : public SynthVoice {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mCurveParam;
+    ParamHandle mNoiseParam;
+    ParamHandle mEnvDurParam;
+    ParamHandle mCf1Param;
+    ParamHandle mCf2Param;
+    ParamHandle mCfRiseParam;
+    ParamHandle mBw1Param;
+    ParamHandle mBw2Param;
+    ParamHandle mBwRiseParam;
+    ParamHandle mHmnumParam;
+    ParamHandle mHmampParam;
+    ParamHandle mPanParam;
 
     // Unit generators
     float mNoiseMix;
@@ -609,7 +738,7 @@ public:
     gam::Env<2> mCFEnv;
     gam::Env<2> mBWEnv;
     // Additional members
-    Mesh mMesh;
+    SharedMesh::Ptr mMesh;
 
     // Initialize voice. This function will nly be called once per voice
     void init() override {
@@ -620,34 +749,35 @@ public:
         mBWEnv.curve(0);
         mOsc.harmonics(12);
         // We have the mesh be a sphere
-        addDisc(mMesh, 1.0, 30);
-
-        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 0.2, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.752, 0.0, 1.0);
-        createInternalTriggerParameter("curve", -7.276, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.056, 0.0, 1.0);
-        createInternalTriggerParameter("envDur", 0.105, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 10, 10.0, 5000);
-        createInternalTriggerParameter("cf2", 1362.003, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 0.421, 0.1, 2);
-        createInternalTriggerParameter("bw1", 2648.691, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 10, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.59, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 20.0, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mMesh = SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); });
+
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.2, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.752, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", -7.276, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.056, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur", 0.105, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 10, 10.0, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 1362.003, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 0.421, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 2648.691, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 10, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.59, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 20.0, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     }
 
     //
     
     virtual void onProcess(AudioIOData& io) override {
+        if (pooled.process(*this)) return;
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam;
+        float noiseMix = mNoiseParam;
         while(io()){
             // mix oscillator with noise
             float s1 = mOsc()*(1-noiseMix) + mNoise()*noiseMix;
@@ -670,15 +800,15 @@ public:
     }
 
    virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam;
+          float amplitude = mAmplitudeParam;
           g.pushMatrix();
           g.translate(sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -8);
           //g.scale(frequency/2000, frequency/4000, 1);
           float scaling = 0.1;
           g.scale(scaling * frequency/200, scaling * frequency/400, scaling* 1);
           g.color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4);
-          g.draw(mMesh);
+          mMesh->draw(g);
           g.popMatrix();
    }
     virtual void onTriggerOn() override {
@@ -696,38 +826,57 @@ public:
     }
 
     void updateFromParameters() {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1]=getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2]=getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1- getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam);
+        mOsc.harmonics(mHmnumParam);
+        mOsc.ampRatio(mHmampParam);
+        mAmpEnv.attack(mAttackTimeParam);
+    //    mAmpEnv.decay(mAttackTimeParam);
+        mAmpEnv.release(mReleaseTimeParam);
+        mAmpEnv.levels()[1]=mSustainParam;
+        mAmpEnv.levels()[2]=mSustainParam;
+
+        mAmpEnv.curve(mCurveParam);
+        mPan.pos(mPanParam);
+        mCFEnv.levels(mCf1Param,
+                      mCf2Param,
+                      mCf1Param);
+
+
+        mCFEnv.lengths()[0] = mCfRiseParam;
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam;
+        mBWEnv.levels(mBw1Param,
+                      mBw2Param,
+                      mBw1Param);
+        mBWEnv.lengths()[0] = mBwRiseParam;
+        mBWEnv.lengths()[1] = 1- mBwRiseParam;
+
+        mCFEnv.totalLength(mEnvDurParam);
+        mBWEnv.totalLength(mEnvDurParam);
     }
 };
 
 // videogame chords SubSyn
 class videoGame : public SynthVoice {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
+    ParamHandle mAttackTimeParam;
+    ParamHandle mReleaseTimeParam;
+    ParamHandle mSustainParam;
+    ParamHandle mCurveParam;
+    ParamHandle mNoiseParam;
+    ParamHandle mEnvDurParam;
+    ParamHandle mCf1Param;
+    ParamHandle mCf2Param;
+    ParamHandle mCfRiseParam;
+    ParamHandle mBw1Param;
+    ParamHandle mBw2Param;
+    ParamHandle mBwRiseParam;
+    ParamHandle mHmnumParam;
+    ParamHandle mHmampParam;
+    ParamHandle mPanParam;
 
     // Unit generators
     float mNoiseMix;
@@ -740,7 +889,7 @@ public:
     gam::Env<2> mCFEnv;
     gam::Env<2> mBWEnv;
     // Additional members
-    Mesh mMesh;
+    SharedMesh::Ptr mMesh;
 
     // Initialize voice. This function will nly be called once per voice
     void init() override {
@@ -751,34 +900,35 @@ public:
         mBWEnv.curve(0);
         mOsc.harmonics(12);
         // We have the mesh be a sphere
-        addOctahedron(mMesh);
-
-        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.569, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.366, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.026, 0.0, 1.0);
-        createInternalTriggerParameter("envDur", 0.317, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 10, 587.201, 5000);
-        createInternalTriggerParameter("cf2", 2104.683, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 0.345, 0.1, 2);
-        createInternalTriggerParameter("bw1", 633.750, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 875.802, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.1, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 11.8, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 0.996, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mMesh = SharedMesh::get("octahedron", [](Mesh &m) { addOctahedron(m); });
+
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.01, 0.01, 3.0);
+        mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+        mSustainParam = createInternalTriggerParameter("sustain", 0.569, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.366, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.026, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur", 0.317, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 10, 587.201, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 2104.683, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 0.345, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 633.750, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 875.802, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.1, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 11.8, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 0.996, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     }
 
     //
     
     virtual void onProcess(AudioIOData& io) override {
+        if (pooled.process(*this)) return;
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam;
+        float noiseMix = mNoiseParam;
         while(io()){
             // mix oscillator with noise
             float s1 = mOsc()*(1-noiseMix) + mNoise()*noiseMix;
@@ -801,15 +951,15 @@ public:
     }
 
    virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam;
+          float amplitude = mAmplitudeParam;
           g.pushMatrix();
           g.translate(sin(static_cast<double>(amplitude)), cos(static_cast<double>(amplitude)), -16);
           //g.scale(frequency/2000, frequency/4000, 1);
           float scaling = 0.1;
           g.scale(scaling * frequency/200, scaling * frequency/400, scaling* 1);
           g.color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4);
-          g.draw(mMesh);
+          mMesh->draw(g);
           g.popMatrix();
    }
     virtual void onTriggerOn() override {
@@ -827,38 +977,45 @@ public:
     }
 
     void updateFromParameters() {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1]=getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2]=getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1- getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam);
+        mOsc.harmonics(mHmnumParam);
+        mOsc.ampRatio(mHmampParam);
+        mAmpEnv.attack(mAttackTimeParam);
+    //    mAmpEnv.decay(mAttackTimeParam);
+        mAmpEnv.release(mReleaseTimeParam);
+        mAmpEnv.levels()[1]=mSustainParam;
+        mAmpEnv.levels()[2]=mSustainParam;
+
+        mAmpEnv.curve(mCurveParam);
+        mPan.pos(mPanParam);
+        mCFEnv.levels(mCf1Param,
+                      mCf2Param,
+                      mCf1Param);
+
+
+        mCFEnv.lengths()[0] = mCfRiseParam;
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam;
+        mBWEnv.levels(mBw1Param,
+                      mBw2Param,
+                      mBw1Param);
+        mBWEnv.lengths()[0] = mBwRiseParam;
+        mBWEnv.lengths()[1] = 1- mBwRiseParam;
+
+        mCFEnv.totalLength(mEnvDurParam);
+        mBWEnv.totalLength(mEnvDurParam);
     }
 };
 
 class Marimba : public SynthVoice
 {
 public:
+  PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+  // Trigger parameters
+  ParamHandle mAmplitudeParam;
+  ParamHandle mFrequencyParam;
+  ParamHandle mAttackTimeParam;
+  ParamHandle mReleaseTimeParam;
+  ParamHandle mPanParam;
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mOsc1;
@@ -871,7 +1028,7 @@ public:
   gam::EnvFollow<> mEnvFollow;
 
   // Additional members
-  Mesh mMesh;
+  SharedMesh::Ptr mMesh;
 
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -883,33 +1040,34 @@ public:
     mAmpEnv.sustainPoint(2); // Make point 2 sustain until a release is issued
 
     // We have the mesh be a rectangle
-    addWireBox(mMesh);
+    mMesh = SharedMesh::get("wire box", [](Mesh &m) { addWireBox(m); });
 
-    createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.8, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 440, 20, 5000);
+    mAttackTimeParam = createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam = createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   // The audio processing function
   void onProcess(AudioIOData &io) override
   {
+    if (pooled.process(*this)) return;
     // Get the values from the parameters and apply them to the corresponding
     // unit generators. You could place these lines in the onTrigger() function,
     // but placing them here allows for realtime prototyping on a running
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    float f = getInternalParameterValue("frequency");
+    float f = mFrequencyParam;
     mOsc1.freq(f);
     mOsc3.freq(f * 3);
     mOsc5.freq(f * 5);
 
-    float a = getInternalParameterValue("amplitude");
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    float a = mAmplitudeParam;
+    mAmpEnv.lengths()[0] = mAttackTimeParam;
+    mAmpEnv.lengths()[2] = mReleaseTimeParam;
+    mPan.pos(mPanParam);
     while (io())
     {
       float s1 = mAmpEnv() * (mOsc1() * a +
@@ -930,28 +1088,28 @@ public:
 
   // The graphics processing function
   void onProcess(Graphics &g) override {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam;
+    float amplitude = mAmplitudeParam;
 
     g.pushMatrix();
     g.translate(-1 * sin(static_cast<double>(frequency)), -1 * cos(static_cast<double>(frequency)), -16);
     g.scale(5 * frequency/1000, 5 * frequency/1000, 1);
     g.color(HSV(frequency / 1000, 0.5 + mAmpEnv() * 0.1, 0.3 + 0.5 * mAmpEnv()));
-    g.draw(mMesh);
+    mMesh->draw(g);
     g.popMatrix();
 
     g.pushMatrix();
     g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -16);
     g.scale(3 * frequency/1000, 3 * frequency/1000, 0.4);
     g.color(HSV(frequency / 1000, 0.5 + mAmpEnv() * 0.1, 0.3 + 0.5 * mAmpEnv()));
-    g.draw(mMesh);
+    mMesh->draw(g);
     g.popMatrix();
 
     g.pushMatrix();
     g.translate(-1 * sin(static_cast<double>(frequency)), cos(static_cast<double>(frequency)), -24);
     g.scale(3 * frequency/1000, 3 * frequency/1000, 0.4);
     g.color(HSV(frequency / 1000, 0.5 + mAmpEnv() * 0.1, 0.3 + 0.5 * mAmpEnv()));
-    g.draw(mMesh);
+    mMesh->draw(g);
     g.popMatrix();
   }
 
@@ -965,6 +1123,10 @@ public:
 class Kick : public SynthVoice
 {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
+    // Trigger parameters
+    ParamHandle mAmplitudeParam;
+    ParamHandle mFrequencyParam;
     // Unit generators
     gam::Pan<> mPan;
     gam::Sine<> mOsc;
@@ -984,21 +1146,23 @@ public:
         // Initialize pitch decay
         mDecay.decay(0.3);
 
-        createInternalTriggerParameter("amplitude", 0.2, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 150, 20, 5000);
+        mAmplitudeParam = createInternalTriggerParameter("amplitude", 0.2, 0.0, 1.0);
+        mFrequencyParam = createInternalTriggerParameter("frequency", 150, 20, 5000);
     }
 
     // The audio processing function
     void onProcess(AudioIOData &io) override
     {
-        mOsc.freq(getInternalParameterValue("frequency"));
+        if (pooled.process(*this)) return;
+        mOsc.freq(mFrequencyParam);
         mPan.pos(0);
         // (removed parameter control for attack and release)
 
+        float amp = mAmplitudeParam;
         while (io())
         {
             mOsc.freqMul(mDecay()); // Multiply pitch oscillator by next decay value
-            float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+            float s1 = mOsc() * mAmpEnv() * amp;
             float s2;
             mPan(s1, s1, s2);
             io.out(0) += s1;
@@ -1027,6 +1191,7 @@ public:
 class Snare : public SynthVoice
 {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
     // Unit generators
     gam::Pan<> mPan;
     gam::AD<> mAmpEnv;   // Amplitude envelope
@@ -1058,6 +1223,7 @@ public:
     // The audio processing function
     void onProcess(AudioIOData &io) override
     {
+        if (pooled.process(*this)) return;
         mOsc.freq(200);
         mOsc2.freq(150);
 
@@ -1099,6 +1265,7 @@ public:
 class Hihat : public SynthVoice
 {
 public:
+    PooledVoice pooled; // lets its VoicePool cut it from the audio thread
     // Unit generators
     gam::Pan<> mPan;
     gam::AD<> mAmpEnv; // Changed amp envelope from Env<3> to AD<>
@@ -1114,6 +1281,7 @@ public:
     // The audio processing function
     void onProcess(AudioIOData &io) override
     {
+        if (pooled.process(*this)) return;
         while (io())
         {
             float s1 = mBurst();
@@ -1136,12 +1304,31 @@ public:
     SynthGUIManager<moonBass> synthManager{"plunk"};
     //    ParameterMIDI parameterMIDI;
     RtMidiIn midiIn; // MIDI input carrier
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // The analyzer pushes the mix's spectra to the GPU; see ScrollingHistory.h
+    SpectrumBus mixSpectrum{FFT_SIZE, FFT_SIZE / 4};
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
+    AudioClock audioClock; // audio time, for the score and the voice pools
+    ScoreStreamer scoreStreamer{audioClock};
+    // Voices are allocated up front with a hard cap per instrument on the
+    // notes sounding at once. Voices with an envelope follower lose their
+    // quietest note when full, the rest their oldest. The second number is
+    // how many notes wait for their start: the most of that instrument's
+    // that start within any 2 s of miniboss.json (the streamer's look-ahead),
+    // with some margin. electricBass and piano aren't in the score.
+    VoicePool<moonBass> moonBasses{synthManager.synth(), audioClock, 8, 8, StealPolicy::Quietest};
+    VoicePool<electricBass> electricBasses{synthManager.synth(), audioClock, 8, 4, StealPolicy::Quietest};
+    VoicePool<piano> pianos{synthManager.synth(), audioClock, 16, 4, StealPolicy::Quietest};
+    VoicePool<chiptuneLead> chiptunes{synthManager.synth(), audioClock, 8, 28};
+    VoicePool<funkyBass> funkyBasses{synthManager.synth(), audioClock, 8, 48};
+    VoicePool<longPluck> longPlucks{synthManager.synth(), audioClock, 16, 24};
+    VoicePool<videoGame> videoGames{synthManager.synth(), audioClock, 12, 20};
+    VoicePool<Marimba> marimbas{synthManager.synth(), audioClock, 16, 24};
+    VoicePool<Kick> kicks{synthManager.synth(), audioClock, 4, 10};
+    VoicePool<Snare> snares{synthManager.synth(), audioClock, 4, 16};
+    VoicePool<Hihat> hihats{synthManager.synth(), audioClock, 8, 24};
     bool showGUI = true;
     bool showSpectro = true;
     bool navi = false;
-    gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
 
     virtual void onInit() override
     {
@@ -1166,13 +1353,48 @@ public:
         {
             printf("Error: No MIDI devices found.\n");
         }
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
+        // Spectrum colored as hue + value * hue gain
+        spectrogram.color(0.5, -100);
+        mixSpectrum.feed(spectrogram);
+        // Run the analyzer now that the sample rate is set
+        mixSpectrum.start();
+
+        moonBasses.level([](moonBass &voice) { return voice.mEnvFollow.value(); });
+        electricBasses.level([](electricBass &voice) { return voice.mEnvFollow.value(); });
+        pianos.level([](piano &voice) { return voice.mEnvFollow.value(); });
+        moonBasses.reserve();
+        electricBasses.reserve();
+        pianos.reserve();
+        chiptunes.reserve();
+        funkyBasses.reserve();
+        longPlucks.reserve();
+        videoGames.reserve();
+        marimbas.reserve();
+        kicks.reserve();
+        snares.reserve();
+        hihats.reserve();
+    }
+
+    // Frees finished voices and cuts notes past each instrument's cap
+    void updateVoices()
+    {
+        moonBasses.update();
+        electricBasses.update();
+        pianos.update();
+        chiptunes.update();
+        funkyBasses.update();
+        longPlucks.update();
+        videoGames.update();
+        marimbas.update();
+        kicks.update();
+        snares.update();
+        hihats.update();
     }
 
     void playMoonBass(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<moonBass>();
+        auto *voice = moonBasses.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("freq", freq);
         voice->setInternalParameterValue("amplitude", amp/2);
@@ -1183,7 +1405,8 @@ public:
 
     void playElectricBass(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<electricBass>();
+        auto *voice = electricBasses.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("freq", freq);
         voice->setInternalParameterValue("amplitude", amp/2);
@@ -1194,7 +1417,8 @@ public:
 
     void playPiano(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<piano>();
+        auto *voice = pianos.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("freq", freq);
         voice->setInternalParameterValue("amplitude", amp/3);
@@ -1205,7 +1429,8 @@ public:
 
     void playChiptune(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<chiptuneLead>();
+        auto *voice = chiptunes.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("frequency", freq);
         voice->setInternalParameterValue("amplitude", amp/2);
@@ -1216,7 +1441,8 @@ public:
 
     void playFunkyBass(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<funkyBass>();
+        auto *voice = funkyBasses.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("frequency", freq/2);
         voice->setInternalParameterValue("amplitude", amp/2);
@@ -1227,7 +1453,8 @@ public:
 
     void playLongPluck(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<longPluck>();
+        auto *voice = longPlucks.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("frequency", freq);
         voice->setInternalParameterValue("amplitude", amp/2);
@@ -1238,7 +1465,8 @@ public:
 
     void playVideoGame(float freq, float time, float duration, float amp = 0.4)
     {
-        auto *voice = synthManager.synth().getVoice<videoGame>();
+        auto *voice = videoGames.acquire(time);
+        if (!voice) return;
 
         voice->setInternalParameterValue("frequency", freq);
         voice->setInternalParameterValue("amplitude", amp/3);
@@ -1249,7 +1477,8 @@ public:
 
     void playMarimba(float freq, float time, float duration, float amp = .1, float attack = 0.1, float decay = 0.2)
     {
-        auto *voice = synthManager.synth().getVoice<Marimba>();
+        auto *voice = marimbas.acquire(time);
+        if (!voice) return;
         // amp, freq, attack, release, pan
         vector<VariantValue> params = vector<VariantValue>({amp, freq, attack, decay, 0.0});
         voice->setTriggerParams(params);
@@ -1258,110 +1487,47 @@ public:
 
     void playKick(float time, float duration = 0.3)
     {
-        auto *voice = synthManager.synth().getVoice<Kick>();
+        auto *voice = kicks.acquire(time);
+        if (!voice) return;
         // amp, freq, attack, release, pan
         synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
     }
     void playSnare(float time, float duration = 0.3)
     {
-        auto *voice = synthManager.synth().getVoice<Snare>();
+        auto *voice = snares.acquire(time);
+        if (!voice) return;
         // amp, freq, attack, release, pan
         synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
     }
     void playHihat(float time, float duration = 0.3)
     {
-        auto *voice = synthManager.synth().getVoice<Hihat>();
+        auto *voice = hihats.acquire(time);
+        if (!voice) return;
         // amp, freq, attack, release, pan
         synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
     }
 
     void playMiniboss() {
-        // read json file
-        std::ifstream f("/Users/gracefeng/allolib/demo1-gracefeng05/tutorials/synthesis/miniboss.json");
-        // cout << "FILE" << endl;
-        // cout << f.rdbuf();
-        json music = json::parse(f);
-
-        json piano1 = music["tracks"][1]["notes"];
-        json piano2 = music["tracks"][2]["notes"];
-        json piano3 = music["tracks"][3]["notes"];
-        json pluck = music["tracks"][4]["notes"];
-        json deepBass = music["tracks"][5]["notes"];
-        json electricBass = music["tracks"][6]["notes"];
-        json kick = music["tracks"][7]["notes"];
-        json snare = music["tracks"][8]["notes"];
-        json hihat = music["tracks"][9]["notes"];
-
-        auto p1 = piano1.begin();
-        auto p2 = piano2.begin();
-        auto p3 = piano3.begin();
-        auto pl = pluck.begin();
-        auto db = deepBass.begin();
-        auto eb = electricBass.begin();
-        auto k = kick.begin();
-        auto s = snare.begin();
-        auto hh = hihat.begin();
-
-
-    while(p1 != piano1.end() || p2 != piano2.end() || p3 != piano3.end() || pl != pluck.end() || 
-    db != deepBass.end() || eb != electricBass.end() || k != kick.end() || s != snare.end() || hh != hihat.end())
-    {
-        if(p1 != piano1.end())
-        {
-            auto note = *p1;
-            playMarimba(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++p1;
-        }
-        if(p2 != piano2.end())
-        {
-            auto note = *p2;
-            playVideoGame(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++p2;
-        }
-        if(p3 != piano3.end())
-        {
-            auto note = *p3;
-            playChiptune(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++p3;
-        }
-        if(pl != pluck.end())
-        {
-            auto note = *pl;
-            playLongPluck(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++pl;
-        }
-        if(db != deepBass.end())
-        {
-            auto note = *db;
-            playMoonBass(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++db;
-        }
-        if(eb != electricBass.end())
-        {
-            auto note = *eb;
-            playFunkyBass(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++eb;
-        }
-        if(k != kick.end())
-        {
-            auto note = *k;
-            playKick(note["time"], note["duration"]);
-            ++k;
-        }
-        if(s != snare.end())
-        {
-            auto note = *s;
-            playSnare(note["time"], note["duration"]);
-            ++s;
-        }
-        if(hh != hihat.end())
-        {
-            auto note = *hh;
-            playHihat(note["time"], note["duration"]);
-            ++hh;
-        }
-    }
-
+        // Notes are handed to the sequencer a couple of seconds ahead of
+        // time from onAnimate() instead of all at once
+        scoreStreamer.onNote([this](const Score &score, uint32_t i, float time) {
+            float freq = freq_of(score.midi(i));
+            float duration = score.duration(i);
+            float velocity = score.velocity(i);
+            switch (score.track(i))
+            {
+            case 1: playMarimba(freq, time, duration, velocity); break;   // piano 1
+            case 2: playVideoGame(freq, time, duration, velocity); break; // piano 2
+            case 3: playChiptune(freq, time, duration, velocity); break;  // piano 3
+            case 4: playLongPluck(freq, time, duration, velocity); break; // pluck
+            case 5: playMoonBass(freq, time, duration, velocity); break;  // deep bass
+            case 6: playFunkyBass(freq, time, duration, velocity); break; // electric bass
+            case 7: playKick(time, duration); break;
+            case 8: playSnare(time, duration); break;
+            case 9: playHihat(time, duration); break;
+            }
+        });
+        scoreStreamer.start("/Users/gracefeng/allolib/demo1-gracefeng05/tutorials/synthesis/miniboss.json");
     }
 
     void onCreate() override
@@ -1374,23 +1540,18 @@ public:
     void onSound(AudioIOData &io) override
     {
         synthManager.render(io); // Render audio
-        // STFT
-        while (io())
-        {
-            if (stft(io.out(0)))
-            { // Loop through all the frequency bins
-                for (unsigned k = 0; k < stft.numBins(); ++k)
-                {
-                    // Here we simply scale the complex sample
-                    spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
-                    // spectrum[k] = stft.bin(k).real();
-                }
-            }
-        }        
+        audioClock.tick(io);
+        // STFT of the mix runs on the analyzer thread
+        mixSpectrum.add(io.outBuffer(0), io.framesPerBuffer());
+        mixSpectrum.commit(io.framesPerBuffer());
     }
 
     void onAnimate(double dt) override
     {
+        scoreStreamer.update();
+        updateVoices();
+        // Upload the spectra pushed since the last frame
+        spectrogram.update();
         navControl().active(navi); // Disable navigation via keyboard, since we
         imguiBeginFrame();
         synthManager.drawSynthControlPanel();
@@ -1402,20 +1563,18 @@ public:
         g.clear();
         synthManager.render(g);
         // // Draw Spectrum
-        mSpectrogram.reset();
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
         if (showSpectro)
         {
-            for (int i = 0; i < FFT_SIZE / 2; i++)
-            {
-                mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-                mSpectrogram.vertex(i, spectrum[i], 0.0);
-            }
-            g.meshColor(); // Use the color in the mesh
+            // Spectrogram below the spectrum, newest on the right
+            g.pushMatrix();
+            g.translate(-3, -4.5, 0);
+            g.scale(10.0, 1.25, 1.0);
+            spectrogram.drawImage(g, 1000);
+            g.popMatrix();
             g.pushMatrix();
             g.translate(-3, -3, 0);
-            g.scale(20.0 / FFT_SIZE, 100, 1.0);
-            g.draw(mSpectrogram);
+            g.scale(10.0, 100, 1.0);
+            spectrogram.drawTrace(g, spectrogram.rows());
             g.popMatrix();
         }
         // Draw GUI
@@ -1505,7 +1664,11 @@ public:
         return true;
     }
 
-    void onExit() override { imguiShutdown(); }
+    void onExit() override
+    {
+        mixSpectrum.stop();
+        imguiShutdown();
+    }
 };
 
 int main()
@@ -26,11 +26,10 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
-// #include <json/json.h>
-// #include "json.hpp"
-#include <nlohmann/json.hpp>
-#include <fstream>
-using json = nlohmann::json;
+#include "ParallelSynth.h"
+#include "Score.h"
+#include "ScoreStreamer.h"
+#include "ScrollingHistory.h"
 
 // using namespace gam;
 using namespace al;
@@ -420,12 +419,22 @@ public:
     SynthGUIManager<Marimba> synthManager{"bloop"};
     //    ParameterMIDI parameterMIDI;
     RtMidiIn midiIn; // MIDI input carrier
-    Mesh mSpectrogram;
-    vector<float> spectrum;
+    // Spectra go to the GPU as they come in; see ScrollingHistory.h
+    ScrollingHistory spectrogram{FFT_SIZE / 2 + 1, ScrollingHistory::kSpectrogramColumns};
     bool showGUI = true;
     bool showSpectro = true;
     bool navi = false;
     gam::STFT stft = gam::STFT(FFT_SIZE, FFT_SIZE / 4, 0, gam::HANN, gam::MAG_FREQ);
+    AudioClock audioClock; // audio time, for scheduling the score
+    ScoreStreamer scoreStreamer{audioClock};
+    // Score voices go to worker threads when parallelVoices is on (backslash toggles)
+    ParallelSynth parallelSynth{4};
+    bool parallelVoices = false;
+
+    SynthSequencer &sequencer()
+    {
+        return parallelVoices ? parallelSynth.next() : synthManager.synthSequencer();
+    }
 
     virtual void onInit() override
     {
@@ -450,30 +459,33 @@ public:
         {
             printf("Error: No MIDI devices found.\n");
         }
-        // Declare the size of the spectrum
-        spectrum.resize(FFT_SIZE / 2 + 1);
+        // Colors, as hue + value * hue gain
+        spectrogram.color(0.5, -100);
     }
 
     void playMarimba(float freq, float time, float duration, float amp = .1, float attack = 0.1, float decay = 0.2)
     {
-        auto *voice = synthManager.synth().getVoice<Marimba>();
+        SynthSequencer &seq = sequencer();
+        auto *voice = seq.synth().getVoice<Marimba>();
         // amp, freq, attack, release, pan
         vector<VariantValue> params = vector<VariantValue>({amp, freq, attack, decay, 0.0});
         voice->setTriggerParams(params);
-        synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+        seq.addVoiceFromNow(voice, time, duration);
     }
 
     void playMarimba2(float freq, float time, float duration, float amp = .1, float attack = 0.1, float decay = 0.2)
     {
-        auto *voice = synthManager.synth().getVoice<Marimba2>();
+        SynthSequencer &seq = sequencer();
+        auto *voice = seq.synth().getVoice<Marimba2>();
         // amp, freq, attack, release, pan
         vector<VariantValue> params = vector<VariantValue>({amp, freq, attack, decay, 0.0});
         voice->setTriggerParams(params);
-        synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+        seq.addVoiceFromNow(voice, time, duration);
     }
 
     void playViolin(float freq, float time, float duration = 0.5, float amp = 0.2, float attack = 0.1, float decay = 0.1){
-    auto* voice = synthManager.synth().getVoice<Violin>();
+    SynthSequencer &seq = sequencer();
+    auto *voice = seq.synth().getVoice<Violin>();
 
     voice->setInternalParameterValue("frequency", freq);
     voice->setInternalParameterValue("amplitude", amp);
@@ -481,55 +493,22 @@ public:
     voice->setInternalParameterValue("releaseTime", decay);
     voice->setInternalParameterValue("pan", 0.0f);
 
-    synthManager.synthSequencer().addVoiceFromNow(voice, time, duration);
+    seq.addVoiceFromNow(voice, time, duration);
   }
 
     void playQuintet() {
-        // read json file
-        std::ifstream f("/Users/gracefeng/allolib/demo1-gracefeng05/tutorials/synthesis/organon.json");
-        // cout << "FILE" << endl;
-        // cout << f.rdbuf();
-        json music = json::parse(f);
-
-        json marimba1 = music["tracks"][0]["notes"];
-        json marimba2 = music["tracks"][1]["notes"];
-        json marimba3 = music["tracks"][2]["notes"];
-        json cello = music["tracks"][3]["notes"];
-
-        auto m1 = marimba1.begin();
-        auto m2 = marimba2.begin();
-        auto m3 = marimba3.begin();
-        auto c = cello.begin();
-
-
-    while(m1 != marimba1.end() || m2 != marimba2.end() || m3 != marimba3.end() || c != cello.end())
-    {
-        if(m1 != marimba1.end())
-        {
-            auto note = *m1;
-            playMarimba(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++m1;
-        }
-        if(m2 != marimba2.end())
-        {
-            auto note = *m2;
-            playMarimba2(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++m2;
-        }
-        if(m3 != marimba3.end())
-        {
-            auto note = *m3;
-            playMarimba(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++m3;
-        }
-        if(c != cello.end())
-        {
-            auto note = *c;
-            playViolin(freq_of(note["midi"]), note["time"], note["duration"], note["velocity"]);
-            ++c;
-        }
-    }
-
+        // Scheduled a little at a time by scoreStreamer.update()
+        scoreStreamer.onNote([this](const Score &score, uint32_t i, float time) {
+            float freq = freq_of(score.midi(i));
+            switch (score.track(i))
+            {
+            case 0: playMarimba(freq, time, score.duration(i), score.velocity(i)); break; // marimba 1
+            case 1: playMarimba2(freq, time, score.duration(i), score.velocity(i)); break; // marimba 2
+            case 2: playMarimba(freq, time, score.duration(i), score.velocity(i)); break; // marimba 3
+            case 3: playViolin(freq, time, score.duration(i), score.velocity(i)); break; // cello
+            }
+        });
+        scoreStreamer.start("/Users/gracefeng/allolib/demo1-gracefeng05/tutorials/synthesis/organon.json");
     }
 
     void onCreate() override
@@ -542,23 +521,30 @@ public:
     void onSound(AudioIOData &io) override
     {
         synthManager.render(io); // Render audio
+        parallelSynth.render(io);
+        audioClock.tick(io);
         // STFT
         while (io())
         {
             if (stft(io.out(0)))
             { // Loop through all the frequency bins
+                float spectrum[FFT_SIZE / 2 + 1];
                 for (unsigned k = 0; k < stft.numBins(); ++k)
                 {
                     // Here we simply scale the complex sample
                     spectrum[k] = tanh(pow(stft.bin(k).real(), 1.3));
                     // spectrum[k] = stft.bin(k).real();
                 }
+                spectrogram.push(spectrum);
             }
         }        
     }
 
     void onAnimate(double dt) override
     {
+        // Upload the spectra pushed since the last frame
+        spectrogram.update();
+        scoreStreamer.update();
         navControl().active(navi); // Disable navigation via keyboard, since we
         imguiBeginFrame();
         synthManager.drawSynthControlPanel();
@@ -569,21 +555,20 @@ public:
     {
         g.clear();
         synthManager.render(g);
+        parallelSynth.render(g);
         // // Draw Spectrum
-        mSpectrogram.reset();
-        mSpectrogram.primitive(Mesh::LINE_STRIP);
         if (showSpectro)
         {
-            for (int i = 0; i < FFT_SIZE / 2; i++)
-            {
-                mSpectrogram.color(HSV(0.5 - spectrum[i] * 100));
-                mSpectrogram.vertex(i, spectrum[i], 0.0);
-            }
-            g.meshColor(); // Use the color in the mesh
+            // Spectrogram below the spectrum, newest on the right
+            g.pushMatrix();
+            g.translate(-3, -4.5, 0);
+            g.scale(10.0, 1.25, 1.0);
+            spectrogram.drawImage(g, 1000);
+            g.popMatrix();
             g.pushMatrix();
             g.translate(-3, -3, 0);
-            g.scale(20.0 / FFT_SIZE, 100, 1.0);
-            g.draw(mSpectrogram);
+            g.scale(10.0, 100, 1.0);
+            spectrogram.drawTrace(g, spectrogram.rows());
             g.popMatrix();
         }
         // Draw GUI
@@ -659,6 +644,10 @@ public:
         case '=':
         navi = !navi;
         break;
+        case '\\':
+        parallelVoices = !parallelVoices;
+        printf("Parallel voices %s\n", parallelVoices ? "on" : "off");
+        break;
         }
         return true;
     }
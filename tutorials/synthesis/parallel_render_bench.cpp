@@ -0,0 +1,97 @@
+// How rendering a dense passage scales with ParallelSynth's thread count.
+//
+//   ./run.sh tutorials/synthesis/parallel_render_bench.cpp
+//
+// Goes up to the number of hardware threads, or pass the maximum to try.
+//
+// Splits a fixed set of FM voices (FMBlock.h) across 1..N RenderPool lanes
+// the same way ParallelSynth does, each lane mixing into its own bus and the
+// buses summed in lane order, and reports the time per 512-frame callback.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Gamma/Domain.h"
+
+#include "FMBlock.h"
+#include "RenderPool.h"
+
+using namespace std;
+
+const unsigned kFrames = 512;
+const unsigned kVoices = 192;
+const int kCallbacks = 400;
+
+struct Voice
+{
+  FMBlock fm;
+  float freq;
+
+  void render(float *bus)
+  {
+    for (unsigned start = 0; start < kFrames; start += FMBlock::kMaxFrames)
+    {
+      for (unsigned i = 0; i < FMBlock::kMaxFrames; ++i)
+      {
+        fm.carFreq[i] = freq;
+        fm.modDepth[i] = freq * 2;
+        fm.amp[i] = 0.01f;
+      }
+      fm.render(FMBlock::kMaxFrames);
+      for (unsigned i = 0; i < FMBlock::kMaxFrames; ++i) bus[start + i] += fm.out[i];
+    }
+  }
+};
+
+// Milliseconds per callback with the voices spread over numLanes lanes
+double render(vector<Voice> &voices, unsigned numLanes, vector<float> &mix)
+{
+  RenderPool pool(numLanes);
+  vector<vector<float>> buses(numLanes, vector<float>(kFrames));
+  auto job = [&](unsigned lane) {
+    fill(buses[lane].begin(), buses[lane].end(), 0.f);
+    // round robin, like ParallelSynth::next()
+    for (size_t v = lane; v < voices.size(); v += numLanes)
+      voices[v].render(buses[lane].data());
+  };
+
+  auto start = chrono::steady_clock::now();
+  for (int c = 0; c < kCallbacks; ++c)
+  {
+    pool.run(job);
+    fill(mix.begin(), mix.end(), 0.f);
+    for (auto &bus : buses)
+      for (unsigned i = 0; i < kFrames; ++i) mix[i] += bus[i];
+  }
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+  return elapsed.count() / kCallbacks;
+}
+
+int main(int argc, char *argv[])
+{
+  gam::sampleRate(48000);
+  double budget = 1000.0 * kFrames / 48000;
+  unsigned maxThreads = max(1u, thread::hardware_concurrency());
+  if (argc > 1) maxThreads = max(1, atoi(argv[1]));
+
+  printf("%u FM voices, %u-frame callbacks (%.2f ms budget)\n", kVoices,
+         kFrames, budget);
+  printf("%8s %12s %9s %9s\n", "threads", "ms/callback", "speedup", "load");
+  double serial = 0;
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    vector<Voice> voices(kVoices);
+    for (unsigned v = 0; v < kVoices; ++v) voices[v].freq = 55.f * (1 + v % 24);
+    vector<float> mix(kFrames);
+    double ms = render(voices, threads, mix);
+    if (threads == 1) serial = ms;
+    printf("%8u %12.3f %8.2fx %8.0f%%\n", threads, ms, serial / ms,
+           100 * ms / budget);
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+// Times reading a voice's trigger parameters by name, as the voices did
+// with getInternalParameterValue(), against reading them through a
+// ParamHandle, per voice per audio block.
+//
+//   ./run.sh tutorials/synthesis/param_handle_bench.cpp
+//
+// Runs without allolib: the voice below keeps its parameters the way
+// SynthVoice does (a std::map from name to shared_ptr<Parameter>, searched
+// with find() and then operator[], the name passed as a std::string), and
+// Parameter::get() is virtual like ParameterWrapper's. The reads per block
+// are miniboss.cpp's electricBass onProcess() before ParamHandle.h (seven
+// lookups per block), and interstellar.cpp's Spectrogram, which read
+// "amplitude" on every sample.
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const unsigned kBufferSize = 512;
+const float kSampleRate = 48000;
+const unsigned kVoices = 64;
+
+struct Parameter
+{
+  Parameter(float value) : mValue(value) {}
+  virtual ~Parameter() {}
+  virtual float get() { return mValue; }
+  float mValue;
+};
+
+// Just what ParamHandle.h does, without the allolib include
+struct Handle
+{
+  Parameter *param = nullptr;
+  float get() const { return param->get(); }
+};
+
+struct Voice
+{
+  map<string, shared_ptr<Parameter>> internal;
+  Handle freq, amplitude, carMul, modMul;
+
+  Voice(float f)
+  {
+    const char *names[] = {"freq", "amplitude", "attackTime", "releaseTime", "sustain", "idx1",
+                           "idx2", "idx3", "carMul", "modMul", "pan"};
+    for (const char *name : names) internal[name] = make_shared<Parameter>(f);
+    freq.param = internal["freq"].get();
+    amplitude.param = internal["amplitude"].get();
+    carMul.param = internal["carMul"].get();
+    modMul.param = internal["modMul"].get();
+  }
+
+  float getInternalParameterValue(string name)
+  {
+    if (internal.find(name) != internal.end()) return internal[name]->get();
+    return 0;
+  }
+};
+
+// electricBass's reads at the top of onProcess()
+float blockByName(Voice &v)
+{
+  float modFreq = v.getInternalParameterValue("freq") * v.getInternalParameterValue("modMul");
+  float carBaseFreq = v.getInternalParameterValue("freq") * v.getInternalParameterValue("carMul");
+  float modScale = v.getInternalParameterValue("freq") * v.getInternalParameterValue("modMul");
+  float amp = v.getInternalParameterValue("amplitude");
+  return modFreq + carBaseFreq + modScale + amp;
+}
+
+float blockByHandle(Voice &v)
+{
+  float modFreq = v.freq.get() * v.modMul.get();
+  float carBaseFreq = v.freq.get() * v.carMul.get();
+  float modScale = v.freq.get() * v.modMul.get();
+  float amp = v.amplitude.get();
+  return modFreq + carBaseFreq + modScale + amp;
+}
+
+// Spectrogram's amplitude, read once per sample
+float samplesByName(Voice &v)
+{
+  float sum = 0;
+  for (unsigned i = 0; i < kBufferSize; ++i) sum += v.getInternalParameterValue("amplitude");
+  return sum;
+}
+
+float samplesByHandle(Voice &v)
+{
+  float sum = 0;
+  for (unsigned i = 0; i < kBufferSize; ++i) sum += v.amplitude.get();
+  return sum;
+}
+
+// Microseconds per voice per block, over at least half a second
+template <typename F>
+double usPerBlock(vector<Voice> &voices, F block, volatile float &sink)
+{
+  long blocks = 0;
+  auto start = chrono::steady_clock::now();
+  chrono::duration<double> elapsed{0};
+  do
+  {
+    for (auto &v : voices) sink += block(v);
+    blocks += voices.size();
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.5);
+  return elapsed.count() * 1e6 / blocks;
+}
+
+int main()
+{
+  vector<Voice> voices;
+  for (unsigned i = 0; i < kVoices; ++i) voices.emplace_back(100.f + i);
+  volatile float sink = 0;  // keeps the reads from being optimized away
+
+  // A 512-frame block is this many microseconds of audio
+  const double budget = kBufferSize / kSampleRate * 1e6;
+  double blockName = usPerBlock(voices, blockByName, sink);
+  double blockHandle = usPerBlock(voices, blockByHandle, sink);
+  double sampleName = usPerBlock(voices, samplesByName, sink);
+  double sampleHandle = usPerBlock(voices, samplesByHandle, sink);
+
+  printf("%-34s %12s %12s %10s\n", "parameter reads per voice block", "by name us", "handle us", "speedup");
+  printf("%-34s %12.3f %12.4f %9.0fx\n", "7 per block (electricBass)", blockName, blockHandle,
+         blockName / blockHandle);
+  printf("%-34s %12.3f %12.4f %9.0fx\n", "1 per sample (Spectrogram)", sampleName, sampleHandle,
+         sampleName / sampleHandle);
+  printf("share of a %u-frame block's %.0f us for 100 voices: by name %.2f%% / %.1f%%, "
+         "handle %.3f%% / %.2f%%\n",
+         kBufferSize, budget, 100 * 100 * blockName / budget, 100 * 100 * sampleName / budget,
+         100 * 100 * blockHandle / budget, 100 * 100 * sampleHandle / budget);
+
+  bool faster = blockHandle < blockName && sampleHandle < sampleName;
+  printf("%s\n", faster ? "ok: handles are faster" : "HANDLES NOT FASTER");
+  return faster ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// Converts Tone.js MIDI JSON scores to the binary .score format (Score.h) and
+// compares how long each takes to load and walk.
+//
+//   ./run.sh tutorials/synthesis/score_convert.cpp
+//
+// With no arguments converts and benchmarks the scores in this folder.
+// Otherwise pass the JSON files to process.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Score.h"
+#include "ScoreJson.h"
+
+using json = nlohmann::json;
+using namespace std;
+
+// Same work the apps used to do: parse, then read every note by key
+double walkJson(const string &path)
+{
+  std::ifstream f(path);
+  json music = json::parse(f);
+  double sum = 0;
+  for (auto &track : music["tracks"])
+  {
+    for (auto &note : track["notes"])
+    {
+      sum += note["time"].get<float>() + note["duration"].get<float>() +
+             note["velocity"].get<float>() + note["midi"].get<int>();
+    }
+  }
+  return sum;
+}
+
+double walkScore(const string &path)
+{
+  Score score;
+  score.open(path);
+  double sum = 0;
+  for (uint32_t i = 0; i < score.size(); i++)
+  {
+    sum += score.time(i) + score.duration(i) + score.velocity(i) + score.midi(i);
+  }
+  return sum;
+}
+
+template <typename F>
+double millisecondsPerRun(F f, int runs)
+{
+  auto start = chrono::steady_clock::now();
+  volatile double sink = 0;
+  for (int i = 0; i < runs; i++)
+  {
+    sink = sink + f();
+  }
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+int main(int argc, char *argv[])
+{
+  vector<string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    files.push_back(argv[i]);
+  }
+  if (files.empty())
+  {
+    // run.sh starts us from bin/
+    files = {"../fugue.json", "../miniboss.json", "../organon.json",
+             "../stringQuintet.json"};
+  }
+
+  printf("%-24s %8s %12s %12s %8s\n", "score", "notes", "json ms", "score ms",
+         "speedup");
+  for (auto &jsonPath : files)
+  {
+    string scorePath = scorePathFor(jsonPath);
+    if (!convertJsonScore(jsonPath, scorePath))
+    {
+      printf("Could not convert %s\n", jsonPath.c_str());
+      continue;
+    }
+    Score score;
+    score.open(scorePath);
+
+    double jsonMs = millisecondsPerRun([&]() { return walkJson(jsonPath); }, 5);
+    double scoreMs =
+        millisecondsPerRun([&]() { return walkScore(scorePath); }, 200);
+    printf("%-24s %8u %12.3f %12.4f %7.0fx\n", jsonPath.c_str(), score.size(),
+           jsonMs, scoreMs, jsonMs / scoreMs);
+  }
+  return 0;
+}
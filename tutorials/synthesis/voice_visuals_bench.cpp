@@ -0,0 +1,105 @@
+// Frame time of voice visuals drawn one by one vs. batched (VoiceVisuals.h).
+//
+//   ./run.sh tutorials/synthesis/voice_visuals_bench.cpp
+//
+// Draws N discs the way the voices do, each with its own push/translate/
+// scale/color, first with a g.draw() per disc and then as one instanced
+// batch, for a growing N. The time of each onDraw() includes glFinish(), so
+// it covers the GPU as well. The table is printed once all sizes are done
+// and the app quits.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "al/app/al_App.hpp"
+#include "al/graphics/al_Shapes.hpp"
+
+#include "SharedMesh.h"
+#include "VoiceVisuals.h"
+
+using namespace al;
+using namespace std;
+
+const unsigned kVoiceCounts[] = {64, 256, 1024, 4096, 16384};
+const unsigned kNumCounts = sizeof(kVoiceCounts) / sizeof(kVoiceCounts[0]);
+const int kWarmupFrames = 30;
+const int kFrames = 120;
+
+struct BenchApp : App
+{
+  VoiceVisuals voiceVisuals;
+  SharedMesh::Ptr disc;
+  VoiceShape discShape;
+
+  unsigned count = 0;   // index into kVoiceCounts
+  bool batched = false;
+  int frame = 0;
+  double total = 0;
+  double results[kNumCounts][2];
+  unsigned drawCalls[kNumCounts];
+
+  void onCreate() override
+  {
+    disc = SharedMesh::get("disc 1 30", [](Mesh &m) { addDisc(m, 1.0, 30); });
+    discShape = voiceVisuals.mesh(disc);
+  }
+
+  void onDraw(Graphics &g) override
+  {
+    auto start = chrono::steady_clock::now();
+
+    g.clear();
+    unsigned voices = kVoiceCounts[count];
+    for (unsigned i = 0; i < voices; ++i)
+    {
+      float angle = i * 0.618f * 6.2832f;
+      float radius = 0.5f + 3.f * i / voices;
+      g.pushMatrix();
+      g.translate(radius * cos(angle), radius * sin(angle), -10);
+      g.scale(0.05f);
+      Color color = HSV(float(i) / voices, 0.8, 1);
+      if (batched)
+      {
+        voiceVisuals.add(discShape, g, color);
+      }
+      else
+      {
+        g.color(color);
+        disc->draw(g);
+      }
+      g.popMatrix();
+    }
+    if (batched)
+    {
+      voiceVisuals.draw(g);
+      drawCalls[count] = voiceVisuals.drawCalls();
+    }
+    glFinish();
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    if (++frame > kWarmupFrames) total += elapsed.count();
+    if (frame < kWarmupFrames + kFrames) return;
+
+    results[count][batched] = total / kFrames;
+    frame = 0;
+    total = 0;
+    batched = !batched;
+    if (batched) return;
+    if (++count < kNumCounts) return;
+
+    printf("%8s %12s %12s %8s %12s\n", "voices", "direct ms", "batched ms", "speedup",
+           "batch calls");
+    for (unsigned c = 0; c < kNumCounts; ++c)
+      printf("%8u %12.3f %12.3f %7.1fx %12u\n", kVoiceCounts[c], results[c][0], results[c][1],
+             results[c][0] / results[c][1], drawCalls[c]);
+    quit();
+  }
+};
+
+int main()
+{
+  BenchApp app;
+  app.start();
+  return 0;
+}